@@ -0,0 +1,21 @@
+# emulates a node crash on a local cluster, and collects the failover time
+# usage: ./failover.sh protocol version app nodes crash_node crash_after_s
+# hosts.xml shall list the hosts of all the nodes, e.g. the local machine
+protocol=$1
+version=$2
+app=$3
+nodes=$4
+crash_node=$5
+crash_after=$6
+echo "protocol=$protocol version=$version app=$app nodes=$nodes crash_node=$crash_node crash_after=$crash_after"
+
+mkdir -p out/failover
+sed "s|</bench>|  <failover>\n    <timeout_us>200000</timeout_us>\n    <crash_node>$crash_node</crash_node>\n    <crash_after_s>$crash_after</crash_after_s>\n  </failover>\n</bench>|" config.xml > config-failover.xml
+
+for ((id = 0; id < $nodes; id++)); do
+	./nocc$protocol-$version --bench $app --txn-flags 1 --verbose --config config-failover.xml --id $id -t 4 -c 10 -r 100 -p $nodes \
+		1>out/failover/nocc$protocol-$app-$version.log_$id 2>&1 &
+done
+wait
+
+grep -h "removed in view\|take over\|failovers" out/failover/nocc$protocol-$app-$version.log_*
@@ -0,0 +1,282 @@
+#!/usr/bin/env python
+
+###############################################################################
+# Runs a named suite of protocol x version x bench combinations, and compares
+# the results with a stored baseline, to catch the perf regressions.
+#
+# usage:
+#    ./regress.py run <suite> [-s regress_suites.xml] [-o out_dir] [--build]
+#    ./regress.py compare <out_dir> <baseline_dir> [--tput 0.05] [--lat 0.10]
+#    ./regress.py baseline <out_dir> <baseline_dir>   // store the results as the baseline
+#
+# Each run writes the structured result of the master (results/*.json, see
+# BenchReporter::dump_results) to <out_dir>/<exe>_<bench>.json.
+# A suite without hosts runs all the nodes at this host, using a port per node;
+# a suite with a hosts file starts node i at its i-th host with ssh, and assumes
+# this directory is at the same path at all the hosts.
+# compare exits with 1 if any throughput drops, or any p50/p99 latency rises,
+# by more than the given fraction.
+###############################################################################
+
+from __future__ import print_function
+
+import sys
+import os
+import json
+import shutil
+import signal
+import subprocess
+import tempfile
+import time
+import xml.etree.cElementTree as ET
+
+from optparse import OptionParser
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR   = os.path.dirname(SCRIPT_DIR)
+BASE_PORT  = 9300
+
+FNULL = open(os.devnull, 'w')
+
+def print_with_tag(tag,s):
+    print("[\033[31m%s\033[0m] %s" % (tag,s))
+
+# suites ######################################################################
+
+def parse_suite(suite_file,name):
+    tree = ET.ElementTree(file = suite_file)
+    for s in tree.getroot().findall("suite"):
+        if s.get("name") != name:
+            continue
+        suite = {
+            "name"     : name,
+            "nodes"    : int(s.findtext("nodes","2")),
+            "threads"  : int(s.findtext("threads","2")),
+            "coroutines" : int(s.findtext("coroutines","4")),
+            "distributed_ratio" : int(s.findtext("distributed_ratio","100")),
+            "timeout_s": int(s.findtext("timeout_s","120")),
+            "warmup"   : int(s.findtext("warmup","1")),
+            "hosts"    : s.findtext("hosts","").strip(),
+            "protocols": s.findtext("protocols","").split(),
+            "versions" : s.findtext("versions","").split(),
+            "benchs"   : s.findtext("benchs","").split(),
+        }
+        return suite
+    print_with_tag("error","no suite %s in %s" % (name,suite_file))
+    sys.exit(1)
+
+def exe_name(protocol,version):
+    return "nocc%s-%s" % (protocol,version)
+
+def build_exe(protocol,version):
+    # the executables are built into scripts/
+    flags = []
+    target = exe_name(protocol,version)
+    if version == "onesided":
+        flags = ["-DONE_SIDED_READ=1"]
+    elif version.startswith("hybrid-"):
+        flags  = ["-DONE_SIDED_READ=2","-DHYBRID_CODE=%s" % version.split("-")[1]]
+        target = exe_name(protocol,"hybrid")
+    else:
+        flags = ["-DONE_SIDED_READ=0"]
+    build_dir = os.path.join(ROOT_DIR,"build-regress")
+    print_with_tag("build","%s %s" % (exe_name(protocol,version)," ".join(flags)))
+    subprocess.check_call(["cmake","-S",ROOT_DIR,"-B",build_dir] + flags,stdout = FNULL)
+    subprocess.check_call(["cmake","--build",build_dir,"--target",target,"-j",str(os.sysconf("SC_NPROCESSORS_ONLN"))],
+                          stdout = FNULL)
+    if target != exe_name(protocol,version):
+        shutil.move(os.path.join(SCRIPT_DIR,target),os.path.join(SCRIPT_DIR,exe_name(protocol,version)))
+
+# runs ########################################################################
+
+def parse_hosts(host_file):
+    tree = ET.ElementTree(file = host_file)
+    return [e.text.strip() for e in tree.getroot().find("macs").findall("a")]
+
+def write_run_files(run_dir,suite,port):
+    # the config is the one of this directory, at a fresh port
+    tree = ET.ElementTree(file = os.path.join(SCRIPT_DIR,"config.xml"))
+    root = tree.getroot()
+    for tag in ["port","port_per_node"]:
+        e = root.find(tag)
+        if e is not None:
+            root.remove(e)
+    ET.SubElement(root,"port").text = str(port)
+    if suite["hosts"] == "":
+        ET.SubElement(root,"port_per_node").text = "1"
+    tree.write(os.path.join(run_dir,"config.xml"))
+
+    if suite["hosts"] == "":
+        hosts = ["localhost"] * suite["nodes"]
+        with open(os.path.join(run_dir,"hosts.xml"),"w") as f:
+            f.write("<hosts>\n  <macs>\n")
+            for h in hosts:
+                f.write("    <a>%s</a>\n" % h)
+            f.write("  </macs>\n</hosts>\n")
+    else:
+        shutil.copy(os.path.join(SCRIPT_DIR,suite["hosts"]),os.path.join(run_dir,"hosts.xml"))
+        hosts = parse_hosts(os.path.join(run_dir,"hosts.xml"))[0:suite["nodes"]]
+    os.mkdir(os.path.join(run_dir,"results"))
+    return hosts
+
+def run_one(suite,exe,bench,port,out_dir):
+    run_dir = tempfile.mkdtemp(prefix = "regress_",dir = SCRIPT_DIR)
+    hosts = write_run_files(run_dir,suite,port)
+    local = suite["hosts"] == ""
+
+    print_with_tag("run","%s %s: %d nodes, t %d, c %d" % (exe,bench,suite["nodes"],suite["threads"],suite["coroutines"]))
+    procs = []
+    for i in range(suite["nodes"]):
+        cmd = "%s --bench %s --txn-flags 1 --verbose --config config.xml --id %d -t %d -c %d -r %d -p %d" \
+              % (os.path.join(SCRIPT_DIR,exe),bench,i,suite["threads"],suite["coroutines"],
+                 suite["distributed_ratio"],suite["nodes"])
+        log = open(os.path.join(run_dir,"log_%d" % i),"w")
+        if local:
+            procs.append(subprocess.Popen(cmd.split(),cwd = run_dir,stdout = log,stderr = subprocess.STDOUT))
+        else:
+            procs.append(subprocess.Popen(["ssh","-n",hosts[i],"cd %s && %s" % (run_dir,cmd)],
+                                          stdout = log,stderr = subprocess.STDOUT))
+
+    # the master ends the run after its epochs, and tells the others to exit
+    deadline = time.time() + suite["timeout_s"]
+    while time.time() < deadline and procs[0].poll() is None:
+        time.sleep(1)
+    if procs[0].poll() is None:
+        print_with_tag("run","timeout, interrupt the master")
+        procs[0].send_signal(signal.SIGINT)
+        time.sleep(10)
+    for p in procs:
+        if p.poll() is None:
+            p.kill()
+    if not local:
+        for h in hosts:
+            subprocess.call(["ssh","-n",h,"pkill -f %s" % exe],stdout = FNULL,stderr = FNULL)
+
+    results = [f for f in os.listdir(os.path.join(run_dir,"results")) if f.endswith(".json")]
+    if len(results) == 0:
+        print_with_tag("error","no result of %s %s, logs kept in %s" % (exe,bench,run_dir))
+        return False
+    res = json.load(open(os.path.join(run_dir,"results",results[0])))
+    res["regress"] = { "suite" : suite["name"], "warmup" : suite["warmup"], "commit" : git_commit() }
+    with open(os.path.join(out_dir,"%s_%s.json" % (exe,bench)),"w") as f:
+        json.dump(res,f,indent = 2)
+    shutil.rmtree(run_dir)
+    return True
+
+def git_commit():
+    try:
+        return subprocess.check_output(["git","-C",ROOT_DIR,"rev-parse","HEAD"]).decode().strip()
+    except Exception:
+        return ""
+
+def run_suite(suite,out_dir,build):
+    if not os.path.exists(out_dir):
+        os.makedirs(out_dir)
+    port = BASE_PORT
+    failed = []
+    for p in suite["protocols"]:
+        for v in suite["versions"]:
+            exe = exe_name(p,v)
+            if build:
+                build_exe(p,v)
+            if not os.path.exists(os.path.join(SCRIPT_DIR,exe)):
+                print_with_tag("error","%s not built, skip" % exe)
+                failed.append(exe)
+                continue
+            for b in suite["benchs"]:
+                if not run_one(suite,exe,b,port,out_dir):
+                    failed.append("%s %s" % (exe,b))
+                port += suite["nodes"] + 1
+    return failed
+
+# comparison ##################################################################
+
+def median(vals):
+    vals = sorted(vals)
+    if len(vals) == 0:
+        return 0.0
+    return vals[len(vals) // 2]
+
+def metrics(res):
+    # throughput: mean of the epochs after the warm up; latency: median of the epochs' percentiles
+    warmup = res.get("regress",{}).get("warmup",0)
+    epochs = [e for e in res["epochs"] if e["epoch"] > warmup]
+    if len(epochs) == 0:
+        epochs = res["epochs"]
+    m = {}
+    if len(epochs) > 0:
+        m["throughput"] = sum([e["throughput"] for e in epochs]) / len(epochs)
+    for t,name in enumerate(res.get("tx_types",[])):
+        lats = [e["latency"][t * 4:t * 4 + 4] for e in epochs if len(e["latency"]) >= t * 4 + 4]
+        lats = [l for l in lats if l[3] > 0] # the TX run in the epoch
+        if len(lats) == 0:
+            continue
+        m["%s.p50" % name] = median([l[0] for l in lats])
+        m["%s.p99" % name] = median([l[1] for l in lats])
+    return m
+
+def compare(out_dir,base_dir,tput_th,lat_th):
+    regressions = 0
+    for f in sorted(os.listdir(base_dir)):
+        if not f.endswith(".json"):
+            continue
+        if not os.path.exists(os.path.join(out_dir,f)):
+            print_with_tag("missing",f)
+            regressions += 1
+            continue
+        base = metrics(json.load(open(os.path.join(base_dir,f))))
+        cur  = metrics(json.load(open(os.path.join(out_dir,f))))
+        for k in sorted(base.keys()):
+            if k not in cur or base[k] == 0:
+                continue
+            change = (cur[k] - base[k]) / base[k]
+            if k == "throughput":
+                bad = change < -tput_th
+            else:
+                bad = change > lat_th
+            tag = "REGRESS" if bad else "ok"
+            if bad:
+                regressions += 1
+            print("%-8s %-40s %-20s %14.3f -> %14.3f (%+.1f%%)" % (tag,f[:-5],k,base[k],cur[k],change * 100))
+    print_with_tag("compare","%d regressions" % regressions)
+    return regressions
+
+def store_baseline(out_dir,base_dir):
+    if not os.path.exists(base_dir):
+        os.makedirs(base_dir)
+    for f in os.listdir(out_dir):
+        if f.endswith(".json"):
+            shutil.copy(os.path.join(out_dir,f),base_dir)
+    print_with_tag("baseline","stored %s to %s" % (out_dir,base_dir))
+
+def main():
+    parser = OptionParser(usage = "%prog run <suite> | compare <out_dir> <baseline_dir> | baseline <out_dir> <baseline_dir>")
+    parser.add_option("-s","--suites",dest = "suites",default = os.path.join(SCRIPT_DIR,"regress_suites.xml"),
+                      help = "the suite file")
+    parser.add_option("-o","--out",dest = "out",default = "",
+                      help = "where the results go, regress_out/<suite> by default")
+    parser.add_option("--build",dest = "build",action = "store_true",default = False,
+                      help = "build the executables of the suite first")
+    parser.add_option("--tput",dest = "tput",type = "float",default = 0.05,
+                      help = "the tolerated throughput drop")
+    parser.add_option("--lat",dest = "lat",type = "float",default = 0.10,
+                      help = "the tolerated latency rise")
+    (options, args) = parser.parse_args()
+
+    if len(args) == 2 and args[0] == "run":
+        suite = parse_suite(options.suites,args[1])
+        out = options.out if options.out != "" else os.path.join(SCRIPT_DIR,"regress_out",suite["name"])
+        failed = run_suite(suite,out,options.build)
+        for f in failed:
+            print_with_tag("failed",f)
+        sys.exit(1 if len(failed) > 0 else 0)
+    elif len(args) == 3 and args[0] == "compare":
+        sys.exit(1 if compare(args[1],args[2],options.tput,options.lat) > 0 else 0)
+    elif len(args) == 3 and args[0] == "baseline":
+        store_baseline(args[1],args[2])
+    else:
+        parser.print_help()
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
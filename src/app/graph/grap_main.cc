@@ -1,52 +1,79 @@
 #include "graph_constants.h"
 #include "graph.h"
+#include "graph_worker.h"
 #include "graph_util.hpp"
 #include "real_distribution.hpp"
 
 #include "rdmaio.h"
 
 #include "db/txs/dbsi.h"
+#include "db/txs/ts_manager.hpp"
 
 #include "framework/bench_runner.h"
 
+#include "rtx/global_vars.h"
+
 #include "util/util.h"
 
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
 // for log normal distribution
 #include <random>
 #include <cmath>
 
 using namespace nocc::util;
+using namespace rdmaio;
+
+extern size_t nthreads;
+extern size_t nclients;
+extern size_t current_partition;
+extern uint64_t ops_per_worker;
+
+extern nocc::db::TSManager *ts_manager;
 
 namespace nocc {
+
+  extern RdmaCtrl *cm;
+
   namespace oltp {
+
+  extern char *store_buffer; // the buffer used to store DrTM-kv
+
   namespace link { // link benchmark
 
+    GraphConfig graph_config;
+
     class GraphLoader : public BenchLoader {
       MemDB *store_;
       uint64_t start_id_; uint64_t end_id_;
-      double medium_data_size_;
+      bool is_primary_;
     public:
-      GraphLoader(uint64_t start_id,uint64_t end_id,double mdz,
+      GraphLoader(uint64_t start_id,uint64_t end_id,
                   uint64_t seed,int partition,MemDB *store,bool is_primary)
-        : start_id_(start_id), end_id_(end_id), medium_data_size_(mdz),
-          BenchLoader(seed)
+        : start_id_(start_id), end_id_(end_id),
+          BenchLoader(seed),
+          store_(store),
+          is_primary_(is_primary)
       {
+        partition_ = partition;
       };
       virtual void load();
+    private:
+      char *put(int tableid,uint64_t key,char *val,int len);
     };
 
     class GraphRunner : public BenchRunner {
     public:
-      GraphRunner(std::string &config_file) {
-
-      }
+      GraphRunner(std::string &config_file);
 
+      virtual void init_put() {}
       virtual std::vector<BenchLoader *> make_loaders(int partition, MemDB* store = NULL);
       virtual std::vector<RWorker *> make_workers();
       virtual std::vector<BackupBenchWorker *> make_backup_workers();
-      virtual void init_store(MemDB* &store) { }
-      virtual void init_backup_store(MemDB* &store) { }
-      virtual void populate_cache() { }
+      virtual void init_store(MemDB* &store);
+      virtual void init_backup_store(MemDB* &store);
+      virtual void populate_cache();
 
       virtual void bootstrap_with_rdma(RdmaCtrl *r) {
       }
@@ -56,40 +83,279 @@ namespace nocc {
     };
 
     void GraphTest(int argc,char **argv) {
-      auto test = RealDistribution();
-      df_t res;
+      GraphRunner runner(nocc::oltp::config_file_name);
+      runner.run();
+      return;
+    }
+
+    // link slots of the nodes in [start,end)
+    static uint64_t total_link_slots(uint64_t start,uint64_t end) {
+      uint64_t sum = 0;
+      for(uint64_t id = start;id < end;++id)
+        sum += LinkCapacity(id);
+      return sum;
+    }
+
+    GraphRunner::GraphRunner(std::string &config_file) : BenchRunner(config_file) {
 
-      std::ifstream ifs("../data/Distribution.dat", std::ifstream::in);
-      auto title = test.get_cdf(res,ifs);
-      pdf_t pdf;
-      test.get_pdf(res,pdf);
-      for(uint i = 0;i < 12;++i) {
+      using boost::property_tree::ptree;
+      using namespace boost;
+      using namespace property_tree;
 
+      GraphConfig &c = graph_config;
+      ptree pt;
+      try {
+        read_xml(config_file,pt);
+      } catch (const ptree_error &e) {
+        // pass
       }
-      //test.get_cdf(res,ifs);
+      c.nodes       = pt.get<uint64_t>("bench.graph.nodes",c.nodes);
+      c.power_alpha = pt.get<double>("bench.graph.power_alpha",c.power_alpha);
+      c.min_degree  = pt.get<int>("bench.graph.min_degree",c.min_degree);
+      c.max_degree  = pt.get<int>("bench.graph.max_degree",c.max_degree);
+      c.link_slack  = pt.get<int>("bench.graph.link_slack",c.link_slack);
+      c.list_limit  = pt.get<int>("bench.graph.list_limit",c.list_limit);
+      c.zipf_theta  = pt.get<double>("bench.graph.zipf_theta",c.zipf_theta);
+      c.nlinks_cdf  = pt.get<std::string>("bench.graph.nlinks_cdf",c.nlinks_cdf);
 
-      return;
+      const char *ops[GRAPH_TXN_NUM] = {"add_link","update_link","delete_link","get_link_list",
+                                        "count_link","get_node","update_node"};
+      for(int i = 0;i < GRAPH_TXN_NUM;++i)
+        c.mix[i] = pt.get<unsigned>(std::string("bench.graph.") + ops[i],c.mix[i]);
+
+      ASSERT(c.power_alpha > 1) << "power law exponent shall be larger than 1";
+      ASSERT(0 <= c.min_degree && c.min_degree <= c.max_degree);
+      ASSERT(c.max_degree + c.link_slack <= GRAPH_MAX_SLOTS && c.link_slack > 0);
+      ASSERT(c.list_limit > 0);
+
+      // the out degrees are generated from the node id, so that all partitions agree on them
+      RealDistribution *real = NULL;
+      if(c.nlinks_cdf.size() > 0) {
+        std::ifstream ifs(c.nlinks_cdf.c_str(),std::ifstream::in);
+        ASSERT(ifs.is_open()) << "failed to open " << c.nlinks_cdf;
+        real = new RealDistribution();
+        real->init_link(ifs);
+      }
+      uint64_t total = c.total_nodes();
+      uint64_t links = 0;
+      c.degree.resize(total);
+      for(uint64_t id = 0;id < total;++id) {
+        uint64_t h = GraphHash(id);
+        double d;
+        if(real != NULL) {
+          d = real->getNLinks(h % total,0,total);
+        } else {
+          // power law, P(degree > x) ~ x ^ (1 - alpha)
+          double u = (h >> 11) * (1.0 / (1ULL << 53));
+          d = c.min_degree * pow(1 - u,-1.0 / (c.power_alpha - 1));
+        }
+        c.degree[id] = (uint16_t)std::min(d,(double)c.max_degree);
+        links += c.degree[id];
+      }
+      delete real;
+
+      c.zetan = ycsb::ZipfianGenerator::zeta(0,total,c.zipf_theta,0);
+
+      fprintf(stdout,"[Graph]: %lu nodes per partition, %f links per node, mix %u %u %u %u %u %u %u\n",
+              c.nodes,links / (double)total,
+              c.mix[0],c.mix[1],c.mix[2],c.mix[3],c.mix[4],c.mix[5],c.mix[6]);
+    }
+
+    static int graph_meta_size() {
+#if MVCC_TX
+      return sizeof(rtx::MVCCHeader);
+#else
+      return sizeof(rtx::RdmaValHeader);
+#endif
+    }
+
+    void GraphRunner::init_store(MemDB* &store) {
+      assert(store == NULL);
+      // Should not give store_buffer to backup MemDB!
+      store = new MemDB(store_buffer);
+
+      uint64_t start = current_partition * graph_config.nodes;
+      uint64_t slots = total_link_slots(start,start + graph_config.nodes);
+#if MVCC_TX
+      const int vn = MVCC_VERSION_NUM;
+#else
+      const int vn = 1;
+#endif
+      store->AddSchema(GRAPH_NODE,TAB_HASH,sizeof(uint64_t),sizeof(Node) * vn,graph_meta_size(),
+                       graph_config.nodes * 1.5);
+      store->AddSchema(GRAPH_LIST,TAB_HASH,sizeof(uint64_t),sizeof(LinkList) * vn,graph_meta_size(),
+                       graph_config.nodes * 1.5);
+      store->AddSchema(GRAPH_LINK,TAB_HASH,sizeof(uint64_t),sizeof(Link) * vn,graph_meta_size(),
+                       slots * 1.5);
+
+      store->EnableRemoteAccess(GRAPH_NODE,cm);
+      store->EnableRemoteAccess(GRAPH_LIST,cm);
+      store->EnableRemoteAccess(GRAPH_LINK,cm);
+    }
+
+    void GraphRunner::init_backup_store(MemDB* &store) {
+      assert(store == NULL);
+      store = new MemDB();
+
+      // backups of all partitions share the same size
+      uint64_t slots = 0;
+      for(uint p = 0;p < total_partition;++p)
+        slots = std::max(slots,total_link_slots(p * graph_config.nodes,(p + 1) * graph_config.nodes));
+#if MVCC_TX
+      const int vn = MVCC_VERSION_NUM;
+#else
+      const int vn = 1;
+#endif
+      int meta_size = sizeof(rtx::RdmaValHeader);
+      store->AddSchema(GRAPH_NODE,TAB_HASH,sizeof(uint64_t),sizeof(Node) * vn,meta_size,
+                       graph_config.nodes,false);
+      store->AddSchema(GRAPH_LIST,TAB_HASH,sizeof(uint64_t),sizeof(LinkList) * vn,meta_size,
+                       graph_config.nodes,false);
+      store->AddSchema(GRAPH_LINK,TAB_HASH,sizeof(uint64_t),sizeof(Link) * vn,meta_size,
+                       slots,false);
     }
 
     std::vector<BenchLoader *> GraphRunner::make_loaders(int partition, MemDB* store) {
       std::vector<BenchLoader *> res;
+      uint64_t start = partition * graph_config.nodes;
+      if(store == NULL)
+        res.push_back(new GraphLoader(start,start + graph_config.nodes,9234,partition,store_,true));
+      else
+        res.push_back(new GraphLoader(start,start + graph_config.nodes,9234,partition,store,false));
       return res;
     }
 
     std::vector<RWorker *> GraphRunner::make_workers() {
       std::vector<RWorker *> res;
+      util::fast_random r(23984543 + current_partition * 73);
+
+      for(uint i = 0;i < nthreads;++i)
+        res.push_back(new GraphWorker(i,r.next(),store_,ops_per_worker,&barrier_a_,&barrier_b_,this));
+
+#if defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+      // add ts worker
+      ts_manager = new TSManager(nthreads + nclients + 1,cm,0,0);
+      res.push_back(ts_manager);
+#endif
       return res;
     }
 
     std::vector<BackupBenchWorker *> GraphRunner::make_backup_workers() {
+      // backups are maintained by the rtx loggers
       std::vector<BackupBenchWorker *> res;
       return res;
     }
 
-    void GraphLoader::load() {
+    void GraphRunner::populate_cache() {
+#if RDMA_CACHE == 1
+      LOG(2) << "loading cache.";
 
+      // create a temporal QP for usage
+      int dev_id = cm->get_active_dev(0);
+      int port_idx = cm->get_active_port(0);
+
+      cm->thread_local_init();
+      cm->open_device(dev_id);
+      cm->register_connect_mr(dev_id); // register memory on the specific device
+
+      cm->link_connect_qps(nthreads + nthreads + 1,dev_id,port_idx,0,IBV_QPT_RC);
+
+      auto db = store_;
+      char *temp = (char *)Rmalloc(256);
+
+      for(uint64_t id = 0;id < graph_config.total_nodes();++id) {
+        auto qp = cm->get_rc_qp(nthreads + nthreads + 1,NodeToPid(id),0);
+        auto off = db->stores_[GRAPH_NODE]->RemoteTraverse(id,qp,temp);
+        assert(off != 0);
+        off = db->stores_[GRAPH_LIST]->RemoteTraverse(id,qp,temp);
+        assert(off != 0);
+        for(uint32_t slot = 0;slot < LinkCapacity(id);++slot) {
+          off = db->stores_[GRAPH_LINK]->RemoteTraverse(makeLinkKey(id,slot),qp,temp);
+          assert(off != 0);
+        }
+      }
+      Rfree(temp);
+#endif
     }
 
+    char *GraphLoader::put(int tableid,uint64_t key,char *val,int len) {
+
+      int meta_size = store_->_schemas[tableid].meta_len;
+#if MVCC_TX
+      int size = meta_size + MVCC_VERSION_NUM * len;
+#else
+      int size = meta_size + len;
+#endif
+      size = Round<int>(size,sizeof(uint64_t));
+
+      char *wrapper = is_primary_ ? (char *)Rmalloc(size) : new char[size];
+      assert(wrapper != NULL);
+      memset(wrapper,0,meta_size);
+      memcpy(wrapper + meta_size,val,len);
+#if MVCC_TX
+      ((rtx::MVCCHeader *)wrapper)->wts[0] = 1;
+#endif
+      auto node = store_->Put(tableid,key,(uint64_t *)wrapper,len);
+      if(is_primary_) {
+        node->off = (uint64_t)wrapper - (uint64_t)(cm->conn_buf_);
+        ASSERT(node->off % sizeof(uint64_t) == 0) << "graph value size " << size;
+      }
+      return wrapper;
+    }
+
+    void GraphLoader::load() {
+
+      if(is_primary_)
+        RThreadLocalInit();
+
+      // the in degrees of the local nodes, from the links of all partitions
+      std::vector<uint32_t> in_count(end_id_ - start_id_,0);
+      for(uint64_t id = 0;id < graph_config.total_nodes();++id) {
+        for(uint32_t slot = 0;slot < graph_config.degree[id];++slot) {
+          uint64_t id2 = LinkTarget(id,slot);
+          if(id2 >= start_id_ && id2 < end_id_)
+            in_count[id2 - start_id_] += 1;
+        }
+      }
+
+      uint64_t links = 0;
+      for(uint64_t id = start_id_;id < end_id_;++id) {
+        Node n;
+        memset(&n,0,sizeof(Node));
+        n.id = id;
+        n.type = DEFAULT_NODE_TYPE;
+        n.version = 1;
+        n.time = rdtsc();
+        memset(n.data,'a' + random_generator_.next() % 26,sizeof(n.data));
+        put(GRAPH_NODE,id,(char *)&n,sizeof(Node));
+
+        uint32_t degree = graph_config.degree[id];
+        uint32_t cap    = LinkCapacity(id);
+
+        LinkList list;
+        memset(&list,0,sizeof(LinkList));
+        list.count = degree;
+        list.in_count = in_count[id - start_id_];
+        list.head = degree % cap;
+        list.version = 1;
+        put(GRAPH_LIST,id,(char *)&list,sizeof(LinkList));
+
+        for(uint32_t slot = 0;slot < cap;++slot) {
+          Link l;
+          memset(&l,0,sizeof(Link));
+          l.id2 = LinkTarget(id,slot);
+          l.type = DEFAULT_LINK_TYPE;
+          l.visibility = slot < degree ? VISIBILITY_DEFAULT : VISIBILITY_HIDDEN;
+          l.version = 1;
+          l.time = n.time;
+          memset(l.data,'a' + random_generator_.next() % 26,sizeof(l.data));
+          put(GRAPH_LINK,makeLinkKey(id,slot),(char *)&l,sizeof(Link));
+        }
+        links += degree;
+      }
+      fprintf(stdout,"[Graph], partition %d loaded %lu nodes, %lu links\n",
+              partition_,end_id_ - start_id_,links);
+    }
 
   }; // end namespace link
   }; // end namespace oltp
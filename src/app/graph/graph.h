@@ -5,12 +5,77 @@
 #include "tx_config.h"
 #include "app/config.h"
 
+#include "graph_scheme.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define GRAPH_DEFAULT_NODES 100000  // nodes per partition
+
+extern size_t total_partition;
+
 namespace nocc {
   namespace oltp {
   namespace link {
 
     void GraphTest(int argc,char **argv); // main hook function
 
+    // the operations of LinkBench
+    enum graph_txn_t {
+      GRAPH_ADD_LINK = 0,
+      GRAPH_UPDATE_LINK,
+      GRAPH_DELETE_LINK,
+      GRAPH_GET_LINK_LIST,
+      GRAPH_COUNT_LINK,
+      GRAPH_GET_NODE,
+      GRAPH_UPDATE_NODE,
+      GRAPH_TXN_NUM
+    };
+
+    struct GraphConfig {
+      uint64_t nodes       = GRAPH_DEFAULT_NODES; // per partition
+      double   power_alpha = 2.0;   // exponent of the power-law out degrees
+      int      min_degree  = 1;
+      int      max_degree  = 1000;
+      int      link_slack  = 4;     // free link slots per node, for the added links
+      int      list_limit  = 10;    // max links returned by a get link list
+      double   zipf_theta  = 0.8;   // skew of the accessed nodes
+      double   zetan       = 0;     // zeta of the total nodes, computed once
+      std::string nlinks_cdf;       // optional cdf file of the out degrees, overrides the power law
+      // the default mix of LinkBench, with the node insert/delete folded into the node updates
+      unsigned mix[GRAPH_TXN_NUM] = {9,8,3,51,5,13,11};
+
+      std::vector<uint16_t> degree; // out degree of each node at load time, generated once at start
+
+      inline uint64_t total_nodes() const { return nodes * total_partition; }
+    };
+
+    extern GraphConfig graph_config;
+
+    inline ALWAYS_INLINE int NodeToPid(uint64_t id) {
+      return id / graph_config.nodes;
+    }
+
+    inline ALWAYS_INLINE uint64_t GraphHash(uint64_t x) {
+      // splitmix64 finalizer
+      x += 0x9E3779B97F4A7C15ULL;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+      return x ^ (x >> 31);
+    }
+
+    // the number of link slots of a node
+    inline ALWAYS_INLINE uint32_t LinkCapacity(uint64_t id) {
+      return std::min(graph_config.degree[id] + graph_config.link_slack,GRAPH_MAX_SLOTS);
+    }
+
+    // the target of a link slot is fixed, scattered over all partitions
+    inline ALWAYS_INLINE uint64_t LinkTarget(uint64_t id1,uint32_t slot) {
+      uint64_t id2 = GraphHash(makeLinkKey(id1,slot)) % graph_config.total_nodes();
+      return id2 == id1 ? (id1 + 1) % graph_config.total_nodes() : id2;
+    }
+
   }; // end namespace link
   }; // end namespace oltp
 };
@@ -1,17 +1,19 @@
+#pragma once
+
 namespace nocc {
 
   namespace oltp {
     namespace link {
-      int DEFAULT_LINK_TYPE = 123456789;
-      int DEFAULT_NODE_TYPE = 2048;
-      bool VISIBILITY_HIDDEN = 0;
-      bool VISIBILITY_DEFAULT = 1;
-      int  DEFAULT_LIMIT = 10000;
-      int  MAX_LINK_DATA = 255;
-      int  DEFAULT_LIMI  = 10000;
+      const int DEFAULT_LINK_TYPE = 123456789;
+      const int DEFAULT_NODE_TYPE = 2048;
+      const bool VISIBILITY_HIDDEN = 0;
+      const bool VISIBILITY_DEFAULT = 1;
+      const int  DEFAULT_LIMIT = 10000;
+      const int  MAX_LINK_DATA = 255;
+      const int  DEFAULT_LIMI  = 10000;
 
-      double LINK_DATASIZE_SIGMA = 1.0;
-      double NODE_DATASIZE_SIGMA = 1.0;
+      const double LINK_DATASIZE_SIGMA = 1.0;
+      const double NODE_DATASIZE_SIGMA = 1.0;
     };
   };
 };
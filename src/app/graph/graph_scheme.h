@@ -2,6 +2,15 @@
 #define NOCC_APP_GRAPH_SCHEME_
 
 #include "all.h"
+#include "util/util.h"
+
+#define GRAPH_NODE  0
+#define GRAPH_LIST  1   // the link list (secondary index) of a node
+#define GRAPH_LINK  2
+
+// bits of the link slot in a link key
+#define GRAPH_SLOT_BITS 16
+#define GRAPH_MAX_SLOTS ((1 << GRAPH_SLOT_BITS) - 1)
 
 namespace nocc {
   namespace oltp {
@@ -15,18 +24,32 @@ namespace nocc {
         char data[CACHE_LINE_SZ];
       };
 
-      class Edge {
+      /**
+       * The out links of a node are kept in capacity slots, keyed by makeLinkKey(id1,slot).
+       * The slots are pre-loaded, since the TX layer has no remote insert; a deleted or unused
+       * slot is hidden. The target of a slot is fixed (see LinkTarget), so the slot identifies
+       * the link (id1,id2).
+       */
+      struct Link {
+        uint64_t id2;
         int  type;
-        bool visiblilty;
+        bool visibility;
         uint64_t version;
+        uint64_t time;
         char data[CACHE_LINE_SZ];
       };
 
+      // the link list index of a node
+      struct LinkList {
+        uint32_t count;     // visible out links
+        uint32_t in_count;  // visible in links, i.e. the count of the inverse links
+        uint32_t head;      // the slot of the next added link, the slots before it are the latest
+        uint64_t version;
+      };
+
       inline ALWAYS_INLINE
-        uint64_t makeEdgeKey(uint64_t id0,uint64_t id1,uint64_t time) {
-        uint64_t *sec = new uint64_t[3];
-        sec[0] = id0; sec[1] = id1;sec[2] = time;
-        return (uint64_t )sec;
+        uint64_t makeLinkKey(uint64_t id1,uint64_t slot) {
+        return (id1 << GRAPH_SLOT_BITS) | slot;
       }
 
     } // end namespace link
@@ -0,0 +1,315 @@
+#include "graph_worker.h"
+#include "graph_constants.h"
+
+#include "tx_config.h"
+
+#include "util/util.h"
+
+#include "rtx/global_vars.h"
+#include "rtx/occ_rdma.h"
+#include "rtx/occ_variants.hpp"
+#include "rtx/nowait_rdma.h"
+#include "rtx/sundial_rdma.h"
+#include "rtx/mvcc_rdma.h"
+#include "rtx/waitdie_rdma.h"
+
+extern size_t current_partition;
+
+namespace nocc {
+
+extern RdmaCtrl *cm;
+
+namespace oltp {
+
+extern __thread util::fast_random   *random_generator;
+
+namespace link {
+
+GraphWorker::GraphWorker(unsigned int id,unsigned long seed,MemDB *db,uint64_t total_ops,
+                         spin_barrier *a, spin_barrier *b,BenchRunner *context):
+    BenchWorker(id,true,seed,total_ops,a,b,context),
+    store_(db),
+    node_chooser_(new ycsb::ScrambledZipfianGenerator(graph_config.total_nodes(),graph_config.zipf_theta,
+                                                      graph_config.zetan))
+{
+}
+
+void GraphWorker::register_callbacks() {
+}
+
+void GraphWorker::check_consistency() {
+}
+
+uint64_t GraphWorker::next_node() {
+  return node_chooser_->next(random_generator[cor_id_]);
+}
+
+txn_result_t GraphWorker::txn_add_link(yield_func_t &yield) {
+  auto &r = random_generator[cor_id_];
+  uint64_t id1 = next_node();
+  int pid1 = NodeToPid(id1);
+
+  rtx_->begin(yield);
+  int idx = rtx_->write(pid1,GRAPH_LIST,id1,sizeof(LinkList),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  LinkList *list = (LinkList *)rtx_->load_write(idx,sizeof(LinkList),yield);
+  if(list == NULL) return txn_result_t(false,73);
+
+  // the link is added at the head, overwriting the oldest link when the slots are used up
+  uint32_t slot = list->head;
+  list->head = (slot + 1) % LinkCapacity(id1);
+  list->version += 1;
+
+  idx = rtx_->write(pid1,GRAPH_LINK,makeLinkKey(id1,slot),sizeof(Link),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  Link *link = (Link *)rtx_->load_write(idx,sizeof(Link),yield);
+  if(link == NULL) return txn_result_t(false,73);
+
+  if(link->visibility == VISIBILITY_HIDDEN) {
+    link->visibility = VISIBILITY_DEFAULT;
+    list->count += 1;
+
+    // the inverse count at the target, which is usually at another partition
+    idx = rtx_->write(NodeToPid(link->id2),GRAPH_LIST,link->id2,sizeof(LinkList),yield);
+    if(idx < 0) return txn_result_t(false,73);
+    LinkList *inv = (LinkList *)rtx_->load_write(idx,sizeof(LinkList),yield);
+    if(inv == NULL) return txn_result_t(false,73);
+    inv->in_count += 1;
+    inv->version += 1;
+  }
+  link->version += 1;
+  link->time = rdtsc();
+  memset(link->data,r.next_char(),sizeof(link->data));
+
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t GraphWorker::txn_update_link(yield_func_t &yield) {
+  auto &r = random_generator[cor_id_];
+  uint64_t id1 = next_node();
+  uint32_t slot = r.next() % LinkCapacity(id1);
+
+  rtx_->begin(yield);
+  int idx = rtx_->write(NodeToPid(id1),GRAPH_LINK,makeLinkKey(id1,slot),sizeof(Link),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  Link *link = (Link *)rtx_->load_write(idx,sizeof(Link),yield);
+  if(link == NULL) return txn_result_t(false,73);
+
+  // updating a missing link is a no-op, as LinkBench counts it
+  if(link->visibility == VISIBILITY_DEFAULT) {
+    link->version += 1;
+    link->time = rdtsc();
+    memset(link->data,r.next_char(),sizeof(link->data));
+  }
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t GraphWorker::txn_delete_link(yield_func_t &yield) {
+  auto &r = random_generator[cor_id_];
+  uint64_t id1 = next_node();
+  int pid1 = NodeToPid(id1);
+  uint32_t slot = r.next() % LinkCapacity(id1);
+
+  rtx_->begin(yield);
+  int idx = rtx_->write(pid1,GRAPH_LINK,makeLinkKey(id1,slot),sizeof(Link),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  Link *link = (Link *)rtx_->load_write(idx,sizeof(Link),yield);
+  if(link == NULL) return txn_result_t(false,73);
+
+  if(link->visibility == VISIBILITY_DEFAULT) {
+    link->visibility = VISIBILITY_HIDDEN;
+    link->version += 1;
+    link->time = rdtsc();
+
+    idx = rtx_->write(pid1,GRAPH_LIST,id1,sizeof(LinkList),yield);
+    if(idx < 0) return txn_result_t(false,73);
+    LinkList *list = (LinkList *)rtx_->load_write(idx,sizeof(LinkList),yield);
+    if(list == NULL) return txn_result_t(false,73);
+    list->count -= 1;
+    list->version += 1;
+
+    idx = rtx_->write(NodeToPid(link->id2),GRAPH_LIST,link->id2,sizeof(LinkList),yield);
+    if(idx < 0) return txn_result_t(false,73);
+    LinkList *inv = (LinkList *)rtx_->load_write(idx,sizeof(LinkList),yield);
+    if(inv == NULL) return txn_result_t(false,73);
+    inv->in_count -= 1;
+    inv->version += 1;
+  }
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t GraphWorker::txn_get_link_list(yield_func_t &yield) {
+  uint64_t id1 = next_node();
+  int pid1 = NodeToPid(id1);
+  uint32_t cap = LinkCapacity(id1);
+
+  rtx_->begin(yield);
+  int idx = rtx_->read(pid1,GRAPH_LIST,id1,sizeof(LinkList),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  LinkList *list = (LinkList *)rtx_->load_read(idx,sizeof(LinkList),yield);
+  if(list == NULL) return txn_result_t(false,73);
+
+  // the latest links are the slots before the head
+  int n = std::min((uint32_t)graph_config.list_limit,cap);
+  int indexes[n];
+  for(int i = 0;i < n;++i) {
+    uint32_t slot = (list->head + cap - 1 - i) % cap;
+    indexes[i] = rtx_->read(pid1,GRAPH_LINK,makeLinkKey(id1,slot),sizeof(Link),yield);
+    if(indexes[i] < 0) return txn_result_t(false,73);
+  }
+  // the hidden links are filtered out, as LinkBench does
+  int found = 0;
+  for(int i = 0;i < n;++i) {
+    Link *link = (Link *)rtx_->load_read(indexes[i],sizeof(Link),yield);
+    if(link == NULL) return txn_result_t(false,73);
+    if(link->visibility == VISIBILITY_DEFAULT)
+      found += 1;
+  }
+  auto ret = rtx_->commit(yield);
+  if(ret) {
+    link_lists_ += 1;
+    listed_links_ += found;
+  }
+  return txn_result_t(ret,73);
+}
+
+txn_result_t GraphWorker::txn_count_link(yield_func_t &yield) {
+  uint64_t id1 = next_node();
+
+  rtx_->begin(yield);
+  int idx = rtx_->read(NodeToPid(id1),GRAPH_LIST,id1,sizeof(LinkList),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  LinkList *list = (LinkList *)rtx_->load_read(idx,sizeof(LinkList),yield);
+  if(list == NULL) return txn_result_t(false,73);
+
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t GraphWorker::txn_get_node(yield_func_t &yield) {
+  uint64_t id = next_node();
+
+  rtx_->begin(yield);
+  int idx = rtx_->read(NodeToPid(id),GRAPH_NODE,id,sizeof(Node),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  Node *node = (Node *)rtx_->load_read(idx,sizeof(Node),yield);
+  if(node == NULL) return txn_result_t(false,73);
+
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t GraphWorker::txn_update_node(yield_func_t &yield) {
+  auto &r = random_generator[cor_id_];
+  uint64_t id = next_node();
+
+  rtx_->begin(yield);
+  int idx = rtx_->write(NodeToPid(id),GRAPH_NODE,id,sizeof(Node),yield);
+  if(idx < 0) return txn_result_t(false,73);
+  Node *node = (Node *)rtx_->load_write(idx,sizeof(Node),yield);
+  if(node == NULL) return txn_result_t(false,73);
+  node->version += 1;
+  node->time = rdtsc();
+  memset(node->data,r.next_char(),sizeof(node->data));
+
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+void GraphWorker::thread_local_init() {
+
+  assert(store_ != NULL);
+  for(uint i = 0;i < server_routine + 1;++i) {
+    // init TXs
+#if defined(OCC_TX)
+#if EM_FASST == 0
+#if ONE_SIDED_READ
+    new_txs_[i] = new rtx::OCCR(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                cm,rdma_sched_,total_partition);
+#else
+    new_txs_[i] = new rtx::OCC(this,store_,rpc_,current_partition,i,-1);
+#endif
+#else // use FaSST's protocol
+#if ONE_SIDED_READ
+    new_txs_[i] = new rtx::OCCFastR(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                    cm,rdma_sched_,total_partition);
+#else
+    new_txs_[i] = new rtx::OCCFast(this,store_,rpc_,current_partition,i,-1);
+#endif
+#endif
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(NOWAIT_TX)
+    new_txs_[i] = new rtx::NOWAIT(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                  cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(SUNDIAL_TX)
+    new_txs_[i] = new rtx::SUNDIAL(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                   cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(MVCC_TX)
+    new_txs_[i] = new rtx::MVCC(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(WAITDIE_TX)
+    new_txs_[i] = new rtx::WAITDIE(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                   cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(CALVIN_TX)
+    new_txs_[i] = new rtx::CALVIN(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                  cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+#else
+    fprintf(stderr,"The graph benchmark runs on the rtx engines only!\n");
+    assert(false);
+#endif
+  }
+#ifdef CALVIN_TX
+  init_calvin_ctx(store_);
+#endif
+  rtx_ = new_txs_[cor_id_];
+  rtx_hook_ = new_txs_[1];
+  init_ro_txs(store_);
+  nocc::rtx::global_lock_manager->thread_local_init();
+} // end func: thread_local_init
+
+workload_desc_vec_t GraphWorker::get_workload() const {
+  return _get_workload();
+}
+
+workload_desc_vec_t GraphWorker::_get_workload() {
+
+  workload_desc_vec_t w;
+  const unsigned *mix = graph_config.mix;
+  unsigned m = 0;
+  for (size_t i = 0; i < GRAPH_TXN_NUM; i++)
+    m += mix[i];
+  ALWAYS_ASSERT(m == 100);
+
+  if(mix[GRAPH_ADD_LINK])
+    w.push_back(workload_desc("AddLink",double(mix[GRAPH_ADD_LINK])/100.0,TxnAddLink));
+  if(mix[GRAPH_UPDATE_LINK])
+    w.push_back(workload_desc("UpdateLink",double(mix[GRAPH_UPDATE_LINK])/100.0,TxnUpdateLink));
+  if(mix[GRAPH_DELETE_LINK])
+    w.push_back(workload_desc("DeleteLink",double(mix[GRAPH_DELETE_LINK])/100.0,TxnDeleteLink));
+  if(mix[GRAPH_GET_LINK_LIST])
+    w.push_back(workload_desc("GetLinkList",double(mix[GRAPH_GET_LINK_LIST])/100.0,TxnGetLinkList));
+  if(mix[GRAPH_COUNT_LINK])
+    w.push_back(workload_desc("CountLink",double(mix[GRAPH_COUNT_LINK])/100.0,TxnCountLink));
+  if(mix[GRAPH_GET_NODE])
+    w.push_back(workload_desc("GetNode",double(mix[GRAPH_GET_NODE])/100.0,TxnGetNode));
+  if(mix[GRAPH_UPDATE_NODE])
+    w.push_back(workload_desc("UpdateNode",double(mix[GRAPH_UPDATE_NODE])/100.0,TxnUpdateNode));
+  return w;
+}
+
+}; // end namespace link
+}; // end namespace oltp
+}; // end namespace nocc
@@ -0,0 +1,94 @@
+#ifndef NOCC_APP_GRAPH_WORKER_
+#define NOCC_APP_GRAPH_WORKER_
+
+#include "graph.h"
+#include "graph_scheme.h"
+
+#include "app/ycsb/ycsb_generator.hpp"
+
+#include "memstore/memdb.h"
+
+#include "framework/bench_worker.h"
+
+namespace nocc {
+  namespace oltp {
+  namespace link {
+
+    /* LinkBench's operations on the social graph */
+    class GraphWorker : public BenchWorker {
+    public:
+      GraphWorker(unsigned int worker_id,unsigned long seed,MemDB *db,uint64_t total_ops,
+                  spin_barrier *a, spin_barrier *b,BenchRunner *context);
+
+      txn_result_t txn_add_link(yield_func_t &yield);
+      txn_result_t txn_update_link(yield_func_t &yield);
+      txn_result_t txn_delete_link(yield_func_t &yield);
+      txn_result_t txn_get_link_list(yield_func_t &yield);
+      txn_result_t txn_count_link(yield_func_t &yield);
+      txn_result_t txn_get_node(yield_func_t &yield);
+      txn_result_t txn_update_node(yield_func_t &yield);
+
+      void exit_report() {
+        LOG(4) << "worker exit.";
+        auto one_second = util::BreakdownTimer::get_one_second_cycle();
+        rtx_hook_->report_statics(one_second);
+        rtx_hook_->report_cycle_statics(one_second);
+        if(link_lists_ > 0)
+          LOG(4) << "visible links per link list: " << (double)listed_links_ / link_lists_;
+      }
+
+      virtual void workload_report() {
+        // record TX's data
+        rtx_hook_->record();
+      }
+
+      virtual workload_desc_vec_t get_workload() const ;
+      static  workload_desc_vec_t _get_workload();
+      virtual void check_consistency();
+      virtual void register_callbacks();
+      virtual void thread_local_init();
+
+    private:
+      MemDB *store_;
+      ycsb::ScrambledZipfianGenerator *node_chooser_ = NULL;
+
+      // the committed get_link_list TXs, and the visible links they returned
+      uint64_t link_lists_   = 0;
+      uint64_t listed_links_ = 0;
+
+      uint64_t next_node();
+
+      static txn_result_t TxnAddLink(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_add_link(yield);
+      }
+
+      static txn_result_t TxnUpdateLink(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_update_link(yield);
+      }
+
+      static txn_result_t TxnDeleteLink(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_delete_link(yield);
+      }
+
+      static txn_result_t TxnGetLinkList(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_get_link_list(yield);
+      }
+
+      static txn_result_t TxnCountLink(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_count_link(yield);
+      }
+
+      static txn_result_t TxnGetNode(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_get_node(yield);
+      }
+
+      static txn_result_t TxnUpdateNode(BenchWorker *w,yield_func_t &yield) {
+        return static_cast<GraphWorker *>(w)->txn_update_node(yield);
+      }
+    };
+
+  }; // end namespace link
+  }; // end namespace oltp
+};
+
+#endif
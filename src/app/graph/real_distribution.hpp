@@ -44,8 +44,11 @@ namespace nocc {
           NODE_WRITE
         };
 
-        void init_link() {
-
+      public:
+        // loads the cdf of the number of links per node, as LinkBench's nlinks distribution
+        void init_link(std::istream &input) {
+          get_cdf(nlinks_cdf_,input);
+          assert(nlinks_cdf_.size() > 0);
         }
 
         uint64_t getNLinks(uint64_t id1,uint64_t start_id,uint64_t end_id) {
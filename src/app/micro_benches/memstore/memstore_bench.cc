@@ -0,0 +1,567 @@
+/**
+ * Micro benchmarks of the memstore data structures, without RDMA or a cluster.
+ *
+ * Each benchmark runs for every given key distribution and thread count, and reports the
+ * throughput and the latency percentiles of its operations:
+ *  hash_get        ClusterHash (the layout of the hash tables) local get
+ *  hash_insert     ClusterHash get_with_insert into an empty table; a single writer, so it only runs at 1 thread
+ *  hash_remote_get ClusterHash remote_traverse with an emulated transport: each node fetched is copied
+ *                  from the table's region after a spin of --remote-delay ns, as a one-sided RDMA read
+ *  btree_insert    MemstoreBPlusTree concurrent Put into an empty tree
+ *  btree_get / btree_seek / btree_scan
+ *                  MemstoreBPlusTree Get, iterator Seek, and Seek + --scan-len Next
+ *  sec_insert / sec_get / sec_scan
+ *                  MemstoreUint64BPlusTree (secondary index) ops on keys (group,primary key), a scan
+ *                  reads up to --scan-len entries of a group, as TPC-C's customer-by-name index
+ *  rtx_scan / rtx_sec_scan
+ *                  RTXIterator seek + scan over the primary / secondary table of a MemDB
+ * The insert benchmarks stop after --keys inserts in total, the others after --duration seconds.
+ *
+ * usage: memstore_bench [--bench b0,b1..] [--threads 1,2,4] [--dist uniform,zipf,seq] [--theta 0.99]
+ *                       [--keys 1000000] [--duration 2] [--scan-len 16] [--remote-delay 2000]
+ *                       [--pin-cpus] [--csv file]
+ */
+
+#include "tx_config.h"
+
+#include "memstore/memdb.h"
+#include "memstore/cluster_chaining.hpp"
+
+#include "rtx/tx_operator.hpp"
+#include "rtx/occ_iterator.hpp"
+
+#include "app/ycsb/ycsb_generator.hpp"
+
+#include "util/util.h"
+#include "util/timer.h"
+#include "util/hdr_histogram.h"
+
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+
+using namespace nocc;
+
+namespace {
+
+#define MB_CLUSTER_NUM 4 // as the hash tables (RHash)
+#define MB_SEC_KLEN    2 // (group, primary key)
+#define MB_GROUP_SIZE  64
+
+typedef drtm::ClusterHash<MemNode,MB_CLUSTER_NUM> hash_t;
+
+enum Dist {
+  DIST_UNIFORM = 0,
+  DIST_ZIPF,
+  DIST_SEQ
+};
+const char *dist_names[] = { "uniform","zipf","seq" };
+
+struct Config {
+  std::vector<std::string> benchs;
+  std::vector<int>  threads   = { 1,2,4,8 };
+  std::vector<Dist> dists     = { DIST_UNIFORM,DIST_ZIPF };
+  double   theta              = 0.99;
+  uint64_t keys               = 1000000;
+  int      duration_s         = 2;
+  int      scan_len           = 16;
+  uint64_t remote_delay_ns    = 2000;
+  bool     pin_cpus           = false;
+  std::string csv;
+} config;
+
+uint64_t second_cycle = 0;
+
+/**
+ * The key chooser of a thread; the items are in [0, n).
+ * The sequential one walks the items, interleaved among the threads.
+ */
+class KeyGen {
+ public:
+  KeyGen(Dist d,uint64_t n,int tid,int nthreads,double zetan)
+      : dist_(d),n_(n),next_(tid),stride_(nthreads),rand_(0xdeadbeef + tid * 7919),
+        uniform_(n),zipf_(n,config.theta,zetan) { }
+
+  inline uint64_t next() {
+    switch(dist_) {
+      case DIST_UNIFORM:
+        return uniform_.next(rand_);
+      case DIST_ZIPF:
+        return zipf_.next(rand_);
+      default: {
+        uint64_t res = next_ % n_;
+        next_ += stride_;
+        return res;
+      }
+    }
+  }
+
+ private:
+  Dist     dist_;
+  uint64_t n_;
+  uint64_t next_;
+  uint64_t stride_;
+  util::fast_random rand_;
+  oltp::ycsb::UniformGenerator uniform_;
+  oltp::ycsb::ScrambledZipfianGenerator zipf_;
+};
+
+// the items are scattered over the key space, so that neighbours in the trees are not neighbours in the items
+inline uint64_t item_to_key(uint64_t item) {
+  return oltp::ycsb::ScrambledZipfianGenerator::fnv_hash64(item) >> 1;
+}
+
+inline void make_sec_key(uint64_t *sec,uint64_t item) {
+  sec[0] = item / MB_GROUP_SIZE;
+  sec[1] = item_to_key(item);
+}
+
+// a value shared by all records; the stores only keep the pointer
+uint64_t dummy_value[8] __attribute__ ((aligned (CACHE_LINE_SZ))) = { 73 };
+
+/**
+ * A benchmark: setup prepares the structures for a run (not timed), op runs one operation of a
+ * thread, adding to aux a bench specific count (e.g. the nodes fetched, or the entries scanned).
+ * The read benchmarks share the structures loaded with all keys, which are built at their first use;
+ * the insert benchmarks build an empty structure per run.
+ */
+struct Bench {
+  std::string name;
+  bool insert;       // stops after config.keys ops in total
+  bool single_writer;
+  std::function<void()> setup;
+  std::function<void(int tid,KeyGen &gen,uint64_t &aux)> op;
+};
+
+struct ThreadCtx {
+  int      tid;
+  uint64_t ops = 0;
+  uint64_t aux = 0;
+  util::HdrHistogram hist;
+} __attribute__ ((aligned (CACHE_LINE_SZ)));
+
+volatile bool running;
+volatile int  ready;
+
+int max_threads = 0;
+
+void spin_ns(uint64_t ns) {
+  uint64_t end = ::rdtsc() + ns * second_cycle / 1000000000;
+  while(::rdtsc() < end)
+    asm volatile("pause" ::: "memory");
+}
+
+/**
+ * The hash table is put in a region, as in the RDMA store buffer, so that it can be "remotely"
+ * traversed at its offset in the region.
+ */
+struct HashRegion {
+  char   *region = NULL;
+  hash_t *hash   = NULL;
+
+  void build(bool fill) {
+    clear();
+    uint64_t size = hash_t::expected_size(config.keys);
+    // leave a page before the table, so that its offset in the region is not 0
+    region = (char *)malloc(size + 4096);
+    assert(region != NULL);
+    hash = new hash_t(config.keys,region + 4096);
+    hash->enable_remote_accesses(region);
+    if(fill) {
+      for(uint64_t i = 0;i < config.keys;++i) {
+        MemNode *n = hash->insert(item_to_key(i));
+        n->value = dummy_value;
+        n->off   = i;
+      }
+    }
+  }
+
+  void clear() {
+    delete hash;
+    free(region);
+    hash = NULL;
+    region = NULL;
+  }
+};
+
+HashRegion loaded_hash, fresh_hash;
+
+// B+tree nodes are never freed, so the fresh trees of the insert runs are leaked
+MemstoreBPlusTree       *loaded_btree = NULL, *fresh_btree = NULL;
+MemstoreUint64BPlusTree *loaded_sec   = NULL, *fresh_sec   = NULL;
+std::vector<Memstore::Iterator *> btree_iters, sec_iters;
+
+// the RTX iterators only use the tables of the TX's MemDB
+MemDB         *db = NULL;
+rtx::TXOpBase rtx_base;
+std::vector<rtx::RTXIterator *> rtx_iters, rtx_sec_iters;
+
+void load_hash() {
+  if(loaded_hash.hash == NULL)
+    loaded_hash.build(true);
+}
+
+void load_btree() {
+  if(loaded_btree != NULL) return;
+  loaded_btree = new MemstoreBPlusTree();
+  for(uint64_t i = 0;i < config.keys;++i)
+    loaded_btree->Put(item_to_key(i),dummy_value);
+  for(int i = 0;i < max_threads;++i)
+    btree_iters.push_back(loaded_btree->GetIterator());
+}
+
+void load_sec() {
+  if(loaded_sec != NULL) return;
+  loaded_sec = new MemstoreUint64BPlusTree(MB_SEC_KLEN);
+  uint64_t key[MB_SEC_KLEN];
+  for(uint64_t i = 0;i < config.keys;++i) {
+    make_sec_key(key,i);
+    loaded_sec->Put((uint64_t)key,(uint64_t *)item_to_key(i));
+  }
+  for(int i = 0;i < max_threads;++i)
+    sec_iters.push_back(loaded_sec->GetIterator());
+}
+
+// a MemDB with the B+tree as its table 0 (as AddSchema's TAB_BTREE), and the secondary index as index 0
+void load_db() {
+  if(db != NULL) return;
+  load_btree();
+  load_sec();
+  db = new MemDB();
+  db->stores_[0] = loaded_btree;
+  db->_indexs[0] = loaded_sec;
+  rtx_base.db_   = db;
+  for(int i = 0;i < max_threads;++i) {
+    rtx_iters.push_back(new rtx::RTXIterator(&rtx_base,0));
+    rtx_sec_iters.push_back(new rtx::RTXIterator(&rtx_base,0,true));
+  }
+}
+
+std::vector<Bench> all_benchs() {
+  std::vector<Bench> res;
+
+  res.push_back({ "hash_get",false,false,load_hash,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            MemNode *n = loaded_hash.hash->get(item_to_key(gen.next()));
+            aux += (n != NULL && n->value != NULL);
+          } });
+
+  res.push_back({ "hash_insert",true,true,
+          []() { fresh_hash.build(false); },
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            MemNode *n = fresh_hash.hash->get_with_insert(item_to_key(gen.next()));
+            n->value = dummy_value;
+          } });
+
+  res.push_back({ "hash_remote_get",false,false,load_hash,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            hash_t::HeaderNode node;
+            MemNode val;
+            char *region = loaded_hash.region;
+            auto off = loaded_hash.hash->remote_traverse(item_to_key(gen.next()),&node,(char *)&val,
+                                                         [region,&aux](uint64_t off,char *buf,int size) {
+                                                           spin_ns(config.remote_delay_ns);
+                                                           memcpy(buf,region + off,size);
+                                                           aux += 1;
+                                                         });
+            assert(off != 0);
+          } });
+
+  res.push_back({ "btree_insert",true,false,
+          []() { fresh_btree = new MemstoreBPlusTree(); },
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            fresh_btree->Put(item_to_key(gen.next()),dummy_value);
+          } });
+
+  res.push_back({ "btree_get",false,false,load_btree,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            MemNode *n = loaded_btree->Get(item_to_key(gen.next()));
+            assert(n != NULL);
+          } });
+
+  res.push_back({ "btree_seek",false,false,load_btree,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            auto it = btree_iters[tid];
+            it->Seek(item_to_key(gen.next()));
+            aux += it->Valid();
+          } });
+
+  res.push_back({ "btree_scan",false,false,load_btree,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            auto it = btree_iters[tid];
+            it->Seek(item_to_key(gen.next()));
+            for(int i = 0;i < config.scan_len && it->Valid();++i) {
+              aux += 1;
+              it->Next();
+            }
+          } });
+
+  res.push_back({ "sec_insert",true,false,
+          []() { fresh_sec = new MemstoreUint64BPlusTree(MB_SEC_KLEN); },
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            uint64_t key[MB_SEC_KLEN];
+            uint64_t item = gen.next();
+            make_sec_key(key,item);
+            fresh_sec->Put((uint64_t)key,(uint64_t *)item_to_key(item));
+          } });
+
+  res.push_back({ "sec_get",false,false,load_sec,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            uint64_t key[MB_SEC_KLEN];
+            make_sec_key(key,gen.next());
+            MemNode *n = loaded_sec->Get((uint64_t)key);
+            assert(n != NULL);
+          } });
+
+  res.push_back({ "sec_scan",false,false,load_sec,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            auto it = sec_iters[tid];
+            uint64_t key[MB_SEC_KLEN] = { gen.next() / MB_GROUP_SIZE,0 };
+            it->Seek((uint64_t)key);
+            for(int i = 0;i < config.scan_len && it->Valid();++i) {
+              if(((uint64_t *)it->Key())[0] != key[0])
+                break;
+              aux += 1;
+              it->Next();
+            }
+          } });
+
+  res.push_back({ "rtx_scan",false,false,load_db,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            auto it = rtx_iters[tid];
+            it->seek(item_to_key(gen.next()));
+            for(int i = 0;i < config.scan_len && it->valid();++i) {
+              aux += (it->value() != NULL);
+              it->next();
+            }
+          } });
+
+  res.push_back({ "rtx_sec_scan",false,false,load_db,
+          [](int tid,KeyGen &gen,uint64_t &aux) {
+            auto it = rtx_sec_iters[tid];
+            uint64_t key[MB_SEC_KLEN] = { gen.next() / MB_GROUP_SIZE,0 };
+            it->seek((uint64_t)key);
+            for(int i = 0;i < config.scan_len && it->valid();++i) {
+              if(((uint64_t *)it->key())[0] != key[0])
+                break;
+              aux += (it->value() != NULL);
+              it->next();
+            }
+          } });
+
+  return res;
+}
+
+struct RunArg {
+  Bench    *bench;
+  ThreadCtx *ctx;
+  Dist      dist;
+  int       nthreads;
+  uint64_t  quota;  // max ops of the thread
+  double    zetan;
+};
+
+void *run_thread(void *a) {
+  RunArg *arg = (RunArg *)a;
+  ThreadCtx &ctx = *(arg->ctx);
+  if(config.pin_cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(ctx.tid % sysconf(_SC_NPROCESSORS_ONLN),&set);
+    pthread_setaffinity_np(pthread_self(),sizeof(set),&set);
+  }
+  KeyGen gen(arg->dist,config.keys,ctx.tid,arg->nthreads,arg->zetan);
+
+  __sync_fetch_and_add(&ready,1);
+  while(!running)
+    asm volatile("pause" ::: "memory");
+
+  while(running && ctx.ops < arg->quota) {
+    uint64_t start = ::rdtsc();
+    arg->bench->op(ctx.tid,gen,ctx.aux);
+    ctx.hist.record(::rdtsc() - start);
+    ctx.ops += 1;
+  }
+  return NULL;
+}
+
+void report(FILE *csv,const Bench &b,Dist d,int nthreads,std::vector<ThreadCtx> &ctxs,uint64_t cycles) {
+  util::HdrHistogram hist;
+  uint64_t ops = 0, aux = 0;
+  for(auto &c : ctxs) {
+    ops += c.ops;
+    aux += c.aux;
+    for(int i = 0;i < util::HdrHistogram::kBuckets;++i) {
+      if(c.hist.count(i) != 0)
+        hist.add(i,c.hist.count(i));
+    }
+  }
+  double secs = (double)cycles / second_cycle;
+  double us   = second_cycle / 1000000.0;
+  double tput = ops / secs;
+  double p50  = hist.percentile(50) / us, p99 = hist.percentile(99) / us;
+  double p999 = hist.percentile(99.9) / us, max = hist.max() / us;
+  // for the remote gets, aux counts the fetched nodes; for the scans, the entries read
+  double aux_per_op = ops == 0 ? 0 : (double)aux / ops;
+
+  fprintf(stdout,"[memstore] %-16s %-8s t %-3d: %10.3f Mops/s, p50 %.3f us, p99 %.3f us, p99.9 %.3f us, max %.3f us, aux/op %.2f\n",
+          b.name.c_str(),dist_names[d],nthreads,tput / 1000000.0,p50,p99,p999,max,aux_per_op);
+  if(csv != NULL) {
+    fprintf(csv,"%s,%s,%d,%lu,%f,%f,%f,%f,%f,%f\n",
+            b.name.c_str(),dist_names[d],nthreads,ops,tput,p50,p99,p999,max,aux_per_op);
+    fflush(csv);
+  }
+}
+
+void run(Bench &b,Dist d,int nthreads,double zetan,FILE *csv) {
+  if(b.single_writer && nthreads > 1) {
+    fprintf(stdout,"[memstore] %-16s %-8s t %-3d: skipped, single writer\n",b.name.c_str(),dist_names[d],nthreads);
+    return;
+  }
+  b.setup();
+
+  std::vector<ThreadCtx> ctxs(nthreads);
+  std::vector<RunArg>    args(nthreads);
+  std::vector<pthread_t> ths(nthreads);
+  uint64_t quota = b.insert ? (config.keys + nthreads - 1) / nthreads : UINT64_MAX;
+
+  running = false;
+  ready   = 0;
+  for(int i = 0;i < nthreads;++i) {
+    ctxs[i].tid = i;
+    args[i] = { &b,&ctxs[i],d,nthreads,quota,zetan };
+    pthread_create(&ths[i],NULL,run_thread,&args[i]);
+  }
+  while(ready < nthreads)
+    usleep(1000);
+
+  uint64_t start = ::rdtsc();
+  running = true;
+  if(!b.insert) {
+    sleep(config.duration_s);
+    running = false;
+  }
+  for(int i = 0;i < nthreads;++i)
+    pthread_join(ths[i],NULL);
+  uint64_t cycles = ::rdtsc() - start;
+  running = false;
+
+  report(csv,b,d,nthreads,ctxs,cycles);
+  if(b.name == "hash_insert")
+    fresh_hash.clear();
+}
+
+template <typename T,typename F>
+std::vector<T> parse_list(const char *s,F f) {
+  std::vector<T> res;
+  std::stringstream ss(s);
+  std::string item;
+  while(std::getline(ss,item,','))
+    if(!item.empty())
+      res.push_back(f(item));
+  return res;
+}
+
+Dist parse_dist(const std::string &s) {
+  for(int i = 0;i <= DIST_SEQ;++i)
+    if(s == dist_names[i])
+      return (Dist)i;
+  fprintf(stderr,"unknown key distribution %s\n",s.c_str());
+  exit(-1);
+}
+
+} // anonymous namespace
+
+int main(int argc,char **argv) {
+
+  static struct option long_options[] = {
+    {"bench"        , required_argument , 0 , 'b'},
+    {"threads"      , required_argument , 0 , 't'},
+    {"dist"         , required_argument , 0 , 'd'},
+    {"theta"        , required_argument , 0 , 'z'},
+    {"keys"         , required_argument , 0 , 'n'},
+    {"duration"     , required_argument , 0 , 's'},
+    {"scan-len"     , required_argument , 0 , 'l'},
+    {"remote-delay" , required_argument , 0 , 'r'},
+    {"pin-cpus"     , no_argument       , 0 , 'p'},
+    {"csv"          , required_argument , 0 , 'c'},
+    {0, 0, 0, 0}
+  };
+  while(1) {
+    int option_index = 0;
+    int c = getopt_long(argc,argv,"b:t:d:z:n:s:l:r:pc:",long_options,&option_index);
+    if(c == -1)
+      break;
+    switch(c) {
+      case 'b':
+        config.benchs = parse_list<std::string>(optarg,[](const std::string &s) { return s; });
+        break;
+      case 't':
+        config.threads = parse_list<int>(optarg,[](const std::string &s) { return std::stoi(s); });
+        break;
+      case 'd':
+        config.dists = parse_list<Dist>(optarg,parse_dist);
+        break;
+      case 'z':
+        config.theta = strtod(optarg,NULL);
+        break;
+      case 'n':
+        config.keys = strtoull(optarg,NULL,10);
+        break;
+      case 's':
+        config.duration_s = atoi(optarg);
+        break;
+      case 'l':
+        config.scan_len = atoi(optarg);
+        break;
+      case 'r':
+        config.remote_delay_ns = strtoull(optarg,NULL,10);
+        break;
+      case 'p':
+        config.pin_cpus = true;
+        break;
+      case 'c':
+        config.csv = optarg;
+        break;
+      default:
+        fprintf(stderr,"usage: %s [--bench b0,b1..] [--threads 1,2,4] [--dist uniform,zipf,seq] [--theta 0.99] "
+                "[--keys n] [--duration s] [--scan-len n] [--remote-delay ns] [--pin-cpus] [--csv file]\n",argv[0]);
+        return -1;
+    }
+  }
+
+  second_cycle = util::BreakdownTimer::get_one_second_cycle();
+
+  FILE *csv = NULL;
+  if(!config.csv.empty()) {
+    csv = fopen(config.csv.c_str(),"w");
+    assert(csv != NULL);
+    fprintf(csv,"bench,dist,threads,ops,ops_per_s,p50_us,p99_us,p999_us,max_us,aux_per_op\n");
+  }
+
+  // zeta of the key space is O(n), so it is computed once
+  double zetan = oltp::ycsb::ZipfianGenerator::zeta(0,config.keys,config.theta,0);
+
+  max_threads = *std::max_element(config.threads.begin(),config.threads.end());
+  auto benchs = all_benchs();
+  fprintf(stdout,"[memstore] %lu keys, theta %f, scan length %d, remote delay %lu ns\n",
+          config.keys,config.theta,config.scan_len,config.remote_delay_ns);
+  for(auto &b : benchs) {
+    if(!config.benchs.empty() &&
+       std::find(config.benchs.begin(),config.benchs.end(),b.name) == config.benchs.end())
+      continue;
+    for(auto d : config.dists)
+      for(auto t : config.threads)
+        run(b,d,t,zetan,csv);
+  }
+  if(csv != NULL)
+    fclose(csv);
+  return 0;
+}
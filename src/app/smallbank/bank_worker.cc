@@ -124,13 +124,57 @@ void GetTwoAccount(util::fast_random &r,
 BankWorker::BankWorker(unsigned int id,unsigned long seed,MemDB *db,uint64_t total_ops,
                        spin_barrier *a, spin_barrier *b,BenchRunner *context):
     BenchWorker(id,true,seed,total_ops,a,b,context),
-    store_(db)
+    store_(db),
+    skew_(skew_config.enabled ? new SkewGenerator(NumAccounts(),AcctToPid,current_partition,total_partition,
+                                                   [this] { return input_time_s(); }) : NULL)
 {
   // clear timer states
   compute_timer.report();
   send_timer.report();
 }
 
+void BankWorker::PickAccount(uint64_t *acct_id) {
+  util::fast_random &r = random_generator[cor_id_];
+  if(skew_ == NULL) {
+    GetAccount(r,acct_id);
+    return;
+  }
+  if(skew_config.cross_ratio < 0) {
+    *acct_id = skew_->item(r);
+    return;
+  }
+  int pid = current_partition;
+  if(skew_->cross_partition(r))
+    skew_->remote_partitions(r,1,&pid);
+  *acct_id = skew_->item(r,pid);
+}
+
+void BankWorker::PickTwoAccount(uint64_t *acct_id_0,uint64_t *acct_id_1) {
+  util::fast_random &r = random_generator[cor_id_];
+  if(skew_ == NULL) {
+    GetTwoAccount(r,acct_id_0,acct_id_1);
+    return;
+  }
+  if(skew_config.cross_ratio < 0) {
+    *acct_id_0 = skew_->item(r);
+    do {
+      *acct_id_1 = skew_->item(r);
+    } while(*acct_id_1 == *acct_id_0);
+    return;
+  }
+  int pids[2] = { (int)current_partition,(int)current_partition };
+  if(skew_->cross_partition(r) && skew_->remote_partitions(r,2,pids) == 1) {
+    // one remote partition, the other account is local
+    pids[1] = current_partition;
+    if(r.next() % 2)
+      std::swap(pids[0],pids[1]);
+  }
+  *acct_id_0 = skew_->item(r,pids[0]);
+  do {
+    *acct_id_1 = skew_->item(r,pids[1]);
+  } while(*acct_id_1 == *acct_id_0);
+}
+
 void BankWorker::register_callbacks() {
 }
 
@@ -531,6 +575,10 @@ void BankWorker::thread_local_init() {
                                    cm,rdma_sched_,total_partition);
     new_txs_[i]->set_logger(new_logger_);
     new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(CALVIN_TX)
+    new_txs_[i] = new rtx::CALVIN(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                  cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
 #elif defined(FARM)
     txs_[i] = new DBFarm(cm,rdma_sched_,store_,worker_id_,rpc_,i);
 #elif defined(SI_TX)
@@ -540,10 +588,14 @@ void BankWorker::thread_local_init() {
     assert(false);
 #endif
   }
+#ifdef CALVIN_TX
+  init_calvin_ctx(store_);
+#endif
   /* init local tx so that it is not a null value */
   tx_ = txs_[cor_id_];
   rtx_ = new_txs_[cor_id_];
   rtx_hook_ = new_txs_[1];
+  init_ro_txs(store_);
   //routine_1_tx_ = txs_[1]; // used for report
   nocc::rtx::global_lock_manager->thread_local_init();
 } // end func: thread_local_init
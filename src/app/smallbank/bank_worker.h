@@ -149,6 +149,12 @@ class BankWorker : public BenchWorker {
   MemDB *store_;
   std::map<int,int> mac_hotmap;
 
+  // the accounts of a TX: by the skewed workload if configured (see skew_generator.h),
+  // otherwise by GetAccount/GetTwoAccount
+  SkewGenerator *skew_;
+  void PickAccount(uint64_t *acct_id);
+  void PickTwoAccount(uint64_t *acct_id_0,uint64_t *acct_id_1);
+
   static txn_result_t TxnSendPayment(BenchWorker *w,yield_func_t &yield) {
 #if ENABLE_TXN_API
     txn_result_t r = static_cast<BankWorker *>(w)->txn_sp_new_api(yield);
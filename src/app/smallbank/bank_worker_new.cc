@@ -79,7 +79,7 @@ txn_result_t BankWorker::txn_wc_new(yield_func_t &yield) {
   float amount = 5.0; //from original code
 
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&id);
+  PickAccount(&id);
   int pid = AcctToPid(id);
 #if EM_FASST == 0
   rtx_->read<SAV,savings::value>(pid,id,yield);
@@ -111,7 +111,7 @@ txn_result_t BankWorker::txn_dc_new(yield_func_t &yield) {
   float amount = 1.3;
 retry:
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&id);
+  PickAccount(&id);
   int pid = AcctToPid(id);
 
 #if EM_FASST == 0
@@ -152,7 +152,7 @@ txn_result_t BankWorker::txn_ts_new(yield_func_t &yield) {
 
   float amount   = 20.20; //from original code
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&id);
+  PickAccount(&id);
   int pid = AcctToPid(id);
 #if EM_FASST == 0
   rtx_->read<SAV,savings::value>(pid,id,yield);
@@ -173,7 +173,7 @@ txn_result_t BankWorker::txn_balance_new(yield_func_t &yield) {
   rtx_->begin(yield);
 
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&(id));
+  PickAccount(&(id));
   int pid = AcctToPid(id);
 
   double res = 0.0;
@@ -194,7 +194,7 @@ txn_result_t BankWorker::txn_amal_new(yield_func_t &yield) {
   rtx_->begin(yield);
 
   uint64_t id0,id1;
-  GetTwoAccount(random_generator[cor_id_],&id0,&id1);
+  PickTwoAccount(&id0,&id1);
 
   int pid0 = AcctToPid(id0);
   int pid1 = AcctToPid(id1),idx1;
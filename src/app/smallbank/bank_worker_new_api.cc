@@ -77,7 +77,7 @@ txn_result_t BankWorker::txn_sp_new_api(yield_func_t &yield) {
   rtx_->begin(yield);
 
   uint64_t id0 = 100,id1 = 101;
-  GetTwoAccount(random_generator[cor_id_],&id0,&id1);
+  PickTwoAccount(&id0,&id1);
   
   float amount = 5.0;
 
@@ -117,7 +117,7 @@ txn_result_t BankWorker::txn_wc_new_api(yield_func_t &yield) {
   float amount = 5.0; //from original code
 
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&id);
+  PickAccount(&id);
   // uint64_t id = 100;
   int pid = AcctToPid(id);
 
@@ -149,7 +149,7 @@ txn_result_t BankWorker::txn_dc_new_api(yield_func_t &yield) {
   float amount = 1.3;
 retry:
   uint64_t id = 100;
-  GetAccount(random_generator[cor_id_],&id);
+  PickAccount(&id);
   int pid = AcctToPid(id);
 
   index = rtx_->write(pid,CHECK,id,sizeof(checking::value),yield);
@@ -186,7 +186,7 @@ txn_result_t BankWorker::txn_ts_new_api(yield_func_t &yield) {
 
   float amount   = 20.20; //from original code
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&id);
+  PickAccount(&id);
   int pid = AcctToPid(id);
   index = rtx_->write(pid,SAV,id,sizeof(savings::value),yield);
   if (index < 0) return txn_result_t(false,73);
@@ -200,23 +200,28 @@ txn_result_t BankWorker::txn_ts_new_api(yield_func_t &yield) {
 txn_result_t BankWorker::txn_balance_new_api(yield_func_t &yield) {
   int index = -1;
 
-  rtx_->begin(yield);
+#if RO_SNAPSHOT
+  auto rtx = ro_txs_[cor_id_];
+#else
+  auto rtx = rtx_;
+#endif
+  rtx->begin(yield);
 
   uint64_t id;
-  GetAccount(random_generator[cor_id_],&(id));
+  PickAccount(&(id));
   int pid = AcctToPid(id);
 
   double res = 0.0;
-  index = rtx_->read(pid,CHECK,id,sizeof(checking::value),yield);
+  index = rtx->read(pid,CHECK,id,sizeof(checking::value),yield);
   if (index < 0) return txn_result_t(false,73);
-  index = rtx_->read(pid,SAV,id,sizeof(savings::value),yield);
+  index = rtx->read(pid,SAV,id,sizeof(savings::value),yield);
   if (index < 0) return txn_result_t(false,73);
 
-  auto cv = (checking::value*)rtx_->load_read(0,sizeof(checking::value),yield);
-  auto sv = (savings::value*)rtx_->load_read(1,sizeof(savings::value),yield);
+  auto cv = (checking::value*)rtx->load_read(0,sizeof(checking::value),yield);
+  auto sv = (savings::value*)rtx->load_read(1,sizeof(savings::value),yield);
   res = cv->c_balance + sv->s_balance;
 
-  bool ret = rtx_->commit(yield);
+  bool ret = rtx->commit(yield);
   return txn_result_t(ret,(uint64_t)0);
 }
 
@@ -227,7 +232,7 @@ txn_result_t BankWorker::txn_amal_new_api(yield_func_t &yield) {
   rtx_->begin(yield);
 
   uint64_t id0,id1;
-  GetTwoAccount(random_generator[cor_id_],&id0,&id1);
+  PickTwoAccount(&id0,&id1);
 
   int pid0 = AcctToPid(id0);
   int pid1 = AcctToPid(id1),idx1;
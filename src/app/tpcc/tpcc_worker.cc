@@ -43,6 +43,11 @@ extern unsigned g_txn_workload_mix[5];
 extern int g_new_order_remote_item_pct;
 extern int g_mico_dist_num;
 
+// the items of the skew generator are the warehouses, from 0
+static int SkewItemToPartition(uint64_t item) {
+  return WarehouseToPartition(item + 1);
+}
+
 // some debug info
 //std::map<uint64_t,int> order_num;
 
@@ -52,7 +57,10 @@ TpccWorker::TpccWorker(unsigned int worker_id,unsigned long seed,
     : TpccMixin(store),
       BenchWorker(worker_id,true,seed,total_ops,a,b,context),
       warehouse_id_start_(warehouse_id_start),
-      warehouse_id_end_(warehouse_id_end)
+      warehouse_id_end_(warehouse_id_end),
+      skew_(skew_config.enabled ? new SkewGenerator(NumWarehouses(),SkewItemToPartition,
+                                                    current_partition,total_partition,
+                                                    [this] { return input_time_s(); }) : NULL)
 {
   assert(NumWarehouses() <= 1024);
   // init last warehouse id
@@ -66,6 +74,28 @@ TpccWorker::TpccWorker(unsigned int worker_id,unsigned long seed,
   INIT_LAT_VARS(read);
 }
 
+uint TpccWorker::PickSupplierWarehouse() {
+  if(skew_ != NULL)
+    return skew_->item(random_generator[cor_id_]) + 1;
+  return RandomNumber(random_generator[cor_id_], 1, NumWarehouses());
+}
+
+/**
+ * Pick the supplier warehouses of the remote stocks of a NewOrder, if the skewed workload
+ * decides the cross-partition ratio: one stock at each remote partition touched.
+ * Return -1 if it does not, then each stock is remote by g_new_order_remote_item_pct.
+ */
+int TpccWorker::PickSkewedRemoteWarehouses(int max,int *whs) {
+  if(skew_ == NULL || skew_config.cross_ratio < 0)
+    return -1;
+  if(!skew_->cross_partition(random_generator[cor_id_]))
+    return 0;
+  int num = skew_->remote_partitions(random_generator[cor_id_],max,whs);
+  for(int i = 0;i < num;++i)
+    whs[i] = skew_->item(random_generator[cor_id_],whs[i]) + 1;
+  return num;
+}
+
 void TpccWorker::register_callbacks() {
   /* register super stock level callback */
   //ro_callbacks_[TX_STOCK_LEVEL] = bind(&TpccWorker::stock_level_piece,this,_1,_2,_3,_4);
@@ -143,6 +173,12 @@ void TpccWorker::thread_local_init() {
       new_txs_[i]->set_logger(new_logger_);
       new_txs_[i]->set_two_phase_committer(two_phase_committer_);
     }
+#elif defined(CALVIN_TX)
+    if(txs_[i]  == NULL) {
+      new_txs_[i] = new rtx::CALVIN(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                    cm,rdma_sched_,total_partition);
+      new_txs_[i]->set_logger(new_logger_);
+    }
 #elif defined(SI_TX)
     txs_[i] = new DBSI(store_,worker_id_,rpc_,i);
 #elif defined(FARM)
@@ -153,8 +189,12 @@ void TpccWorker::thread_local_init() {
 #endif
   nocc::rtx::global_lock_manager[i].thread_local_init();
   }
+#ifdef CALVIN_TX
+  init_calvin_ctx(store_);
+#endif
   //routine_1_tx_ = txs_[1]; // used for report
   rtx_hook_ = new_txs_[1];
+  init_ro_txs(store_);
   /* init local tx so that it is not a null value */
   tx_ = txs_[cor_id_];
 
@@ -477,7 +517,7 @@ txn_result_t TpccWorker::txn_payment(yield_func_t &yield) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
       assert(false);
     }
-#elif  defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif  defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
     DBTXIterator iter((DBTX *)tx_,CUST_INDEX,false);
     if(tx_ != NULL) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -649,7 +689,7 @@ txn_result_t TpccWorker::txn_delivery(yield_func_t &yield) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
       assert(false);
     }
-#elif  defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif  defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
     DBTXIterator iter((DBTX *)tx_,NEWO);
     if(tx_ != NULL) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -706,7 +746,7 @@ txn_result_t TpccWorker::txn_delivery(yield_func_t &yield) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
       assert(false);
     }
-#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
     DBTXIterator iter1((DBTX *)tx_,ORLI);
     if(tx_ != NULL) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -799,7 +839,7 @@ txn_result_t TpccWorker::txn_stock_level(yield_func_t &yield) {
     fprintf(stderr, "rtx_ should be used instead of tx_");
     assert(false);
   }
-#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
   DBTXIterator iter((DBTX *)tx_,ORLI);
   if(tx_ != NULL) {
     fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -953,7 +993,7 @@ txn_result_t TpccWorker::txn_super_stock_level(yield_func_t &yield) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
       assert(false);
     }
-#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
     DBTXIterator iter((DBTX *)tx_,ORLI);
     if(tx_ != NULL) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -1065,7 +1105,7 @@ txn_result_t TpccWorker::txn_order_status(yield_func_t &yield) {
     fprintf(stderr, "rtx_ should be used instead of tx_");
     assert(false);
   }
-#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif defined(NOWAIT_TX) || defined(WAITDIE_TX)  || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
   DBTXIterator citer((DBTX *)tx_,CUST_INDEX,false);
   if(tx_ != NULL) {
     fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -1134,7 +1174,7 @@ txn_result_t TpccWorker::txn_order_status(yield_func_t &yield) {
     fprintf(stderr, "rtx_ should be used instead of tx_");
     assert(false);
   }
-#elif defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
   DBTXIterator iter((DBTX *)tx_,ORDER_INDEX);
   if(tx_ != NULL) {
     fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -1289,7 +1329,7 @@ void TpccWorker::check_consistency() {
       fprintf(stderr, "rtx_ should be used instead of tx_");
       assert(false);
     }
-#elif defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
     DBTXIterator iter((DBTX *)tx_,NEWO);
     if(tx_ != NULL) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
@@ -1636,7 +1676,7 @@ txn_result_t TpccWorker::txn_payment_naive(yield_func_t &yield) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
       assert(false);
     }
-#elif  defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+#elif  defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX) || defined(CALVIN_TX)
     DBTXIterator iter((DBTX *)tx_,CUST_INDEX,false);
     if(tx_ != NULL) {
       fprintf(stderr, "rtx_ should be used instead of tx_");
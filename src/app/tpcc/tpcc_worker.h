@@ -128,6 +128,11 @@ class TpccWorker : public TpccMixin, public BenchWorker {
  private:
   const uint warehouse_id_start_ ;
   const uint warehouse_id_end_ ;
+
+  // the supplier warehouses of the remote stocks of a skewed workload (see skew_generator.h)
+  SkewGenerator *skew_;
+  uint PickSupplierWarehouse();
+  int  PickSkewedRemoteWarehouses(int max,int *whs);
   uint64_t last_no_o_ids_[1024][10];
   LAT_VARS(read);
 
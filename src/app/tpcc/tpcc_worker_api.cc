@@ -14,6 +14,7 @@
 
 #include "rtx/occ_rdma.h"
 #include "rtx/occ_variants.hpp"
+#include "rtx/occ_iterator.hpp"
 
 extern __thread RemoteHelper *remote_helper;
 
@@ -55,8 +56,46 @@ txn_result_t TpccWorker::txn_delivery_api(yield_func_t &yield) {
 }
 
 txn_result_t TpccWorker::txn_stock_level_api(yield_func_t &yield) {
+#if RO_SNAPSHOT
+  auto rtx = ro_txs_[cor_id_];
+
+  const uint warehouse_id = PickWarehouseId(random_generator[cor_id_], warehouse_id_start_, warehouse_id_end_);
+  const uint threshold = RandomNumber(random_generator[cor_id_], 10, 20);
+  const uint districtID = RandomNumber(random_generator[cor_id_], 1, NumDistrictsPerWarehouse());
+
+  rtx->begin(yield);
+
+  uint64_t d_key = makeDistrictKey(warehouse_id, districtID);
+  auto idx = rtx->read<DIST,district::value>(current_partition,d_key,yield);
+  if(idx < 0) return txn_result_t(false,73);
+  uint64_t cur_next_o_id = ((district::value *)rtx->load_read(idx,sizeof(district::value),yield))->d_next_o_id;
+
+  const int32_t lower = cur_next_o_id >= STOCK_LEVEL_ORDER_COUNT ? (cur_next_o_id - STOCK_LEVEL_ORDER_COUNT) : 0;
+  uint64_t start = makeOrderLineKey(warehouse_id, districtID, lower, 0);
+  uint64_t end   = makeOrderLineKey(warehouse_id, districtID, cur_next_o_id, 0);
+
+  // order lines are never updated in place, so they are scanned without entering the read-set
+  std::set<uint64_t> s_keys;
+  rtx::RTXIterator iter(rtx,ORLI);
+  for(iter.seek(start);iter.valid() && iter.key() < end;iter.next()) {
+    order_line::value *v_ol = (order_line::value *)(iter.value() + store_->_schemas[ORLI].meta_len);
+    s_keys.insert(makeStockKey(warehouse_id, v_ol->ol_i_id));
+  }
+
+  int low_stocks = 0;
+  for(auto s_key : s_keys) {
+    idx = rtx->read<STOC,stock::value>(current_partition,s_key,yield);
+    if(idx < 0) return txn_result_t(false,73);
+    stock::value *v_s = (stock::value *)rtx->load_read(idx,sizeof(stock::value),yield);
+    if(v_s->s_quantity < int(threshold))
+      low_stocks += 1;
+  }
+  bool ret = rtx->commit(yield);
+  return txn_result_t(ret,low_stocks);
+#else
   assert(false); // not implemented yet
   return txn_result_t(true,10);
+#endif
 }
 
 txn_result_t TpccWorker::txn_super_stock_level_api(yield_func_t &yield) {
@@ -65,8 +104,83 @@ txn_result_t TpccWorker::txn_super_stock_level_api(yield_func_t &yield) {
 }
 
 txn_result_t TpccWorker::txn_order_status_api(yield_func_t &yield) {
+#if RO_SNAPSHOT
+  auto rtx = ro_txs_[cor_id_];
+
+  const uint warehouse_id = PickWarehouseId(random_generator[cor_id_], warehouse_id_start_, warehouse_id_end_);
+  const uint districtID = RandomNumber(random_generator[cor_id_], 1, NumDistrictsPerWarehouse());
+  uint customerID = GetCustomerId(random_generator[cor_id_]);
+
+  if(RandomNumber(random_generator[cor_id_], 1, 100) <= 60) {
+    // the customer by last name: the middle one of the matches in the local CUST_INDEX
+    uint8_t lastname_buf[CustomerLastNameMaxSize + 1];
+    NDB_MEMSET(lastname_buf, 0, sizeof(lastname_buf));
+    GetNonUniformCustomerLastNameRun(lastname_buf, random_generator[cor_id_]);
+
+    static const std::string zeros(16, 0);
+    static const std::string ones(16, (char)255);
+    std::string clast((const char *)lastname_buf, 16);
+    uint64_t c_start = makeCustomerIndex(warehouse_id, districtID, clast, zeros);
+    uint64_t c_end   = makeCustomerIndex(warehouse_id, districtID, clast, ones);
+
+    std::vector<uint64_t> c_keys;
+    Memstore::Iterator *citer = store_->stores_[CUST_INDEX]->GetIterator();
+    for(citer->Seek(c_start);citer->Valid() && compareCustomerIndex(citer->Key(), c_end);citer->Next()) {
+      if(citer->CurNode()->value == NULL)
+        continue;
+      uint64_t *prikeys = (uint64_t *)((char *)(citer->CurNode()->value) + store_->_schemas[CUST_INDEX].meta_len);
+      for(uint64_t i = 1;i <= prikeys[0];++i)
+        c_keys.push_back(prikeys[i]);
+    }
+    delete citer;
+    if(!c_keys.empty())
+      customerID = static_cast<uint>(c_keys[(c_keys.size() + 1) / 2 - 1] << 32 >> 32);
+  }
+  uint64_t c_key = makeCustomerKey(warehouse_id, districtID, customerID);
+
+  rtx->begin(yield);
+
+  auto idx = rtx->read<CUST,customer::value>(current_partition,c_key,yield);
+  if(idx < 0) return txn_result_t(false,73);
+
+  // find the latest order of the customer
+  uint64_t start = makeOrderIndex(warehouse_id, districtID, customerID, 10000000 + 1);
+  uint64_t end   = makeOrderIndex(warehouse_id, districtID, customerID, 1);
+
+  Memstore::Iterator *iter = store_->stores_[ORDER_INDEX]->GetIterator();
+  iter->Seek(start);
+  if(iter->Valid())
+    iter->Prev();
+
+  int o_ol_cnt = 0;
+  if(iter->Valid() && iter->Key() >= end && iter->CurNode()->value != NULL) {
+    uint64_t *prikeys = (uint64_t *)((char *)(iter->CurNode()->value) + store_->_schemas[ORDER_INDEX].meta_len);
+    int32_t o_id = static_cast<int32_t>(prikeys[1] << 32 >> 32);
+
+    idx = rtx->read<ORDE,oorder::value>(current_partition,prikeys[1],yield);
+    if(idx < 0) {
+      delete iter;
+      return txn_result_t(false,73);
+    }
+    o_ol_cnt = ((oorder::value *)rtx->load_read(idx,sizeof(oorder::value),yield))->o_ol_cnt;
+
+    for(int32_t line_number = 1; line_number <= o_ol_cnt; ++line_number) {
+      uint64_t ol_key = makeOrderLineKey(warehouse_id, districtID, o_id, line_number);
+      idx = rtx->read<ORLI,order_line::value>(current_partition,ol_key,yield);
+      if(idx < 0) {
+        delete iter;
+        return txn_result_t(false,73);
+      }
+    }
+  }
+  delete iter;
+
+  bool ret = rtx->commit(yield);
+  return txn_result_t(ret,o_ol_cnt);
+#else
   assert(false); // not implemented yet
   return txn_result_t(true,10);
+#endif
 }
 
 
@@ -46,14 +46,17 @@ txn_result_t TpccWorker::txn_new_order_new_api(yield_func_t &yield) {
   int num_remote_stocks(0),num_local_stocks(0);
 
   const uint numItems = RandomNumber(random_generator[cor_id_], 5, MAX_ITEM);
+  int skewed_supplies[MAX_ITEM];
+  const int num_skewed = PickSkewedRemoteWarehouses(numItems,skewed_supplies);
 #if OR
   START(read);
 #endif
   for (uint i = 0; i < numItems; i++) {
     bool conflict = false;
     int item_id = GetItemId(random_generator[cor_id_]);
-    if (NumWarehouses() == 1 ||
-        RandomNumber(random_generator[cor_id_], 1, 100) > g_new_order_remote_item_pct) {
+    if (num_skewed >= 0 ? i >= (uint)num_skewed :
+        (NumWarehouses() == 1 ||
+         RandomNumber(random_generator[cor_id_], 1, 100) > g_new_order_remote_item_pct)) {
       // locla stock case
       uint supplier_warehouse_id = warehouse_id;
       uint64_t s_key = makeStockKey(supplier_warehouse_id , item_id);
@@ -71,7 +74,7 @@ txn_result_t TpccWorker::txn_new_order_new_api(yield_func_t &yield) {
       uint64_t s_key;
       uint supplier_warehouse_id;
       do {
-        supplier_warehouse_id = RandomNumber(random_generator[cor_id_], 1, NumWarehouses());
+        supplier_warehouse_id = num_skewed >= 0 ? skewed_supplies[i] : PickSupplierWarehouse();
         s_key = makeStockKey(supplier_warehouse_id, item_id);
         if(stock_set.find(s_key)!=stock_set.end()){
           conflict = true;
@@ -74,9 +74,11 @@ bool TypeMapInitDone = false;
 
 uint64_t preload_trade_per_server_offset(0);
 
-TpceLoader::TpceLoader(unsigned long seed, MemDB *store)
-    : TpceMixin(store),
-      BenchLoader(seed)
+TpceLoader::TpceLoader(unsigned long seed, MemDB *store,int loader_id,int num_loaders)
+    : BenchLoader(seed),
+      TpceMixin(store),
+      loader_id_(loader_id),
+      num_loaders_(num_loaders)
 {
 
 }
@@ -149,6 +151,11 @@ void TpceLoader::simple_load() {
   LOG(4) << "Simple TPCE load done.";
 }
 
+/* loader 0 loads the fixed tables, the others wait for it before loading their customers */
+static volatile bool fixed_tables_loaded = false;
+/* protects the global maps and the trade id counter, which are filled by all the loaders */
+static SpinLock load_lock;
+
 void TpceLoader::load() {
 
   if(store_ == NULL) {
@@ -156,16 +163,50 @@ void TpceLoader::load() {
     return;
   }
   LOG(3) << "load store.";
-  return simple_load();
-  NoccTpceLoadFactory *factory = new NoccTpceLoadFactory(store_);
-  /* Init TPCE loading factory */
+
+  if(loader_id_ == 0) {
+    load_fixed_tables();
+    asm volatile("" ::: "memory");
+    fixed_tables_loaded = true;
+  } else {
+    while(!fixed_tables_loaded) {
+      asm volatile("pause\n": : :"memory");
+    }
+  }
+
+  /* the customers of a slice are aligned to the load units, which EGen generates independently */
+  int num_units   = num_load_units();
+  int start_unit  = num_units * loader_id_ / num_loaders_;
+  int end_unit    = num_units * (loader_id_ + 1) / num_loaders_;
+  if(start_unit == end_unit)
+    return;
+  load_customer_tables(mStartCustomer + start_unit * iDefaultLoadUnitSize,
+                       (end_unit - start_unit) * iDefaultLoadUnitSize);
+  LOG(4) << "TPC-E loader " << loader_id_ << " load done!";
+}
+
+static CGenerateAndLoad *make_generator(NoccTpceLoadFactory *factory,int start_customer,int customer_count) {
 
   char  szInDir[64];
   snprintf(szInDir,64,"/home/wxd/egen_flat_in/"); // used in local data center
   //snprintf(szInDir,64,"/home/ubuntu/egen_flat_in/"); // used in aws
-  int   iLoadUnitSize = iDefaultLoadUnitSize;
   bool  bGenerateUsingCache  = true;
 
+  CGenerateAndLoadStandardOutput* output = new CGenerateAndLoadStandardOutput();
+  return new CGenerateAndLoad(*inputFiles, customer_count,
+                              start_customer,
+                              totalCustomer, iDefaultLoadUnitSize,
+                              scaleFactor, tradeDays,
+                              factory, logger, output, szInDir,
+                              bGenerateUsingCache);
+}
+
+void TpceLoader::load_fixed_tables() {
+
+  char  szInDir[64];
+  snprintf(szInDir,64,"/home/wxd/egen_flat_in/"); // used in local data center
+  //snprintf(szInDir,64,"/home/ubuntu/egen_flat_in/"); // used in aws
+
   char szLogFileName[64];
 
   snprintf(&szLogFileName[0], sizeof(szLogFileName),
@@ -174,29 +215,20 @@ void TpceLoader::load() {
   /* Create log formatter and logger instance */
   logger = new CEGenLogger(eDriverEGenLoader, 0, szLogFileName, &fmt);
 
-  CGenerateAndLoadStandardOutput* output = NULL;
-
   inputFiles = new CInputFiles();
-  output = new CGenerateAndLoadStandardOutput();
   inputFiles->Initialize(eDriverEGenLoader, totalCustomer, totalCustomer, szInDir);
 
   cerr << "[tpce] load settings:" << endl;
   cerr << "  Total customer    : " << totalCustomer << endl;
-  cerr << "  Load unit size    : " << iLoadUnitSize  << endl;
-
+  cerr << "  Load unit size    : " << iDefaultLoadUnitSize  << endl;
+  cerr << "  Loaders           : " << num_loaders_ << endl;
 
-  CGenerateAndLoad *TpceLoadFactory = new CGenerateAndLoad(*inputFiles, accountPerPartition,
-                                                           mStartCustomer,
-                                                           totalCustomer, iLoadUnitSize,
-                                                           scaleFactor, tradeDays,
-                                                           factory, logger, output, szInDir,
-                                                           bGenerateUsingCache);
+  NoccTpceLoadFactory *factory = new NoccTpceLoadFactory(store_);
+  CGenerateAndLoad *TpceLoadFactory = make_generator(factory,mStartCustomer,accountPerPartition);
 #ifdef SANITY_CHECKS
   tx = new DBRad(store_,0,NULL);
 #endif
 
-  /* true loading */
-
   /* fixed tables */
   fprintf(stdout,"Generate and load fixed tables\n");
   TpceLoadFactory->m_iStartFromCustomer = 1;
@@ -208,8 +240,6 @@ void TpceLoader::load() {
   TpceLoadFactory->m_iCustomerCount = accountPerPartition;
   /* reset done */
 
-  /**/
-
   TpceLoadFactory->GenerateAndLoadTradeType();
   TpceLoadFactory->GenerateAndLoadCharge();
   TpceLoadFactory->GenerateAndLoadExchange();
@@ -238,35 +268,41 @@ void TpceLoader::load() {
   TpceLoadFactory->GenerateAndLoadTaxrate();
   TpceLoadFactory->GenerateAndLoadCommissionRate();
 
-  TpceLoadFactory->GenerateAndLoadCustomerTaxrate();
-
-  fprintf(stdout,"Generate and load customer account\n");
-  TpceLoadFactory->GenerateAndLoadCustomer();
-  TpceLoadFactory->GenerateAndLoadCustomerAccountAndAccountPermission();
-
-  fprintf(stdout,"Generate trades table\n");
-  TpceLoadFactory->GenerateAndLoadGrowingTables();
-  //      TpceLoadFactory->GenerateAndLoadTaxrate
-  fprintf(stdout,"\ntrades table done\n");
-
   /* Some remaining fixed tables */
   TpceLoadFactory->GenerateAndLoadCompanyCompetitor();
   TpceLoadFactory->GenerateAndLoadSector();
+
+  LOG(4) << "TPC-E fixed tables load done!";
+}
+
+void TpceLoader::load_customer_tables(int start_customer,int customer_count) {
+
+  fprintf(stdout,"[TPCE loader %d] load customers %d to %d\n",loader_id_,
+          start_customer,start_customer + customer_count - 1);
+
+  /* each loader has its own factory, thus its own table loaders */
+  NoccTpceLoadFactory *factory = new NoccTpceLoadFactory(store_);
+  CGenerateAndLoad *TpceLoadFactory = make_generator(factory,start_customer,customer_count);
+
+  TpceLoadFactory->GenerateAndLoadCustomerTaxrate();
+  TpceLoadFactory->GenerateAndLoadCustomer();
+  TpceLoadFactory->GenerateAndLoadCustomerAccountAndAccountPermission();
   TpceLoadFactory->GenerateAndLoadWatchListAndWatchItem();
 
-  LOG(4) << "TPC-E load done!";
-  while(1) sleep(1);
+  TpceLoadFactory->GenerateAndLoadGrowingTables();
 }
 
 class TpceWatchListLoader : public CBaseLoader<WATCH_LIST_ROW> {
  public:
   TpceWatchListLoader() {}
   virtual void WriteNextRecord(CBaseLoader<WATCH_LIST_ROW>::PT record) {
+    load_lock.Lock();
     assert(WatchList.find(record->WL_C_ID) == WatchList.end());
     WatchList.insert(std::make_pair(record->WL_C_ID,record->WL_ID));
     assert(WatchItem.find(record->WL_ID) == WatchItem.end());
     std::vector<std::string> empty_list;
     WatchItem.insert(std::make_pair(record->WL_ID,empty_list));
+    load_lock.Unlock();
   }
   virtual void FinishLoad() { fprintf(stdout,"[TPCE loader] watch list load done.\n");}
 };
@@ -275,8 +311,10 @@ class TpceWatchItemLoader : public CBaseLoader<WATCH_ITEM_ROW> {
  public:
   TpceWatchItemLoader() {}
   virtual void WriteNextRecord(CBaseLoader<WATCH_ITEM_ROW>::PT record) {
+    load_lock.Lock();
     assert(WatchItem.find(record->WI_WL_ID) != WatchItem.end());
     WatchItem[record->WI_WL_ID].push_back(record->WI_S_SYMB);
+    load_lock.Unlock();
   }
   virtual void FinishLoad() { fprintf(stdout,"[TPCE loader] watch item load done.\n");}
 };
@@ -351,8 +389,8 @@ class TpceDMLoader : public CBaseLoader<DAILY_MARKET_ROW> , public TpceMixin {
     int meta_len = store_->_schemas[DAILY_MARKET].meta_len;
     char *wrapper = (char *)malloc(dm_size + meta_len);
 
-    daily_market::value *v = (daily_market::value *)(wrapper + meta_len);
 #if 0
+    daily_market::value *v = (daily_market::value *)(wrapper + meta_len);
     v->dm_close = record->DM_CLOSE;
     v->dm_high  = record->DM_HIGH;
     v->dm_low   = record->DM_LOW;
@@ -695,7 +733,7 @@ class TpceLTLoader : public CBaseLoader<LAST_TRADE_ROW>, public TpceMixin {
     uint64_t co_id = SecurityToCompany[symbl];
     int pid = companyToPartition(co_id);
 
-    if(pid == current_partition) {
+    if(pid == (int)current_partition) {
 
       RThreadLocalInit();
       char *se_wrapper2 = (char *)Rmalloc(se_size);
@@ -741,7 +779,6 @@ class TpceCTLoader : public CBaseLoader<CUSTOMER_TAXRATE_ROW> , public TpceMixin
     int meta = store_->_schemas[CUST_TAX].meta_len;
     char *wrapper = (char *)malloc(len + meta);
 
-    customer_taxrate::value *v = (customer_taxrate::value *)(wrapper + meta);
     uint64_t key = makeCustTaxKey(record->CX_C_ID,*(uint64_t *)(record->CX_TX_ID));
     assert(TpceTaxMap.find(key & 0xffffffff) != TpceTaxMap.end());
     store_->Put(CUST_TAX,key,(uint64_t *)wrapper);
@@ -791,6 +828,7 @@ class TpceTradeLoader : public CBaseLoader<TRADE_ROW> , public TpceMixin {
 
     trade::value *v = (trade::value *)(wrapper + meta);
 
+    load_lock.Lock();
     if(iAbortedTradeModFactor == lastTradeId % iAbortTrade)
       lastTradeId += 1;
     /* currently manally create trade id */
@@ -800,6 +838,7 @@ class TpceTradeLoader : public CBaseLoader<TRADE_ROW> , public TpceMixin {
     tid -= preload_trade_per_server_offset;
     if(tid > lastTradeId)
       lastTradeId = tid;
+    load_lock.Unlock();
     //	if(tid == 200000000054562) fprintf(stdout,"load!!!\n");
     tid = encode_trade_id(tid,0,0);
     v->t_dts = record->T_DTS.GetDate();
@@ -977,8 +1016,10 @@ class TpceBrokerLoader : public CBaseLoader<BROKER_ROW> , public TpceMixin {
     store_->Put(BROKER,record->B_ID,(uint64_t *)wrapper);
     num += 1;
     /* TODO!! maybe need secondary index? */
+    load_lock.Lock();
     assert(BrokerNameToKey.find(std::string(record->B_NAME)) == BrokerNameToKey.end());
     BrokerNameToKey.insert(std::make_pair(record->B_NAME,record->B_ID));
+    load_lock.Unlock();
   }
   virtual void FinishLoad() {  fprintf(stdout,".");  }
 };
@@ -1042,7 +1083,7 @@ class TpceTradeHLoader : public CBaseLoader<TRADE_HISTORY_ROW> , public TpceMixi
     char *wrapper = (char *)malloc(len + meta);
     memset(wrapper,0,len + meta);
 
-    trade_history::value *v = (trade_history::value *)(wrapper + meta);
+    //	trade_history::value *v = (trade_history::value *)(wrapper + meta);
     //	v->th_st_id = std::string(record->TH_ST_ID);
 
     /* make key */
@@ -1074,7 +1115,7 @@ class TpceCALoader : public CBaseLoader<CUSTOMER_ACCOUNT_ROW> , public TpceMixin
     v->ca_bal = record->CA_BAL;
 
     store_->Put(CUSTACCT,record->CA_ID,(uint64_t *)wrapper);
-    if(caToPartition(record->CA_ID) != current_partition) {
+    if(caToPartition(record->CA_ID) != (int)current_partition) {
       //	  fprintf(stdout,"ca id %lu custid %lu\n",record->CA_ID,v->ca_c_id);
       return;
     }
@@ -302,10 +302,10 @@ TpceMainRunner::TpceMainRunner (std::string &config_file)
 std::vector<BenchLoader *> TpceMainRunner::make_loaders(int partition, MemDB* store) {
   std::vector<BenchLoader *> ret;
   /* The seed is not used in this loader, thus any number is ok */
-  if(store == NULL){
-    ret.push_back(new TpceLoader(73,store_));
-  } else {
-    ret.push_back(new TpceLoader(73,store));
+  /* one loader per EGen load unit of the partition, see TpceLoader */
+  int num_loaders = TpceLoader::num_load_units();
+  for(int i = 0;i < num_loaders;++i) {
+    ret.push_back(new TpceLoader(73,store == NULL ? store_ : store,i,num_loaders));
   }
   return ret;
 }
@@ -324,6 +324,12 @@ std::vector<RWorker *> TpceMainRunner::make_workers() {
   ret.push_back(ts_manager);
 #endif
 #endif
+
+#if defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+  // add ts worker
+  ts_manager = new TSManager(nthreads + nclients + 1,cm,0,0);
+  ret.push_back(ts_manager);
+#endif
 #if CS == 1
   for(uint i = 0;i < nclients;++i)
     ret.push_back(new TpceClient(nthreads + i,r.next()));
@@ -16,6 +16,8 @@ extern     std::map<std::string,std::string> TpceSector;
 
 extern     __thread std::queue<TPCE::TTickerEntry>         *marketFeedQueue;
 
+#if !ENABLE_TXN_API
+
 void TpceWorker::customer_position_piece(yield_func_t &yield,int id, int cid,char *input) {
 
   CPInputHeader *header = (CPInputHeader *)input;
@@ -325,6 +327,8 @@ void TpceWorker::market_watch_piece(yield_func_t &yield,int id,int cid, char *in
   //this->context_transfer();
 }
 
+#endif // !ENABLE_TXN_API
+
 /***** helper rpcs ********/
 
 void TpceWorker::add_market_feed(int id,int cid, char *input, void *arg) {
@@ -13,6 +13,10 @@
 #include "egen/EGenLoader_stdafx.h"
 #include "egen/EGenGenerateAndLoad.h"
 
+#include "rtx/global_vars.h"
+#include "rtx/occ_rdma.h"
+#include "rtx/occ_variants.hpp"
+
 //#include "framework/rpc.h"
 #include "framework/req_buf_allocator.h"
 #include "core/logging.h"
@@ -142,12 +146,15 @@ TpceWorker::TpceWorker(unsigned int worker_id,unsigned long seed,MemDB *store,
 void TpceWorker::register_callbacks() {
 
   fprintf(stdout,"TPCE register callbacks\n");
+#if !ENABLE_TXN_API
+  /* the TX api versions access the remote last trades through rtx, so no pieces are forked */
   one_shot_callbacks[TX_CP]  = bind(&TpceWorker::customer_position_piece,this,_1,_2,_3,_4);
   one_shot_callbacks[TX_SED] = bind(&TpceWorker::security_detail_piece,this,_1,_2,_3,_4);
   one_shot_callbacks[TX_TL0] = bind(&TpceWorker::trade_lookup_piece0,this,_1,_2,_3,_4);
   one_shot_callbacks[TX_TL1] = bind(&TpceWorker::trade_lookup_piece1,this,_1,_2,_3,_4);
   one_shot_callbacks[TX_BV]  = bind(&TpceWorker::broker_volumn_piece,this,_1,_2,_3,_4);
   one_shot_callbacks[TX_MW]  = bind(&TpceWorker::market_watch_piece,this,_1,_2,_3,_4);
+#endif
 
   rpc_->register_callback(bind(&TpceWorker::add_market_feed,this,_1,_2,_3,_4), \
                           RPC_ADD);
@@ -172,11 +179,6 @@ workload_desc_vec_t TpceWorker::_get_workload() {
     m += g_txn_workload_mix[i];
   assert(m == 100);
 
-#if 1 // a special hook to test TPCE's read-only TX
-  w.push_back(workload_desc("Customer position",1,TxnCustomerPos));
-  return w;
-#endif
-
   if (g_txn_workload_mix[0]) {
     w.push_back(workload_desc("CustomerPosition", g_txn_workload_mix[0]/100.0, TxnCustomerPos));
   }
@@ -214,8 +216,6 @@ void TpceWorker::check_consistency() {
   fprintf(stdout,"worker %d check consistency\n",worker_id_);
 
   MemstoreUint64BPlusTree *trq = (MemstoreUint64BPlusTree *)(store_->stores_[TRADE_REQ]);
-  MemstoreUint64BPlusTree *th  = (MemstoreUint64BPlusTree *)(store_->stores_[TRADE_HIST]);
-  MemstoreUint64BPlusTree *trs = store_->_indexs[SEC_SC_TR];
   if(trq != NULL) {
   }
 }
@@ -239,44 +239,60 @@ void TpceWorker::thread_local_init() {
   prev_executed = 0;
   prev_numbered = 0;
 
-  for(uint i = 0;i < server_routine + 1;++i) {
+  for(int i = 0;i < server_routine + 1;++i) {
     market_feed_process_idx[i] = -1;
     tradeResultCache[i] = NULL;
 
-
 #ifdef RAD_TX
     txs_[i] = new DBRad(store_,worker_id_,rpc_,i);
 #elif defined(OCC_TX)
     if(txs_[i] == NULL) {
+#if EM_FASST == 0
 #if ONE_SIDED_READ
-      new_txs_[i] = new OCCR(this,store_,rpc_,current_partition,worker_id_,i,current_partition,
+      new_txs_[i] = new rtx::OCCR(this,store_,rpc_,current_partition,worker_id_,i,-1,
                                   cm,rdma_sched_,total_partition);
 #else
-      new_txs_[i] = new OCC(this,store_,rpc_,current_partition,i,current_partition);
+      new_txs_[i] = new rtx::OCC(this,store_,rpc_,current_partition,i,-1);
 #endif
-      continue;
+#else
+      new_txs_[i] = new rtx::OCCFast(this,store_,rpc_,current_partition,i,-1);
+#endif
+      new_txs_[i]->set_logger(new_logger_);
+      new_txs_[i]->set_two_phase_committer(two_phase_committer_);
     }
-    txs_[i] = new DBTX(store_,worker_id_,rpc_,i);
-    remote_helper = new RemoteHelper(store_,total_partition,server_routine + 1);
 #elif defined(NOWAIT_TX)
     if(txs_[i] == NULL) {
-#if ONE_SIDED_READ
-      new_txs_[i] = new NOWAIT(this,store_,rpc_,current_partition,worker_id_,i,current_partition,
-                                  cm,rdma_sched_,total_partition);
-#else
-      assert(false);
-#endif
-      continue;
+      new_txs_[i] = new rtx::NOWAIT(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                    cm,rdma_sched_,total_partition);
+      new_txs_[i]->set_logger(new_logger_);
+      new_txs_[i]->set_two_phase_committer(two_phase_committer_);
     }
 #elif defined(WAITDIE_TX)
-    if (txs_[i] == NULL) {
-#if ONE_SIDED_READ
-      new_txs_[i] = new WAITDIE(this,store_,rpc_,current_partition,worker_id_,i,current_partition,
+    if(txs_[i] == NULL) {
+      new_txs_[i] = new rtx::WAITDIE(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                     cm,rdma_sched_,total_partition);
+      new_txs_[i]->set_logger(new_logger_);
+      new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+    }
+#elif defined(MVCC_TX)
+    if(txs_[i] == NULL) {
+      new_txs_[i] = new rtx::MVCC(this,store_,rpc_,current_partition,worker_id_,i,-1,
                                   cm,rdma_sched_,total_partition);
-#else
-      assert(false);
-#endif
-      continue;
+      new_txs_[i]->set_logger(new_logger_);
+      new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+    }
+#elif defined(SUNDIAL_TX)
+    if(txs_[i] == NULL) {
+      new_txs_[i] = new rtx::SUNDIAL(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                     cm,rdma_sched_,total_partition);
+      new_txs_[i]->set_logger(new_logger_);
+      new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+    }
+#elif defined(CALVIN_TX)
+    if(txs_[i] == NULL) {
+      new_txs_[i] = new rtx::CALVIN(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                    cm,rdma_sched_,total_partition);
+      new_txs_[i]->set_logger(new_logger_);
     }
 #elif defined(FARM)
     txs_[i] = new DBFarm(cm,rdma_sched_,store_,worker_id_,rpc_,i);
@@ -286,12 +302,20 @@ void TpceWorker::thread_local_init() {
     fprintf(stderr,"No transaction layer used!\n");
     assert(false);
 #endif
+    nocc::rtx::global_lock_manager[i].thread_local_init();
   }
+#ifdef CALVIN_TX
+  init_calvin_ctx(store_);
+#endif
+  rtx_hook_ = new_txs_[1];
+  init_ro_txs(store_);
   /* init local tx so that it is not a null value */
   tx_ = txs_[cor_id_];
-  rtx_hook_ = new_txs_[1];
+  rtx_ = new_txs_[cor_id_];
 }
 
+#if !ENABLE_TXN_API
+
 /* TXs */
 txn_result_t
 TpceWorker::txn_trade_order(yield_func_t &yield) {
@@ -3542,6 +3566,8 @@ txn_result_t TpceWorker::trade_update_frame3(yield_func_t &yield,TTradeUpdateTxn
   return txn_result_t(ret,tx_->report_rw_set() + tx_->remoteset->read_items_ + tx_->remoteset->write_items_);
 #endif
 }
+#endif // !ENABLE_TXN_API
+
 /* end namespace tpce */
 };
 };
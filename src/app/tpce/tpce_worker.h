@@ -26,7 +26,8 @@
 #define TX_BV  4
 #define TX_MW  5
 
-#define RPC_ADD (MAX_RPC_REGISTERED - 1)
+#define RPC_ADD 31 /* beyond the RPC ids of rtx (rtx/txn_interface.h) */
+static_assert(RPC_ADD < 32,"the rpc id has 5 bits in the header (core/rrpc.h)");
 
 extern size_t current_partition;
 
@@ -121,13 +122,24 @@ struct  SK {
 
 void TpceTest(int argc,char **argv);
 
+/* The loaders of a partition split its customers into EGen load units.
+   Loader 0 first loads the fixed and the per-company tables, which are shared by all the slices,
+   then every loader loads the customer tables of its own slice in parallel.
+*/
 class TpceLoader : public BenchLoader, public TpceMixin {
  public:
-  TpceLoader(unsigned long seed, MemDB *store);
+  TpceLoader(unsigned long seed, MemDB *store,int loader_id = 0,int num_loaders = 1);
+  static int num_load_units() { return accountPerPartition / TPCE::iDefaultLoadUnitSize; }
  protected:
   virtual void load();
   // Used to test RDMA performance, which load a subset of tables for simplicity
   void simple_load();
+ private:
+  void load_fixed_tables();
+  void load_customer_tables(int start_customer,int customer_count);
+
+  int loader_id_;
+  int num_loaders_;
 };
 
 class TpceWorker : public TpceMixin, public BenchWorker {
@@ -158,6 +170,45 @@ class TpceWorker : public TpceMixin, public BenchWorker {
   txn_result_t trade_update_frame2(yield_func_t &yield, TPCE::TTradeUpdateTxnInput &input);
   txn_result_t trade_update_frame3(yield_func_t &yield, TPCE::TTradeUpdateTxnInput &input);
 
+#if ENABLE_TXN_API
+  /* implementations using the TX api of rtx */
+  txn_result_t txn_trade_order_api(yield_func_t &yield);
+  txn_result_t txn_trade_result_api(yield_func_t &yield);
+  txn_result_t txn_broker_volume_api(yield_func_t &yield);
+  txn_result_t txn_market_watch_api(yield_func_t &yield);
+  txn_result_t txn_security_detail_api(yield_func_t &yield);
+  txn_result_t txn_trade_lookup_api(yield_func_t &yield);
+  txn_result_t txn_trade_status_api(yield_func_t &yield);
+  txn_result_t txn_market_feed_api(yield_func_t &yield);
+  txn_result_t txn_trade_update_api(yield_func_t &yield);
+
+  txn_result_t trade_lookup_frame1_api(yield_func_t &yield, TPCE::TTradeLookupTxnInput &input);
+  txn_result_t trade_lookup_frame2_api(yield_func_t &yield, TPCE::TTradeLookupTxnInput &input);
+  txn_result_t trade_lookup_frame3_api(yield_func_t &yield, TPCE::TTradeLookupTxnInput &input);
+  txn_result_t trade_lookup_frame4_api(yield_func_t &yield, TPCE::TTradeLookupTxnInput &input);
+
+  txn_result_t trade_update_frame1_api(yield_func_t &yield, TPCE::TTradeUpdateTxnInput &input);
+  txn_result_t trade_update_frame2_api(yield_func_t &yield, TPCE::TTradeUpdateTxnInput &input);
+  txn_result_t trade_update_frame3_api(yield_func_t &yield, TPCE::TTradeUpdateTxnInput &input);
+
+  bool read_trade_details_api(uint64_t tid,bool is_cash,int max_hist,yield_func_t &yield);
+
+  /* read (write) a record through rtx_, return NULL if the record is absent or the TX shall abort */
+  template <int tableid,typename V>
+  inline V *rtx_read(int pid,uint64_t key,yield_func_t &yield) {
+    int idx = rtx_->read(pid,tableid,key,sizeof(V),yield);
+    if(idx < 0) return NULL;
+    return (V *)(rtx_->load_read(idx,sizeof(V),yield));
+  }
+
+  template <int tableid,typename V>
+  inline V *rtx_write(int pid,uint64_t key,yield_func_t &yield) {
+    int idx = rtx_->write(pid,tableid,key,sizeof(V),yield);
+    if(idx < 0) return NULL;
+    return (V *)(rtx_->load_write(idx,sizeof(V),yield));
+  }
+#endif
+
   /* remote fork pieces */
   void customer_position_piece(yield_func_t &yield,int id,int cid,char *input);
   void security_detail_piece(yield_func_t &yield,int id,int cid,char *input);
@@ -188,51 +239,90 @@ class TpceWorker : public TpceMixin, public BenchWorker {
 
   /* Wrappers*/
   static txn_result_t TxnTradeOrder(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_order_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_order(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnTradeResult(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_result_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_result(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnCustomerPos(BenchWorker *w,yield_func_t &yield) {
-    //txn_result_t r = static_cast<TpceWorker *>(w)->txn_customer_position(yield);
+#if ENABLE_TXN_API
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_cp_new(yield);
+#else
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_customer_position(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnBrokerVolume(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_broker_volume_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_broker_volume(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnMarketWatch(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_market_watch_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_market_watch(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnSecurityDetail(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_security_detail_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_security_detail(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnTradeLookup(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_lookup_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_lookup(yield);
+#endif
     return r;
   }
 
   static txn_result_t TxnTradeStatus(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_status_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_status(yield);
+#endif
     return r;
   }
   static txn_result_t TxnMarketFeed(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_market_feed_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_market_feed(yield);
+#endif
     return r;
   }
   static txn_result_t TxnTradeUpdate(BenchWorker *w,yield_func_t &yield) {
+#if ENABLE_TXN_API
+    txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_update_api(yield);
+#else
     txn_result_t r = static_cast<TpceWorker *>(w)->txn_trade_update(yield);
+#endif
     return r;
   }
 };
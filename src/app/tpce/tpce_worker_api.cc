@@ -0,0 +1,1073 @@
+#include "tx_config.h"
+
+#include "tpce_worker.h"
+
+#include "rtx/occ_rdma.h"
+#include "rtx/occ_variants.hpp"
+#include "rtx/occ_iterator.hpp"
+
+#include <queue>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+
+extern size_t current_partition;
+extern size_t total_partition;
+
+using namespace TPCE;
+
+/**
+ * TPC-E's TXs on the TX api of rtx (read/write/load_read/load_write).
+ * The pointer-keyed B+tree tables are only accessed at the local partition, and the last trades,
+ * which are owned by the partition of the company, are accessed through LT1.
+ * The inserts follow the TX api (see TPC-C's implementations); there is no delete or secondary index
+ * update in the api, so a closed holding is kept with a zero quantity.
+ */
+
+namespace nocc {
+
+namespace oltp {
+
+extern __thread util::fast_random   *random_generator;
+
+namespace tpce {
+
+#if ENABLE_TXN_API
+
+extern __thread std::queue<TTradeResultTxnInput> *tradeResultQueue;
+extern __thread std::queue<TTickerEntry>         *marketFeedQueue;
+extern __thread int8_t *market_feed_process_idx;
+extern __thread TTickerEntry (*tickerBuffer)[10];
+extern __thread TTradeResultTxnInput **tradeResultCache;
+
+extern uint64_t type_margin_executed;
+extern uint64_t lastTradeId;
+
+extern std::map<std::string,trade_type::value *>    TpceTradeHash;
+extern std::map<std::string,industry::value *>      TpceIndustry;
+extern std::map<uint64_t,   news_item::value*>      TpceNewsItem;
+extern std::map<std::string,int>                    TpceExchangeMap;
+extern std::map<std::string,status_type::value *>   TpceStatusType;
+extern std::map<std::string,std::string>            TpceSector;
+extern std::map<std::string,std::string>            SecurityToSector;
+extern std::map<uint64_t,uint64_t>                  WatchList;
+extern std::map<uint64_t,std::vector<std::string> > WatchItem;
+extern std::map<std::string,uint64_t>               TpceTradeTypeMap;
+extern std::map<int32_t, double>                    TpceTaxMap;
+extern std::map<std::string,uint64_t>               SecurityToCompany;
+extern std::map<std::string,uint64_t>               CONameToId;
+extern std::map<std::string,uint64_t>               IndustryNametoID;
+extern std::map<std::string,uint64_t>               SecurityToId;
+
+#define TPCE_ABORT txn_result_t(false,73)
+
+txn_result_t TpceWorker::txn_trade_order_api(yield_func_t &yield) {
+
+  TTradeOrderTxnInput input;
+  /* Ensuring that the seed is the same as the abort seed */
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  static int meta_size = store_->_schemas[HOLDING].meta_len;
+
+  bool    bExecutorIsAccountOwner;
+  int32_t iTradeType;
+  input_generator_->GenerateTradeOrderInput(input, iTradeType,bExecutorIsAccountOwner);
+
+  rtx_->begin(yield);
+
+  uint64_t trade_id = get_last_trade_id();
+  auto now_dts = CDateTime().GetDate();
+
+  /* Frame 1 */
+  customer_account::value *ca = rtx_read<CUSTACCT,customer_account::value>(current_partition,
+                                                                           input.acct_id,yield);
+  if(ca == NULL) return TPCE_ABORT;
+  customers::value *c = rtx_read<ECUST,customers::value>(current_partition,ca->ca_c_id,yield);
+  if(c == NULL) return TPCE_ABORT;
+  /**** Frame 1 done ****/
+
+  /* Frame 2 */
+  // TODO!! since tax id is 14 byte fixed, so i just hard coded it here
+  uint64_t ap_key = makeAPKey(input.acct_id, c->c_tax_id.data(),14);
+  account_permission::value *ap = rtx_read<ACCTPER,account_permission::value>(current_partition,
+                                                                              ap_key,yield);
+  if(ap == NULL) return TPCE_ABORT;
+
+  trade_type::value *tt = TpceTradeHash[std::string(input.trade_type_id)];
+  /**** Frame 2 done ****/
+
+  /* Frame 3 */
+  char exch_id[6 + 1]; /* 6 is from the specification */
+  memset(exch_id,0,sizeof(exch_id));
+  uint64_t symbol;
+  uint64_t co_id;
+  security::value *sv;
+
+  if(input.symbol[0] == '\0') {
+    /* securit symbol is not specified, just select security from company */
+    co_id = CONameToId[input.co_name];
+    uint64_t sec_key = makeSecuritySecondIndex(co_id,input.issue);
+    MemNode *mn     = store_->_indexs[SEC_IDX]->Get(sec_key);
+    assert(mn != NULL);
+    symbol = (uint64_t )(mn->value);
+
+    sv = rtx_read<SECURITY,security::value>(current_partition,symbol,yield);
+    if(sv == NULL) return TPCE_ABORT;
+  } else {
+    /* just directly fetch securtiy and company */
+    symbol = makeSecurityIndex(input.symbol);
+    sv = rtx_read<SECURITY,security::value>(current_partition,symbol,yield);
+    if(sv == NULL) return TPCE_ABORT;
+    co_id = sv->s_co_id;
+
+    company::value *co_v = rtx_read<COMPANY,company::value>(current_partition,co_id,yield);
+    if(co_v == NULL) return TPCE_ABORT;
+  }
+  memcpy(exch_id,sv->s_ex_id.data(),MIN(sv->s_ex_id.size(),sizeof(exch_id) - 1));
+
+  int hs_qty = 0;
+  uint64_t hs_key = makeHSKey(input.acct_id,(const char *)symbol);
+  if(store_->Get(HOLDING_SUM,hs_key) != NULL) {
+    holding_summary::value *hsv = rtx_read<HOLDING_SUM,holding_summary::value>(current_partition,
+                                                                               hs_key,yield);
+    if(hsv == NULL) return TPCE_ABORT;
+    hs_qty = hsv->hs_qty;
+  }
+
+  /* the last trades are issued first, and fetched in a batch after the local parts are done */
+  int pid = companyToPartition(co_id);
+  int lt_idx = -1;
+  std::vector<std::pair<int,int> > margin_lts; // (read idx, hs_qty)
+
+  if(input.type_is_margin) {
+    type_margin_executed += 1;
+    const char *min_s = "\0";
+    rtx::RTXIterator hs_iter(rtx_,HOLDING_SUM,false);
+    hs_iter.seek(makeHSKey(input.acct_id,min_s));
+    while(hs_iter.valid()) {
+      uint64_t *key = (uint64_t *)(hs_iter.key());
+      if(key[0] != (uint64_t)input.acct_id) break;
+      holding_summary::value *v = (holding_summary::value *)(hs_iter.value() + meta_size);
+      char *s_symb = (char *)(&(key[1]));
+
+      int idx = rtx_->read(companyToPartition(SecurityToCompany[s_symb]),LT1,SecurityToId[s_symb],
+                           sizeof(last_trade::value),yield);
+      if(idx < 0) return TPCE_ABORT;
+      if(compareSecurityKey((uint64_t)s_symb,symbol))
+        lt_idx = idx;
+      margin_lts.push_back(std::make_pair(idx,(int)(v->hs_qty)));
+      hs_iter.next();
+    }
+  }
+  if(lt_idx == -1) {
+    lt_idx = rtx_->read(pid,LT1,SecurityToId[(char *)symbol],sizeof(last_trade::value),yield);
+    if(lt_idx < 0) return TPCE_ABORT;
+  }
+
+  double hold_price = 0.0;
+  double buy_value  = 0.0;
+  double sell_value = 0.0;
+  int    needed_qty = input.trade_qty;
+
+  /* estimate the impact of the trade to the holdings in the opposite direction */
+  if(tt->tt_is_sell ? (hs_qty > 0) : (hs_qty < 0)) {
+    std::vector<std::pair<int32_t, double> > hold_list;
+    uint64_t min = makeHoldingKey(input.acct_id,0,(char *)symbol,0);
+    uint64_t max = makeHoldingKey(input.acct_id,std::numeric_limits<uint64_t>::max(),(char *)symbol,
+                                  std::numeric_limits<uint64_t>::max());
+    rtx::RTXIterator iter(rtx_,HOLDING,false);
+    iter.seek(min);
+    while(iter.valid() && compareHoldingKey(iter.key(),max)) {
+      holding::value *hv = (holding::value *)(iter.value() + meta_size);
+      hold_list.push_back(std::make_pair((int32_t)hv->h_qty,(double)hv->h_price));
+      iter.next();
+    }
+    if(input.is_lifo) {
+      std::reverse(hold_list.begin(),hold_list.end());
+    }
+
+    for(auto &hold : hold_list) {
+      if(needed_qty == 0)
+        break;
+      int hold_qty = std::abs(hold.first);
+      if(hold_qty == 0) continue;
+      int qty = MIN(hold_qty,needed_qty);
+      hold_price = hold.second;
+      if(tt->tt_is_sell) {
+        buy_value  += qty * hold_price;
+        sell_value += qty * input.requested_price;
+      } else {
+        sell_value += qty * hold_price;
+        buy_value  += qty * input.requested_price;
+      }
+      needed_qty -= qty;
+    }
+  }
+
+  double tax_rates = 0.0;
+  if(sell_value > buy_value && (ca->ca_tax_st == 1 || ca->ca_tax_st == 2)) {
+    rtx::RTXIterator iter(rtx_,CUST_TAX,false);
+    iter.seek(makeCustTaxKey(ca->ca_c_id,0));
+    while(iter.valid()) {
+      uint64_t key = iter.key();
+      if((key >> 32) != (uint64_t)ca->ca_c_id)
+        break;
+      tax_rates += TpceTaxMap[key & 0xffffffff];
+      iter.next();
+    }
+  }
+
+  /* commission rate */
+  double comm_rate = 0.0;
+  uint64_t cr_key = makeCRKey(c->c_tier,input.trade_type_id,exch_id,input.trade_qty);
+  rtx::RTXIterator cr_iter(rtx_,CR,false);
+  cr_iter.seek(cr_key);
+  assert(cr_iter.valid());
+  comm_rate = ((commission_rate::value *)(cr_iter.value() + meta_size))->cr_rate;
+
+  /* fetch charge */
+  uint64_t ch_key = makeChargeKey(TpceTradeTypeMap[std::string(input.trade_type_id)], c->c_tier);
+  charge::value *charge_v = rtx_read<CHARGE,charge::value>(current_partition,ch_key,yield);
+  if(charge_v == NULL) return TPCE_ABORT;
+  double charge_amount = charge_v->ch_chrg;
+
+  /* the remote last trades are fetched here */
+  double hold_assets = 0.0;
+  for(auto &r : margin_lts) {
+    last_trade::value *ltv = (last_trade::value *)(rtx_->load_read(r.first,sizeof(last_trade::value),yield));
+    if(ltv == NULL) return TPCE_ABORT;
+    hold_assets += ltv->lt_price * r.second;
+  }
+  if(rtx_->load_read(lt_idx,sizeof(last_trade::value),yield) == NULL)
+    return TPCE_ABORT;
+  /**** Frame 3 done ****/
+
+  /* Frame 4 */
+  trade::value v_t;
+  bool is_cash = !(input.type_is_margin);
+  auto comm_amount = (comm_rate / 100) * input.trade_qty * input.requested_price;
+
+  v_t.t_dts = now_dts;
+  if(tt->tt_is_mrkt)
+    v_t.t_st_id = std::string(input.st_submitted_id);
+  else
+    v_t.t_st_id = std::string(input.st_pending_id);
+  v_t.t_tt_id = std::string(input.trade_type_id);
+  v_t.t_is_cash = is_cash;
+  v_t.t_s_symb = std::string((char *)symbol);
+  v_t.t_qty = input.trade_qty;
+  v_t.t_bid_price = input.requested_price;
+  v_t.t_ca_id = input.acct_id;
+  v_t.t_exec_name = std::string(input.exec_f_name) + " " + std::string(input.exec_l_name);
+  v_t.t_trade_price = 0;
+  v_t.t_chrg = charge_amount;
+  v_t.t_comm = comm_amount;
+  v_t.t_tax = 0;
+  v_t.t_lifo = input.is_lifo;
+  rtx_->insert<TRADE,trade::value>(current_partition,trade_id,&v_t,yield);
+
+  if(!tt->tt_is_mrkt && pid == (int)current_partition) {
+    /* the trade request is sharded by the security, and its keys are only meaningful locally */
+    trade_request::value trv;
+    trv.tr_tt_id = std::string(input.trade_type_id);
+    trv.tr_qty   = input.trade_qty;
+    trv.tr_bid_price = input.requested_price;
+    uint64_t tr_key = makeTRKey(trade_id, ca->ca_b_id, (const char *)symbol,
+                                SecurityToSector[(char *)symbol].data());
+    rtx_->insert<TRADE_REQ,trade_request::value>(pid,tr_key,&trv,yield);
+  }
+
+  trade_history::value th;
+  uint64_t th_key = makeTHKey(trade_id,now_dts,"PNGD");
+  rtx_->insert<TRADE_HIST,trade_history::value>(current_partition,th_key,&th,yield);
+  /**** Frame 4 done ****/
+
+  bool res = rtx_->commit(yield);
+  if(res) {
+    tradeResultQueue->emplace(input.requested_price,trade_id);
+
+    TTickerEntry entry;
+    strcpy(entry.symbol,(char *)symbol);
+    entry.trade_qty = input.trade_qty;
+    entry.price_quote = input.requested_price;
+    if(pid != (int)current_partition) {
+      /* the market feed is processed at the partition of the last trade */
+      char *msg = rpc_->get_fly_buf(cor_id_);
+      memcpy(msg,(char *)(&entry),sizeof(TTickerEntry));
+      rpc_->append_req(msg,RPC_ADD,sizeof(TTickerEntry),cor_id_,RRpc::REQ,pid);
+    } else {
+      marketFeedQueue->push(entry);
+    }
+  }
+  return txn_result_t(res,1);
+}
+
+txn_result_t TpceWorker::txn_trade_result_api(yield_func_t &yield) {
+
+  static int meta_size = store_->_schemas[HOLDING].meta_len;
+
+  if(tradeResultCache[cor_id_] == NULL) {
+    TTradeResultTxnInput input(0,0);
+    if(!tradeResultQueue->empty()) {
+      input = tradeResultQueue->front();
+      tradeResultQueue->pop();
+    }
+    if(store_->Get(TRADE,input.trade_id) == NULL) {
+      /* the ordered trade is not in the store (the TX api drops the inserts),
+         so a pre-populated trade is settled instead, at its bid price */
+      input.trade_id = encode_trade_id(random_generator[cor_id_].next() % lastTradeId + 1,0,0);
+      input.trade_price = 0;
+      if(store_->Get(TRADE,input.trade_id) == NULL)
+        return txn_result_t(true,1);
+    }
+    tradeResultCache[cor_id_] = new TTradeResultTxnInput(input.trade_price,input.trade_id);
+  }
+  TTradeResultTxnInput *input = tradeResultCache[cor_id_];
+
+  rtx_->begin(yield);
+  uint64_t trade_dts = CDateTime().GetDate();
+
+  /* Frame 1 */
+  trade::value *tv = rtx_write<TRADE,trade::value>(current_partition,input->trade_id,yield);
+  if(tv == NULL) return TPCE_ABORT;
+
+  auto acct_id = tv->t_ca_id;
+  double trade_price = input->trade_price > 0 ? input->trade_price : tv->t_bid_price;
+  trade_type::value *tt = TpceTradeHash[tv->t_tt_id.data()];
+
+  int hs_qty = 0;
+  holding_summary::value *hsv = NULL;
+  uint64_t hs_key = makeHSKey(acct_id,tv->t_s_symb.data());
+  if(store_->Get(HOLDING_SUM,hs_key) != NULL) {
+    hsv = rtx_write<HOLDING_SUM,holding_summary::value>(current_partition,hs_key,yield);
+    if(hsv == NULL) return TPCE_ABORT;
+    hs_qty = hsv->hs_qty;
+  }
+  auto charge_v = tv->t_chrg;
+  /**** Frame 1 done ****/
+
+  /* Frame 2 */
+  double buy_value  = 0.0;
+  double sell_value = 0.0;
+  int needed_qty = tv->t_qty;
+
+  customer_account::value *cav = rtx_write<CUSTACCT,customer_account::value>(current_partition,
+                                                                             acct_id,yield);
+  if(cav == NULL) return TPCE_ABORT;
+
+  /* First close the holdings in the opposite direction */
+  if(tt->tt_is_sell ? (hs_qty > 0) : (hs_qty < 0)) {
+    uint64_t min = makeHoldingKey(acct_id,0,(char *)(tv->t_s_symb.data()),0);
+    uint64_t max = makeHoldingKey(acct_id,std::numeric_limits<uint64_t>::max(),
+                                  (char *)(tv->t_s_symb.data()),
+                                  std::numeric_limits<uint64_t>::max());
+    std::vector<uint64_t> hold_keys;
+    rtx::RTXIterator iter(rtx_,HOLDING,false);
+    iter.seek(min);
+    while(iter.valid() && compareHoldingKey(iter.key(),max)) {
+      hold_keys.push_back(iter.key());
+      iter.next();
+    }
+    if(!tv->t_lifo) {
+      std::reverse(hold_keys.begin(),hold_keys.end());
+    }
+
+    for(uint64_t hold_key : hold_keys) {
+      if(needed_qty == 0) break;
+      holding::value *hv = rtx_write<HOLDING,holding::value>(current_partition,hold_key,yield);
+      if(hv == NULL) return TPCE_ABORT;
+      if(hv->h_qty == 0) continue; /* a closed holding */
+
+      int hold_qty = std::abs(hv->h_qty);
+      int qty = MIN(hold_qty,needed_qty);
+      holding_history::value v_hh;
+      v_hh.hh_before_qty = hv->h_qty;
+      hv->h_qty += tt->tt_is_sell ? -qty : qty;
+      v_hh.hh_after_qty  = hv->h_qty;
+      uint64_t hh_key = makeHoldingHistKey(input->trade_id,((uint64_t *)hold_key)[3]);
+      rtx_->insert<HOLDING_HIST,holding_history::value>(current_partition,hh_key,&v_hh,yield);
+
+      if(tt->tt_is_sell) {
+        buy_value  += qty * hv->h_price;
+        sell_value += qty * trade_price;
+      } else {
+        sell_value += qty * hv->h_price;
+        buy_value  += qty * trade_price;
+      }
+      needed_qty -= qty;
+    }
+  }
+
+  if(needed_qty > 0) {
+    /* open a new holding with the rest */
+    holding_history::value v_hh;
+    v_hh.hh_before_qty = 0;
+    v_hh.hh_after_qty  = tt->tt_is_sell ? -needed_qty : needed_qty;
+    uint64_t hh_key = makeHoldingHistKey(input->trade_id,input->trade_id);
+    rtx_->insert<HOLDING_HIST,holding_history::value>(current_partition,hh_key,&v_hh,yield);
+
+    holding::value v_h;
+    v_h.h_price = trade_price;
+    v_h.h_qty   = v_hh.hh_after_qty;
+    v_h.h_dts   = trade_dts;
+    uint64_t hk = makeHoldingKey(acct_id,input->trade_id,tv->t_s_symb.data(),trade_dts);
+    rtx_->insert<HOLDING,holding::value>(current_partition,hk,&v_h,yield);
+  }
+
+  int new_hs_qty = tt->tt_is_sell ? hs_qty - tv->t_qty : hs_qty + tv->t_qty;
+  if(hsv != NULL) {
+    hsv->hs_qty = new_hs_qty;
+  } else {
+    holding_summary::value hs;
+    hs.hs_qty = new_hs_qty;
+    rtx_->insert<HOLDING_SUM,holding_summary::value>(current_partition,hs_key,&hs,yield);
+  }
+  /**** Frame 2 done ****/
+
+  /* Frame 3 */
+  double tax_rates = 0.0;
+  uint64_t cust_id = cav->ca_c_id;
+  rtx::RTXIterator ct_iter(rtx_,CUST_TAX,false);
+  ct_iter.seek(makeCustTaxKey(cust_id,0));
+  while(ct_iter.valid()) {
+    if((ct_iter.key() >> 32) != cust_id) break;
+    tax_rates += TpceTaxMap[ct_iter.key() & 0xffffffff];
+    ct_iter.next();
+  }
+  tv->t_tax = (sell_value - buy_value) * tax_rates;
+  /**** Frame 3 done ****/
+
+  /* Frame 4 */
+  security::value *vs = rtx_read<SECURITY,security::value>(current_partition,
+                                                           makeSecurityIndex(tv->t_s_symb.data()),yield);
+  if(vs == NULL) return TPCE_ABORT;
+  customers::value *vc = rtx_read<ECUST,customers::value>(current_partition,cust_id,yield);
+  if(vc == NULL) return TPCE_ABORT;
+
+  double comm_rate = 0.0;
+  rtx::RTXIterator cr_iter(rtx_,CR,false);
+  cr_iter.seek(makeCRKey(vc->c_tier,tv->t_tt_id.data(),vs->s_ex_id.data(),0));
+  while(cr_iter.valid()) {
+    commission_rate::value *cv = (commission_rate::value *)(cr_iter.value() + meta_size);
+    if(cv->cr_to_qty >= tv->t_qty) {
+      comm_rate = cv->cr_rate;
+      break;
+    }
+    cr_iter.next();
+  }
+  /**** Frame 4 done ****/
+
+  /* Frame 5 */
+  double comm_amount = (comm_rate / 100) * (tv->t_qty * trade_price);
+  tv->t_comm        = comm_amount;
+  tv->t_dts         = MAX(trade_dts,tv->t_dts);
+  tv->t_st_id       = std::string("CMPT");
+  tv->t_trade_price = trade_price;
+
+  trade_history::value v_th;
+  uint64_t th_key = makeTHKey(input->trade_id,trade_dts,"CMPT");
+  rtx_->insert<TRADE_HIST,trade_history::value>(current_partition,th_key,&v_th,yield);
+
+  uint64_t b_id = cav->ca_b_id;
+  if(brokerToPartition(b_id) == (int)current_partition) {
+    broker::value *vb = rtx_write<BROKER,broker::value>(current_partition,b_id,yield);
+    if(vb == NULL) return TPCE_ABORT;
+    vb->b_comm_total += comm_amount;
+    vb->b_num_trades += 1;
+  }
+  /**** Frame 5 done ****/
+
+  /* Frame 6 */
+  CDateTime   due_date_time( trade_dts );
+  due_date_time.Add(2, 0);        // add 2 days
+  due_date_time.SetHMS(0,0,0,0);  // zero out time portion
+
+  double se_amount = tv->t_qty * trade_price - charge_v - comm_amount;
+
+  settlement::value setv;
+  setv.se_cash_type = tv->t_is_cash ? "Cash Account" : "Margin";
+  setv.se_cash_due_date = due_date_time.GetDate();
+  setv.se_amt = se_amount;
+  rtx_->insert<SETTLEMENT,settlement::value>(current_partition,input->trade_id,&setv,yield);
+
+  if(tv->t_is_cash) {
+    cav->ca_bal += se_amount;
+
+    cash_transaction::value ctx;
+    ctx.ct_dts = trade_dts;
+    ctx.ct_amt = se_amount;
+    ctx.ct_name = std::string(tt->tt_name.data()) +
+                  " " + std::to_string(tv->t_qty) + " shares of " + std::string(vs->s_name.data());
+    rtx_->insert<CASH_TX,cash_transaction::value>(current_partition,input->trade_id,&ctx,yield);
+  }
+  /**** Frame 6 done ****/
+
+  bool res = rtx_->commit(yield);
+  if(res) {
+    delete tradeResultCache[cor_id_];
+    tradeResultCache[cor_id_] = NULL;
+  }
+  return txn_result_t(res,1);
+}
+
+txn_result_t TpceWorker::txn_market_feed_api(yield_func_t &yield) {
+
+  if(market_feed_process_idx[cor_id_] == -1) {
+    /* nothing has processed yet*/
+    if(marketFeedQueue->size() < 10)
+      return txn_result_t(true,1);
+    for(uint i = 0;i < 10;++i) {
+      tickerBuffer[cor_id_][i] = marketFeedQueue->front();
+      marketFeedQueue->pop();
+    }
+  }
+  auto now_dts = CDateTime().GetDate();
+  const char *min_s = "\0";
+
+  /* each ticker is processed in a separate TX, an aborted one is retried from the ticker */
+  for(uint i = market_feed_process_idx[cor_id_] + 1;i < 10;++i) {
+
+    rtx_->begin(yield);
+    auto &ticker = tickerBuffer[cor_id_][i];
+    int pid = companyToPartition(SecurityToCompany[ticker.symbol]);
+
+    last_trade::value *lt = rtx_write<LT1,last_trade::value>(pid,SecurityToId[ticker.symbol],yield);
+    if(lt == NULL) return TPCE_ABORT;
+    lt->lt_price = lt->lt_price + ticker.price_quote;
+    lt->lt_vol  += ticker.trade_qty;
+    lt->lt_dts   = now_dts;
+
+    if(pid == (int)current_partition) {
+      /* submit the pending trade requests of the security */
+      rtx::RTXIterator tr_iter(rtx_,TRADE_REQ,false);
+      tr_iter.seek(makeTRKey(0,0,ticker.symbol,min_s));
+      while(tr_iter.valid()) {
+        uint64_t *key = (uint64_t *)tr_iter.key();
+        if(!compareSecurityKey((uint64_t)key,(uint64_t)(ticker.symbol))) break;
+
+        uint64_t trade_id = key[3];
+        if(decode_trade_mac(trade_id) == (int)current_partition && store_->Get(TRADE,trade_id) != NULL) {
+          trade::value *tv = rtx_write<TRADE,trade::value>(current_partition,trade_id,yield);
+          if(tv == NULL) return TPCE_ABORT;
+          tv->t_dts   = MAX(now_dts,tv->t_dts);
+          tv->t_st_id = std::string("SBMT");
+
+          trade_history::value th;
+          uint64_t th_key = makeTHKey(trade_id,now_dts,"SBMT");
+          rtx_->insert<TRADE_HIST,trade_history::value>(current_partition,th_key,&th,yield);
+        }
+        tr_iter.next();
+      }
+    }
+    if(!rtx_->commit(yield))
+      return TPCE_ABORT;
+    market_feed_process_idx[cor_id_] += 1;
+  }
+  market_feed_process_idx[cor_id_] = -1;
+  return txn_result_t(true,1);
+}
+
+/* read the settlement, cash transaction and trade history of a (local) trade */
+bool TpceWorker::read_trade_details_api(uint64_t tid,bool is_cash,int max_hist,yield_func_t &yield) {
+
+  if(store_->Get(SETTLEMENT,tid) != NULL &&
+     rtx_read<SETTLEMENT,settlement::value>(current_partition,tid,yield) == NULL)
+    return false;
+
+  if(is_cash && store_->Get(CASH_TX,tid) != NULL &&
+     rtx_read<CASH_TX,cash_transaction::value>(current_partition,tid,yield) == NULL)
+    return false;
+
+  const char *min_s = "\0";
+  int th_cursor(0);
+  rtx::RTXIterator th_iter(rtx_,TRADE_HIST,false);
+  th_iter.seek(makeTHKey(tid,0,min_s));
+  while(th_iter.valid()) {
+    uint64_t *key = (uint64_t *)th_iter.key();
+    if(key[0] != tid || th_cursor >= max_hist) break;
+    if(rtx_read<TRADE_HIST,trade_history::value>(current_partition,th_iter.key(),yield) == NULL)
+      return false;
+    th_cursor += 1;
+    th_iter.next();
+  }
+  return true;
+}
+
+txn_result_t TpceWorker::txn_trade_lookup_api(yield_func_t &yield) {
+
+  TTradeLookupTxnInput input;
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  input_generator_->GenerateTradeLookupInput(input);
+
+  if(input.frame_to_execute == 1) {
+    return trade_lookup_frame1_api(yield,input);
+  } else if(input.frame_to_execute == 2) {
+    return trade_lookup_frame2_api(yield,input);
+  } else if(input.frame_to_execute == 3) {
+    return trade_lookup_frame3_api(yield,input);
+  } else if(input.frame_to_execute == 4) {
+    return trade_lookup_frame4_api(yield,input);
+  }
+  return txn_result_t(true,73);
+}
+
+txn_result_t TpceWorker::trade_lookup_frame1_api(yield_func_t &yield, TTradeLookupTxnInput &input) {
+
+  rtx_->begin(yield);
+  for(int i = 0;i < input.max_trades;++i) {
+    /* This id is generated by egen, so we shall fix it.*/
+    uint64_t tid = encode_trade_id(input.trade_id[i],0,0);
+    if(store_->Get(TRADE,tid) == NULL) continue;
+
+    trade::value *tv = rtx_read<TRADE,trade::value>(current_partition,tid,yield);
+    if(tv == NULL) return TPCE_ABORT;
+    if(!read_trade_details_api(tid,tv->t_is_cash,TradeLookupMaxTradeHistoryRowsReturned,yield))
+      return TPCE_ABORT;
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::trade_lookup_frame2_api(yield_func_t &yield, TTradeLookupTxnInput &input) {
+
+  rtx_->begin(yield);
+  auto start_dts = CDateTime((TIMESTAMP_STRUCT*)&input.start_trade_dts).GetDate();
+  auto end_dts = CDateTime((TIMESTAMP_STRUCT*)&input.end_trade_dts).GetDate();
+
+  int num_found(0);
+  rtx::RTXIterator t_ca_iter(rtx_,SEC_CA_TRADE,true);
+  t_ca_iter.seek(makeSecondCATrade(input.acct_id,start_dts,0));
+  while(t_ca_iter.valid()) {
+    uint64_t *key = (uint64_t *)t_ca_iter.key();
+    if(num_found >= input.max_trades || key[0] != (uint64_t)input.acct_id || key[1] > end_dts) break;
+
+    trade::value *tv = rtx_read<TRADE,trade::value>(current_partition,key[2],yield);
+    if(tv == NULL) return TPCE_ABORT;
+    if(!read_trade_details_api(key[2],tv->t_is_cash,TradeLookupMaxTradeHistoryRowsReturned,yield))
+      return TPCE_ABORT;
+    num_found += 1;
+    t_ca_iter.next();
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::trade_lookup_frame3_api(yield_func_t &yield, TTradeLookupTxnInput &input) {
+
+  rtx_->begin(yield);
+  uint64_t start_dts = CDateTime((TIMESTAMP_STRUCT*)&input.start_trade_dts).GetDate();
+  uint64_t end_dts = CDateTime((TIMESTAMP_STRUCT*)&input.end_trade_dts).GetDate();
+
+  /* the security-trade index is kept at the partition of the security,
+     so only the trades of a local security are looked up */
+  if(companyToPartition(SecurityToCompany[input.symbol]) == (int)current_partition) {
+    int num_found(0);
+    rtx::RTXIterator sec_iter(rtx_,SEC_S_T,true);
+    sec_iter.seek(makeSecondSecTrade(input.symbol,start_dts,0));
+    while(sec_iter.valid()) {
+      uint64_t *key = (uint64_t *)sec_iter.key();
+      if(num_found >= TradeLookupMaxRows ||
+         !compareSecurityKey((uint64_t)(&key[0]),(uint64_t)(input.symbol)) || key[3] > end_dts)
+        break;
+      uint64_t tid = key[4];
+      num_found += 1;
+      sec_iter.next();
+
+      if(decode_trade_mac(tid) != (int)current_partition || store_->Get(TRADE,tid) == NULL)
+        continue;
+      trade::value *tv = rtx_read<TRADE,trade::value>(current_partition,tid,yield);
+      if(tv == NULL) return TPCE_ABORT;
+      if(!read_trade_details_api(tid,tv->t_is_cash,TradeLookupMaxTradeHistoryRowsReturned,yield))
+        return TPCE_ABORT;
+    }
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::trade_lookup_frame4_api(yield_func_t &yield, TTradeLookupTxnInput &input) {
+
+  rtx_->begin(yield);
+  auto dts = CDateTime((TIMESTAMP_STRUCT*)&(input.start_trade_dts)).GetDate();
+
+  rtx::RTXIterator t_iter(rtx_,SEC_CA_TRADE,true);
+  t_iter.seek(makeSecondCATrade(input.acct_id,dts,0));
+  if(t_iter.valid()) {
+    uint64_t *key = (uint64_t *)t_iter.key();
+    uint64_t tid = key[2];
+    if(key[0] == (uint64_t)input.acct_id && decode_trade_mac(tid) == (int)current_partition) {
+      /* fetching holding history */
+      int count(0);
+      rtx::RTXIterator hh_iter(rtx_,HOLDING_HIST,false);
+      hh_iter.seek(makeHoldingHistKey(tid,0));
+      while(hh_iter.valid()) {
+        uint64_t *hh_key = (uint64_t *)hh_iter.key();
+        if(hh_key[0] != tid || count >= TradeLookupFrame4MaxRows)
+          break;
+        if(rtx_read<HOLDING_HIST,holding_history::value>(current_partition,hh_iter.key(),yield) == NULL)
+          return TPCE_ABORT;
+        count += 1;
+        hh_iter.next();
+      }
+    }
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::txn_trade_status_api(yield_func_t &yield) {
+
+  TTradeStatusTxnInput input;
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  input_generator_->GenerateTradeStatusInput(input);
+
+  rtx_->begin(yield);
+
+  int t_cursor(0);
+  rtx::RTXIterator ca_iter(rtx_,SEC_CA_TRADE,true);
+  ca_iter.seek(makeSecondCATrade(input.acct_id,0,0));
+  while(ca_iter.valid()) {
+    uint64_t *key = (uint64_t *)ca_iter.key();
+    if(key[0] != (uint64_t)input.acct_id || t_cursor >= 50)
+      break;
+    ca_iter.next();
+    if(store_->Get(TRADE,key[2]) == NULL) continue;
+
+    trade::value *tr = rtx_read<TRADE,trade::value>(current_partition,key[2],yield);
+    if(tr == NULL) return TPCE_ABORT;
+    security::value *sec = rtx_read<SECURITY,security::value>(current_partition,
+                                                              makeSecurityIndex(tr->t_s_symb.data()),yield);
+    if(sec == NULL) return TPCE_ABORT;
+    exchange::value *exc = rtx_read<EXCHANGE,exchange::value>(current_partition,
+                                                              TpceExchangeMap[sec->s_ex_id.data()],yield);
+    if(exc == NULL) return TPCE_ABORT;
+    t_cursor += 1;
+  }
+
+  customer_account::value *ca = rtx_read<CUSTACCT,customer_account::value>(current_partition,
+                                                                           input.acct_id,yield);
+  if(ca == NULL) return TPCE_ABORT;
+  if(rtx_read<ECUST,customers::value>(current_partition,ca->ca_c_id,yield) == NULL)
+    return TPCE_ABORT;
+  if(rtx_read<BROKER,broker::value>(current_partition,ca->ca_b_id,yield) == NULL)
+    return TPCE_ABORT;
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::txn_security_detail_api(yield_func_t &yield) {
+
+  TSecurityDetailTxnInput input;
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  input_generator_->GenerateSecurityDetailInput(input);
+
+  rtx_->begin(yield);
+
+  security::value *s = rtx_read<SECURITY,security::value>(current_partition,
+                                                          makeSecurityIndex(input.symbol),yield);
+  if(s == NULL) return TPCE_ABORT;
+  uint64_t co_id = s->s_co_id;
+
+  /* the last trade may be remote, it is fetched after the local parts */
+  int lt_idx = rtx_->read(companyToPartition(co_id),LT1,SecurityToId[input.symbol],
+                          sizeof(last_trade::value),yield);
+  if(lt_idx < 0) return TPCE_ABORT;
+
+  company::value *vc = rtx_read<COMPANY,company::value>(current_partition,co_id,yield);
+  if(vc == NULL) return TPCE_ABORT;
+  exchange::value *ex = rtx_read<EXCHANGE,exchange::value>(current_partition,
+                                                           TpceExchangeMap[s->s_ex_id.data()],yield);
+  if(ex == NULL) return TPCE_ABORT;
+
+  const char *min_s = "\0";
+  rtx::RTXIterator cc_iter(rtx_,COMPANY_C,false);
+  cc_iter.seek(makeCCKey(co_id,0,min_s));
+  while(cc_iter.valid()) {
+    uint64_t *key = (uint64_t *)cc_iter.key();
+    if(key[0] != co_id) break;
+    if(rtx_read<COMPANY,company::value>(current_partition,key[1],yield) == NULL)
+      return TPCE_ABORT;
+    cc_iter.next();
+  }
+
+  int row_count(0);
+  rtx::RTXIterator fin_iter(rtx_,FINANCIAL,false);
+  fin_iter.seek(makeFinKey(co_id,0,0));
+  while(fin_iter.valid()) {
+    uint64_t *key = (uint64_t *)fin_iter.key();
+    if(row_count >= max_fin_len || key[0] != co_id) break;
+    if(rtx_read<FINANCIAL,financial::value>(current_partition,fin_iter.key(),yield) == NULL)
+      return TPCE_ABORT;
+    row_count += 1;
+    fin_iter.next();
+  }
+
+  int dm_len(0);
+  rtx::RTXIterator dm_iter(rtx_,DAILY_MARKET,false);
+  dm_iter.seek(makeDMKey(input.symbol,CDateTime((TIMESTAMP_STRUCT*)&(input.start_day)).GetDate()));
+  while(dm_iter.valid()) {
+    uint64_t *key = (uint64_t *)(dm_iter.key());
+    if(dm_len >= input.max_rows_to_return ||
+       !compareSecurityKey((uint64_t)(&(key[0])),(uint64_t)(input.symbol)))
+      break;
+    if(rtx_read<DAILY_MARKET,daily_market::value>(current_partition,dm_iter.key(),yield) == NULL)
+      return TPCE_ABORT;
+    dm_len += 1;
+    dm_iter.next();
+  }
+
+  int nx_len(0);
+  rtx::RTXIterator nx_iter(rtx_,NEWS_XREF,false);
+  nx_iter.seek(makeNXRKey(co_id,0));
+  while(nx_iter.valid()) {
+    uint64_t *key = (uint64_t *)nx_iter.key();
+    if(key[0] != co_id || nx_len >= max_news_len) break;
+    assert(TpceNewsItem.find(key[1]) != TpceNewsItem.end());
+    nx_len += 1;
+    nx_iter.next();
+  }
+
+  if(rtx_->load_read(lt_idx,sizeof(last_trade::value),yield) == NULL)
+    return TPCE_ABORT;
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::txn_market_watch_api(yield_func_t &yield) {
+
+  TMarketWatchTxnInput input;
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  input_generator_->GenerateMarketWatchInput(input);
+
+  uint64_t start_day =  CDateTime((TIMESTAMP_STRUCT*) (&(input.start_day))).GetDate();
+
+  rtx_->begin(yield);
+
+  std::vector<SK> stock_list;
+  const char *min_s = "\0";
+  if(input.c_id) {
+    /* customer's watch list */
+    auto &list = WatchItem[WatchList[input.c_id]];
+    for(uint i = 0;i < list.size();++i)
+      stock_list.emplace_back(list[i]);
+  } else if(input.industry_name[0]) {
+    uint64_t in_id = IndustryNametoID[input.industry_name];
+    rtx::RTXIterator iter(rtx_,SEC_SC_INS,true);
+    iter.seek(makeSecondCompanyIndustrySecurity(in_id,input.starting_co_id,min_s));
+    while(iter.valid()) {
+      uint64_t *key = (uint64_t *)(iter.key());
+      if(key[0] != in_id || key[1] > (uint64_t)input.ending_co_id) break;
+      stock_list.emplace_back((char *)(&(key[2])));
+      iter.next();
+    }
+  } else if(input.acct_id) {
+    rtx::RTXIterator iter(rtx_,HOLDING_SUM,false);
+    iter.seek(makeHSKey(input.acct_id,min_s));
+    while(iter.valid()) {
+      uint64_t *key = (uint64_t *)(iter.key());
+      if(key[0] != (uint64_t)input.acct_id) break;
+      stock_list.emplace_back((char *)(&(key[1])));
+      iter.next();
+    }
+  }
+
+  /* the last trades are read from their partitions in a batch */
+  std::vector<int> lt_idxs;
+  for(auto &s : stock_list) {
+    int pid = companyToPartition(SecurityToCompany[s.data]);
+    int idx = rtx_->read(pid,LT1,SecurityToId[s.data],sizeof(last_trade::value),yield);
+    if(idx < 0) return TPCE_ABORT;
+    lt_idxs.push_back(idx);
+  }
+
+  for(auto &s : stock_list) {
+    if(rtx_read<SECURITY,security::value>(current_partition,(uint64_t)(s.data),yield) == NULL)
+      return TPCE_ABORT;
+    uint64_t dm_key = makeDMKey(s.data,start_day);
+    if(store_->Get(DAILY_MARKET,dm_key) != NULL &&
+       rtx_read<DAILY_MARKET,daily_market::value>(current_partition,dm_key,yield) == NULL)
+      return TPCE_ABORT;
+  }
+
+  for(int idx : lt_idxs) {
+    if(rtx_->load_read(idx,sizeof(last_trade::value),yield) == NULL)
+      return TPCE_ABORT;
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::txn_broker_volume_api(yield_func_t &yield) {
+
+  TBrokerVolumeTxnInput1 input;
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  input_generator_->GenerateBrokerVolumeInput(input);
+
+  rtx_->begin(yield);
+
+  auto &sc_id = TpceSector[input.sector_name];
+  const char *min_s = "\0";
+
+  /* the trade requests of a broker are kept at its partition, so only the local brokers are summed */
+  double broker_volumn(0);
+  for(int i = 0;i < input.broker_num;++i) {
+    uint64_t b_id = input.broker_list[i];
+    if(brokerToPartition(b_id) != (int)current_partition)
+      continue;
+    if(rtx_read<BROKER,broker::value>(current_partition,b_id,yield) == NULL)
+      return TPCE_ABORT;
+
+    rtx::RTXIterator tr_iter(rtx_,SEC_SC_TR,true);
+    tr_iter.seek(makeSecondTradeRequest(sc_id.data(),b_id,min_s,0));
+    while(tr_iter.valid()) {
+      uint64_t *key = (uint64_t *)(tr_iter.key());
+      if(key[1] != b_id) break;
+      uint64_t k = transferToTR(tr_iter.key());
+      tr_iter.next();
+      if(store_->Get(TRADE_REQ,k) == NULL) continue;
+
+      trade_request::value *v = rtx_read<TRADE_REQ,trade_request::value>(current_partition,k,yield);
+      if(v == NULL) return TPCE_ABORT;
+      broker_volumn += v->tr_bid_price * v->tr_qty;
+    }
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::txn_trade_update_api(yield_func_t &yield) {
+
+  TTradeUpdateTxnInput input;
+  input_generator_->SetRNGSeed(random_generator[cor_id_].get_seed());
+  input_generator_->GenerateTradeUpdateInput(input);
+
+  if(input.frame_to_execute == 1) {
+    return trade_update_frame1_api(yield,input);
+  } else if(input.frame_to_execute == 2) {
+    return trade_update_frame2_api(yield,input);
+  } else if(input.frame_to_execute == 3) {
+    return trade_update_frame3_api(yield,input);
+  }
+  return txn_result_t(true,73);
+}
+
+txn_result_t TpceWorker::trade_update_frame1_api(yield_func_t &yield,TTradeUpdateTxnInput &input) {
+
+  rtx_->begin(yield);
+  int num_updates(0);
+
+  for(int i = 0;i < input.max_trades;++i) {
+    uint64_t tid = encode_trade_id(input.trade_id[i],0,0);
+    if(store_->Get(TRADE,tid) == NULL) continue;
+
+    trade::value *tv;
+    if(num_updates < input.max_updates) {
+      tv = rtx_write<TRADE,trade::value>(current_partition,tid,yield);
+      if(tv == NULL) return TPCE_ABORT;
+      num_updates += 1;
+
+      std::string temp_exec_name = tv->t_exec_name.data();
+      size_t index = temp_exec_name.find(" X ");
+      if(index != std::string::npos){
+        temp_exec_name.replace(index, 3, " ");
+      } else {
+        index = temp_exec_name.find(" ");
+        if(index != std::string::npos)
+          temp_exec_name.replace(index, 1, " X ");
+      }
+      tv->t_exec_name = temp_exec_name;
+    } else {
+      tv = rtx_read<TRADE,trade::value>(current_partition,tid,yield);
+      if(tv == NULL) return TPCE_ABORT;
+    }
+    if(!read_trade_details_api(tid,tv->t_is_cash,TradeUpdateMaxTradeHistoryRowsReturned,yield))
+      return TPCE_ABORT;
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::trade_update_frame2_api(yield_func_t &yield,TTradeUpdateTxnInput &input) {
+
+  rtx_->begin(yield);
+  auto start_dts = CDateTime((TIMESTAMP_STRUCT*)&input.start_trade_dts).GetDate();
+  auto end_dts = CDateTime((TIMESTAMP_STRUCT*)&input.end_trade_dts).GetDate();
+
+  int num_found(0), num_updates(0);
+  rtx::RTXIterator t_ca_iter(rtx_,SEC_CA_TRADE,true);
+  t_ca_iter.seek(makeSecondCATrade(input.acct_id,start_dts,0));
+  while(t_ca_iter.valid()) {
+    uint64_t *key = (uint64_t *)t_ca_iter.key();
+    if(num_found >= input.max_trades || key[0] != (uint64_t)input.acct_id || key[1] > end_dts) break;
+    uint64_t tid = key[2];
+    num_found += 1;
+    t_ca_iter.next();
+    if(store_->Get(SETTLEMENT,tid) == NULL) continue;
+
+    trade::value *tv = rtx_read<TRADE,trade::value>(current_partition,tid,yield);
+    if(tv == NULL) return TPCE_ABORT;
+
+    if(num_updates < input.max_updates) {
+      settlement::value *sv = rtx_write<SETTLEMENT,settlement::value>(current_partition,tid,yield);
+      if(sv == NULL) return TPCE_ABORT;
+      if(tv->t_is_cash) {
+        if(sv->se_cash_type == "Cash Account") sv->se_cash_type = "Cash";
+        else sv->se_cash_type = "Cash Account";
+      } else {
+        if(sv->se_cash_type == "Margin Account") sv->se_cash_type = "Margin";
+        else sv->se_cash_type = "Margin Account";
+      }
+      num_updates += 1;
+    }
+    if(!read_trade_details_api(tid,tv->t_is_cash,TradeUpdateMaxTradeHistoryRowsReturned,yield))
+      return TPCE_ABORT;
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+txn_result_t TpceWorker::trade_update_frame3_api(yield_func_t &yield,TTradeUpdateTxnInput &input) {
+
+  rtx_->begin(yield);
+  uint64_t start_dts = CDateTime((TIMESTAMP_STRUCT*)&input.start_trade_dts).GetDate();
+  uint64_t end_dts = CDateTime((TIMESTAMP_STRUCT*)&input.end_trade_dts).GetDate();
+
+  /* as trade lookup's frame 3, only the trades of a local security are updated */
+  if(companyToPartition(SecurityToCompany[input.symbol]) == (int)current_partition) {
+    int num_found(0), num_updates(0);
+    rtx::RTXIterator sec_iter(rtx_,SEC_S_T,true);
+    sec_iter.seek(makeSecondSecTrade(input.symbol,start_dts,0));
+    while(sec_iter.valid()) {
+      uint64_t *key = (uint64_t *)sec_iter.key();
+      if(num_found >= input.max_trades ||
+         !compareSecurityKey((uint64_t)(&key[0]),(uint64_t)(input.symbol)) || key[3] > end_dts)
+        break;
+      uint64_t tid = key[4];
+      num_found += 1;
+      sec_iter.next();
+
+      if(decode_trade_mac(tid) != (int)current_partition || store_->Get(TRADE,tid) == NULL)
+        continue;
+      trade::value *tv = rtx_read<TRADE,trade::value>(current_partition,tid,yield);
+      if(tv == NULL) return TPCE_ABORT;
+      security::value *sv = rtx_read<SECURITY,security::value>(current_partition,
+                                                               makeSecurityIndex(tv->t_s_symb.data()),yield);
+      if(sv == NULL) return TPCE_ABORT;
+
+      if(tv->t_is_cash && num_updates < input.max_updates && store_->Get(CASH_TX,tid) != NULL) {
+        cash_transaction::value *cv = rtx_write<CASH_TX,cash_transaction::value>(current_partition,
+                                                                                 tid,yield);
+        if(cv == NULL) return TPCE_ABORT;
+        trade_type::value *tt = TpceTradeHash[tv->t_tt_id.data()];
+        std::stringstream ss;
+        if(cv->ct_name.str().find(" shares of ") != std::string::npos)
+          ss << tt->tt_name.data() << " " << tv->t_qty << " Shares of " << sv->s_name.data();
+        else
+          ss << tt->tt_name.data() << " " << tv->t_qty << " shares of " << sv->s_name.data();
+        cv->ct_name = ss.str();
+        num_updates += 1;
+      }
+      if(store_->Get(SETTLEMENT,tid) != NULL &&
+         rtx_read<SETTLEMENT,settlement::value>(current_partition,tid,yield) == NULL)
+        return TPCE_ABORT;
+    }
+  }
+  return txn_result_t(rtx_->commit(yield),1);
+}
+
+#endif // ENABLE_TXN_API
+
+} // namespace tpce
+
+} // namespace oltp
+
+} // namespace nocc
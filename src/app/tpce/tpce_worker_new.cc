@@ -27,6 +27,8 @@ extern std::map<uint64_t,std::vector<std::string> > WatchItem;
 extern std::map<std::string,std::uint64_t >         SecurityToId;
 extern std::map<std::string,uint64_t> SecurityToCompany;
 
+#if ENABLE_TXN_API
+
 txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
 
   TCustomerPositionTxnInput input;
@@ -54,9 +56,10 @@ txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
 
   std::vector<uint64_t> acct_ids;
 
-  customers::value *vc = rtx_->get<ECUST,customers::value>(current_partition,
-                                                           cust_id,yield);
-  assert(vc != NULL);
+  customers::value *vc = rtx_read<ECUST,customers::value>(current_partition,cust_id,yield);
+  if(vc == NULL) return txn_result_t(false,73);
+
+  std::vector<int> lt_idxs; // the last trades are fetched in a batch
 
   uint64_t c_key_start = makeCustAcctKey(cust_id,0);
 
@@ -71,8 +74,9 @@ txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
     uint64_t acct_id = key[1];
     acct_ids.push_back(acct_id);
 
-    customer_account::value *cv = rtx_->get<CUSTACCT,customer_account::value>(current_partition,
-                                                                              acct_id,yield);
+    customer_account::value *cv = rtx_read<CUSTACCT,customer_account::value>(current_partition,
+                                                                             acct_id,yield);
+    if(cv == NULL) return txn_result_t(false,73);
     rtx::RTXIterator hs_iter(rtx_,HOLDING_SUM,false);
 
     uint64_t hs_start_key = makeHSKey(acct_id,(const char *)(min_s));
@@ -89,16 +93,20 @@ txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
 
       int pid = companyToPartition(co_id);
 
-      //      LOG(4) << "fetch lt from " << pid;
-      last_trade::value *lt = rtx_->get<LT1,last_trade::value>(pid,
-                                                               lt_id,yield);
-      //LOG(4) << "fetch lt from " << pid << "; check value " << lt->lt_price;
+      int idx = rtx_->read(pid,LT1,lt_id,sizeof(last_trade::value),yield);
+      if(idx < 0) return txn_result_t(false,73);
+      lt_idxs.push_back(idx);
       hs_iter.next();
     }
 
     c_iter.next();
   }
 
+  for(int idx : lt_idxs) {
+    last_trade::value *lt = (last_trade::value *)rtx_->load_read(idx,sizeof(last_trade::value),yield);
+    if(lt == NULL) return txn_result_t(false,73);
+  }
+
   int hist_len = 0;
 
   if(input.get_history) {
@@ -115,7 +123,8 @@ txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
       uint64_t *key = (uint64_t *)(iter.key());
       if(count++ == 10 || acct_id != key[0])
         break;
-      trade::value *tv = rtx_->get<TRADE,trade::value>(current_partition,key[2],yield);
+      trade::value *tv = rtx_read<TRADE,trade::value>(current_partition,key[2],yield);
+      if(tv == NULL) return txn_result_t(false,73);
 
       rtx::RTXIterator th_iter(rtx_,TRADE_HIST,false);
       uint64_t min_th_key = makeTHKey(key[2],std::numeric_limits<uint64_t>::min(),min_s);
@@ -123,10 +132,11 @@ txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
 
       while(th_iter.valid()) {
         uint64_t *th_key = (uint64_t *)th_iter.key();
-        trade_history::value *v = rtx_->get<TRADE_HIST,trade_history::value>(current_partition,
-                                                                             (uint64_t)th_key,yield);
         if(th_key[0] != key[2])
           break;
+        trade_history::value *v = rtx_read<TRADE_HIST,trade_history::value>(current_partition,
+                                                                            (uint64_t)th_key,yield);
+        if(v == NULL) return txn_result_t(false,73);
         hist_len += 1;
         th_iter.next();
       }
@@ -138,6 +148,8 @@ txn_result_t TpceWorker::txn_cp_new(yield_func_t &yield) {
   return txn_result_t(res,1);
 }
 
+#endif // ENABLE_TXN_API
+
 } // namespace oltp
 
 } // namespace tpce
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "framework/utils/util.h"
+
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * Key choosers of YCSB, following the generators of the YCSB core package.
+ * All generators return an item index in [0, n), and are not thread-safe.
+ */
+
+namespace nocc {
+namespace oltp {
+namespace ycsb {
+
+class UniformGenerator {
+ public:
+  explicit UniformGenerator(uint64_t n) : n_(n) { }
+
+  inline uint64_t next(util::fast_random &r) {
+    return r.next() % n_;
+  }
+ private:
+  uint64_t n_;
+};
+
+/**
+ * Zipfian over [0, n), item 0 is the most popular one.
+ * Uses the method of Gray et al., "Quickly generating billion-record synthetic databases".
+ * n can grow after construction (as the latest generator does); zeta is then extended incrementally.
+ */
+class ZipfianGenerator {
+ public:
+  // zetan can be given if it is pre-computed, since computing it is O(n)
+  ZipfianGenerator(uint64_t n,double theta,double zetan = 0)
+      : theta_(theta),
+        alpha_(1.0 / (1.0 - theta)),
+        zeta2_(zeta(0,2,theta,0)),
+        n_(0),zetan_(0) {
+    if(zetan > 0) {
+      n_ = n;
+      zetan_ = zetan;
+      update_eta();
+    } else
+      grow(n);
+  }
+
+  static double zeta(uint64_t from,uint64_t to,double theta,double initial) {
+    double sum = initial;
+    for(uint64_t i = from;i < to;++i)
+      sum += 1.0 / pow(i + 1,theta);
+    return sum;
+  }
+
+  inline uint64_t next(util::fast_random &r) {
+    double u  = r.next_uniform();
+    double uz = u * zetan_;
+    if(uz < 1.0)
+      return 0;
+    if(uz < 1.0 + pow(0.5,theta_))
+      return 1;
+    uint64_t ret = (uint64_t)(n_ * pow(eta_ * u - eta_ + 1,alpha_));
+    return ret < n_ ? ret : n_ - 1;
+  }
+
+  inline uint64_t next(util::fast_random &r,uint64_t n) {
+    if(n != n_)
+      grow(n);
+    return next(r);
+  }
+
+ private:
+  void grow(uint64_t n) {
+    if(n < n_) {
+      // shrinking is rare, re-compute from scratch
+      n_ = 0;
+      zetan_ = 0;
+    }
+    zetan_ = zeta(n_,n,theta_,zetan_);
+    n_ = n;
+    update_eta();
+  }
+
+  inline void update_eta() {
+    eta_ = (1 - pow(2.0 / n_,1 - theta_)) / (1 - zeta2_ / zetan_);
+  }
+
+  const double theta_;
+  const double alpha_;
+  const double zeta2_;
+  uint64_t n_;
+  double   zetan_;
+  double   eta_;
+};
+
+/**
+ * Zipfian whose popular items are scattered over the key space, rather than clustered
+ * at its head, by hashing the zipfian rank (FNV-1a, as YCSB does).
+ */
+class ScrambledZipfianGenerator {
+ public:
+  ScrambledZipfianGenerator(uint64_t n,double theta,double zetan = 0)
+      : n_(n),zipf_(n,theta,zetan) { }
+
+  static inline uint64_t fnv_hash64(uint64_t val) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for(int i = 0;i < 8;++i) {
+      hash ^= val & 0xff;
+      hash *= 1099511628211ULL;
+      val >>= 8;
+    }
+    return hash;
+  }
+
+  inline uint64_t next(util::fast_random &r) {
+    return fnv_hash64(zipf_.next(r)) % n_;
+  }
+ private:
+  uint64_t n_;
+  ZipfianGenerator zipf_;
+};
+
+/**
+ * Skews towards the most recently inserted items: returns n - 1 - zipfian(n),
+ * where n is the number of inserted items at the time of the call.
+ */
+class LatestGenerator {
+ public:
+  LatestGenerator(uint64_t n,double theta) : zipf_(n,theta) { }
+
+  inline uint64_t next(util::fast_random &r,uint64_t n) {
+    return n - 1 - age(r,n);
+  }
+
+  // the age of the chosen item, where 0 is the newest one of the n items
+  inline uint64_t age(util::fast_random &r,uint64_t n) {
+    return zipf_.next(r,n);
+  }
+ private:
+  ZipfianGenerator zipf_;
+};
+
+} // namespace ycsb
+} // namespace oltp
+} // namespace nocc
@@ -0,0 +1,304 @@
+#include "tx_config.h"
+
+#include "core/logging.h"
+
+#include "ycsb_schema.h"
+#include "ycsb_worker.h"
+
+#include "db/txs/ts_manager.hpp"
+
+#include "framework/bench_runner.h"
+
+#include "rdmaio.h"
+#include "rtx/global_vars.h"
+using namespace rdmaio;
+
+#include <boost/foreach.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <string>
+
+using namespace std;
+
+extern size_t nthreads;
+extern size_t nclients;
+extern size_t current_partition;
+extern size_t total_partition;
+extern uint64_t ops_per_worker;
+
+extern nocc::db::TSManager *ts_manager;
+
+namespace nocc {
+
+extern RdmaCtrl *cm;       // global RDMA handler
+namespace oltp {
+
+extern char *store_buffer; // the buffer used to store DrTM-kv
+
+namespace ycsb {
+
+YcsbConfig ycsb_config;
+
+class YcsbMainRunner : public BenchRunner  {
+ public:
+  YcsbMainRunner(std::string &config_file) ;
+  virtual void init_put() {}
+  virtual std::vector<BenchLoader *> make_loaders(int partition, MemDB* store = NULL);
+  virtual std::vector<RWorker *> make_workers();
+  virtual std::vector<BackupBenchWorker *> make_backup_workers();
+  virtual void init_store(MemDB* &store);
+  virtual void init_backup_store(MemDB* &store);
+  virtual void populate_cache();
+
+  virtual void bootstrap_with_rdma(RdmaCtrl *r) {
+  }
+
+  virtual void warmup_buffer(char *buffer) {
+  }
+};
+
+void YcsbTest(int argc,char **argv) {
+  YcsbMainRunner runner (nocc::oltp::config_file_name);
+  runner.run();
+  return ;
+}
+
+// read, update, insert, scan, read-modify-write
+static void set_workload_mix(char workload) {
+  static const unsigned mixes[6][YCSB_TXN_NUM] = {
+    {50,50,0,0,0},   // A: update heavy
+    {95,5,0,0,0},    // B: read mostly
+    {100,0,0,0,0},   // C: read only
+    {95,0,5,0,0},    // D: read latest
+    {0,0,5,95,0},    // E: short ranges
+    {50,0,0,0,50}    // F: read-modify-write
+  };
+  ASSERT(workload >= 'A' && workload <= 'F') << "unknown YCSB workload " << workload;
+  memcpy(ycsb_config.mix,mixes[workload - 'A'],sizeof(ycsb_config.mix));
+}
+
+YcsbMainRunner::YcsbMainRunner(std::string &config_file) : BenchRunner(config_file) {
+
+  using boost::property_tree::ptree;
+  using namespace boost;
+  using namespace property_tree;
+
+  YcsbConfig &c = ycsb_config;
+  std::string dist = "default";
+
+  ptree pt;
+  try {
+    read_xml(config_file,pt);
+  } catch (const ptree_error &e) {
+    //pass
+  }
+  try {
+    c.workload = pt.get<std::string>("bench.ycsb.workload").at(0);
+  } catch (const ptree_error &e) {
+    //pass
+  }
+  c.record_count = pt.get<uint64_t>("bench.ycsb.record_count",c.record_count);
+  c.insert_space = pt.get<uint64_t>("bench.ycsb.insert_space",c.insert_space);
+  c.field_count  = pt.get<int>("bench.ycsb.field_count",c.field_count);
+  c.field_len    = pt.get<int>("bench.ycsb.field_len",c.field_len);
+  c.ops_per_txn  = pt.get<int>("bench.ycsb.ops_per_txn",c.ops_per_txn);
+  c.max_scan_len = pt.get<int>("bench.ycsb.max_scan_len",c.max_scan_len);
+  c.zipf_theta   = pt.get<double>("bench.ycsb.zipf_theta",c.zipf_theta);
+  dist           = pt.get<std::string>("bench.ycsb.distribution",dist);
+
+  set_workload_mix(c.workload);
+
+  // workload D reads the latest records, the others default to zipfian, as YCSB's core workloads
+  if(dist == "uniform")
+    c.distribution = YCSB_UNIFORM;
+  else if(dist == "latest" || (dist == "default" && c.workload == 'D'))
+    c.distribution = YCSB_LATEST;
+  else if(dist == "zipfian" || dist == "default")
+    c.distribution = YCSB_ZIPFIAN;
+  else
+    ASSERT(false) << "unknown YCSB distribution " << dist;
+
+  ASSERT(c.record_count > 0 && c.field_count > 0 && c.field_len > 0);
+  ASSERT(c.value_len() <= UINT16_MAX) << "YCSB record too large: " << c.value_len();
+  ASSERT(c.max_scan_len > 0 && c.ops_per_txn > 0);
+  ASSERT(c.mix[YCSB_INSERT] == 0 || c.insert_space > 0) << "YCSB inserts require insert_space > 0";
+  ASSERT((uint64_t)c.ops_per_txn <= c.total_records());
+#ifdef CALVIN_TX
+  // CALVIN re-runs a TX from its seed, but the insert keys and the latest records
+  // follow the shared count of the inserts, which changes between the runs
+  ASSERT(c.mix[YCSB_INSERT] == 0 && c.distribution != YCSB_LATEST)
+      << "CALVIN does not support the YCSB inserts or the latest distribution (workloads D and E)";
+#endif
+
+  // zeta of the total records is shared by all workers' zipfian generators
+  if(c.distribution == YCSB_ZIPFIAN)
+    c.zetan = ZipfianGenerator::zeta(0,c.total_records(),c.zipf_theta,0);
+
+  fprintf(stdout,"[YCSB]: workload %c (%u, %u, %u, %u, %u), %lu records per partition of %d x %d bytes, "
+          "distribution %s, theta %f, %d ops per TX\n",
+          c.workload,c.mix[0],c.mix[1],c.mix[2],c.mix[3],c.mix[4],
+          c.record_count,c.field_count,c.field_len,dist.c_str(),c.zipf_theta,c.ops_per_txn);
+}
+
+static int ycsb_meta_size() {
+#if MVCC_TX
+  return sizeof(rtx::MVCCHeader);
+#else
+  return sizeof(rtx::RdmaValHeader);
+#endif
+}
+
+void YcsbMainRunner::init_store(MemDB* &store){
+  assert(store == NULL);
+  // Should not give store_buffer to backup MemDB!
+  store = new MemDB(store_buffer);
+
+#if MVCC_TX
+  store->AddSchema(YCSB_TABLE,TAB_HASH,sizeof(uint64_t),ycsb_config.value_len() * MVCC_VERSION_NUM,
+                   ycsb_meta_size(),ycsb_config.keys_per_partition() * 1.5);
+#else
+  store->AddSchema(YCSB_TABLE,TAB_HASH,sizeof(uint64_t),ycsb_config.value_len(),
+                   ycsb_meta_size(),ycsb_config.keys_per_partition() * 1.5);
+#endif
+  store->EnableRemoteAccess(YCSB_TABLE,cm);
+}
+
+void YcsbMainRunner::init_backup_store(MemDB* &store){
+  assert(store == NULL);
+  store = new MemDB();
+
+#if MVCC_TX
+  store->AddSchema(YCSB_TABLE,TAB_HASH,sizeof(uint64_t),ycsb_config.value_len() * MVCC_VERSION_NUM,
+                   sizeof(rtx::RdmaValHeader),ycsb_config.keys_per_partition(),false);
+#else
+  store->AddSchema(YCSB_TABLE,TAB_HASH,sizeof(uint64_t),ycsb_config.value_len(),
+                   sizeof(rtx::RdmaValHeader),ycsb_config.keys_per_partition(),false);
+#endif
+}
+
+class YcsbLoader : public BenchLoader {
+  MemDB *store_;
+  bool is_primary_;
+ public:
+  YcsbLoader(unsigned long seed, int partition, MemDB *store, bool is_primary) : BenchLoader(seed) {
+    store_ = store;
+    partition_ = partition;
+    is_primary_ = is_primary;
+  }
+
+  void load() {
+
+    if(is_primary_)
+      RThreadLocalInit();
+
+    const int vlen = ycsb_config.value_len();
+    int meta_size = store_->_schemas[YCSB_TABLE].meta_len;
+#if MVCC_TX
+    int size = meta_size + MVCC_VERSION_NUM * vlen;
+#else
+    int size = meta_size + vlen;
+#endif
+    size = Round<int>(size,sizeof(uint64_t));
+
+    // the reserve of the inserts is loaded as well, since the TX layer has no remote insert
+    uint64_t start = partition_ * ycsb_config.keys_per_partition();
+    uint64_t end   = start + ycsb_config.keys_per_partition();
+
+    for(uint64_t key = start;key < end;++key) {
+
+      char *wrapper = NULL;
+      if(is_primary_)
+        wrapper = (char *)Rmalloc(size);
+      else
+        wrapper = new char[size];
+      assert(wrapper != NULL);
+
+      memset(wrapper,0,meta_size);
+      char *val = wrapper + meta_size;
+      for(int f = 0;f < ycsb_config.field_count;++f)
+        memset(val + f * ycsb_config.field_len,'a' + random_generator_.next() % 26,ycsb_config.field_len);
+#if MVCC_TX
+      ((rtx::MVCCHeader *)wrapper)->wts[0] = 1;
+#endif
+      auto node = store_->Put(YCSB_TABLE,key,(uint64_t *)wrapper,vlen);
+      if(is_primary_) {
+        node->off = (uint64_t)wrapper - (uint64_t)(cm->conn_buf_);
+        ASSERT(node->off % sizeof(uint64_t) == 0) << "ycsb value size " << size;
+      }
+    }
+    fprintf(stdout,"[YCSB], partition %d loaded %lu records\n",partition_,end - start);
+  }
+};
+
+std::vector<BenchLoader *> YcsbMainRunner::make_loaders(int partition, MemDB* store) {
+  std::vector<BenchLoader *> ret;
+  if(store == NULL){
+    ret.push_back(new YcsbLoader(9234,partition,store_,true));
+  } else {
+    ret.push_back(new YcsbLoader(9234,partition,store,false));
+  }
+  return ret;
+}
+
+std::vector<RWorker *> YcsbMainRunner::make_workers() {
+  std::vector<RWorker *> ret;
+  util::fast_random r(23984543 + current_partition * 73);
+
+  for(uint i = 0;i < nthreads;++i) {
+    ret.push_back(new YcsbWorker(i,r.next(),store_,ops_per_worker,&barrier_a_,&barrier_b_,this));
+  }
+
+#if defined(NOWAIT_TX) || defined(WAITDIE_TX) || defined(SUNDIAL_TX) || defined(MVCC_TX)
+  // add ts worker
+  ts_manager = new TSManager(nthreads + nclients + 1,cm,0,0);
+  ret.push_back(ts_manager);
+#endif
+  return ret;
+}
+
+std::vector<BackupBenchWorker *> YcsbMainRunner::make_backup_workers() {
+  // backups are maintained by the rtx loggers
+  return std::vector<BackupBenchWorker *>();
+}
+
+void YcsbMainRunner::populate_cache() {
+
+#if RDMA_CACHE == 1
+  LOG(2) << "loading cache.";
+
+  // create a temporal QP for usage
+  int dev_id = cm->get_active_dev(0);
+  int port_idx = cm->get_active_port(0);
+
+  cm->thread_local_init();
+  cm->open_device(dev_id);
+  cm->register_connect_mr(dev_id); // register memory on the specific device
+
+  cm->link_connect_qps(nthreads + nthreads + 1,dev_id,port_idx,0,IBV_QPT_RC);
+
+  // calculate the time of populating the cache
+  struct  timeval start;
+  struct  timeval end;
+
+  gettimeofday(&start,NULL);
+
+  auto db = store_;
+  char *temp = (char *)Rmalloc(256);
+
+  for(uint64_t key = 0;key < ycsb_config.keys_per_partition() * total_partition;++key) {
+    auto off = db->stores_[YCSB_TABLE]->RemoteTraverse(key,
+                                                       cm->get_rc_qp(nthreads + nthreads + 1,KeyToPid(key),0),temp);
+    assert(off != 0);
+  }
+  Rfree(temp);
+  gettimeofday(&end,NULL);
+
+  auto diff = (end.tv_sec-start.tv_sec) + (end.tv_usec - start.tv_usec) /  1000000.0;
+  fprintf(stdout,"Time to loader the caching is %f second\n",diff);
+#endif
+}
+
+} // end namespace ycsb
+} // end namespace oltp
+} // end namespace nocc
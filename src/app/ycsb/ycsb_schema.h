@@ -0,0 +1,23 @@
+#ifndef NOCC_OLTP_YCSB_SCHEMA_H
+#define NOCC_OLTP_YCSB_SCHEMA_H
+
+#include <stdint.h>
+
+#define YCSB_TABLE 0
+
+// defaults of the standard YCSB core workloads
+#define YCSB_DEFAULT_RECORDS     100000   // records per partition
+#define YCSB_DEFAULT_FIELDS      10
+#define YCSB_DEFAULT_FIELD_LEN   100
+#define YCSB_DEFAULT_SCAN_LEN    10
+#define YCSB_DEFAULT_ZIPF_THETA  0.99
+
+/**
+ * A YCSB record is field_count fields of field_len bytes, keyed by a uint64_t.
+ * The record size is configured at runtime, so the value is not a DO_STRUCT.
+ * Keys are range partitioned: partition p owns [p * P, (p + 1) * P), where
+ * P = record_count + insert_space. The first record_count keys are the loaded records,
+ * the rest are the reserve which the inserts fill (see YcsbWorker::txn_insert).
+ */
+
+#endif
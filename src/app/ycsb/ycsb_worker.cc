@@ -0,0 +1,287 @@
+#include "ycsb_worker.h"
+
+#include "tx_config.h"
+
+#include "rtx/global_vars.h"
+#include "rtx/occ_rdma.h"
+#include "rtx/occ_variants.hpp"
+#include "rtx/nowait_rdma.h"
+#include "rtx/sundial_rdma.h"
+#include "rtx/mvcc_rdma.h"
+#include "rtx/waitdie_rdma.h"
+
+#include <set>
+
+extern size_t current_partition;
+
+namespace nocc {
+
+extern RdmaCtrl *cm;
+
+namespace oltp {
+
+extern __thread util::fast_random   *random_generator;
+
+namespace ycsb {
+
+YcsbWorker::YcsbWorker(unsigned int id,unsigned long seed,MemDB *db,uint64_t total_ops,
+                       spin_barrier *a, spin_barrier *b,BenchRunner *context):
+    BenchWorker(id,true,seed,total_ops,a,b,context),
+    store_(db)
+{
+  const YcsbConfig &c = ycsb_config;
+  uniform_ = new UniformGenerator(c.total_records());
+  zipfian_ = new ScrambledZipfianGenerator(c.total_records(),c.zipf_theta,c.zetan);
+  latest_  = new LatestGenerator(c.record_count,c.zipf_theta);
+}
+
+void YcsbWorker::register_callbacks() {
+}
+
+void YcsbWorker::check_consistency() {
+}
+
+uint64_t YcsbWorker::next_key() {
+  auto &r = random_generator[cor_id_];
+  switch(ycsb_config.distribution) {
+    case YCSB_UNIFORM:
+      return RecordToKey(uniform_->next(r));
+    case YCSB_LATEST: {
+      // the inserts of all partitions proceed at a similar rate,
+      // so the local frontier is used to pick the latest records of any partition
+      const uint64_t inserted = ycsb_config.inserted;
+      const uint64_t live = std::min(inserted,ycsb_config.insert_space); // inserts not overwritten
+      uint64_t age = latest_->age(r,ycsb_config.record_count + live);
+      uint64_t pid = r.next() % total_partition;
+      uint64_t idx;
+      if(age < live) // the reserve wraps around, so the newest insert is at the last slot written
+        idx = ycsb_config.record_count + (inserted - 1 - age) % ycsb_config.insert_space;
+      else
+        idx = ycsb_config.record_count - 1 - (age - live);
+      return pid * ycsb_config.keys_per_partition() + idx;
+    }
+    case YCSB_ZIPFIAN:
+    default:
+      return RecordToKey(zipfian_->next(r));
+  }
+}
+
+// inserts fill the local reserve in order, and wrap around when it is used up
+uint64_t YcsbWorker::next_insert_key() {
+  uint64_t slot = __sync_fetch_and_add(&ycsb_config.inserted,1) % ycsb_config.insert_space;
+  return current_partition * ycsb_config.keys_per_partition() + ycsb_config.record_count + slot;
+}
+
+txn_result_t YcsbWorker::txn_read(yield_func_t &yield) {
+  const int vlen = ycsb_config.value_len();
+  int indexes[ycsb_config.ops_per_txn];
+  std::set<uint64_t> keys;
+
+  rtx_->begin(yield);
+  for(int i = 0;i < ycsb_config.ops_per_txn;++i) {
+    uint64_t key = next_key();
+    while(keys.find(key) != keys.end())
+      key = next_key();
+    keys.insert(key);
+
+    indexes[i] = rtx_->read(KeyToPid(key),YCSB_TABLE,key,vlen,yield);
+    if(indexes[i] < 0) return txn_result_t(false,73);
+  }
+  for(int i = 0;i < ycsb_config.ops_per_txn;++i) {
+    char *val = rtx_->load_read(indexes[i],vlen,yield);
+    if(val == NULL) return txn_result_t(false,73);
+  }
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t YcsbWorker::txn_update(yield_func_t &yield) {
+  const int vlen = ycsb_config.value_len();
+  const int flen = ycsb_config.field_len;
+  auto &r = random_generator[cor_id_];
+  int indexes[ycsb_config.ops_per_txn];
+  std::set<uint64_t> keys;
+
+  rtx_->begin(yield);
+  for(int i = 0;i < ycsb_config.ops_per_txn;++i) {
+    uint64_t key = next_key();
+    while(keys.find(key) != keys.end())
+      key = next_key();
+    keys.insert(key);
+
+    indexes[i] = rtx_->write(KeyToPid(key),YCSB_TABLE,key,vlen,yield);
+    if(indexes[i] < 0) return txn_result_t(false,73);
+  }
+  for(int i = 0;i < ycsb_config.ops_per_txn;++i) {
+    char *val = rtx_->load_write(indexes[i],vlen,yield);
+    if(val == NULL) return txn_result_t(false,73);
+    // update one field, as YCSB's default (writeallfields=false)
+    int field = r.next() % ycsb_config.field_count;
+    memset(val + field * flen,r.next_char(),flen);
+  }
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t YcsbWorker::txn_insert(yield_func_t &yield) {
+  const int vlen = ycsb_config.value_len();
+  auto &r = random_generator[cor_id_];
+
+  rtx_->begin(yield);
+  uint64_t key = next_insert_key();
+  int idx = rtx_->write(current_partition,YCSB_TABLE,key,vlen,yield);
+  if(idx < 0) return txn_result_t(false,73);
+
+  char *val = rtx_->load_write(idx,vlen,yield);
+  if(val == NULL) return txn_result_t(false,73);
+  memset(val,r.next_char(),vlen);
+
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t YcsbWorker::txn_scan(yield_func_t &yield) {
+  const int vlen = ycsb_config.value_len();
+  auto &r = random_generator[cor_id_];
+
+  uint64_t start = next_key();
+  int pid = KeyToPid(start);
+  // a scan does not cross partitions
+  uint64_t end = std::min(start + 1 + r.next() % ycsb_config.max_scan_len,
+                          (pid + 1) * ycsb_config.keys_per_partition());
+  int indexes[end - start];
+
+  rtx_->begin(yield);
+  for(uint64_t key = start;key < end;++key) {
+    indexes[key - start] = rtx_->read(pid,YCSB_TABLE,key,vlen,yield);
+    if(indexes[key - start] < 0) return txn_result_t(false,73);
+  }
+  for(uint64_t i = 0;i < end - start;++i) {
+    char *val = rtx_->load_read(indexes[i],vlen,yield);
+    if(val == NULL) return txn_result_t(false,73);
+  }
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+txn_result_t YcsbWorker::txn_rmw(yield_func_t &yield) {
+  const int vlen = ycsb_config.value_len();
+  const int flen = ycsb_config.field_len;
+  auto &r = random_generator[cor_id_];
+  int indexes[ycsb_config.ops_per_txn];
+  std::set<uint64_t> keys;
+
+  rtx_->begin(yield);
+  for(int i = 0;i < ycsb_config.ops_per_txn;++i) {
+    uint64_t key = next_key();
+    while(keys.find(key) != keys.end())
+      key = next_key();
+    keys.insert(key);
+
+    indexes[i] = rtx_->write(KeyToPid(key),YCSB_TABLE,key,vlen,yield);
+    if(indexes[i] < 0) return txn_result_t(false,73);
+  }
+  for(int i = 0;i < ycsb_config.ops_per_txn;++i) {
+    char *val = rtx_->load_write(indexes[i],vlen,yield);
+    if(val == NULL) return txn_result_t(false,73);
+    // the new field depends on the whole record read
+    char sum = 0;
+    for(int j = 0;j < vlen;++j)
+      sum += val[j];
+    int field = r.next() % ycsb_config.field_count;
+    memset(val + field * flen,sum + 1,flen);
+  }
+  auto ret = rtx_->commit(yield);
+  return txn_result_t(ret,73);
+}
+
+void YcsbWorker::thread_local_init() {
+
+  assert(store_ != NULL);
+  for(int i = 0;i < server_routine + 1;++i) {
+    // init TXs
+#if defined(OCC_TX)
+#if EM_FASST == 0
+#if ONE_SIDED_READ
+    new_txs_[i] = new rtx::OCCR(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                cm,rdma_sched_,total_partition);
+#else
+    new_txs_[i] = new rtx::OCC(this,store_,rpc_,current_partition,i,-1);
+#endif
+#else // use FaSST's protocol
+#if ONE_SIDED_READ
+    new_txs_[i] = new rtx::OCCFastR(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                    cm,rdma_sched_,total_partition);
+#else
+    new_txs_[i] = new rtx::OCCFast(this,store_,rpc_,current_partition,i,-1);
+#endif
+#endif
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(NOWAIT_TX)
+    new_txs_[i] = new rtx::NOWAIT(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                  cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(SUNDIAL_TX)
+    new_txs_[i] = new rtx::SUNDIAL(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                   cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(MVCC_TX)
+    new_txs_[i] = new rtx::MVCC(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(WAITDIE_TX)
+    new_txs_[i] = new rtx::WAITDIE(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                   cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+    new_txs_[i]->set_two_phase_committer(two_phase_committer_);
+#elif defined(CALVIN_TX)
+    new_txs_[i] = new rtx::CALVIN(this,store_,rpc_,current_partition,worker_id_,i,-1,
+                                  cm,rdma_sched_,total_partition);
+    new_txs_[i]->set_logger(new_logger_);
+#else
+    fprintf(stderr,"YCSB runs on the rtx engines only!\n");
+    assert(false);
+#endif
+  }
+#ifdef CALVIN_TX
+  init_calvin_ctx(store_);
+#endif
+  rtx_ = new_txs_[cor_id_];
+  rtx_hook_ = new_txs_[1];
+  init_ro_txs(store_);
+  nocc::rtx::global_lock_manager->thread_local_init();
+} // end func: thread_local_init
+
+workload_desc_vec_t YcsbWorker::get_workload() const {
+  return _get_workload();
+}
+
+workload_desc_vec_t YcsbWorker::_get_workload() {
+
+  workload_desc_vec_t w;
+  const unsigned *mix = ycsb_config.mix;
+  unsigned m = 0;
+  for (size_t i = 0; i < YCSB_TXN_NUM; i++)
+    m += mix[i];
+  ALWAYS_ASSERT(m == 100);
+
+  if(mix[YCSB_READ])
+    w.push_back(workload_desc("Read",double(mix[YCSB_READ])/100.0,TxnRead));
+  if(mix[YCSB_UPDATE])
+    w.push_back(workload_desc("Update",double(mix[YCSB_UPDATE])/100.0,TxnUpdate));
+  if(mix[YCSB_INSERT])
+    w.push_back(workload_desc("Insert",double(mix[YCSB_INSERT])/100.0,TxnInsert));
+  if(mix[YCSB_SCAN])
+    w.push_back(workload_desc("Scan",double(mix[YCSB_SCAN])/100.0,TxnScan));
+  if(mix[YCSB_RMW])
+    w.push_back(workload_desc("ReadModifyWrite",double(mix[YCSB_RMW])/100.0,TxnRMW));
+  return w;
+}
+
+} // namespace ycsb
+} // namespace oltp
+} // namespace nocc
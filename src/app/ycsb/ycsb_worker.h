@@ -0,0 +1,141 @@
+#ifndef NOCC_OLTP_YCSB_H
+#define NOCC_OLTP_YCSB_H
+
+#include "all.h"
+
+#include "tx_config.h"
+#include "app/config.h"
+
+#include "ycsb_schema.h"
+#include "ycsb_generator.hpp"
+
+#include "memstore/memdb.h"
+
+#include "framework/bench_worker.h"
+#include "framework/utils/util.h"
+
+#include <string>
+
+extern size_t total_partition;
+
+namespace nocc {
+namespace oltp {
+namespace ycsb {
+
+enum ycsb_dist_t {
+  YCSB_ZIPFIAN = 0,
+  YCSB_LATEST,
+  YCSB_UNIFORM
+};
+
+// the TXs of the YCSB core workloads
+enum ycsb_txn_t {
+  YCSB_READ = 0,
+  YCSB_UPDATE,
+  YCSB_INSERT,
+  YCSB_SCAN,
+  YCSB_RMW,
+  YCSB_TXN_NUM
+};
+
+struct YcsbConfig {
+  char     workload     = 'A';
+  uint64_t record_count = YCSB_DEFAULT_RECORDS;  // per partition
+  uint64_t insert_space = YCSB_DEFAULT_RECORDS;  // per partition, keys reserved for the inserts
+  int      field_count  = YCSB_DEFAULT_FIELDS;
+  int      field_len    = YCSB_DEFAULT_FIELD_LEN;
+  int      ops_per_txn  = 1;
+  int      max_scan_len = YCSB_DEFAULT_SCAN_LEN;
+  ycsb_dist_t distribution = YCSB_ZIPFIAN;
+  double   zipf_theta   = YCSB_DEFAULT_ZIPF_THETA;
+  double   zetan        = 0;                     // zeta of the total records, computed once
+  unsigned mix[YCSB_TXN_NUM] = {50,50,0,0,0};
+
+  // number of the local inserts, shared by the workers of this partition
+  volatile uint64_t inserted = 0;
+
+  inline uint64_t value_len() const { return field_count * field_len; }
+  inline uint64_t keys_per_partition() const { return record_count + insert_space; }
+  inline uint64_t total_records() const { return record_count * total_partition; }
+};
+
+extern YcsbConfig ycsb_config;
+
+void YcsbTest(int argc,char **argv);
+
+inline ALWAYS_INLINE int KeyToPid(uint64_t key) {
+  return key / ycsb_config.keys_per_partition();
+}
+
+// the key of the idx-th loaded record, idx in [0, total_records())
+inline ALWAYS_INLINE uint64_t RecordToKey(uint64_t idx) {
+  return (idx / ycsb_config.record_count) * ycsb_config.keys_per_partition() +
+      idx % ycsb_config.record_count;
+}
+
+/* Tx's implementation */
+class YcsbWorker : public BenchWorker {
+ public:
+  YcsbWorker(unsigned int worker_id,unsigned long seed,MemDB *db,uint64_t total_ops,
+             spin_barrier *a, spin_barrier *b,BenchRunner *context);
+
+  txn_result_t txn_read(yield_func_t &yield);
+  txn_result_t txn_update(yield_func_t &yield);
+  txn_result_t txn_insert(yield_func_t &yield);
+  txn_result_t txn_scan(yield_func_t &yield);
+  txn_result_t txn_rmw(yield_func_t &yield);
+
+  void exit_report() {
+    LOG(4) << "worker exit.";
+    auto one_second = util::BreakdownTimer::get_one_second_cycle();
+    rtx_hook_->report_statics(one_second);
+    rtx_hook_->report_cycle_statics(one_second);
+  }
+
+  virtual void workload_report() {
+    // record TX's data
+    rtx_hook_->record();
+  }
+
+  virtual workload_desc_vec_t get_workload() const ;
+  static  workload_desc_vec_t _get_workload();
+  virtual void check_consistency();
+  virtual void register_callbacks();
+  virtual void thread_local_init();
+
+ private:
+  MemDB *store_;
+
+  UniformGenerator          *uniform_ = NULL;
+  ScrambledZipfianGenerator *zipfian_ = NULL;
+  LatestGenerator           *latest_  = NULL;
+
+  uint64_t next_key();
+  uint64_t next_insert_key();
+
+  static txn_result_t TxnRead(BenchWorker *w,yield_func_t &yield) {
+    return static_cast<YcsbWorker *>(w)->txn_read(yield);
+  }
+
+  static txn_result_t TxnUpdate(BenchWorker *w,yield_func_t &yield) {
+    return static_cast<YcsbWorker *>(w)->txn_update(yield);
+  }
+
+  static txn_result_t TxnInsert(BenchWorker *w,yield_func_t &yield) {
+    return static_cast<YcsbWorker *>(w)->txn_insert(yield);
+  }
+
+  static txn_result_t TxnScan(BenchWorker *w,yield_func_t &yield) {
+    return static_cast<YcsbWorker *>(w)->txn_scan(yield);
+  }
+
+  static txn_result_t TxnRMW(BenchWorker *w,yield_func_t &yield) {
+    return static_cast<YcsbWorker *>(w)->txn_rmw(yield);
+  }
+};
+
+} // end namespace ycsb
+} // end namespace oltp
+} // end namespace nocc
+
+#endif
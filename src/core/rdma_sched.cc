@@ -5,6 +5,7 @@
 #include "logging.h"
 
 #include "rrpc.h"
+#include "rtx/global_vars.h" // for the view
 
 extern size_t nthreads;
 extern size_t current_partition;
@@ -44,13 +45,24 @@ void RScheduler::poll_comps() {
     }
 
     if(unlikely(wc_.status != IBV_WC_SUCCESS)) {
-      LOG(3) << "got bad completion with status: " << wc_.status << " with error " << ibv_wc_status_str(wc_.status)
-             << "@node " << qp->nid;
-      if(wc_.status != IBV_WC_RETRY_EXC_ERR)
-        assert(false);
-      else {
-        it++;
-        continue;
+      if(rtx::global_view != NULL && !rtx::global_view->is_alive(qp->nid)) {
+        // the QP is fenced by a view change, and all its requests are flushed, the unsignaled
+        // ones included. the flushes are completed as usual, so no coroutine waits forever
+        LOG(1) << "flushed completion @node " << qp->nid << ": " << ibv_wc_status_str(wc_.status);
+        auto cor_id = decode_corid(wc_.wr_id);
+        if(qp->pendings == 0 || (cor_id != 0 && pending_counts_[cor_id] == 0)) {
+          it++; // of a request nobody waits for
+          continue;
+        }
+      } else {
+        LOG(3) << "got bad completion with status: " << wc_.status << " with error " << ibv_wc_status_str(wc_.status)
+               << "@node " << qp->nid;
+        if(wc_.status != IBV_WC_RETRY_EXC_ERR)
+          assert(false);
+        else {
+          it++;
+          continue;
+        }
       }
     }
 
@@ -66,8 +78,10 @@ void RScheduler::poll_comps() {
 
     auto cor_id = decode_corid(wc_.wr_id);
 
-    if(cor_id == 0)
+    if(cor_id == 0) {
+      it = pending_qps_.erase(it);
       continue;  // ignore null completion
+    }
 
     //LOG(2) << "polled " << cor_id  << " low " << low_watermark;
 
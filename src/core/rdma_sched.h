@@ -31,6 +31,19 @@ class RScheduler {
     add_pending(cor_id,qp);
   }
 
+  /**
+   * post a send which is signaled only if the QP needs to be polled.
+   * the completion shall not be waited, so it is usually posted with the cor_id 0.
+   */
+  void post_send_pending(rdmaio::Qp *qp,int cor_id,ibv_wr_opcode op,char *local_buf,int len,uint64_t off,int flags) {
+    if(qp->rc_need_poll()) {
+      post_send(qp,cor_id,op,local_buf,len,off,flags | IBV_SEND_SIGNALED);
+    } else {
+      qp->high_watermark_ += 1;
+      qp->rc_post_send(op,local_buf,len,off,flags,encode_wrid(cor_id,qp->high_watermark_));
+    }
+  }
+
   void post_cas(rdmaio::Qp *qp,int cor_id,char *local_buf,uint64_t off,uint64_t compare,uint64_t swap,int flags) {
     qp->high_watermark_ += 1;
     qp->rc_post_compare_and_swap(local_buf,off,compare,swap,flags,encode_wrid(cor_id,qp->high_watermark_));
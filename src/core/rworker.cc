@@ -15,6 +15,8 @@
 
 #include "logging.h" // for prints
 
+#include "rtx/ts_clock.hpp"
+
 // system or library headers
 #include <queue>
 #include <unistd.h>
@@ -28,6 +30,8 @@ using namespace std;
 using namespace rdmaio;
 using namespace rdmaio::ring_imm_msg;
 
+extern size_t current_partition;
+
 namespace nocc {
 
 // a dedicated routine is used to poll network events
@@ -94,6 +98,68 @@ int RWorker::choose_rnic_port() {
   return use_port_;
 }
 
+void RWorker::serve_two_phase_commit() const {
+  typedef TwoPhaseCommitMemManager M;
+  ASSERT(twophase_mem != NULL) << "two-phase-commit mem does not set up.";
+  for (int from_mac = 0; from_mac < cm_->get_num_nodes(); ++from_mac) {
+    for (int i = 1; i < total_worker_coroutine + 1;++i) {
+      volatile uint64_t *slot = twophase_mem->get_local_ptr(twophase_mem->request_offset(from_mac, worker_id_, i));
+      uint64_t rec = *slot;
+      switch(M::type(rec)) {
+        case M::TWO_PHASE_PREPARE: {
+          // a node in a view change does not take new commitments
+          uint8_t vote = global_view->halted() ? M::VOTE_ABORT : M::VOTE_COMMIT;
+          uint64_t voted = M::encode(M::seq(rec),vote);
+          // the coordinator may have moved on (e.g. timed out) meanwhile
+          if(!__sync_bool_compare_and_swap(slot,rec,voted))
+            break;
+          twophase_mem->voted_at(from_mac, worker_id_, i) = TSClock::local_now();
+          rdma_sched_->post_send_pending(cm_->get_rc_qp(worker_id_,from_mac,0),0,IBV_WR_RDMA_WRITE,
+                                         (char *)&voted,sizeof(uint64_t),
+                                         twophase_mem->vote_offset(current_partition, worker_id_, i),
+                                         IBV_SEND_INLINE);
+          break;
+        }
+        case M::TWO_PHASE_DECISION_COMMIT:
+        case M::TWO_PHASE_DECISION_ABORT:
+          __sync_bool_compare_and_swap(slot,rec,0);
+          break;
+        case M::VOTE_COMMIT:
+        case M::VOTE_ABORT: {
+          // voted, but the decision is not received yet
+          uint64_t &voted_at = twophase_mem->voted_at(from_mac, worker_id_, i);
+          uint64_t now = TSClock::local_now();
+          volatile uint64_t *inquiry = twophase_mem->get_local_ptr(twophase_mem->inquiry_offset(from_mac, worker_id_, i));
+          uint64_t decision = *inquiry;
+          if(M::seq(decision) == M::seq(rec) &&
+             (M::type(decision) == M::TWO_PHASE_DECISION_COMMIT || M::type(decision) == M::TWO_PHASE_DECISION_ABORT)) {
+            __sync_bool_compare_and_swap(slot,rec,0); // resolved by the coordinator's decision
+            twophase_mem->in_doubt(worker_id_) += 1;
+            break;
+          }
+          if(now - voted_at < TWO_PC_TIMEOUT_US * 2)
+            break;
+          if(!global_view->is_alive(from_mac)) {
+            // the coordinator is removed from the view, presume abort
+            __sync_bool_compare_and_swap(slot,rec,0);
+            twophase_mem->in_doubt(worker_id_) += 1;
+            LOG(3) << "presume abort for the 2pc round " << M::seq(rec) << " of failed node " << from_mac;
+            break;
+          }
+          // ask the coordinator for its decision, the result is checked in the next scans
+          voted_at = now;
+          rdma_sched_->post_send_pending(cm_->get_rc_qp(worker_id_,from_mac,0),0,IBV_WR_RDMA_READ,
+                                         (char *)inquiry,sizeof(uint64_t),
+                                         twophase_mem->decision_offset(worker_id_, i),0);
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+}
+
 void RWorker::init_rdma() {
 
   if(!USE_RDMA) // avoids calling cm on other networks
@@ -142,6 +208,7 @@ void RWorker::init_routines(int coroutines) {
   // first per-routine data structure
   routines_         = new coroutine_func_t[1 + coroutines];
   random_generator  = new util::fast_random[1 + coroutines];
+  stage_profs_      = new StageProfile[1 + coroutines];
 
   for(uint i = 0;i < 1 + coroutines;++i){
     random_generator[i].set_seed0(rand_generator_.next());
@@ -11,6 +11,7 @@
 #include "ud_msg.h"
 #include "rdma_sched.h"
 #include "routine.h"
+#include "./utils/stage_profiler.h"
 #include "rtx/global_vars.h"
 #include "rtx/two_phase_commit_mem_manager.hpp"
 #include <vector>
@@ -155,23 +156,15 @@ class RWorker : public ndb_thread {
       }
     }
 
+#if TX_TWO_PHASE_COMMIT_STYLE == 2
     //serving as the txn manager for handling remote two-phase-commit prepare and decision messages
-    ASSERT(twophase_mem != NULL) << "two-phase-commit mem does not set up.";
-    for (int i = 1; i < total_worker_coroutine + 1;++i) {
-      for (int from_mac = 0; from_mac < cm_->get_num_nodes(); ++from_mac) {
-        char* local_ptr = twophase_mem->get_local_ptr(from_mac, worker_id_, i);
-        if((*(uint8_t*)local_ptr) == TwoPhaseCommitMemManager::TWO_PHASE_PREPARE) {
-          (*(uint8_t*)local_ptr) = TwoPhaseCommitMemManager::VOTE_COMMIT;
-          // LOG(3) << "offset " << local_ptr - (char *)(cm_->conn_buf_) << " written vote commit.";
-        }
-        if ((*(uint8_t*)local_ptr) == TwoPhaseCommitMemManager::TWO_PHASE_DECISION_COMMIT) {
-          (*(uint8_t*)local_ptr) = 0; 
-          // LOG(3) << "offset " << local_ptr - (char *)(cm_->conn_buf_) << " written zero.";
-        }
-      }
-    }
+    serve_two_phase_commit();
+#endif
   }
 
+  // votes for the prepare records written by remote coordinators, and resolves in-doubt rounds
+  void serve_two_phase_commit() const;
+
   void indirect_yield(yield_func_t &yield);
   void indirect_must_yield(yield_func_t &yield);
   void indirect_yield_timeout(yield_func_t &yield, double timeout);
@@ -189,6 +182,16 @@ class RWorker : public ndb_thread {
   inline ALWAYS_INLINE
   int cor_id() const { return cor_id_; }
 
+  // the stage breakdown of the running coroutine
+  inline ALWAYS_INLINE
+  StageProfile &stage_profile() { return stage_profs_[cor_id_]; }
+
+  // add up the stage breakdowns of all the coroutines
+  void collect_stage_profile(StageProfile &sum) const {
+    for(int i = 0;i < total_worker_coroutine + 1;++i)
+      sum.add(stage_profs_[i]);
+  }
+
  public:
   const unsigned int worker_id_;  // thread id of the running routine
   RoutineMeta *routine_meta_ = NULL;
@@ -201,6 +204,7 @@ class RWorker : public ndb_thread {
   RRpc *rpc_    = NULL;
   RScheduler *rdma_sched_ = NULL;
   int       use_port_ = -1;  // which RNIC's device to use
+  StageProfile *stage_profs_ = NULL; // per coroutine
 
   // running status
   bool   running = false;
@@ -15,6 +15,12 @@ void RWorker::indirect_yield(yield_func_t &yield) {
 inline ALWAYS_INLINE
 void RWorker::indirect_must_yield(yield_func_t &yield) {
 
+#if NOCC_STAGE_PROFILE
+  auto &prof = stage_profs_[cor_id_];
+  auto wait_start = rdtsc();
+  uint64_t hw_start[HW_NUM];
+  bool hw = prof.read_hw(hw_start);
+#endif
   int next = routine_meta_->next_->id_;
   cor_id_  = next;
   auto cur = routine_meta_;
@@ -23,6 +29,11 @@ void RWorker::indirect_must_yield(yield_func_t &yield) {
   cur->yield_from_routine_list(yield);
 
   change_ctx(cor_id_);
+#if NOCC_STAGE_PROFILE
+  prof.waited += rdtsc() - wait_start;
+  if(hw)
+    prof.add_hw_waited(hw_start);
+#endif
 }
 
 inline ALWAYS_INLINE
@@ -33,6 +44,12 @@ void RWorker::indirect_yield_timeout(yield_func_t &yield, double timeout) {
 inline ALWAYS_INLINE
 void RWorker::indirect_must_yield_until_timeout(yield_func_t &yield, double timeout) {
 
+#if NOCC_STAGE_PROFILE
+  auto &prof = stage_profs_[cor_id_];
+  auto wait_start = rdtsc();
+  uint64_t hw_start[HW_NUM];
+  bool hw = prof.read_hw(hw_start);
+#endif
   int next = routine_meta_->next_->id_;
   cor_id_  = next;
   auto cur = routine_meta_;
@@ -41,11 +58,22 @@ void RWorker::indirect_must_yield_until_timeout(yield_func_t &yield, double time
   cur->yield_from_routine_list_until_timeout(yield, timeout);
 
   change_ctx(cor_id_);
+#if NOCC_STAGE_PROFILE
+  prof.waited += rdtsc() - wait_start;
+  if(hw)
+    prof.add_hw_waited(hw_start);
+#endif
 }
 
 inline ALWAYS_INLINE
 void RWorker::yield_next(yield_func_t &yield) {
   // yield to the next routine
+#if NOCC_STAGE_PROFILE
+  auto &prof = stage_profs_[cor_id_];
+  auto wait_start = rdtsc();
+  uint64_t hw_start[HW_NUM];
+  bool hw = prof.read_hw(hw_start);
+#endif
   routine_meta_->active_ = false;
 
   int next = routine_meta_->next_->id_;
@@ -57,6 +85,11 @@ void RWorker::yield_next(yield_func_t &yield) {
 
   change_ctx(cor_id_);
   assert(cor_id_ == routine_meta_->id_);
+#if NOCC_STAGE_PROFILE
+  prof.waited += rdtsc() - wait_start;
+  if(hw)
+    prof.add_hw_waited(hw_start);
+#endif
 }
 
 // end class nocc_worker
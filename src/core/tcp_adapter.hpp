@@ -94,8 +94,9 @@ class Adapter : public MsgHandler {
   static std::vector<std::mutex *>   locks;
 
  public:
+  // node i listens at tcp_port + i * port_stride; a stride allows running all nodes at one host
   static void create_shared_sockets(const std::vector<std::string> &network,int tcp_port,
-                                    zmq::context_t &context) {
+                                    zmq::context_t &context,int port_stride = 0) {
     
     assert(sockets.size() == 0 && locks.size() == 0);
     for(uint i = 0;i < network.size();++i) {
@@ -114,7 +115,7 @@ class Adapter : public MsgHandler {
 
       auto s = new zmq::socket_t(context, ZMQ_PUSH);
       char address[32] = "";
-      snprintf(address, 32, "tcp://%s:%d", ip, tcp_port);
+      snprintf(address, 32, "tcp://%s:%d", ip, tcp_port + i * port_stride);
       // snprintf(address, 32, "tcp://%s:%d", network[i].c_str(), tcp_port);
       fprintf(stdout, "[TCP] creating shared sockets for %s\n", address);
       s->connect(address);
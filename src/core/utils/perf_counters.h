@@ -0,0 +1,147 @@
+#ifndef NOCC_PERF_COUNTERS
+#define NOCC_PERF_COUNTERS
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+
+namespace nocc {
+
+// the hardware events counted per TX stage
+enum HwCounter {
+  HW_CYCLES = 0,
+  HW_INSTRUCTIONS,
+  HW_LLC_MISSES,
+  HW_DTLB_MISSES,     // load misses
+  HW_BRANCH_MISSES,
+  HW_NUM
+};
+
+static const char *const hw_counter_names[HW_NUM] = {
+  "cycles","instructions","llc_misses","dtlb_misses","branch_misses"
+};
+
+/**
+ * The hardware counters of a thread, opened with perf_event_open.
+ * Only the user space is counted, since perf_event_paranoid usually forbids the kernel.
+ * The counters are read with rdpmc from their mmaped pages, which costs tens of cycles per
+ * counter, or with read() if the kernel does not allow rdpmc.
+ * Events the CPU (or the VM) does not have read as 0.
+ */
+class PerfCounters {
+ public:
+  // open the counters of the calling thread, and make them the local ones
+  static PerfCounters *open_local() {
+    PerfCounters *c = new PerfCounters();
+    if(c->opened() == 0) {
+      delete c;
+      return NULL;
+    }
+    local_ref() = c;
+    return c;
+  }
+
+  // the counters of the calling thread, or NULL if they are not enabled
+  static inline PerfCounters *local() { return local_ref(); }
+
+  ~PerfCounters() {
+    for(int i = 0;i < HW_NUM;++i) {
+      if(pages_[i] != NULL)
+        munmap(pages_[i],sysconf(_SC_PAGESIZE));
+      if(fds_[i] >= 0)
+        close(fds_[i]);
+    }
+    if(local_ref() == this)
+      local_ref() = NULL;
+  }
+
+  int opened() const {
+    int res = 0;
+    for(int i = 0;i < HW_NUM;++i)
+      res += fds_[i] >= 0;
+    return res;
+  }
+
+  inline void read(uint64_t *vals) const {
+    for(int i = 0;i < HW_NUM;++i)
+      vals[i] = read(i);
+  }
+
+  inline uint64_t read(int i) const {
+    if(fds_[i] < 0)
+      return 0;
+    struct perf_event_mmap_page *pc = pages_[i];
+    if(pc != NULL) {
+      uint32_t seq,idx;
+      uint64_t count;
+      do {
+        seq = pc->lock;
+        asm volatile("" ::: "memory");
+        idx   = pc->index;
+        count = pc->offset;
+        if(pc->cap_user_rdpmc && idx != 0) {
+          uint64_t pmc = rdpmc(idx - 1);
+          int shift = 64 - pc->pmc_width;
+          count += (int64_t)(pmc << shift) >> shift;
+        }
+        asm volatile("" ::: "memory");
+      } while(pc->lock != seq);
+      if(pc->cap_user_rdpmc && idx != 0)
+        return count;
+    }
+    // the counter is not on the PMU now, or rdpmc is not allowed
+    uint64_t count = 0;
+    if(::read(fds_[i],&count,sizeof(count)) != sizeof(count))
+      return 0;
+    return count;
+  }
+
+ private:
+  int fds_[HW_NUM];
+  struct perf_event_mmap_page *pages_[HW_NUM];
+
+  PerfCounters() {
+    static const struct { uint32_t type; uint64_t config; } events[HW_NUM] = {
+      { PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES },
+      { PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS },
+      { PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES },
+      { PERF_TYPE_HW_CACHE,PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+      { PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    for(int i = 0;i < HW_NUM;++i) {
+      struct perf_event_attr attr;
+      memset(&attr,0,sizeof(attr));
+      attr.size           = sizeof(attr);
+      attr.type           = events[i].type;
+      attr.config         = events[i].config;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      fds_[i]   = syscall(__NR_perf_event_open,&attr,0 /* this thread */,-1 /* any cpu */,-1,0);
+      pages_[i] = NULL;
+      if(fds_[i] < 0)
+        continue;
+      void *p = mmap(NULL,sysconf(_SC_PAGESIZE),PROT_READ,MAP_SHARED,fds_[i],0);
+      if(p != MAP_FAILED)
+        pages_[i] = (struct perf_event_mmap_page *)p;
+    }
+  }
+
+  static inline uint64_t rdpmc(uint32_t counter) {
+    uint32_t lo,hi;
+    asm volatile("rdpmc" : "=a" (lo), "=d" (hi) : "c" (counter));
+    return ((uint64_t)hi << 32) | lo;
+  }
+
+  static inline PerfCounters *&local_ref() {
+    static __thread PerfCounters *counters = NULL;
+    return counters;
+  }
+};
+
+} // namespace nocc
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef NOCC_STAGE_PROFILER
+#define NOCC_STAGE_PROFILER
+
+#include "latency_profier.h"
+#include "perf_counters.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <string>
+
+namespace nocc {
+
+#define NOCC_STAGE_PROFILE 1
+
+// the stages of a TX, shared by all the rtx engines
+enum TxStage {
+  STAGE_EXEC = 0,   // the TX logic and the local operations, i.e. out of the other stages
+  STAGE_READ,       // remote reads during the execution
+  STAGE_LOCK,
+  STAGE_VALIDATE,   // also the lease renewal of sundial
+  STAGE_LOG,
+  STAGE_2PC,
+  STAGE_COMMIT,     // write back
+  STAGE_RELEASE,    // release locks, at commit or abort
+  STAGE_NUM
+};
+
+static const char *const stage_names[STAGE_NUM] = {
+  "exec","read","lock","validate","log","2pc","commit","release"
+};
+
+/**
+ * The per-stage time breakdown of the TXs of a coroutine.
+ * The time of a stage is split into the time on CPU, and the time the coroutine yielded,
+ * waiting for the network (or a lock); the latter is counted by RWorker's yields in waited.
+ * Stages may nest; the execution gets the time out of the outermost stages.
+ * An aborted TX is accounted to the stage which was started but not finished, since the engines
+ * return at a failure without ending the stage; or to the execution.
+ * If the thread has hardware counters (see perf_counters.h), the events on CPU of each stage are
+ * counted in hw, the same way as cpu.
+ */
+struct StageProfile {
+  uint64_t cpu[STAGE_NUM];
+  uint64_t wait[STAGE_NUM];
+  uint64_t count[STAGE_NUM];
+  uint64_t aborts[STAGE_NUM];
+  uint64_t hw[STAGE_NUM][HW_NUM];
+  uint64_t commits;
+
+  uint64_t waited;            // total cycles the coroutine yielded
+  uint64_t hw_waited[HW_NUM]; // total events of the other coroutines while it yielded
+
+  // the TX in progress
+  int      open;
+  uint64_t tx_start;
+  uint64_t tx_waited;
+  uint64_t staged;
+  uint64_t staged_wait;
+  uint64_t tx_hw[HW_NUM];
+  uint64_t tx_hw_waited[HW_NUM];
+  uint64_t staged_hw[HW_NUM];
+
+  StageProfile() { clear(); }
+
+  void clear() { memset(this,0,sizeof(StageProfile)); }
+
+  inline void begin_tx() {
+    open        = STAGE_EXEC;
+    tx_start    = rdtsc();
+    tx_waited   = waited;
+    staged      = 0;
+    staged_wait = 0;
+    PerfCounters *pc = PerfCounters::local();
+    if(pc != NULL) {
+      pc->read(tx_hw);
+      memcpy(tx_hw_waited,hw_waited,sizeof(hw_waited));
+      memset(staged_hw,0,sizeof(staged_hw));
+    }
+  }
+
+  inline void end_stage(int s,int prev,uint64_t start,uint64_t wait_start,
+                        const uint64_t *hw_start = NULL,const uint64_t *hw_wait_start = NULL) {
+    uint64_t total = rdtsc() - start;
+    uint64_t w     = waited - wait_start;
+    cpu[s]   += total - w;
+    wait[s]  += w;
+    count[s] += 1;
+    if(prev == STAGE_EXEC) {
+      staged      += total;
+      staged_wait += w;
+    }
+    if(hw_start != NULL) {
+      uint64_t now[HW_NUM];
+      PerfCounters::local()->read(now);
+      for(int i = 0;i < HW_NUM;++i) {
+        uint64_t on_cpu = on_cpu_events(now[i] - hw_start[i],hw_waited[i] - hw_wait_start[i]);
+        hw[s][i] += on_cpu;
+        if(prev == STAGE_EXEC)
+          staged_hw[i] += on_cpu;
+      }
+    }
+    open = prev;
+  }
+
+  inline void end_tx(bool commit) {
+    uint64_t total = rdtsc() - tx_start;
+    uint64_t w     = waited - tx_waited;
+    if(total >= staged && w >= staged_wait) {
+      total -= staged;
+      w     -= staged_wait;
+      cpu[STAGE_EXEC]  += total > w ? total - w : 0;
+      wait[STAGE_EXEC] += w;
+    }
+    count[STAGE_EXEC] += 1;
+    if(commit)
+      commits += 1;
+    else
+      aborts[open] += 1;
+
+    PerfCounters *pc = PerfCounters::local();
+    if(pc != NULL) {
+      uint64_t now[HW_NUM];
+      pc->read(now);
+      for(int i = 0;i < HW_NUM;++i) {
+        uint64_t on_cpu = on_cpu_events(now[i] - tx_hw[i],hw_waited[i] - tx_hw_waited[i]);
+        hw[STAGE_EXEC][i] += on_cpu > staged_hw[i] ? on_cpu - staged_hw[i] : 0;
+      }
+    }
+  }
+
+  // read the counters of the thread; false if it has none
+  inline bool read_hw(uint64_t *vals) const {
+    PerfCounters *pc = PerfCounters::local();
+    if(pc == NULL)
+      return false;
+    pc->read(vals);
+    return true;
+  }
+
+  // count the events of the other coroutines, run since the current one yielded at start
+  inline void add_hw_waited(const uint64_t *start) {
+    uint64_t now[HW_NUM];
+    PerfCounters::local()->read(now);
+    for(int i = 0;i < HW_NUM;++i)
+      hw_waited[i] += now[i] - start[i];
+  }
+
+  static inline uint64_t on_cpu_events(uint64_t total,uint64_t w) {
+    return total > w ? total - w : 0;
+  }
+
+  bool has_hw() const {
+    for(int i = 0;i < STAGE_NUM;++i)
+      if(hw[i][HW_CYCLES] != 0 || hw[i][HW_INSTRUCTIONS] != 0)
+        return true;
+    return false;
+  }
+
+  void add(const StageProfile &p) {
+    for(int i = 0;i < STAGE_NUM;++i) {
+      cpu[i]    += p.cpu[i];
+      wait[i]   += p.wait[i];
+      count[i]  += p.count[i];
+      aborts[i] += p.aborts[i];
+      for(int j = 0;j < HW_NUM;++j)
+        hw[i][j] += p.hw[i][j];
+    }
+    commits += p.commits;
+  }
+
+  // the events per execution of stage s, the IPC and the LLC misses per 1000 instructions
+  void hw_per_exec(int s,double *vals,double *ipc,double *llc_mpki) const {
+    double n = count[s] == 0 ? 1 : count[s];
+    for(int j = 0;j < HW_NUM;++j)
+      vals[j] = hw[s][j] / n;
+    *ipc      = hw[s][HW_CYCLES] == 0 ? 0 : hw[s][HW_INSTRUCTIONS] / (double)hw[s][HW_CYCLES];
+    *llc_mpki = hw[s][HW_INSTRUCTIONS] == 0 ? 0 : hw[s][HW_LLC_MISSES] * 1000.0 / hw[s][HW_INSTRUCTIONS];
+  }
+
+  /**
+   * Write the breakdown as <prefix>_<node>.json and <prefix>_<node>.csv,
+   * or print the CSV to stdout if no prefix is given.
+   * Times are in us: per execution of a stage, and per committed TX.
+   * The hardware events, if counted, are per execution of a stage.
+   */
+  void report(const std::string &prefix,int node,uint64_t second_cycle) const {
+    double us = second_cycle / 1000000.0;
+    double c  = commits == 0 ? 1 : commits;
+    uint64_t total_aborts = 0;
+    for(int i = 0;i < STAGE_NUM;++i)
+      total_aborts += aborts[i];
+
+    FILE *csv  = stdout;
+    FILE *json = NULL;
+    if(!prefix.empty()) {
+      std::string base = prefix + "_" + std::to_string(node);
+      csv  = fopen((base + ".csv").c_str(),"w");
+      json = fopen((base + ".json").c_str(),"w");
+      if(csv == NULL || json == NULL) {
+        fprintf(stderr,"[stage profile] failed to open %s.{csv,json}\n",base.c_str());
+        if(csv != NULL) fclose(csv);
+        if(json != NULL) fclose(json);
+        return;
+      }
+    }
+
+    const bool with_hw = has_hw();
+    fprintf(csv,"stage,count,cpu_us,wait_us,cpu_us_per_commit,wait_us_per_commit,aborts");
+    if(with_hw) {
+      for(int j = 0;j < HW_NUM;++j)
+        fprintf(csv,",%s",hw_counter_names[j]);
+      fprintf(csv,",ipc,llc_mpki");
+    }
+    fprintf(csv,"\n");
+    if(json != NULL)
+      fprintf(json,"{\n  \"node\": %d,\n  \"commits\": %lu,\n  \"aborts\": %lu,\n  \"stages\": [\n",
+              node,commits,total_aborts);
+
+    for(int i = 0;i < STAGE_NUM;++i) {
+      double n = count[i] == 0 ? 1 : count[i];
+      double cpu_us  = cpu[i] / us / n,  wait_us  = wait[i] / us / n;
+      double cpu_ptx = cpu[i] / us / c,  wait_ptx = wait[i] / us / c;
+      fprintf(csv,"%s,%lu,%.3f,%.3f,%.3f,%.3f,%lu",
+              stage_names[i],count[i],cpu_us,wait_us,cpu_ptx,wait_ptx,aborts[i]);
+      if(json != NULL)
+        fprintf(json,"    {\"stage\": \"%s\", \"count\": %lu, \"cpu_us\": %.3f, \"wait_us\": %.3f, "
+                "\"cpu_us_per_commit\": %.3f, \"wait_us_per_commit\": %.3f, \"aborts\": %lu",
+                stage_names[i],count[i],cpu_us,wait_us,cpu_ptx,wait_ptx,aborts[i]);
+      if(with_hw) {
+        double vals[HW_NUM],ipc,llc_mpki;
+        hw_per_exec(i,vals,&ipc,&llc_mpki);
+        for(int j = 0;j < HW_NUM;++j)
+          fprintf(csv,",%.1f",vals[j]);
+        fprintf(csv,",%.3f,%.3f",ipc,llc_mpki);
+        if(json != NULL) {
+          fprintf(json,", \"hw\": {");
+          for(int j = 0;j < HW_NUM;++j)
+            fprintf(json,"\"%s\": %.1f, ",hw_counter_names[j],vals[j]);
+          fprintf(json,"\"ipc\": %.3f, \"llc_mpki\": %.3f}",ipc,llc_mpki);
+        }
+      }
+      fprintf(csv,"\n");
+      if(json != NULL)
+        fprintf(json,"}%s\n",i + 1 == STAGE_NUM ? "" : ",");
+    }
+
+    if(json != NULL) {
+      fprintf(json,"  ]\n}\n");
+      fclose(json);
+      fclose(csv);
+    }
+  }
+};
+
+// the hardware counters at the start of a stage
+struct StageHwMark {
+  bool     on;
+  uint64_t counters[HW_NUM];
+  uint64_t waited[HW_NUM];
+
+  explicit StageHwMark(const StageProfile *p) : on(p->read_hw(counters)) {
+    if(on)
+      memcpy(waited,p->hw_waited,sizeof(waited));
+  }
+
+  inline const uint64_t *start() const { return on ? counters : NULL; }
+};
+
+#if NOCC_STAGE_PROFILE
+/**
+ * Profile a stage of the TX run by the current coroutine of worker_;
+ * use them in pairs, like START/END.
+ */
+#define STAGE_START(S) StageProfile *_stage_## S = &(worker_->stage_profile()); \
+  int _stage_## S ##_prev = _stage_## S ->open;                                \
+  uint64_t _stage_## S ##_start = rdtsc();                                     \
+  uint64_t _stage_## S ##_wait  = _stage_## S ->waited;                        \
+  StageHwMark _stage_## S ##_hw(_stage_## S);                                  \
+  _stage_## S ->open = S;
+
+#define STAGE_END(S) _stage_## S ->end_stage(S,_stage_## S ##_prev,_stage_## S ##_start,_stage_## S ##_wait, \
+                                             _stage_## S ##_hw.start(),_stage_## S ##_hw.waited);
+
+#else
+#define STAGE_START(S) ;
+#define STAGE_END(S) ;
+#endif
+
+} // namespace nocc
+
+#endif
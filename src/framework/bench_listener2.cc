@@ -31,6 +31,7 @@ extern std::vector<SingleQueue *> local_comm_queues;
 namespace oltp {
 
 static std::ofstream log_file;
+static std::string   result_file;  // the structured results of the run, see BenchReporter::dump_results
 static bool global_inited = false;
 static struct timespec start_t;
 
@@ -69,6 +70,9 @@ BenchLocalListener::BenchLocalListener(unsigned worker_id,const std::vector<RWor
              exe_name.c_str(),bench_type.c_str(),total_partition,nthreads,coroutine_num,distributed_ratio);
     LOG(2)<<"try log results to " << log_file_name;
     log_file.open(log_file_name,std::ofstream::out);
+    result_file = "./results/" + exe_name + "_" + bench_type + "_" + std::to_string(total_partition) + "_"
+                  + std::to_string(nthreads) + "_" + std::to_string(coroutine_num) + "_"
+                  + std::to_string(distributed_ratio) + ".json";
   } // end master extra stuff
 
   reporter_->init(&workers_);
@@ -300,6 +304,8 @@ void BenchLocalListener::exit_handler() {
     log_file << m_l << " " << m_9<<" " << m_99 <<" "<<m_av<<std::endl;
     log_file.close();
   }
+  if(!result_file.empty())
+    reporter_->dump_results(result_file);
 #endif
 
   // really end the benchmark
@@ -1,13 +1,25 @@
 #include "config.h"
+#include "rocc_config.h"
 #include "bench_reporter.h"
 
 #include <string>
 #include <string.h>
+#include <stdio.h>
 #include <vector>
+#include <fstream>
 
 extern size_t nthreads;
+extern size_t coroutine_num;
+extern size_t distributed_ratio;
+extern size_t current_partition;
+extern size_t total_partition;
+extern std::string exe_name;
+extern std::string bench_type;
+
 #define MIN(x,y) ((x) > (y)?(y):(x))
 
+#define WARMUP_EPOCHS 10 // the results of the first epochs are not logged
+
 // an example reporter for the framework
 
 // the data exchanged between servers
@@ -16,8 +28,18 @@ struct WorkerData {
   int32_t commits;
   int32_t aborts;
   int32_t abort_ratio;
+  uint16_t hist_entries; // followed by the non-zero buckets of the latency histograms
+  uint8_t  hist_bits;    // precision of the shipped buckets, see HdrHistogram::index
 };
 
+struct HistEntry {
+  uint16_t bucket;
+  uint8_t  tx;
+  uint32_t count;
+} __attribute__ ((aligned (8)));
+
+#define MAX_HIST_ENTRIES ((LAT_HIST_MSG_SIZE - sizeof(WorkerData)) / sizeof(HistEntry))
+
 static std::string normalize_throughput(uint64_t thpt) {
 
   static uint64_t K = 1000;
@@ -42,7 +64,13 @@ uint64_t second_cycle;
 
 std::vector<double> thpts;
 
-size_t BenchReporter::data_len() { return sizeof(WorkerData);}
+size_t BenchReporter::data_len() {
+#if LAT_HISTOGRAM
+  return sizeof(WorkerData) + MAX_HIST_ENTRIES * sizeof(HistEntry);
+#else
+  return sizeof(WorkerData);
+#endif
+}
 
 void BenchReporter::init(const std::vector<BenchWorker *> *workers) {
 
@@ -68,6 +96,14 @@ void BenchReporter::init(const std::vector<BenchWorker *> *workers) {
     all_commits.push_back(0.0);
     all_aborts.push_back(0.0);
   }
+
+#if LAT_HISTOGRAM
+  for(auto &w : (*workers_)[0]->get_workload())
+    tx_names_.push_back(w.name);
+  prev_hists_.resize(nthreads * tx_names_.size());
+  node_hists_.resize(total_partition,std::vector<util::HdrHistogram>(tx_names_.size()));
+  run_hists_.resize(tx_names_.size());
+#endif
 }
 
 
@@ -79,6 +115,9 @@ void BenchReporter::merge_data(char *data,int id) {
   throughputs[id] = p->throughput;
   all_commits[id] = p->commits;
   all_aborts[id] = p->aborts;
+#if LAT_HISTOGRAM
+  merge_histograms(data,id);
+#endif
 }
 
 void BenchReporter::collect_data(char *data,struct  timespec &start_t) {
@@ -104,9 +143,121 @@ void BenchReporter::collect_data(char *data,struct  timespec &start_t) {
   p->commits = commit_num;
   p->aborts = abort_num;
   p->abort_ratio = abort_ratio;
+#if LAT_HISTOGRAM
+  collect_histograms(data);
+#endif
   return;
 }
 
+#if LAT_HISTOGRAM
+void BenchReporter::collect_histograms(char *data) {
+
+  using util::HdrHistogram;
+  WorkerData *p = (WorkerData *)data;
+  HistEntry *entries = (HistEntry *)(data + sizeof(WorkerData));
+  int ntx = tx_names_.size();
+  double ns_per_cycle = 1000000000.0 / second_cycle;
+
+  // the latencies of this epoch, converted to ns
+  std::vector<HdrHistogram> epoch(ntx);
+  for(uint w = 0;w < nthreads;++w) {
+    for(int t = 0;t < ntx;++t) {
+      auto &cur  = (*workers_)[w]->lat_hists_[t];
+      auto &prev = prev_hists_[w * ntx + t];
+      for(int i = 0;i < HdrHistogram::kBuckets;++i) {
+        uint64_t c = cur.count(i);
+        if(c == prev.count(i)) continue;
+        double ns = HdrHistogram::highest(i) * ns_per_cycle;
+        uint64_t v = ns >= 1.8e19 ? UINT64_MAX : (uint64_t)ns;
+        epoch[t].add(HdrHistogram::index(v),c - prev.count(i));
+        prev.add(i,c - prev.count(i));
+      }
+    }
+  }
+
+  // ship the non-zero buckets, coarsened until they fit in the message
+  p->hist_entries = 0;
+  for(int bits = HdrHistogram::kSubBits;bits >= 1;--bits) {
+    uint n = 0;
+    bool fit = true;
+    for(int t = 0;t < ntx && fit;++t) {
+      int last = -1;
+      for(int i = 0;i < HdrHistogram::kBuckets;++i) {
+        uint64_t c = epoch[t].count(i);
+        if(c == 0) continue;
+        int b = HdrHistogram::index(HdrHistogram::highest(i),bits);
+        if(b != last) {
+          if(n == MAX_HIST_ENTRIES) {
+            fit = false;
+            break;
+          }
+          entries[n].bucket = b;
+          entries[n].tx     = t;
+          entries[n].count  = 0;
+          n += 1;
+          last = b;
+        }
+        entries[n - 1].count += c;
+      }
+    }
+    if(fit) {
+      p->hist_bits = bits;
+      p->hist_entries = n;
+      break;
+    }
+  }
+}
+
+void BenchReporter::merge_histograms(char *data,int id) {
+
+  using util::HdrHistogram;
+  WorkerData *p = (WorkerData *)data;
+  HistEntry *entries = (HistEntry *)(data + sizeof(WorkerData));
+  auto &hists = node_hists_[id];
+  for(auto &h : hists)
+    h.clear();
+  for(uint i = 0;i < p->hist_entries;++i) {
+    auto &e = entries[i];
+    if(e.tx >= hists.size()) continue;
+    hists[e.tx].add(HdrHistogram::index(HdrHistogram::highest(e.bucket,p->hist_bits)),e.count);
+  }
+}
+
+void BenchReporter::report_histograms(uint64_t epoch,std::ofstream &log_file) {
+
+  for(uint t = 0;t < tx_names_.size();++t) {
+    util::HdrHistogram h;
+    for(uint n = 0;n < node_hists_.size();++n) {
+      for(int i = 0;i < util::HdrHistogram::kBuckets;++i)
+        h.add(i,node_hists_[n][t].count(i));
+    }
+    // in us
+    double p50  = h.percentile(50) / 1000.0;
+    double p99  = h.percentile(99) / 1000.0;
+    double p999 = h.percentile(99.9) / 1000.0;
+    double max  = h.max() / 1000.0;
+#if LISTENER_PRINT_PERF == 1
+    if(h.total() > 0)
+      fprintf(stdout,"  %s latency(us) p50 %.1f, p99 %.1f, p999 %.1f, max %.1f\n",
+              tx_names_[t].c_str(),p50,p99,p999,max);
+#endif
+#ifdef LOG_RESULTS
+    if(epoch > WARMUP_EPOCHS && log_file.is_open())
+      log_file << " " << p50 << " " << p99 << " " << p999 << " " << max;
+#endif
+    auto &lats = epoch_results_.back().tx_lats;
+    lats.insert(lats.end(),{ p50,p99,p999,max });
+    if(epoch > WARMUP_EPOCHS) {
+      for(int i = 0;i < util::HdrHistogram::kBuckets;++i)
+        run_hists_[t].add(i,h.count(i));
+    }
+  }
+  for(auto &hists : node_hists_)
+    for(auto &h : hists)
+      h.clear();
+}
+#endif
+
 void BenchReporter::report_data(uint64_t epoch,std::ofstream &log_file) {
 
   (*workers_)[0]->workload_report();
@@ -135,15 +286,25 @@ void BenchReporter::report_data(uint64_t epoch,std::ofstream &log_file) {
 #endif
 #endif
 
+  epoch_results_.push_back({ epoch,sum,abort_ratio });
+
 #ifdef LOG_RESULTS
-  if(epoch > 10 && log_file.is_open()) {
+  if(epoch > WARMUP_EPOCHS && log_file.is_open()) {
     /* warm up for 10 seconds, also the calcuation script will skip some seconds*/
     /* record the result */
     log_file << (sum) << " "<< abort_ratio <<" "
-             << latency << std::endl;
+             << latency;
     thpts.push_back(throughput);
   }
 #endif
+#if LAT_HISTOGRAM
+  // appends p50/p99/p999/max (us) of each TX type to the line
+  report_histograms(epoch,log_file);
+#endif
+#ifdef LOG_RESULTS
+  if(epoch > WARMUP_EPOCHS && log_file.is_open())
+    log_file << std::endl;
+#endif
 
   // clear the report data
   throughput = 0;
@@ -210,6 +371,140 @@ void BenchReporter::end() {
   fprintf(stdout,"avg thpt: %f\n",sum / c);
 }
 
+static const char *protocol_name() {
+#if defined(OCC_TX)
+  return "occ";
+#elif defined(NOWAIT_TX)
+  return "nowait";
+#elif defined(WAITDIE_TX)
+  return "waitdie";
+#elif defined(SUNDIAL_TX)
+  return "sundial";
+#elif defined(MVCC_TX)
+  return "mvcc";
+#elif defined(CALVIN_TX)
+  return "calvin";
+#else
+  return "other";
+#endif
+}
+
+static void dump_build_flags(FILE *f) {
+  fprintf(f,"  \"build\": {\n");
+  fprintf(f,"    \"protocol\": \"%s\",\n",protocol_name());
+#ifdef ONE_SIDED_READ
+  fprintf(f,"    \"ONE_SIDED_READ\": %d,\n",ONE_SIDED_READ);
+#else
+  fprintf(f,"    \"ONE_SIDED_READ\": 0,\n");
+#endif
+#ifdef HYBRID_CODE
+  fprintf(f,"    \"HYBRID_CODE\": %d,\n",HYBRID_CODE);
+#else
+  fprintf(f,"    \"HYBRID_CODE\": 0,\n");
+#endif
+  fprintf(f,"    \"USE_RDMA\": %d,\n",USE_RDMA);
+  fprintf(f,"    \"USE_TCP_MSG\": %d,\n",USE_TCP_MSG);
+  fprintf(f,"    \"TX_LOG_STYLE\": %d,\n",TX_LOG_STYLE);
+  fprintf(f,"    \"TX_TWO_PHASE_COMMIT_STYLE\": %d,\n",TX_TWO_PHASE_COMMIT_STYLE);
+  fprintf(f,"    \"ENABLE_TXN_API\": %d,\n",ENABLE_TXN_API);
+  fprintf(f,"    \"RDMA_CACHE\": %d,\n",RDMA_CACHE);
+  fprintf(f,"    \"LOG_DELTA\": %d,\n",LOG_DELTA);
+  fprintf(f,"    \"DURABLE_LOG\": %d,\n",DURABLE_LOG);
+  fprintf(f,"    \"EPOCH_COMMIT\": %d,\n",EPOCH_COMMIT);
+  fprintf(f,"    \"CONTENTION_MANAGER\": %d\n",CONTENTION_MANAGER);
+  fprintf(f,"  },\n");
+}
+
+void BenchReporter::dump_results(const std::string &file) {
+
+  FILE *f = fopen(file.c_str(),"w");
+  if(f == NULL) {
+    fprintf(stderr,"failed to open the result file %s\n",file.c_str());
+    return;
+  }
+
+  fprintf(f,"{\n");
+  fprintf(f,"  \"config\": {\"exe\": \"%s\", \"bench\": \"%s\", \"nodes\": %lu, \"threads\": %lu, "
+          "\"coroutines\": %lu, \"distributed_ratio\": %lu, \"warmup_epochs\": %d},\n",
+          exe_name.c_str(),bench_type.c_str(),total_partition,nthreads,coroutine_num,
+          distributed_ratio,WARMUP_EPOCHS);
+  if(skew_config.enabled)
+    fprintf(f,"  \"skew\": {\"cross_ratio\": %d, \"partitions\": %d, \"theta\": %.3f, "
+            "\"move_s\": %lu, \"move_pct\": %.3f},\n",
+            skew_config.cross_ratio,skew_config.partitions,skew_config.theta,
+            skew_config.move_s,skew_config.move_pct);
+  dump_build_flags(f);
+
+  std::vector<std::string> names;
+#if LAT_HISTOGRAM
+  names = tx_names_;
+#endif
+  fprintf(f,"  \"tx_types\": [");
+  for(uint t = 0;t < names.size();++t)
+    fprintf(f,"%s\"%s\"",t == 0 ? "" : ", ",names[t].c_str());
+  fprintf(f,"],\n");
+
+  // throughput (TX/s) and latency (us) of the whole run, without the warm up
+  double thpt = 0;
+  uint n = 0;
+  for(auto &e : epoch_results_) {
+    if(e.epoch <= WARMUP_EPOCHS) continue;
+    thpt += e.throughput;
+    n += 1;
+  }
+  fprintf(f,"  \"summary\": {\"throughput\": %f, \"latency\": {",n == 0 ? 0 : thpt / n);
+#if LAT_HISTOGRAM
+  for(uint t = 0;t < names.size();++t) {
+    auto &h = run_hists_[t];
+    fprintf(f,"%s\"%s\": [%.3f, %.3f, %.3f, %.3f]",t == 0 ? "" : ", ",names[t].c_str(),
+            h.percentile(50) / 1000.0,h.percentile(99) / 1000.0,h.percentile(99.9) / 1000.0,
+            h.max() / 1000.0);
+  }
+#endif
+  fprintf(f,"}},\n");
+
+  // aborts of this node, by the stage they happened at
+  fprintf(f,"  \"aborts\": {");
+#if NOCC_STAGE_PROFILE
+  StageProfile stages;
+  for(auto w : *workers_)
+    w->collect_stage_profile(stages);
+  fprintf(f,"\"commits\": %lu",stages.commits);
+  for(int i = 0;i < STAGE_NUM;++i)
+    fprintf(f,", \"%s\": %lu",stage_names[i],stages.aborts[i]);
+#endif
+  fprintf(f,"},\n");
+
+#if NOCC_STAGE_PROFILE
+  // hardware events of this node per execution of a stage, if counted
+  if(stages.has_hw()) {
+    fprintf(f,"  \"hw_counters\": {");
+    for(int i = 0;i < STAGE_NUM;++i) {
+      double vals[HW_NUM],ipc,llc_mpki;
+      stages.hw_per_exec(i,vals,&ipc,&llc_mpki);
+      fprintf(f,"%s\"%s\": {",i == 0 ? "" : ", ",stage_names[i]);
+      for(int j = 0;j < HW_NUM;++j)
+        fprintf(f,"\"%s\": %.1f, ",hw_counter_names[j],vals[j]);
+      fprintf(f,"\"ipc\": %.3f, \"llc_mpki\": %.3f}",ipc,llc_mpki);
+    }
+    fprintf(f,"},\n");
+  }
+#endif
+
+  fprintf(f,"  \"epochs\": [\n");
+  for(uint i = 0;i < epoch_results_.size();++i) {
+    auto &e = epoch_results_[i];
+    fprintf(f,"    {\"epoch\": %lu, \"throughput\": %f, \"abort_ratio\": %f, \"latency\": [",
+            e.epoch,e.throughput,e.abort_ratio);
+    for(uint j = 0;j < e.tx_lats.size();++j)
+      fprintf(f,"%s%.3f",j == 0 ? "" : ", ",e.tx_lats[j]);
+    fprintf(f,"]}%s\n",i + 1 == epoch_results_.size() ? "" : ",");
+  }
+  fprintf(f,"  ]\n}\n");
+  fclose(f);
+  LOG(2) << "results written to " << file;
+}
+
 }; // namespace oltp
 
 
@@ -16,6 +16,9 @@ class BenchReporter { // not thread safe
   virtual size_t data_len();
   virtual void end();
 
+  // write the config, build flags and per-epoch results of the run as JSON (master only)
+  virtual void dump_results(const std::string &file);
+
  private:
   double throughput;
   uint64_t commits;
@@ -37,6 +40,26 @@ class BenchReporter { // not thread safe
   std::vector<double > throughputs;
   std::vector<uint64_t> all_commits;
   std::vector<uint64_t> all_aborts;
+
+  struct EpochResult {
+    uint64_t epoch;
+    double   throughput;
+    double   abort_ratio;
+    std::vector<double> tx_lats;  // p50/p99/p999/max (us) of each TX type
+  };
+  std::vector<EpochResult> epoch_results_;
+
+#if LAT_HISTOGRAM
+  // per-epoch latency histograms (ns) of each TX type
+  std::vector<std::string> tx_names_;
+  std::vector<util::HdrHistogram> prev_hists_;                // workers' snapshots at the last epoch
+  std::vector<std::vector<util::HdrHistogram> > node_hists_;  // merged from each node
+  std::vector<util::HdrHistogram> run_hists_;                 // all nodes, after the warm up
+
+  void collect_histograms(char *data);
+  void merge_histograms(char *data,int id);
+  void report_histograms(uint64_t epoch,std::ofstream &log_file);
+#endif
 };
 
 } // end namespace oltp
@@ -11,6 +11,15 @@
 
 #include "rtx/logger.hpp"
 #include "rtx/global_vars.h"
+#include "rtx/ts_clock.hpp"
+#include "rtx/log_replayer.hpp"
+#include "rtx/failover.hpp"
+#ifdef CALVIN_TX
+#include "rtx/calvin_scheduler.h"
+#endif
+#if DURABLE_LOG
+#include "rtx/durable_log.hpp"
+#endif
 
 #include <boost/foreach.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -19,6 +28,8 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <sstream>
+
 #include "ring_imm_msg.h"
 
 
@@ -35,7 +46,10 @@ size_t current_partition = 0;             // current worker id
 size_t distributed_ratio = 1; // the distributed transaction's ratio
 
 
+extern std::string bench_type;
+
 int tcp_port = 33333;
+static bool port_per_node = false; // node i uses tcp_port + i, to emulate a cluster at one host
 
 namespace nocc {
 
@@ -68,6 +82,13 @@ uint64_t r_buffer_size = 0;
 uint64_t twophase_commit_mem_base_offset = 0;
 TwoPhaseCommitMemManager* twophase_mem = NULL;
 
+#if DURABLE_LOG
+static rtx::DurableLogConfig durable_log_conf; // filled by parse_config
+#endif
+static int replay_threads = 0; // 0: the log cleaners apply the logs inline
+static std::string snapshot_dir;  // empty: always run the loaders
+static uint64_t snapshot_fingerprint = 0; // of the options the loaders depend on
+
 std::string config_file_name;
 std::string host_file = "hosts.xml";  // default host file
 
@@ -87,10 +108,11 @@ BenchRunner::BenchRunner(std::string &config_file)
 
   std::fill_n(backup_stores_,RTX_MAX_BACKUP,static_cast<MemDB *>(NULL));
 
-  rtx::global_view = new rtx::SymmetricView(rep_factor,net_def_.size());
+  rtx::global_view = new rtx::SymmetricView(rep_factor,net_def_.size(),rtx::placement_config);
   //rtx::global_view->print();
 
   rtx::global_lock_manager = new rtx::GlobalLockManager[200]; // hard coded
+  rtx::TSClock::calibrate();
   /* reset the barrier number */
   barrier_a_.n = nthreads;
 }
@@ -136,13 +158,13 @@ BenchRunner::run() {
   for(uint i = 0;i < nthreads + nclients + 4;++i) {
     local_comm_queues.push_back(new SingleQueue());
   }
-  poller = new AdapterPoller(local_comm_queues,tcp_port);
+  poller = new AdapterPoller(local_comm_queues,tcp_port + (port_per_node ? current_partition : 0));
   poller->create_recv_socket(recv_context);
 
   // create sender sockets
 #if DEDICATED == 0
   LOG(3) << "[TCP] creating shared sockets";
-  Adapter::create_shared_sockets(cm->network_,tcp_port,send_context);
+  Adapter::create_shared_sockets(cm->network_,tcp_port,send_context,port_per_node ? 1 : 0);
 #endif // end if create dedicated send sockets
 #endif // end if USE_RDMA
 
@@ -167,6 +189,18 @@ BenchRunner::run() {
   LOG(2) << "Total two-phase committer area " << get_memory_size_g(twophase_mem_sz) << "G.";
   total_sz += twophase_mem_sz;
 
+#ifdef CALVIN_TX
+  // CALVIN's input and value forwarding rings
+  calvin_mem = new CalvinMemManager(rdma_buffer,total_partition,nthreads,CALVIN_RING_SIZE,total_sz);
+  uint64_t calvin_mem_sz = Round(calvin_mem->total_size(), M2);
+  assert(r_buffer_size > total_sz + calvin_mem_sz);
+  memset(rdma_buffer + total_sz,0,calvin_mem_sz); // empty rings
+  LOG(2) << "Total CALVIN ring area " << get_memory_size_g(calvin_mem_sz) << "G.";
+  total_sz += calvin_mem_sz;
+
+  calvin_scheduler = new CalvinScheduler(calvin_mem,current_partition,total_partition,nthreads);
+#endif
+
   uint64_t store_size = 0;
 #if 1
 // #if ONE_SIDED_READ == 1
@@ -200,7 +234,11 @@ BenchRunner::run() {
   MemNode::init_time = std::chrono::system_clock::now();
 #endif
 
-  const vector<BenchLoader *> loaders = make_loaders(current_partition);
+  // restart from the snapshot, if there is one
+  bool from_snapshot = !snapshot_dir.empty() &&
+                       store_->LoadSnapshot(snapshot_dir,current_partition,current_partition,snapshot_fingerprint,
+                                             rdma_buffer);
+  const vector<BenchLoader *> loaders = from_snapshot ? vector<BenchLoader *>() : make_loaders(current_partition);
   {
     const pair<uint64_t, uint64_t> mem_info_before = get_system_memory_info();
     {
@@ -218,6 +256,8 @@ BenchRunner::run() {
     const double delta_mb = double(delta)/1048576.0;
     cout << "[Runner] local db size: " << delta_mb << " MB" << endl;
   }
+  if(!snapshot_dir.empty() && !from_snapshot)
+    store_->Snapshot(snapshot_dir,current_partition,current_partition,snapshot_fingerprint);
   init_put();
 
 #if USE_RDMA
@@ -242,6 +282,8 @@ BenchRunner::run() {
 
   std::set<int> backed_list; // the primary id which I should backed
   global_view->response_for(current_partition,backed_list);
+  ASSERT(backed_list.size() <= MAX_BACKUP_NUM)
+      << "backs " << backed_list.size() << " partitions, max " << MAX_BACKUP_NUM << " supported.";
 
   int i(0);
   for(auto it = backed_list.begin();it != backed_list.end();++it) {
@@ -249,7 +291,11 @@ BenchRunner::run() {
     int backed_id = *it;
 
     init_backup_store(backup_stores_[i]);
-    const vector<BenchLoader *> loaders = make_loaders(backed_id,backup_stores_[i]);
+    bool from_snapshot = !snapshot_dir.empty() &&
+                         backup_stores_[i]->LoadSnapshot(snapshot_dir,current_partition,backed_id,
+                                                                    snapshot_fingerprint,rdma_buffer);
+    const vector<BenchLoader *> loaders = from_snapshot ? vector<BenchLoader *>() :
+                                          make_loaders(backed_id,backup_stores_[i]);
     {
       const pair<uint64_t, uint64_t> mem_info_before = get_system_memory_info();
       {
@@ -268,6 +314,8 @@ BenchRunner::run() {
       const double delta_mb = double(delta)/1048576.0;
       LOG(2) << "[Runner] Backup DB[" << i << "] for " << backed_id << " size: " << delta_mb << " MB";
     }
+    if(!snapshot_dir.empty() && !from_snapshot)
+      backup_stores_[i]->Snapshot(snapshot_dir,current_partition,backed_id,snapshot_fingerprint);
     logger->add_backup_store(backed_id,backup_stores_[i++]);
   }
 
@@ -278,6 +326,18 @@ BenchRunner::run() {
     workers.push_back(poller);
 
   bootstrap_with_rdma(cm);
+#ifdef CALVIN_TX
+  calvin_scheduler->start();
+#endif
+  if(replay_threads > 0 && !backed_list.empty()) {
+    rtx::log_replayer = new rtx::LogReplayer(replay_threads,nthreads);
+    rtx::log_replayer->start();
+  }
+#if DURABLE_LOG
+  // one log stream per thread which may receive log acks
+  rtx::durable_log = new rtx::DurableLog(durable_log_conf,current_partition,nthreads + nclients + 2);
+  rtx::durable_log->start();
+#endif
   for (vector<RWorker *>::const_iterator it = workers.begin();
        it != workers.end(); ++it){
     (*it)->start();
@@ -339,6 +399,12 @@ void BenchRunner::parse_config(std::string &config_file) {
 
     }
     LOG(2) << "Use TCP port " << tcp_port;
+    try {
+      port_per_node = pt.get<int>("bench.port_per_node") != 0;
+      LOG(2) << "node i uses TCP port " << tcp_port << " + i";
+    } catch (const ptree_error &e) {
+      // pass
+    }
 
     try{
       nclients = pt.get<size_t>("bench.clients");
@@ -353,9 +419,123 @@ void BenchRunner::parse_config(std::string &config_file) {
       rep_factor = 0;
     }
 
+#if DURABLE_LOG
+    try {
+      durable_log_conf.dir        = pt.get<std::string>("bench.durable_log.dir");
+      durable_log_conf.writers    = pt.get<int>("bench.durable_log.writers");
+      durable_log_conf.flush_us   = pt.get<uint64_t>("bench.durable_log.flush_us");
+      durable_log_conf.segment_mb = pt.get<uint64_t>("bench.durable_log.segment_mb");
+    } catch (const ptree_error &e) {
+      LOG(2) << "durable log config is partially given, use the default for the rest.";
+    }
+#endif
+
+    try {
+      replay_threads = pt.get<int>("bench.replay_threads");
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      auto &conf = rtx::failover_config;
+      conf.heartbeat_us = pt.get<uint64_t>("bench.failover.heartbeat_us",conf.heartbeat_us);
+      conf.timeout_us   = pt.get<uint64_t>("bench.failover.timeout_us");
+      conf.enabled      = true;
+      conf.crash_node   = pt.get<int>("bench.failover.crash_node",conf.crash_node);
+      conf.crash_after_s = pt.get<uint64_t>("bench.failover.crash_after_s",conf.crash_after_s);
+      LOG(2) << "failover enabled, failure timeout " << conf.timeout_us << "us.";
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      auto &conf = rtx::placement_config;
+      for(auto &v : pt.get_child("bench.placement")) {
+        if(v.first == "partition") {
+          std::istringstream ss(v.second.get<std::string>("backups"));
+          auto &backups = conf.backups[v.second.get<int>("id")];
+          for(int b;ss >> b;)
+            backups.push_back(b);
+        } else if(v.first == "table") {
+          // a table id is only meaningful to its benchmark
+          if(v.second.get<std::string>("bench",bench_type) != bench_type)
+            continue;
+          int id = v.second.get<int>("id");
+          if(v.second.get<int>("replicated",0))
+            conf.replicated.insert(id);
+          else
+            conf.table_rep[id] = v.second.get<int>("rep_factor");
+        }
+      }
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      auto &conf = open_loop_config;
+      std::istringstream ss(pt.get<std::string>("bench.open_loop.rates"));
+      for(double r;ss >> r;)
+        conf.rates.push_back(r);
+      conf.step_s  = pt.get<uint64_t>("bench.open_loop.step_s",conf.step_s);
+      conf.poisson = pt.get<std::string>("bench.open_loop.arrival","poisson") != "fixed";
+      conf.enabled = !conf.rates.empty();
+      LOG(2) << "open-loop clients with " << conf.rates.size() << " load steps of "
+             << conf.step_s << " seconds.";
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      auto &conf = skew_config;
+      pt.get_child("bench.skew");
+      conf.cross_ratio = pt.get<int>("bench.skew.cross_ratio",conf.cross_ratio);
+      conf.partitions  = std::max(pt.get<int>("bench.skew.partitions",conf.partitions),1);
+      conf.theta       = pt.get<double>("bench.skew.theta",conf.theta);
+      conf.move_s      = pt.get<uint64_t>("bench.skew.move_s",conf.move_s);
+      conf.move_pct    = pt.get<double>("bench.skew.move_pct",conf.move_pct);
+      conf.enabled     = true;
+      LOG(2) << "skewed workload: cross-partition ratio " << conf.cross_ratio << ", "
+             << conf.partitions << " remote partitions, theta " << conf.theta
+             << ", the hotspot moves " << conf.move_pct << "% every " << conf.move_s << " seconds.";
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      stage_profile_prefix = pt.get<std::string>("bench.stage_profile");
+      LOG(2) << "write the stage breakdown to " << stage_profile_prefix << "_<node>.{json,csv}";
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      stage_hw_counters = pt.get<bool>("bench.hw_counters");
+      if(stage_hw_counters)
+        LOG(2) << "count the hardware events of the TX stages.";
+    } catch (const ptree_error &e) {
+      // pass
+    }
+    try {
+      snapshot_dir = pt.get<std::string>("bench.snapshot_dir");
+      LOG(2) << "use DB snapshots in " << snapshot_dir;
+    } catch (const ptree_error &e) {
+      // pass
+    }
+
     if(scale_factor == 0)
       scale_factor = nthreads;
 
+    if(!snapshot_dir.empty()) {
+      // the loaded data depends on the scale, the partitions, and the options of the app
+      std::ostringstream conf;
+      conf << scale_factor << " " << total_partition << " " << nthreads;
+      for(auto &v : pt.get_child("bench")) {
+        if(v.first == "tpcc" || v.first == "tpce" || v.first == "ycsb" || v.first == "bank"
+           || v.first == "graph") {
+          conf << " " << v.first << ":";
+          write_xml(conf,v.second);
+        }
+      }
+      snapshot_fingerprint = 14695981039346656037ULL; // FNV-1a
+      for(char c : conf.str())
+        snapshot_fingerprint = (snapshot_fingerprint ^ (uint8_t)c) * 1099511628211ULL;
+      LOG(2) << "the fingerprint of the DB snapshots: " << std::hex << snapshot_fingerprint << std::dec;
+    }
+
   } catch (const ptree_error &e) {
     /* using the default settings  */
     LOG(LOG_ERROR) << "some error happens in parse scale factor or clients. Maybe its not important";
@@ -7,6 +7,11 @@
 
 #include "req_buf_allocator.h"
 
+#include "rtx/log_replayer.hpp"
+#if DURABLE_LOG
+#include "rtx/durable_log.hpp"
+#endif
+
 #include "db/txs/dbrad.h"
 #include "db/txs/dbsi.h"
 
@@ -30,6 +35,8 @@ __thread rtx::WAITDIE  **new_txs_ = NULL;
 __thread rtx::SUNDIAL  **new_txs_ = NULL;
 #elif defined(MVCC_TX)
 __thread rtx::MVCC  **new_txs_ = NULL;
+#elif defined(CALVIN_TX)
+__thread rtx::CALVIN  **new_txs_ = NULL;
 #endif
 
 extern uint64_t total_ring_sz;
@@ -60,6 +67,16 @@ extern MemDB *backup_stores_[MAX_BACKUP_NUM];
 
 SpinLock exit_lock;
 
+OpenLoopConfig open_loop_config;
+static std::vector<OpenLoopGenerator *> open_loop_gens; // of all the workers, for the report
+
+SkewConfig skew_config;
+
+std::string stage_profile_prefix;           // empty: print the stage breakdown to stdout
+bool stage_hw_counters = false;
+static std::vector<RWorker *> stage_workers; // of all the workers, for the stage breakdown
+static std::atomic<uint64_t> unavailable_txs(0); // dropped by all the workers, see rtx::TXOpBase::route
+
 BenchWorker::BenchWorker(unsigned worker_id,bool set_core,unsigned seed,uint64_t total_ops,
                          spin_barrier *barrier_a,spin_barrier *barrier_b,BenchRunner *context,
                          DBLogger *db_logger):
@@ -81,6 +98,9 @@ BenchWorker::BenchWorker(unsigned worker_id,bool set_core,unsigned seed,uint64_t
 {
   assert(cm_ != NULL);
   INIT_LAT_VARS(yield);
+#if LAT_HISTOGRAM
+  lat_hists_ = new util::HdrHistogram[NOCC_BENCH_MAX_TX];
+#endif
 #if CS == 0
   nclients = 0;
   server_routine = coroutine_num;
@@ -110,6 +130,9 @@ void BenchWorker::init_tx_ctx() {
 #elif defined(MVCC_TX)
   new_txs_          = new rtx::MVCC*[1 + server_routine + 2];
   std::fill_n(new_txs_,1 + server_routine + 2,static_cast<rtx::MVCC*>(NULL));
+#elif defined(CALVIN_TX)
+  new_txs_          = new rtx::CALVIN*[1 + server_routine + 2];
+  std::fill_n(new_txs_,1 + server_routine + 2,static_cast<rtx::CALVIN*>(NULL));
 #else
   assert(false);
 #endif
@@ -127,6 +150,8 @@ void BenchWorker::init_tx_ctx() {
   }
   for(uint i = 0;i < 1 + server_routine + 2;++i)
     txs_[i] = NULL;
+  input_time_s_ = new uint64_t[1 + server_routine + 2];
+  std::fill_n(input_time_s_,1 + server_routine + 2,(uint64_t)time(NULL));
 
   // init workloads
   workloads = new workload_desc_vec_t[server_routine + 2];
@@ -180,9 +205,56 @@ void BenchWorker::run() {
   this->init_two_phase_committer();
   
   this->thread_local_init();   // application specific init
+#if CONTENTION_MANAGER
+  contention_mgr_ = new ContentionManager(get_workload().size(),coroutine_num,
+                                          random_generator[0].get_seed() + worker_id_);
+#endif
 
   register_callbacks();
 
+#if NOCC_STAGE_PROFILE
+  if(stage_hw_counters) {
+    PerfCounters *pc = PerfCounters::open_local();
+    int opened = pc == NULL ? 0 : pc->opened();
+    if(opened < HW_NUM && worker_id_ == 0)
+      LOG(3) << "only " << opened << " of " << HW_NUM << " hardware counters opened, "
+             << "check perf_event_paranoid.";
+  }
+  exit_lock.Lock();
+  stage_workers.push_back(this);
+  exit_lock.Unlock();
+#endif
+
+#if CS == 0
+  if(open_loop_config.enabled) {
+    std::vector<double> mix;
+    for(auto &w : get_workload())
+      mix.push_back(w.frequency);
+    open_loop_ = new OpenLoopGenerator(mix,nthreads,random_generator[0].get_seed() + worker_id_);
+    exit_lock.Lock();
+    open_loop_gens.push_back(open_loop_);
+    exit_lock.Unlock();
+  }
+#endif
+
+  // one probe stream per node is enough to align the TSClock
+  if(worker_id_ == 0)
+    skew_estimator_ = new rtx::SkewEstimator(rpc_,current_partition,
+                                             RTX_TS_PROBE_RPC_ID,RTX_TS_REPLY_RPC_ID);
+#ifdef CALVIN_TX
+  // CALVIN's executors run the sequenced batches and are never halted
+  if(worker_id_ == 0 && rtx::failover_config.enabled)
+    LOG(4) << "failover is not supported by CALVIN, it is disabled.";
+#else
+  if(worker_id_ == 0 && rtx::failover_config.enabled)
+    failover_mgr_ = new rtx::FailoverManager(rpc_,cm_,current_partition,total_partition,nthreads,
+                                             RTX_HEARTBEAT_RPC_ID,RTX_VIEW_CHANGE_RPC_ID,
+                                             new_txs_[0]->db_,rdma_buffer, // the store the TXs access
+                                             [this](int pid) -> MemDB * {
+                                               return new_logger_ == NULL ? NULL : new_logger_->backed_store(pid);
+                                             });
+#endif
+
 #if CS == 1
 #if LOCAL_CLIENT == 0
   create_client_connections(nthreads + nclients);
@@ -217,8 +289,15 @@ BenchWorker::worker_routine(yield_func_t &yield) {
   workloads[cor_id_] = get_workload();
   auto &workload = workloads[cor_id_];
 
+#ifdef CALVIN_TX
+  // CALVIN only executes the sequenced TXs, which never abort
+  if(cor_id_ == 1)
+    calvin_sequencer_routine(yield);
+  else
+    calvin_executor_routine(yield);
+#endif
+
   // Used for OCC retry
-  unsigned int backoff_shifts = 0;
   unsigned long abort_seed = 73;
 
   while(abort_seed == random_generator[cor_id_].get_seed()) {
@@ -234,17 +313,34 @@ BenchWorker::worker_routine(yield_func_t &yield) {
    //uint64_t max_count = 2000;
    //while (max_count-- > 0) {
   while(true) {
+    // new TXs wait until the view change is done
+    if(unlikely(rtx::global_view->halted())) {
+      yield_next(yield);
+      continue;
+    }
+    running_txs_ += 1;
 #if CS == 0
-    /* select the workload */
-    double d = random_generator[cor_id_].next_uniform();
-
     uint tx_idx = 0;
-    for(size_t i = 0;i < workload.size();++i) {
-      if((i + 1) == workload.size() || d < workload[i].frequency) {
-        tx_idx = i;
-        break;
+    OpenLoopGenerator::Arrival arrival;
+    if(open_loop_ != NULL) {
+      // serve the queued arrivals, rather than issuing the next TX at once
+      open_loop_->generate(rdtsc());
+      if(!open_loop_->pop(arrival)) {
+        yield_next(yield);
+        continue;
+      }
+      tx_idx = arrival.tx_idx;
+    } else {
+      /* select the workload */
+      double d = random_generator[cor_id_].next_uniform();
+
+      for(size_t i = 0;i < workload.size();++i) {
+        if((i + 1) == workload.size() || d < workload[i].frequency) {
+          tx_idx = i;
+          break;
+        }
+        d -= workload[i].frequency;
       }
-      d -= workload[i].frequency;
     }
 #else
 #if LOCAL_CLIENT
@@ -274,12 +370,26 @@ BenchWorker::worker_routine(yield_func_t &yield) {
       (workload[tx_idx].latency_timer).start();
       //#endif
     }
+#endif
+#if LAT_HISTOGRAM
+    uint64_t tx_start = rdtsc();
+#if CS == 0
+    if(open_loop_ != NULL)
+      tx_start = arrival.time;
+#endif
 #endif
     const unsigned long old_seed = random_generator[cor_id_].get_seed();
+    input_time_s_[cor_id_] = time(NULL); // a retry keeps the inputs, as well as the seed
     (*txn_counts)[tx_idx] += 1;
  abort_retry:
     ntxn_executed_ += 1;
+#if NOCC_STAGE_PROFILE
+    stage_profs_[cor_id_].begin_tx();
+#endif
     auto ret = workload[tx_idx].fn(this,yield);
+#if NOCC_STAGE_PROFILE
+    stage_profs_[cor_id_].end_tx(ret.first);
+#endif
 #if NO_ABORT == 1
     //ret.first = true;
 #endif
@@ -287,6 +397,12 @@ BenchWorker::worker_routine(yield_func_t &yield) {
     if(likely(ret.first)) {
       // commit case
       retry_count = 0;
+#if CONTENTION_MANAGER
+      contention_mgr_->on_commit(cor_id_,tx_idx);
+#endif
+#if LAT_HISTOGRAM
+      lat_hists_[tx_idx].record(rdtsc() - tx_start);
+#endif
 #if CALCULATE_LAT == 1
       if(cor_id_ == 1) {
         //#if LATENCY == 1
@@ -299,6 +415,8 @@ BenchWorker::worker_routine(yield_func_t &yield) {
 
 #if CS == 0 // self_generated requests
       ntxn_commits_ += 1;
+      if(open_loop_ != NULL)
+        open_loop_->record(arrival,rdtsc());
 
 #if PROFILE_RW_SET == 1 || PROFILE_SERVER_NUM == 1
       if(ret.second > 0)
@@ -314,6 +432,18 @@ BenchWorker::worker_routine(yield_func_t &yield) {
       char *reply = rpc_->get_reply_buf();
       rpc_->send_reply(reply,sizeof(uint8_t),req.c_id,req.c_tid,req.cor_id,client_handler_);
 #endif
+#endif
+    } else if(unlikely(rtx_->unavailable())) {
+      // the TX touches a partition which is being taken over, so it is dropped rather than retried
+      unavailable_txs.fetch_add(1);
+#if CS == 1 // the client is not left waiting
+#if LOCAL_CLIENT
+      char dummy = req.cor_id;
+      conns[req.c_tid]->enqueue(worker_id_,(char *)(&dummy),sizeof(char));
+#else
+      char *reply = rpc_->get_reply_buf();
+      rpc_->send_reply(reply,sizeof(uint8_t),req.c_id,req.c_tid,req.cor_id,client_handler_);
+#endif
 #endif
     } else {
       retry_count += 1;
@@ -329,12 +459,33 @@ BenchWorker::worker_routine(yield_func_t &yield) {
         (*txn_aborts)[tx_idx] += 1;
       }
       ntxn_aborts_ += 1;
+#if CONTENTION_MANAGER
+      {
+        // back off, and wait for the hot key's worker-local token if the TX keeps aborting on it
+        int backoff = contention_mgr_->on_abort(cor_id_,tx_idx,
+                                                rtx_->conflict_tableid_,rtx_->conflict_key_);
+        rtx_->record_conflict(-1,0);
+        for(int i = 0;i < backoff;++i)
+          yield_next(yield);
+        while(!contention_mgr_->try_enter(cor_id_))
+          yield_next(yield);
+      }
+#endif
       yield_next(yield);
 
+      // an aborted TX holds nothing, so it waits out a view change as a new one
+      if(unlikely(rtx::global_view->halted())) {
+        running_txs_ -= 1;
+        while(rtx::global_view->halted())
+          yield_next(yield);
+        running_txs_ += 1;
+      }
+
       // reset the old seed
       random_generator[cor_id_].set_seed(old_seed);
       goto abort_retry;
     }
+    running_txs_ -= 1;
     yield_next(yield);
     // end worker main loop
   }
@@ -347,10 +498,154 @@ BenchWorker::worker_routine(yield_func_t &yield) {
 }
 
 
+#ifdef CALVIN_TX
+int BenchWorker::calvin_gen_batch(uint64_t epoch,char *batch,yield_func_t &yield) {
+  auto &workload = workloads[cor_id_];
+  int num = (server_routine - 1) * CALVIN_TXS_PER_COR;
+
+  auto exec_tx = rtx_;
+  rtx_ = calvin_gen_tx_;
+  char *ptr = batch;
+  for(int i = 0;i < num;++i) {
+    rtx::det_request *req = (rtx::det_request *)ptr;
+    uint tx_idx = 0;
+    uint64_t next_seed = 0;
+    bool retry = !calvin_ctx_->retries.empty();
+    if(retry) {
+      // a TX whose execution diverged from its input goes first, with a new reconnaissance
+      tx_idx = calvin_ctx_->retries.front().first;
+      req->req_seed = calvin_ctx_->retries.front().second;
+      calvin_ctx_->retries.pop_front();
+      next_seed = random_generator[cor_id_].get_seed();
+      random_generator[cor_id_].set_seed(req->req_seed);
+    } else {
+      double d = random_generator[cor_id_].next_uniform();
+      for(size_t j = 0;j < workload.size();++j) {
+        if((j + 1) == workload.size() || d < workload[j].frequency) {
+          tx_idx = j;
+          break;
+        }
+        d -= workload[j].frequency;
+      }
+      // the executors replay the TX from the same seed
+      req->req_seed = random_generator[cor_id_].get_seed();
+    }
+    input_time_s_[cor_id_] = time(NULL);
+    req->input_time_s = input_time_s_[cor_id_];
+    workload[tx_idx].fn(this,yield);
+    if(retry)
+      random_generator[cor_id_].set_seed(next_seed);
+
+    req->txn_id = CALVIN_TXN_ID(epoch,current_partition,worker_id_,i);
+    req->timestamp = rdtsc();
+    req->req_idx = tx_idx;
+    req->req_initiator = current_partition;
+    rtx_->fill_request(req);
+    ptr += req->size();
+  }
+  rtx_ = exec_tx;
+  return num;
+}
+
+void BenchWorker::calvin_sequencer_routine(yield_func_t &yield) {
+  int max_num = (server_routine - 1) * CALVIN_TXS_PER_COR;
+  char *batch = (char *)malloc(max_num * (sizeof(rtx::det_request) +
+                                          CALVIN_MAX_ACCESS * sizeof(rtx::CalvinAccess)));
+  const uint64_t epoch_cycles = BreakdownTimer::get_one_second_cycle() / 1000000 * CALVIN_EPOCH_US;
+  uint64_t epoch = 0;
+  uint64_t next_epoch_time = rdtsc();
+
+  while(true) {
+    rtx_->poll_rings();
+    // forward the local values of the granted TXs; this never waits for other TXs
+    rtx_->forward_ready(yield);
+    while(!calvin_ctx_->passive.empty()) {
+      // a passive participant only provides values
+      rtx::CalvinTxn *txn = calvin_ctx_->passive.front();
+      calvin_ctx_->passive.pop_front();
+      calvin_report(txn->req,true);
+      calvin_ctx_->scheduler->finish(worker_id_,txn);
+    }
+
+    // seal an epoch, unless the local scheduler lags behind
+    if(rdtsc() >= next_epoch_time && epoch < calvin_ctx_->scheduler->epoch() + CALVIN_EPOCH_LAG) {
+      int num = calvin_gen_batch(epoch,batch,yield);
+      rtx_->send_batch(epoch,batch,num,yield);
+      epoch += 1;
+      next_epoch_time = rdtsc() + epoch_cycles;
+    }
+    yield_next(yield);
+  }
+}
+
+void BenchWorker::calvin_executor_routine(yield_func_t &yield) {
+  auto &workload = workloads[cor_id_];
+  while(true) {
+    if(calvin_ctx_->exec_queue.empty()) {
+      yield_next(yield);
+      continue;
+    }
+    rtx::CalvinTxn *txn = calvin_ctx_->exec_queue.front();
+    calvin_ctx_->exec_queue.pop_front();
+    rtx::det_request *req = txn->req;
+
+    rtx_->prepare(txn);
+    random_generator[cor_id_].set_seed(req->req_seed);
+    input_time_s_[cor_id_] = req->input_time_s;
+    auto ret = workload[req->req_idx].fn(this,yield);
+    if(rtx_->diverged()) {
+      // all the active participants diverge alike, and write nothing
+      if(rtx::CALVIN::is_reporter(req,current_partition)) {
+        ntxn_aborts_ += 1;
+        rtx_->restart(yield);
+      }
+    } else
+      calvin_report(req,ret.first);
+    rtx_->finish(yield);
+    yield_next(yield);
+  }
+}
+
+void BenchWorker::calvin_report(const rtx::det_request *req,bool commit) {
+  if(!rtx::CALVIN::is_reporter(req,current_partition))
+    return;
+  (*txn_counts)[req->req_idx] += 1;
+  ntxn_executed_ += 1;
+  if(!commit) {
+    // logical aborts are deterministic, and are not retried
+    ntxn_aborts_ += 1;
+    return;
+  }
+  ntxn_commits_ += 1;
+#if LAT_HISTOGRAM
+  if(req->req_initiator == current_partition)
+    lat_hists_[req->req_idx].record(rdtsc() - req->timestamp);
+#endif
+#if CALCULATE_LAT == 1
+  if(req->req_initiator == current_partition) {
+    auto &timer = workloads[1][req->req_idx].latency_timer; // the one reported
+    timer.temp = req->timestamp;
+    timer.end();
+  }
+#endif
+}
+#endif
+
 void BenchWorker::events_handler() {
   LOG(3) << "in bench event handler";
   RWorker::events_handler();
-
+  // ack the view change once the TXs in flight are done
+  if(unlikely(rtx::global_view->halted()) && running_txs_ == 0 &&
+     acked_halt_ != rtx::global_view->halt_round()) {
+    acked_halt_ = rtx::global_view->halt_round();
+    rtx::global_view->quiesce();
+  }
+  if(skew_estimator_ != NULL)
+    skew_estimator_->poll();
+  if(new_logger_ != NULL)
+    new_logger_->poll();
+  if(failover_mgr_ != NULL)
+    failover_mgr_->poll();
 }
 
 void BenchWorker::exit_handler() {
@@ -378,10 +673,51 @@ void BenchWorker::exit_handler() {
     }
     fprintf(stdout,"succs ratio %f\n",(double)(ntxn_commits_) /
             (double)(ntxn_executed_));
+    if(open_loop_ != NULL) {
+      std::vector<std::string> names;
+      for(auto &w : workload)
+        names.push_back(w.name);
+      OpenLoopGenerator::report(open_loop_gens,names);
+    }
+#if CONTENTION_MANAGER
+    fprintf(stdout,"commits after waiting a hot key's worker token %lu\n",contention_mgr_->token_commits());
+#endif
+#if DURABLE_LOG
+    rtx::durable_log->report();
+#endif
+    if(rtx::log_replayer != NULL)
+      rtx::log_replayer->report();
+#if LOG_DELTA
+    fprintf(stdout,"delta logs rejected by the backups %lu\n",(uint64_t)rtx::rejected_deltas());
+#endif
+    if(failover_mgr_ != NULL) {
+      failover_mgr_->report();
+      fprintf(stdout,"TXs dropped for the partitions being taken over %lu\n",(uint64_t)unavailable_txs);
+    }
+#if TX_LOG_STYLE == 2
+    if(new_logger_ != NULL)
+      fprintf(stdout,"logs waiting for ring credits %lu\n",((rtx::RDMALogger *)new_logger_)->credit_stalls_);
+#endif
+#if EPOCH_COMMIT
+    if(new_logger_ != NULL)
+      new_logger_->epoch_report();
+#endif
+    if(two_phase_committer_ != NULL)
+      two_phase_committer_->report();
+#if NOCC_STAGE_PROFILE
+    {
+      StageProfile total;
+      exit_lock.Lock();
+      for(auto w : stage_workers)
+        w->collect_stage_profile(total);
+      exit_lock.Unlock();
+      total.report(stage_profile_prefix,current_partition,second_cycle);
+    }
+#endif
 
     exit_report();
 #endif
-#if MVCC_TX || NOWAIT_TX || SUNDIAL_TX || OCC_TX || WAITDIE_TX
+#if MVCC_TX || NOWAIT_TX || SUNDIAL_TX || OCC_TX || WAITDIE_TX || CALVIN_TX
     int temp[40];
     for(int i = 0; i < 40; ++i)
         temp[i] = 0;
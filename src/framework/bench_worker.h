@@ -7,10 +7,17 @@
 #include "core/utils/count_vector.hpp"
 
 #include "util/util.h"
+#include "util/hdr_histogram.h"
 
 #include "db/txs/tx_handler.h"
 
 #include "rtx/logger.hpp"
+#include "rtx/skew_estimator.hpp"
+#include "rtx/failover.hpp"
+
+#include "contention_manager.h"
+#include "open_loop.h"
+#include "skew_generator.h"
 
 #ifdef OCC_TX
 #include "rtx/occ.h"
@@ -27,6 +34,13 @@
 //       which should be refactored later after.
 #include "rtx/global_vars.h"
 #endif
+#elif defined(CALVIN_TX)
+#include "rtx/calvin_rdma.h"
+#include "rtx/global_vars.h"
+#endif
+
+#if RO_SNAPSHOT
+#include "rtx/ro_snapshot.hpp"
 #endif
 
 #include <queue>          // std::queue
@@ -56,6 +70,8 @@ extern __thread rtx::WAITDIE  **new_txs_;
 extern __thread rtx::SUNDIAL  **new_txs_;
 #elif defined(MVCC_TX)
 extern __thread rtx::MVCC  **new_txs_;
+#elif defined(CALVIN_TX)
+extern __thread rtx::CALVIN  **new_txs_;
 #endif
 
 extern     RdmaCtrl *cm;
@@ -68,6 +84,11 @@ namespace oltp {
 
 extern uint64_t twophase_commit_mem_base_offset; 
 
+// the file prefix of the stage breakdown, from config.xml
+extern std::string stage_profile_prefix;
+// whether to count the hardware events of the stages (see perf_counters.h), from config.xml
+extern bool stage_hw_counters;
+
 class BenchWorker;
 class BenchRunner;
 extern View* my_view; // replication setting of the data
@@ -132,6 +153,9 @@ class BenchWorker : public RWorker {
 
   void req_rpc_handler(int id,int cid,char *msg,void *arg);
 
+  // the wall clock (s) when the current TX's inputs were produced; CALVIN's executors replay it
+  inline uint64_t input_time_s() const { return input_time_s_[cor_id_]; }
+
   void change_ctx(int cor_id) {
     tx_ = txs_[cor_id];
     rtx_ = new_txs_[cor_id];
@@ -208,6 +232,44 @@ class BenchWorker : public RWorker {
 #endif
   }
 
+#ifdef CALVIN_TX
+  // shall be called after new_txs_ are created
+  void init_calvin_ctx(MemDB *store) {
+    assert(calvin_ctx_ == NULL);
+    calvin_ctx_ = new rtx::CalvinContext(rtx::calvin_scheduler,rtx::calvin_mem,
+                                         current_partition,worker_id_);
+    for(int i = 0;i < server_routine + 1;++i)
+      new_txs_[i]->set_context(calvin_ctx_);
+    calvin_gen_tx_ = new rtx::CALVIN(this,store,rpc_,current_partition,worker_id_,1,-1,
+                                     cm_,rdma_sched_,total_partition);
+    calvin_gen_tx_->set_gen_mode();
+    calvin_gen_tx_->set_context(calvin_ctx_);
+  }
+
+  // coroutine 1 sequences the inputs, and forwards the values of the granted TXs;
+  // the others execute the granted TXs
+  void calvin_sequencer_routine(yield_func_t &yield);
+  void calvin_executor_routine(yield_func_t &yield);
+  int  calvin_gen_batch(uint64_t epoch,char *batch,yield_func_t &yield);
+  void calvin_report(const rtx::det_request *req,bool commit);
+#endif
+
+  // one read-only TX per coroutine, local records are read without the network;
+  // shall be called after new_txs_ are created, since MVCC snapshots use their clocks
+  void init_ro_txs(MemDB *store) {
+#if RO_SNAPSHOT
+    assert(ro_txs_ == NULL);
+    ro_txs_ = new rtx::ROSnapshot*[server_routine + 1];
+    for(uint i = 0;i < server_routine + 1;++i) {
+      ro_txs_[i] = new rtx::ROSnapshot(this,store,rpc_,current_partition,worker_id_,i,current_partition,
+                                       cm_,rdma_sched_,total_partition);
+#if MVCC_TX
+      ro_txs_[i]->set_clock(new_txs_[i]);
+#endif
+    }
+#endif
+  }
+
   virtual ~BenchWorker() { }
   virtual workload_desc_vec_t get_workload() const = 0;
   virtual void register_callbacks() = 0;     /*register read-only callback*/
@@ -239,9 +301,25 @@ class BenchWorker : public RWorker {
 #elif defined(MVCC_TX)
   rtx::MVCC *rtx_;
   rtx::MVCC *rtx_hook_ = NULL;
+#elif defined(CALVIN_TX)
+  rtx::CALVIN *rtx_;
+  rtx::CALVIN *rtx_hook_ = NULL;
+  rtx::CALVIN *calvin_gen_tx_ = NULL;      // runs the TXs in the gen mode to sequence their inputs
+  rtx::CalvinContext *calvin_ctx_ = NULL;
+#endif
+#if RO_SNAPSHOT
+  rtx::ROSnapshot **ro_txs_ = NULL;
 #endif
   LAT_VARS(yield);
 
+  ContentionManager *contention_mgr_ = NULL;
+  OpenLoopGenerator *open_loop_ = NULL;        // only if the open-loop clients are enabled
+  rtx::SkewEstimator *skew_estimator_ = NULL; // only at worker 0
+  rtx::FailoverManager *failover_mgr_ = NULL; // only at worker 0, if failover is enabled
+  uint64_t *input_time_s_ = NULL;              // per coroutine, see input_time_s()
+  int      running_txs_ = 0;                   // of the coroutines, the view change waits for them
+  uint64_t acked_halt_  = 0;                   // the last halt round of the view acked
+
   /* For statistics counts */
   size_t ntxn_commits_;
   size_t ntxn_aborts_;
@@ -252,6 +330,10 @@ class BenchWorker : public RWorker {
   size_t ntxn_remote_counts_;
   util::BreakdownTimer latency_timer_;
   CountVector<double> latencys_;
+#if LAT_HISTOGRAM
+  // latencies (cycles) of each TX type, written by the worker only, read by the reporter
+  util::HdrHistogram *lat_hists_;
+#endif
 
  private:
   bool initilized_;
@@ -6,7 +6,9 @@
 // rdma related stuffs
 #define HUGE_PAGE  1
 #define USE_UD_MSG 1
-#define USE_TCP_MSG 0
+#ifndef USE_TCP_MSG
+#define USE_TCP_MSG 0  // the -tcp executables set it
+#endif
 #define SINGLE_MR  0
 #define BUF_SIZE   10480 // RDMA buffer size registered, in a small setting
 //#define BUF_SIZE 512
@@ -28,6 +30,14 @@
 #define POLL_CYCLES    0      // print the polling cycle
 #define CALCULATE_LAT  1
 #define LATENCY 0 // 1: global latency report; 0: workload specific report
+#define LAT_HISTOGRAM 1     // per-thread latency histograms of all TXs, reported per epoch
+#define LAT_HIST_MSG_SIZE 3072 // max bytes of the histograms sent by a node per epoch
+
+// contention management of the aborted TXs (see contention_manager.h) is set in tx_config.h
+
+// open-loop clients (see open_loop.h), enabled by the open_loop entry of config.xml
+#define OPEN_LOOP_MAX_QUEUE   100000   // arrivals queued at a worker, the exceeded ones are dropped
+#define OPEN_LOOP_MAX_SAMPLES 1000000  // latencies kept per load step and TX type
 
 #if USE_TCP_MSG == 1
 #undef  USE_UD_MSG
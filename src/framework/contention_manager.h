@@ -0,0 +1,154 @@
+#ifndef NOCC_FRAMEWORK_CONTENTION_MANAGER_H_
+#define NOCC_FRAMEWORK_CONTENTION_MANAGER_H_
+
+#include "tx_config.h"
+#include "config.h"
+#include "core/utils/util.h"
+
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+
+namespace nocc {
+
+namespace oltp {
+
+/**
+ * A per-worker contention manager, consulted by the worker routine when a TX aborts.
+ * 1. Randomized exponential backoff per TX type, measured in coroutine yields.
+ * 2. Hot keys, detected from the record which caused the abort (TXOpBase::record_conflict).
+ * 3. (Optional, CM_WORKER_TOKEN) A TX which keeps aborting on the same hot key takes a token
+ *    of the key before re-execution, so the coroutines of a worker stop racing on it.
+ *    The token only orders the retries within the worker: it is not a lock of the record,
+ *    and the TXs of other workers and nodes keep racing on the key.
+ * All coroutines of a worker share one instance, so no synchronization is required.
+ */
+class ContentionManager {
+ public:
+  ContentionManager(int num_tx_types,int num_cors,unsigned long seed) :
+      tx_windows_(num_tx_types,0),
+      cors_(num_cors + 1),
+      rand_(seed) {
+  }
+
+  // returns the number of yields to back off before the retry
+  int on_abort(int cor_id,int tx_idx,int tableid,uint64_t key) {
+    auto &c = cors_[cor_id];
+    bool has_conflict = (tableid >= 0);
+    if(has_conflict) {
+      bool same = (c.tableid == tableid && c.key == key);
+      c.same_key_aborts = same ? c.same_key_aborts + 1 : 1;
+      c.tableid = tableid;
+      c.key     = key;
+      touch_hot(tableid,key);
+    }
+
+    auto &w = tx_windows_[tx_idx];
+    w = (w == 0) ? 1 : std::min(w << 1,(uint32_t)CM_MAX_BACKOFF);
+
+#if CM_WORKER_TOKEN
+    if(has_conflict && c.same_key_aborts >= CM_TOKEN_RETRIES && is_hot(tableid,key))
+      c.wait_token = true;
+#endif
+    return rand_.next() % (w + 1);
+  }
+
+  void on_commit(int cor_id,int tx_idx) {
+    tx_windows_[tx_idx] >>= 1;
+    auto &c = cors_[cor_id];
+    release_token(c);
+    c.same_key_aborts = 0;
+    c.tableid = -1;
+  }
+
+  // whether the coroutine can (re-)execute its TX now; otherwise it shall yield and retry.
+  // only the coroutines of this worker are excluded
+  bool try_enter(int cor_id) {
+    auto &c = cors_[cor_id];
+    if(!c.wait_token || c.hold_token)
+      return true;
+    auto k = std::make_pair(c.tableid,c.key);
+    auto it = tokens_.find(k);
+    if(it != tokens_.end())
+      return false;
+    tokens_[k] = cor_id;
+    c.token = k;
+    c.hold_token = true;
+    return true;
+  }
+
+  bool is_hot(int tableid,uint64_t key) const {
+    const HotEntry &e = hot_keys_[slot(tableid,key)];
+    return e.tableid == tableid && e.key == key && e.aborts >= CM_HOT_THRESHOLD;
+  }
+
+  uint64_t token_commits() const { return token_commits_; }
+
+ private:
+  // configurations
+  static const uint32_t CM_MAX_BACKOFF = 1024; // max yields before a retry
+  static const int CM_HOT_SLOTS        = 1024;
+  static const uint32_t CM_HOT_THRESHOLD = 8;  // aborts within a decay period
+  static const uint64_t CM_DECAY_PERIOD  = 4096;
+  static const int CM_TOKEN_RETRIES = 3;
+
+  struct CorState {
+    int      tableid = -1;
+    uint64_t key     = 0;
+    int      same_key_aborts = 0;
+    bool     wait_token = false;
+    bool     hold_token = false;
+    std::pair<int,uint64_t> token;
+  };
+
+  struct HotEntry {
+    int      tableid = -1;
+    uint64_t key     = 0;
+    uint32_t aborts  = 0;
+  };
+
+  inline int slot(int tableid,uint64_t key) const {
+    return (int)(((key * 0x9E3779B97F4A7C15ULL) ^ (uint64_t)tableid) % CM_HOT_SLOTS);
+  }
+
+  void touch_hot(int tableid,uint64_t key) {
+    HotEntry &e = hot_keys_[slot(tableid,key)];
+    if(e.tableid == tableid && e.key == key) {
+      e.aborts += 1;
+    } else if(e.aborts <= 1) { // replace a cold entry
+      e.tableid = tableid;
+      e.key = key;
+      e.aborts = 1;
+    } else {
+      e.aborts -= 1;
+    }
+    if(++total_aborts_ % CM_DECAY_PERIOD == 0) {
+      for(auto &h : hot_keys_)
+        h.aborts >>= 1;
+    }
+  }
+
+  void release_token(CorState &c) {
+    if(c.hold_token) {
+      tokens_.erase(c.token);
+      token_commits_ += 1;
+    }
+    c.hold_token = false;
+    c.wait_token = false;
+  }
+
+  std::vector<uint32_t> tx_windows_;
+  std::vector<CorState> cors_;
+  HotEntry hot_keys_[CM_HOT_SLOTS];
+  std::map<std::pair<int,uint64_t>,int> tokens_;
+
+  util::fast_random rand_;
+  uint64_t total_aborts_ = 0;
+  uint64_t token_commits_ = 0;
+};
+
+} // namespace oltp
+} // namespace nocc
+
+#endif
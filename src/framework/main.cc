@@ -47,6 +47,7 @@
 #include "app/tpcc/tpcc_worker.h"
 #include "app/tpce/tpce_worker.h"
 #include "app/smallbank/bank_worker.h"
+#include "app/ycsb/ycsb_worker.h"
 #include "app/micro_benches/bench_micro.h"
 
 #include "util/spinlock.h"
@@ -280,12 +281,14 @@ int main(int argc, char **argv)
 
   if(bench_type == "tpcc") {
     test_fn = nocc::oltp::tpcc::TpccTest;
-  // } else if(bench_type == "tpce") {
-  //   test_fn = nocc::oltp::tpce::TpceTest;
+  } else if(bench_type == "tpce") {
+    test_fn = nocc::oltp::tpce::TpceTest;
   } else if(bench_type == "micro") {
     test_fn = nocc::oltp::micro::MicroTest;
   } else if(bench_type == "bank") {
     test_fn = nocc::oltp::bank::BankTest;
+  } else if(bench_type == "ycsb") {
+    test_fn = nocc::oltp::ycsb::YcsbTest;
   } else if(bench_type == "graph") {
     test_fn = nocc::oltp::link::GraphTest;
   } else{
@@ -0,0 +1,184 @@
+#ifndef NOCC_FRAMEWORK_OPEN_LOOP_H_
+#define NOCC_FRAMEWORK_OPEN_LOOP_H_
+
+#include "config.h"
+#include "util/timer.h"
+#include "util/spinlock.h"
+#include "core/utils/util.h"
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+
+namespace nocc {
+
+namespace oltp {
+
+struct OpenLoopConfig {
+  bool     enabled = false;
+  bool     poisson = true;          // Poisson arrivals; otherwise a fixed inter-arrival time
+  std::vector<double> rates;        // offered load of a node (TX/s), one per step
+  uint64_t step_s  = 10;            // length of a load step
+};
+
+// filled by the runner from config.xml
+extern OpenLoopConfig open_loop_config;
+
+/**
+ * An open-loop load generator of a worker.
+ * Requests arrive independently of the completions, at the node's offered rate split among
+ * its workers (the merge of the workers' Poisson arrivals is a Poisson arrival of the node).
+ * Each request is stamped at its arrival, and queued until a coroutine of the worker serves it,
+ * so the recorded latency includes the queueing delay.
+ * The offered rate steps through the configured rates, and the latencies are kept per step and
+ * TX type. All coroutines of a worker share one instance; the lock only guards the samples
+ * against the report.
+ */
+class OpenLoopGenerator {
+ public:
+  struct Arrival {
+    int      tx_idx;
+    uint64_t time;   // rdtsc at arrival
+  };
+
+  OpenLoopGenerator(const std::vector<double> &mix,int num_workers,unsigned long seed) :
+      mix_(mix),
+      rand_(seed),
+      samples_(open_loop_config.rates.size(),std::vector<std::vector<uint64_t> >(mix.size())),
+      completed_(open_loop_config.rates.size(),0),
+      dropped_(open_loop_config.rates.size(),0) {
+    second_cycle_ = util::BreakdownTimer::get_one_second_cycle();
+    step_cycles_  = open_loop_config.step_s * second_cycle_;
+    for(double r : open_loop_config.rates)
+      mean_gaps_.push_back(r > 0 ? second_cycle_ * num_workers / r : 0);
+  }
+
+  // generates the arrivals up to now; no request arrives after the last step
+  void generate(uint64_t now) {
+    if(start_ == 0) {
+      start_ = now;
+      next_arrival_ = now;
+    }
+    while(next_arrival_ <= now) {
+      uint64_t s = (next_arrival_ - start_) / step_cycles_;
+      if(s >= mean_gaps_.size()) {
+        next_arrival_ = UINT64_MAX;
+        break;
+      }
+      if(mean_gaps_[s] == 0) { // no load in this step
+        next_arrival_ = start_ + (s + 1) * step_cycles_;
+        continue;
+      }
+      if(queue_.size() < OPEN_LOOP_MAX_QUEUE)
+        queue_.push_back({ select_tx(),next_arrival_ });
+      else
+        dropped_[s] += 1;
+      next_arrival_ += gap(mean_gaps_[s]);
+    }
+  }
+
+  bool pop(Arrival &a) {
+    if(queue_.empty()) return false;
+    a = queue_.front();
+    queue_.pop_front();
+    return true;
+  }
+
+  // a request is accounted to the step of its arrival
+  void record(const Arrival &a,uint64_t end) {
+    int s = step(a.time);
+    lock_.Lock();
+    completed_[s] += 1;
+    auto &buf = samples_[s][a.tx_idx];
+    if(buf.size() < OPEN_LOOP_MAX_SAMPLES)
+      buf.push_back(end - a.time);
+    lock_.Unlock();
+  }
+
+  /* report the latency percentiles of all the workers' generators, per step and TX type */
+  static void report(const std::vector<OpenLoopGenerator *> &gens,const std::vector<std::string> &names) {
+    if(gens.empty()) return;
+    double ms = gens[0]->second_cycle_ / 1000.0;
+    auto &rates = open_loop_config.rates;
+
+    for(uint s = 0;s < rates.size();++s) {
+      uint64_t completed(0), dropped(0);
+      for(auto g : gens) {
+        completed += g->completed_[s];
+        dropped   += g->dropped_[s];
+      }
+      if(completed == 0 && dropped == 0)
+        continue;
+      fprintf(stdout,"[open loop] step %u: offered %.0f tx/s, served %.0f tx/s, dropped %lu\n",
+              s,rates[s],(double)completed / open_loop_config.step_s,dropped);
+
+      for(uint t = 0;t < names.size();++t) {
+        std::vector<uint64_t> all;
+        for(auto g : gens) {
+          g->lock_.Lock();
+          auto &buf = g->samples_[s][t];
+          all.insert(all.end(),buf.begin(),buf.end());
+          g->lock_.Unlock();
+        }
+        if(all.empty()) continue;
+        std::sort(all.begin(),all.end());
+        fprintf(stdout,"  %s: %lu, p50 %f ms, p99 %f ms, p99.9 %f ms\n",names[t].c_str(),all.size(),
+                percentile(all,50) / ms,percentile(all,99) / ms,percentile(all,99.9) / ms);
+      }
+    }
+  }
+
+ private:
+  std::vector<double> mix_;     // frequencies of the TX types, as in the workload
+  util::fast_random rand_;
+
+  uint64_t second_cycle_;
+  uint64_t step_cycles_;
+  std::vector<double> mean_gaps_; // mean inter-arrival cycles of each step
+
+  uint64_t start_ = 0;
+  uint64_t next_arrival_ = 0;
+
+  std::deque<Arrival> queue_;
+
+  SpinLock lock_;
+  std::vector<std::vector<std::vector<uint64_t> > > samples_;
+  std::vector<uint64_t> completed_;
+  std::vector<uint64_t> dropped_;
+
+  int step(uint64_t t) const {
+    uint64_t s = (t - start_) / step_cycles_;
+    return std::min(s,(uint64_t)(mean_gaps_.size() - 1));
+  }
+
+  uint64_t gap(double mean) {
+    if(!open_loop_config.poisson)
+      return (uint64_t)mean;
+    double u = rand_.next_uniform();
+    return (uint64_t)(-std::log(1.0 - u) * mean) + 1;
+  }
+
+  int select_tx() {
+    double d = rand_.next_uniform();
+    for(size_t i = 0;i < mix_.size();++i) {
+      if((i + 1) == mix_.size() || d < mix_[i])
+        return i;
+      d -= mix_[i];
+    }
+    return 0;
+  }
+
+  static double percentile(const std::vector<uint64_t> &sorted,double p) {
+    size_t idx = std::min((size_t)std::floor(sorted.size() * p / 100.0),sorted.size() - 1);
+    return sorted[idx];
+  }
+};
+
+} // namespace oltp
+
+} // namespace nocc
+
+#endif
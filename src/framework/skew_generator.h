@@ -0,0 +1,139 @@
+#ifndef NOCC_FRAMEWORK_SKEW_GENERATOR_H_
+#define NOCC_FRAMEWORK_SKEW_GENERATOR_H_
+
+#include "framework/utils/util.h"
+#include "app/ycsb/ycsb_generator.hpp"
+
+#include <map>
+#include <functional>
+#include <utility>
+#include <time.h>
+#include <stdint.h>
+
+namespace nocc {
+
+namespace oltp {
+
+struct SkewConfig {
+  bool     enabled     = false;
+  int      cross_ratio = -1;   // % of TXs touching remote partitions; < 0: the benchmark's own ratio
+  int      partitions  = 1;    // remote partitions touched by a cross-partition TX
+  double   theta       = 0;    // zipf theta over the items (warehouses, accounts); 0: uniform
+  uint64_t move_s      = 0;    // the hotspot moves every move_s seconds; 0: it stays
+  double   move_pct    = 10;   // by move_pct% of the items
+};
+
+// filled by the runner from config.xml
+extern SkewConfig skew_config;
+
+/**
+ * A skew- and partition-affinity-aware chooser of the items (e.g. warehouses, accounts) of a
+ * benchmark, as given by skew_config.
+ * The items are [0, n), to_pid maps an item to its partition. The popularity of an item follows
+ * zipf(theta) of its distance to the hotspot, i.e. the hot items are the ones after the hotspot,
+ * and the hotspot moves by move_pct% of the items every move_s seconds. The hotspot follows the
+ * wall clock given by now_s, so it moves at all the nodes at the same time; the workers pass the
+ * time of the TX's inputs, which CALVIN's executors replay from the request, so the executors
+ * pick the items the sequencer did.
+ * Items of a given partition are drawn by rejecting the items of the others; so with a contiguous
+ * to_pid (TPC-C) the hot items form a hot partition, and with a hashed one (SmallBank) they are
+ * spread over the partitions.
+ * Not thread-safe; each worker has its own.
+ */
+class SkewGenerator {
+ public:
+  typedef int (*to_pid_t)(uint64_t item);
+  typedef std::function<uint64_t()> seconds_fn_t;
+
+  SkewGenerator(uint64_t n,to_pid_t to_pid,int self,int total_partition,
+                seconds_fn_t now_s = [] { return (uint64_t)time(NULL); }) :
+      n_(n),to_pid_(to_pid),self_(self),total_partition_(total_partition),now_s_(now_s),
+      zipf_(n,skew_config.theta > 0 ? skew_config.theta : 0.5,skew_config.theta > 0 ? zeta(n) : 1) {
+    move_step_ = (uint64_t)(n * skew_config.move_pct / 100.0);
+  }
+
+  // whether the next TX touches remote partitions; only meaningful if cross_ratio >= 0
+  inline bool cross_partition(util::fast_random &r) {
+    return total_partition_ > 1 && r.next() % 100 < (uint64_t)skew_config.cross_ratio;
+  }
+
+  // the remote partitions touched by a cross-partition TX with at most max items at remote; returns the number
+  int remote_partitions(util::fast_random &r,int max,int *pids) {
+    int num = std::min(std::min(skew_config.partitions,max),total_partition_ - 1);
+    int found = 0;
+    // the hot items decide the partitions
+    for(int tries = 0;found < num && tries < kMaxTries * total_partition_;++tries) {
+      int pid = to_pid_(item(r));
+      if(pid != self_ && !contains(pids,found,pid))
+        pids[found++] = pid;
+    }
+    while(found < num) {
+      int pid = r.next() % total_partition_;
+      if(pid != self_ && !contains(pids,found,pid))
+        pids[found++] = pid;
+    }
+    return found;
+  }
+
+  // an item of any partition
+  inline uint64_t item(util::fast_random &r) {
+    if(skew_config.theta <= 0)
+      return r.next() % n_;
+    return (zipf_.next(r) + hotspot()) % n_;
+  }
+
+  // an item of partition pid
+  uint64_t item(util::fast_random &r,int pid) {
+    for(int tries = 0;tries < kMaxTries * total_partition_;++tries) {
+      uint64_t res = item(r);
+      if(to_pid_(res) == pid)
+        return res;
+    }
+    // the partition has few hot items, pick a uniform one
+    while(true) {
+      uint64_t res = r.next() % n_;
+      if(to_pid_(res) == pid)
+        return res;
+    }
+  }
+
+  inline uint64_t hotspot() const {
+    if(skew_config.move_s == 0)
+      return 0;
+    return (now_s_() / skew_config.move_s) * move_step_ % n_;
+  }
+
+ private:
+  static const int kMaxTries = 64;
+
+  const uint64_t n_;
+  const to_pid_t to_pid_;
+  const int self_;
+  const int total_partition_;
+  const seconds_fn_t now_s_;
+  uint64_t move_step_;
+  ycsb::ZipfianGenerator zipf_;
+
+  static bool contains(const int *pids,int num,int pid) {
+    for(int i = 0;i < num;++i)
+      if(pids[i] == pid)
+        return true;
+    return false;
+  }
+
+  // zeta is O(n), so it is computed once per item count; the generators are made at the main thread
+  static double zeta(uint64_t n) {
+    static std::map<std::pair<uint64_t,double>,double> zetas;
+    auto key = std::make_pair(n,skew_config.theta);
+    auto it = zetas.find(key);
+    if(it != zetas.end())
+      return it->second;
+    return zetas[key] = ycsb::ZipfianGenerator::zeta(0,n,skew_config.theta,0);
+  }
+};
+
+} // namespace oltp
+
+} // namespace nocc
+
+#endif
@@ -80,7 +80,11 @@ class ClusterHash {
   }
 
   void enable_remote_accesses(RdmaCtrl *cm) {
-    auto base_ptr = (char *)(cm->conn_buf_);
+    enable_remote_accesses((char *)(cm->conn_buf_));
+  }
+
+  // the table is in the (RDMA) region starting at base_ptr
+  void enable_remote_accesses(char *base_ptr) {
     base_off_ = data_ptr_ - base_ptr;
   }
 
@@ -132,29 +136,41 @@ class ClusterHash {
     HeaderNode *node = (HeaderNode *)Rmalloc(sizeof(HeaderNode));
     assert(node != NULL);
 
+    auto res = remote_traverse(key,node,val,[this,qp](uint64_t off,char *buf,int size) {
+        fetch_node(qp,off,buf,size);
+      });
+    assert(res != 0);
+    Rfree(node);
+    return res;
+  }
+
+  /**
+   * Traverse the chain of key in a remote table, reading each node into node with
+   * fetch(off,buf,size), where off is the node's offset in the remote region.
+   * return offset of the found data (copied to val), 0 if the key is not found.
+   * The fetch can be any transport; the micro benchmarks of memstore use a local emulation.
+   */
+  template <typename Fetch>
+  inline uint64_t remote_traverse(uint64_t key,HeaderNode *node,char *val,Fetch &&fetch) {
+
     uint64_t idx = get_hash(key);
     uint64_t node_off = idx * sizeof(HeaderNode) + base_off_;
-    fetch_node(qp,node_off,(char *)node,sizeof(HeaderNode));
+    fetch(node_off,(char *)node,sizeof(HeaderNode));
 
     while(1) {
       for(uint i = 0;i < DRTM_CLUSTER_NUM;++i) {
         if(node->keys[i].key == key && node->keys[i].valid) {
-          uint64_t res = CLUSTER_OFF(node,i) + node_off;
           memcpy(val,&(node->datas[i]),sizeof(Data));
-          Rfree(node);
-          return res;
+          return CLUSTER_OFF(node,i) + node_off;
         }
       } // traverse the large header
       assert(node->next >= 0 && indirect_num_ > node->next);
-      if(node->next != 0) {
-        node_off = get_indirect_loc(node->next) + base_off_;
-        fetch_node(qp,node_off,(char *)node,sizeof(HeaderNode));
-      } else {
-        assert(false);
-      }
+      if(node->next == 0)
+        return 0;
+      node_off = get_indirect_loc(node->next) + base_off_;
+      fetch(node_off,(char *)node,sizeof(HeaderNode));
     }
-    Rfree(node);
-    return 0; // error case, shall not happen
+    return 0;
   }
 
   //
@@ -262,6 +278,41 @@ class ClusterHash {
     return murmur_hash_64a(key, 0xdeadbeef) % logical_num_;
   }
 
+  /**
+   * Helpers for snapshots.
+   * The used part of the table is the logical nodes followed by the allocated indirect nodes,
+   * which can be copied as an image since all links are node indexes.
+   */
+  inline char *raw_ptr() const {
+    return data_ptr_;
+  }
+
+  inline uint64_t used_size() const {
+    return (uint64_t)(logical_num_ + free_indirect_num_) * sizeof(HeaderNode);
+  }
+
+  inline int used_indirect_num() const {
+    return free_indirect_num_;
+  }
+
+  inline void restore_image(int used_indirect) {
+    assert(used_indirect <= indirect_num_);
+    free_indirect_num_ = used_indirect;
+  }
+
+  // iterate the valid slots in their physical order
+  template <typename F>
+  void for_each(F f) {
+    int nodes = logical_num_ + free_indirect_num_;
+    for(int n = 0;n < nodes;++n) {
+      HeaderNode *node = (HeaderNode *)(data_ptr_ + n * sizeof(HeaderNode));
+      for(uint i = 0;i < DRTM_CLUSTER_NUM;++i) {
+        if(node->keys[i].valid)
+          f((uint64_t)node->keys[i].key,&(node->datas[i]));
+      }
+    }
+  }
+
 
  protected:
   char *data_ptr_;
@@ -7,6 +7,8 @@
 #define MEM_DB
 
 #include <stdint.h>
+#include <string.h>
+#include <string>
 
 #include "memstore.h"
 
@@ -59,7 +61,10 @@ class MemDB {
   /*
     Do not give the same store_buffer to different MemDB instances!
   */
-  MemDB(char *s_buffer = NULL): store_buffer_(s_buffer) { }
+  MemDB(char *s_buffer = NULL): store_buffer_(s_buffer) {
+    memset(stores_,0,sizeof(stores_));
+    memset(_indexs,0,sizeof(_indexs));
+  }
 
   // expected_num: the number of records in table
   void AddSchema(int tableid, TABLE_CLASS c, int klen,int vlen,int meta_len,int expected_num = 1024,bool need_cache = true);
@@ -85,6 +90,32 @@ class MemDB {
   MemNode  *Put(int tableid,uint64_t key,uint64_t *value,int len = 0);
   void      PutIndex(int indexid,uint64_t key,uint64_t *value);
 
+  /**
+   * Snapshots of the tables, one file per table, written and loaded in parallel.
+   * Hash tables are saved as images of their bucket arrays, so a loaded table keeps the offsets
+   * of its records in store_buffer_; B+trees are saved as sorted records and bulk loaded.
+   * The schemas shall be added in the same order before loading.
+   * Secondary indexes are not included.
+   * The fingerprint of the loading config is saved in the files; a snapshot taken with another
+   * one is not loaded.
+   */
+  void Snapshot(const std::string &dir,int node,int partition,uint64_t fingerprint);
+  // returns false if there is no complete snapshot of the partition taken by node in dir,
+  // or it is taken with another fingerprint.
+  // The values are allocated with Rmalloc, and their offsets to rdma_base (the start of the
+  // registered RDMA buffer) are the nodes' off, as the loaders set them.
+  bool LoadSnapshot(const std::string &dir,int node,int partition,uint64_t fingerprint,
+                    char *rdma_base);
+
+  /**
+   * Merges the records of a backup store, which has the same schemas, into the tables,
+   * when the backup takes over the partition. The values are copied to the RDMA heap as the
+   * snapshot loaders do, so the records are read locally, with RPCs, and with one-sided reads.
+   * The records which are in the tables are kept. Secondary indexes are not merged.
+   * Returns the number of merged records.
+   */
+  uint64_t Absorb(MemDB *backup,char *rdma_base);
+
   uint64_t store_size_ = 0; // store size alloced on the RDMA area
 };
 
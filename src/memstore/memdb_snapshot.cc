@@ -0,0 +1,313 @@
+#include "tx_config.h"
+#include "memdb.h"
+#include "rdma_hash.hpp"
+
+#include "core/logging.h"
+#include "core/utils/thread.h"
+#include "util/util.h"
+
+#include "ralloc.h" // for Rmalloc
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <vector>
+
+using namespace nocc;
+
+#define SNAPSHOT_MAGIC 0x32504e5343434f52ULL // "ROCCSNP2"
+
+namespace {
+
+struct SnapshotHeader {
+  uint64_t magic;
+  uint64_t fingerprint;   // of the config the tables are loaded with
+  uint32_t tableid;
+  uint32_t table_class;
+  uint32_t klen;
+  uint32_t value_len;     // meta_len + vlen
+  uint64_t records;
+  uint64_t image_size;    // the bucket array image, only for hash tables
+  uint64_t used_indirect; // only for hash tables
+};
+
+// the node is in the name, since the primary and the backups of a partition may share the dir
+std::string snapshot_file(const std::string &dir,int node,int partition,int tableid) {
+  char name[64];
+  snprintf(name,sizeof(name),"/n%d-part%d-t%d.snap",node,partition,tableid);
+  return dir + name;
+}
+
+bool read_header(const std::string &file,SnapshotHeader &header) {
+  int fd = open(file.c_str(),O_RDONLY);
+  if(fd < 0)
+    return false;
+  bool res = pread(fd,&header,sizeof(header),0) == sizeof(header);
+  close(fd);
+  return res;
+}
+
+// key bytes of a record in a B+tree
+inline int key_bytes(const MemDB::TableSchema &schema) {
+  return schema.c == TAB_BTREE1 ? schema.klen * sizeof(uint64_t) : sizeof(uint64_t);
+}
+
+inline bool has_value(MemNode *node) {
+  return node->value != NULL && (uint64_t)(node->value) > 2; // 1, 2 are deletion marks
+}
+
+class SnapshotWriter {
+ public:
+  SnapshotWriter(const std::string &file) : file_(file) {
+    fp_ = fopen((file + ".tmp").c_str(),"w");
+    ASSERT(fp_ != NULL) << "cannot create snapshot " << file << ": " << strerror(errno);
+    setvbuf(fp_,NULL,_IOFBF,16 * 1024 * 1024);
+  }
+
+  inline void write(const void *ptr,uint64_t size) {
+    ASSERT(fwrite(ptr,1,size,fp_) == size) << "write snapshot " << file_ << " error";
+  }
+
+  // the snapshot only becomes visible after it is complete
+  void commit(SnapshotHeader &header) {
+    fseek(fp_,0,SEEK_SET);
+    write(&header,sizeof(header));
+    fflush(fp_);
+    fsync(fileno(fp_));
+    fclose(fp_);
+    ASSERT(rename((file_ + ".tmp").c_str(),file_.c_str()) == 0);
+  }
+
+ private:
+  const std::string file_;
+  FILE *fp_;
+};
+
+void save_table(MemDB *db,int tableid,const std::string &file,uint64_t fingerprint) {
+  auto &schema = db->_schemas[tableid];
+  SnapshotHeader header = {SNAPSHOT_MAGIC,fingerprint,(uint32_t)tableid,(uint32_t)schema.c,(uint32_t)schema.klen,
+                           (uint32_t)(schema.meta_len + schema.vlen),0,0,0};
+  SnapshotWriter w(file);
+  w.write(&header,sizeof(header)); // placeholder
+
+  if(schema.c == TAB_HASH) {
+    RHash *tab = (RHash *)(db->stores_[tableid]);
+    header.image_size    = tab->used_size();
+    header.used_indirect = tab->used_indirect_num();
+    w.write(tab->raw_ptr(),header.image_size);
+    // then the values, in the order of the slots
+    tab->for_each([&](uint64_t key,MemNode *node) {
+        uint64_t flag = has_value(node) ? 1 : 0;
+        w.write(&flag,sizeof(uint64_t));
+        if(flag)
+          w.write(node->value,header.value_len);
+        header.records += 1;
+      });
+  } else {
+    Memstore::Iterator *iter = db->stores_[tableid]->GetIterator();
+    int kbytes = key_bytes(schema);
+    for(iter->SeekToFirst();iter->Valid();iter->Next()) {
+      MemNode *node = iter->CurNode();
+      if(!has_value(node))
+        continue;
+      uint64_t key = iter->Key();
+      w.write(schema.c == TAB_BTREE1 ? (void *)key : (void *)&key,kbytes);
+      w.write(&(node->seq),sizeof(uint64_t));
+      w.write(node->value,header.value_len);
+      header.records += 1;
+    }
+    delete iter;
+  }
+  w.commit(header);
+}
+
+// the values are put back in the RDMA heap
+inline uint64_t *restore_value(const char *ptr,int len) {
+  char *value = (char *)Rmalloc(len);
+  ASSERT(value != NULL) << "RDMA heap is exhausted while loading the snapshot";
+  memcpy(value,ptr,len);
+  return (uint64_t *)value;
+}
+
+// node->off is the offset of the value, as the loaders set it, which the one-sided reads fetch
+inline void set_value_off(MemNode *node,char *rdma_base) {
+  node->off = (char *)(node->value) - rdma_base;
+  assert(node->off % sizeof(uint64_t) == 0);
+}
+
+void load_table(MemDB *db,int tableid,const std::string &file,char *rdma_base) {
+  auto &schema = db->_schemas[tableid];
+  int fd = open(file.c_str(),O_RDONLY);
+  ASSERT(fd >= 0);
+  struct stat st;
+  fstat(fd,&st);
+  char *base = (char *)mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE | MAP_POPULATE,fd,0);
+  ASSERT(base != MAP_FAILED) << "mmap snapshot " << file << " error: " << strerror(errno);
+
+  SnapshotHeader *header = (SnapshotHeader *)base;
+  ASSERT(header->magic == SNAPSHOT_MAGIC && header->tableid == (uint32_t)tableid
+         && header->table_class == (uint32_t)schema.c
+         && header->value_len == (uint32_t)(schema.meta_len + schema.vlen))
+      << "snapshot " << file << " does not match the schema of table " << tableid;
+  char *ptr = base + sizeof(SnapshotHeader);
+  // ssmalloc finds the free list of an exiting thread's RDMA heap with its malloc heap,
+  // so the loader thread sets up the malloc heap first, even if it does not malloc
+  free(malloc(sizeof(uint64_t)));
+  RThreadLocalInit();
+
+  if(schema.c == TAB_HASH) {
+    RHash *tab = (RHash *)(db->stores_[tableid]);
+    ASSERT(header->image_size <= tab->size()) << "snapshot of table " << tableid << " is larger than the table";
+    // copy the buckets in place, so the records are at the same offsets as before
+    memcpy(tab->raw_ptr(),ptr,header->image_size);
+    tab->restore_image(header->used_indirect);
+    ptr += header->image_size;
+
+    char *table_base = tab->raw_ptr();
+    tab->for_each([&](uint64_t key,MemNode *node) {
+        uint64_t flag = *((uint64_t *)ptr);
+        ptr += sizeof(uint64_t);
+        node->lock = 0;
+        node->value = NULL;
+        node->off = tab->base_off_ + ((char *)node - table_base);
+        if(flag) {
+          node->value = restore_value(ptr,header->value_len);
+          set_value_off(node,rdma_base);
+          ptr += header->value_len;
+        }
+      });
+  } else {
+    int kbytes = key_bytes(schema);
+    for(uint64_t i = 0;i < header->records;++i) {
+      uint64_t key = *((uint64_t *)ptr);
+      if(schema.c == TAB_BTREE1) {
+        uint64_t *keys = (uint64_t *)malloc(kbytes);
+        memcpy(keys,ptr,kbytes);
+        key = (uint64_t)keys;
+      }
+      ptr += kbytes;
+      uint64_t seq = *((uint64_t *)ptr);
+      ptr += sizeof(uint64_t);
+      MemNode *node = db->Put(tableid,key,restore_value(ptr,header->value_len),schema.vlen);
+      set_value_off(node,rdma_base);
+      ptr += header->value_len;
+      node->seq = seq;
+    }
+  }
+  ASSERT(ptr == base + st.st_size) << "snapshot " << file << " is corrupted";
+  munmap(base,st.st_size);
+  close(fd);
+}
+
+class SnapshotThread : public ndb_thread {
+ public:
+  SnapshotThread(MemDB *db,int tableid,const std::string &file,uint64_t fingerprint,bool load,
+                 char *rdma_base = NULL) :
+      db_(db),tableid_(tableid),file_(file),fingerprint_(fingerprint),load_(load),rdma_base_(rdma_base) { }
+
+  void run() {
+    if(load_)
+      load_table(db_,tableid_,file_,rdma_base_);
+    else
+      save_table(db_,tableid_,file_,fingerprint_);
+  }
+ private:
+  MemDB *db_;
+  const int tableid_;
+  const std::string file_;
+  const uint64_t fingerprint_;
+  const bool load_;
+  char *const rdma_base_;
+};
+
+void run_parallel(std::vector<SnapshotThread *> &threads) {
+  for(auto t : threads)
+    t->start();
+  for(auto t : threads) {
+    t->join();
+    delete t;
+  }
+}
+
+} // end anonymous namespace
+
+void MemDB::Snapshot(const std::string &dir,int node,int partition,uint64_t fingerprint) {
+  if(mkdir(dir.c_str(),0755) != 0 && errno != EEXIST)
+    ASSERT(false) << "cannot create the snapshot dir " << dir << ": " << strerror(errno);
+
+  std::vector<SnapshotThread *> threads;
+  for(int i = 0;i < MAX_TABLE_SUPPORTED;++i) {
+    if(stores_[i] != NULL)
+      threads.push_back(new SnapshotThread(this,i,snapshot_file(dir,node,partition,i),fingerprint,false));
+  }
+  run_parallel(threads);
+  LOG(2) << "snapshot of partition " << partition << " saved to " << dir;
+}
+
+bool MemDB::LoadSnapshot(const std::string &dir,int node,int partition,uint64_t fingerprint,
+                         char *rdma_base) {
+  std::vector<SnapshotThread *> threads;
+  for(int i = 0;i < MAX_TABLE_SUPPORTED;++i) {
+    if(stores_[i] == NULL)
+      continue;
+    auto file = snapshot_file(dir,node,partition,i);
+    SnapshotHeader header;
+    bool usable = read_header(file,header);
+    if(usable && (header.magic != SNAPSHOT_MAGIC || header.fingerprint != fingerprint)) {
+      LOG(LOG_WARNING) << "snapshot " << file << " is taken with another config, reload partition " << partition;
+      usable = false;
+    }
+    if(!usable) {
+      for(auto t : threads)
+        delete t;
+      return false;
+    }
+    threads.push_back(new SnapshotThread(this,i,file,fingerprint,true,rdma_base));
+  }
+  if(threads.empty())
+    return false;
+  run_parallel(threads);
+  LOG(2) << "partition " << partition << " loaded from the snapshot in " << dir;
+  return true;
+}
+
+uint64_t MemDB::Absorb(MemDB *backup,char *rdma_base) {
+  uint64_t absorbed = 0;
+  RThreadLocalInit();
+  for(int i = 0;i < MAX_TABLE_SUPPORTED;++i) {
+    if(stores_[i] == NULL || backup->stores_[i] == NULL)
+      continue;
+    auto &schema = _schemas[i];
+    int value_len = schema.meta_len + schema.vlen;
+    auto absorb = [&](uint64_t key,MemNode *node) {
+      if(!has_value(node))
+        return;
+      MemNode *mine = stores_[i]->Get(key);
+      if(mine != NULL && has_value(mine))
+        return;
+      if(schema.c == TAB_BTREE1) {
+        // the tree keeps the pointer to the key
+        uint64_t *keys = (uint64_t *)malloc(key_bytes(schema));
+        memcpy(keys,(void *)key,key_bytes(schema));
+        key = (uint64_t)keys;
+      }
+      MemNode *n = Put(i,key,restore_value((char *)(node->value),value_len),schema.vlen);
+      set_value_off(n,rdma_base);
+      n->seq = node->seq;
+      absorbed += 1;
+    };
+    if(schema.c == TAB_HASH) {
+      ((RHash *)(backup->stores_[i]))->for_each(absorb);
+      continue;
+    }
+    Memstore::Iterator *iter = backup->stores_[i]->GetIterator();
+    for(iter->SeekToFirst();iter->Valid();iter->Next())
+      absorb(iter->Key(),iter->CurNode());
+    delete iter;
+  }
+  return absorbed;
+}
@@ -60,6 +60,8 @@ class Memstore {
     // The returned iterator is not valid.
     Iterator() {}
 
+    virtual ~Iterator() {}
+
     virtual bool Valid() = 0;
 
     // REQUIRES: Valid()
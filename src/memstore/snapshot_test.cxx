@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+
+#include "memdb.h"
+#include "ralloc.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+size_t total_partition = 1;
+
+namespace {
+
+const int kHashTab  = 0;
+const int kBTreeTab = 1;
+const int kVlen     = 64;
+const int kMetaLen  = 8;
+const int kRecords  = 64;
+
+const uint64_t kStoreSize = 64 * 1024 * 1024;
+const uint64_t kHeapSize  = 64 * 1024 * 1024;
+
+// the registered RDMA buffer: the stores, then the RDMA heap
+char *rdma_base = NULL;
+uint64_t store_used = 0;
+
+void init_rdma_buffer() {
+  if(rdma_base != NULL)
+    return;
+  rdma_base = (char *)malloc(kStoreSize + kHeapSize);
+  ASSERT_NE(RInit(rdma_base + kStoreSize,kHeapSize),0u);
+  RThreadLocalInit();
+}
+
+// a backup store is not in the RDMA buffer
+MemDB *new_db(bool backup = false) {
+  // each db has its own hash table area
+  MemDB *db = new MemDB(backup ? NULL : rdma_base + store_used);
+  db->AddSchema(kHashTab,TAB_HASH,sizeof(uint64_t),kVlen,kMetaLen,1024);
+  db->AddSchema(kBTreeTab,TAB_BTREE,sizeof(uint64_t),kVlen,kMetaLen);
+  store_used += db->store_size_;
+  assert(store_used <= kStoreSize);
+  return db;
+}
+
+void load(MemDB *db,uint64_t first = 1,uint64_t base = 0) {
+  for(uint64_t k = first;k < first + kRecords;++k) {
+    for(int tab = kHashTab;tab <= kBTreeTab;++tab) {
+      char *value = (char *)Rmalloc(kMetaLen + kVlen);
+      memset(value,0,kMetaLen + kVlen);
+      *((uint64_t *)(value + kMetaLen)) = base + k * 10 + tab;
+      auto node = db->Put(tab,k,(uint64_t *)value);
+      node->off = value - rdma_base;
+    }
+  }
+}
+
+} // end anonymous namespace
+
+// the restored records shall be fetched by the one-sided reads at their off
+TEST(snapshot_test,restored_off_is_value_off)
+{
+  init_rdma_buffer();
+  char dir[] = "/tmp/rocc_snapshot_testXXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+  MemDB *db = new_db();
+  load(db);
+  db->Snapshot(dir,0,0,0xbeef);
+
+  MemDB *restored = new_db();
+  ASSERT_TRUE(restored->LoadSnapshot(dir,0,0,0xbeef,rdma_base));
+
+  for(uint64_t k = 1;k <= kRecords;++k) {
+    for(int tab = kHashTab;tab <= kBTreeTab;++tab) {
+      MemNode *node = restored->stores_[tab]->Get(k);
+      ASSERT_TRUE(node != NULL);
+      char *value = (char *)(node->value);
+      EXPECT_NE(value,(char *)(db->stores_[tab]->Get(k)->value));
+      EXPECT_EQ(node->off,(uint64_t)(value - rdma_base));
+      EXPECT_EQ(*((uint64_t *)(rdma_base + node->off + kMetaLen)),k * 10 + tab);
+    }
+  }
+}
+
+TEST(snapshot_test,other_fingerprint_is_not_loaded)
+{
+  init_rdma_buffer();
+  char dir[] = "/tmp/rocc_snapshot_testXXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != NULL);
+
+  MemDB *db = new_db();
+  load(db);
+  db->Snapshot(dir,0,0,0xbeef);
+
+  MemDB *restored = new_db();
+  EXPECT_FALSE(restored->LoadSnapshot(dir,0,0,0xdead,rdma_base));
+  EXPECT_FALSE(restored->LoadSnapshot(dir,1,0,0xbeef,rdma_base)); // taken by another node
+}
+
+// the records taken over are fetched at their off, and the records of the store are kept
+TEST(snapshot_test,absorbed_off_is_value_off)
+{
+  init_rdma_buffer();
+  MemDB *db = new_db();
+  load(db);
+  MemDB *backup = new_db(true);
+  const uint64_t base = 100000;
+  load(backup,kRecords / 2 + 1,base);
+
+  EXPECT_EQ(db->Absorb(backup,rdma_base),(uint64_t)kRecords);
+
+  for(uint64_t k = 1;k < kRecords / 2 + 1 + kRecords;++k) {
+    for(int tab = kHashTab;tab <= kBTreeTab;++tab) {
+      MemNode *node = db->stores_[tab]->Get(k);
+      ASSERT_TRUE(node != NULL);
+      char *value = (char *)(node->value);
+      uint64_t expected = (k <= kRecords ? 0 : base) + k * 10 + tab;
+      EXPECT_EQ(node->off,(uint64_t)(value - rdma_base));
+      EXPECT_EQ(*((uint64_t *)(rdma_base + node->off + kMetaLen)),expected);
+      if(k > kRecords)
+        EXPECT_NE(value,(char *)(backup->stores_[tab]->Get(k)->value));
+    }
+  }
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "core/logging.h"
+#include "calvin_structure.h"
+
+namespace nocc {
+
+namespace rtx {
+
+/**
+ * The RDMA area used by CALVIN.
+ * Each node reserves one ring for the TX inputs and one ring for the forwarded values,
+ * per (sender mac, sender thread). Senders use the same layout to calculate the remote offsets.
+ *
+ * A ring entry: | header | payload (8 bytes aligned) | header |,
+ * where header = (size << 32 | magic). A zero header is an empty slot; the reader checks the
+ * trailing header to make sure the entry is complete, and zeroes the entry after consuming it.
+ *
+ * After all the rings, there are two head areas, like the ones of the log rings:
+ *  - the consumed heads of the rings, i.e. the bytes the reader has zeroed, published by the reader;
+ *  - the senders' cached copies of the heads of their remote rings, used as local READ buffers.
+ * A sender can put an entry only if it has enough credits, so unread entries are never overwritten.
+ */
+class CalvinMemManager {
+ public:
+  enum RING_TYPE {
+    INPUT_RING = 0,
+    FORWARD_RING = 1
+  };
+
+  static const uint32_t RING_MAGIC = 0x63616c76;
+  static const uint32_t WRAP_MAGIC = 0x77726170;
+
+  // each head occupies a cache line, since they are updated by different threads
+  static const uint64_t HEAD_SIZE = 64;
+
+  CalvinMemManager(char *local_p,int ms,int ts,uint64_t ring_size,uint64_t base_off = 0) :
+      local_buffer_(local_p),
+      mac_num_(ms),thread_num_(ts),
+      ring_size_(ring_size),
+      base_offset_(base_off) {
+    assert(ring_size_ % sizeof(uint64_t) == 0);
+  }
+
+  inline uint64_t total_size() const {
+    return rings_size() + 2 * head_area_size();
+  }
+
+  inline uint64_t get_ring_offset(int type,int from_mac,int from_tid) const {
+    return base_offset_ + ((type * mac_num_ + from_mac) * thread_num_ + from_tid) * ring_size_;
+  }
+
+  inline char *get_local_ring(int type,int from_mac,int from_tid) const {
+    return local_buffer_ + get_ring_offset(type,from_mac,from_tid);
+  }
+
+  // offset of the consumed head of ring (type,from_mac,from_tid) at its reader
+  inline uint64_t get_head_offset(int type,int from_mac,int from_tid) const {
+    return base_offset_ + rings_size() + ((type * mac_num_ + from_mac) * thread_num_ + from_tid) * HEAD_SIZE;
+  }
+
+  inline volatile uint64_t *get_local_head(int type,int from_mac,int from_tid) const {
+    return (volatile uint64_t *)(local_buffer_ + get_head_offset(type,from_mac,from_tid));
+  }
+
+  // local buffer of thread tid to read the head of its ring at to_mac
+  inline volatile uint64_t *get_cached_head(int type,int to_mac,int tid) const {
+    return (volatile uint64_t *)(local_buffer_ + head_area_size() + get_head_offset(type,to_mac,tid));
+  }
+
+  static inline uint64_t entry_size(uint32_t size) {
+    return sizeof(uint64_t) * 2 + CALVIN_ALIGN8(size);
+  }
+
+  static inline uint64_t make_header(uint32_t size,uint32_t magic) {
+    return ((uint64_t)size << 32) | magic;
+  }
+
+  char *const    local_buffer_;
+  const int      mac_num_;
+  const int      thread_num_;
+  const uint64_t ring_size_;
+ private:
+  const uint64_t base_offset_;
+
+  inline uint64_t rings_size() const {
+    return 2 * mac_num_ * thread_num_ * ring_size_;
+  }
+
+  inline uint64_t head_area_size() const {
+    return 2 * mac_num_ * thread_num_ * HEAD_SIZE;
+  }
+};
+
+// The sender side of a ring, which tracks where the next entry goes.
+// head points to the latest known consumed head of the ring: the reader's own one if the ring is
+// local, or the sender's cached copy of it otherwise, which shall be refreshed when out of credits.
+class CalvinRingWriter {
+ public:
+  CalvinRingWriter(uint64_t ring_size = 0,volatile uint64_t *head = NULL) :
+      ring_size_(ring_size),head_(head) { }
+
+  // whether an entry fits without overwriting the entries which are not consumed
+  inline bool has_credits(uint32_t size) const {
+    uint64_t esz = CalvinMemManager::entry_size(size);
+    uint64_t need = esz;
+    if(tail_ + esz + sizeof(uint64_t) > ring_size_)
+      need += ring_size_ - tail_; // the wrapped space
+    return written_ + need - *head_ <= ring_size_;
+  }
+
+  // returns the offset of the entry in the ring; wrap_off is set if a wrap header
+  // shall be written at that offset first, otherwise it is -1
+  inline uint64_t reserve(uint32_t size,int64_t &wrap_off) {
+    uint64_t esz = CalvinMemManager::entry_size(size);
+    ASSERT(esz + sizeof(uint64_t) <= ring_size_) << "CALVIN ring entry too large " << size;
+    ASSERT(has_credits(size)) << "CALVIN ring overflows, written " << written_ << " consumed " << *head_;
+    wrap_off = -1;
+    if(tail_ + esz + sizeof(uint64_t) > ring_size_) {
+      wrap_off = tail_;
+      written_ += ring_size_ - tail_;
+      tail_ = 0;
+    }
+    uint64_t res = tail_;
+    tail_ += esz;
+    written_ += esz;
+    return res;
+  }
+
+  // fill an entry in a local buffer before posting it
+  static inline uint64_t format(char *buf,const char *payload,uint32_t size) {
+    uint64_t header = CalvinMemManager::make_header(size,CalvinMemManager::RING_MAGIC);
+    *(uint64_t *)buf = header;
+    if(payload != buf + sizeof(uint64_t))
+      memcpy(buf + sizeof(uint64_t),payload,size);
+    *(uint64_t *)(buf + sizeof(uint64_t) + CALVIN_ALIGN8(size)) = header;
+    return CalvinMemManager::entry_size(size);
+  }
+
+  // put an entry into a ring in local memory, used when the entry is received by RPC
+  inline void local_put(char *ring,const char *payload,uint32_t size) {
+    int64_t wrap_off;
+    uint64_t off = reserve(size,wrap_off);
+    uint64_t header = CalvinMemManager::make_header(size,CalvinMemManager::RING_MAGIC);
+    memcpy(ring + off + sizeof(uint64_t),payload,size);
+    *(uint64_t *)(ring + off + sizeof(uint64_t) + CALVIN_ALIGN8(size)) = header;
+    asm volatile("" ::: "memory");
+    *(volatile uint64_t *)(ring + off) = header;
+    if(wrap_off >= 0) {
+      asm volatile("" ::: "memory");
+      *(volatile uint64_t *)(ring + wrap_off) =
+          CalvinMemManager::make_header(0,CalvinMemManager::WRAP_MAGIC);
+    }
+  }
+
+ private:
+  uint64_t ring_size_;
+  volatile uint64_t *head_;
+  uint64_t tail_    = 0; // offset in the ring
+  uint64_t written_ = 0; // total bytes written, including the wrapped space
+};
+
+// The receiver side of a ring, which publishes the consumed bytes to head
+class CalvinRingReader {
+ public:
+  CalvinRingReader(char *ring = NULL,uint64_t ring_size = 0,volatile uint64_t *head = NULL) :
+      ring_(ring),ring_size_(ring_size),head_ptr_(head) { }
+
+  // returns the payload of the next complete entry, or NULL
+  inline char *peek(uint32_t &size) {
+    volatile uint64_t header = *(volatile uint64_t *)(ring_ + head_);
+    if(header == 0)
+      return NULL;
+    if((uint32_t)header == CalvinMemManager::WRAP_MAGIC) {
+      *(uint64_t *)(ring_ + head_) = 0;
+      consume(ring_size_ - head_);
+      head_ = 0;
+      return peek(size);
+    }
+    ASSERT((uint32_t)header == CalvinMemManager::RING_MAGIC) << "corrupted CALVIN ring at " << head_;
+    size = header >> 32;
+    volatile uint64_t trailer = *(volatile uint64_t *)(ring_ + head_ + sizeof(uint64_t) + CALVIN_ALIGN8(size));
+    if(trailer != header)
+      return NULL; // partially written
+    return ring_ + head_ + sizeof(uint64_t);
+  }
+
+  inline void pop(uint32_t size) {
+    uint64_t esz = CalvinMemManager::entry_size(size);
+    memset(ring_ + head_,0,esz);
+    head_ += esz;
+    consume(esz);
+  }
+
+ private:
+  char    *ring_;
+  uint64_t ring_size_;
+  volatile uint64_t *head_ptr_;
+  uint64_t head_ = 0;     // offset in the ring
+  uint64_t consumed_ = 0;
+
+  // the slots are zeroed before they are given back to the sender
+  inline void consume(uint64_t bytes) {
+    consumed_ += bytes;
+    asm volatile("" ::: "memory");
+    *head_ptr_ = consumed_;
+  }
+};
+
+} // namespace rtx
+} // namespace nocc
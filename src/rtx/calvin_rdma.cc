@@ -0,0 +1,325 @@
+#include "calvin_rdma.h"
+
+namespace nocc {
+
+namespace rtx {
+
+void CALVIN::fill_request(det_request *req) {
+  req->nReads  = gen_reads_.size();
+  req->nWrites = gen_writes_.size();
+  int i = 0;
+  for(auto &a : gen_reads_) {
+    a.is_write = 0;
+    req->access[i++] = a;
+  }
+  for(auto &a : gen_writes_) {
+    a.is_write = 1;
+    req->access[i++] = a;
+  }
+}
+
+void CALVIN::send_batch(uint64_t epoch,char *reqs,int num,yield_func_t &yield) {
+  char *payload = send_buf_ + sizeof(uint64_t);
+  CalvinBatchHeader *header = (CalvinBatchHeader *)payload;
+
+  // every node receives a batch (maybe empty) per epoch, so that the schedulers can make progress
+  for(int pid = 0;pid < ctx_->mem->mac_num_;++pid) {
+    header->epoch = epoch;
+    header->num = 0;
+    header->last = 0;
+    char *ptr = payload + sizeof(CalvinBatchHeader);
+
+    char *req_ptr = reqs;
+    for(int i = 0;i < num;++i) {
+      det_request *req = (det_request *)req_ptr;
+      req_ptr += req->size();
+      if(!req->touches(pid))
+        continue;
+      if(ptr + req->size() - payload > CALVIN_CHUNK_SIZE) {
+        send_ring(CalvinMemManager::INPUT_RING,pid,send_buf_,ptr - payload,yield);
+        header->num = 0;
+        ptr = payload + sizeof(CalvinBatchHeader);
+      }
+      memcpy(ptr,req,req->size());
+      ptr += req->size();
+      header->num += 1;
+    }
+    header->last = 1;
+    send_ring(CalvinMemManager::INPUT_RING,pid,send_buf_,ptr - payload,yield);
+  }
+}
+
+void CALVIN::forward_ready(yield_func_t &yield) {
+  CalvinTxn *txn;
+  while((txn = ctx_->scheduler->next_ready(worker_id_)) != NULL) {
+    if(forward_values(txn,yield))
+      ctx_->exec_queue.push_back(txn);
+    else
+      ctx_->passive.push_back(txn);
+  }
+}
+
+void CALVIN::send_ring(int type,int pid,char *buf,int size,yield_func_t &yield) {
+  char *payload = buf + sizeof(uint64_t);
+  ASSERT(size <= CALVIN_CHUNK_SIZE) << "CALVIN ring entry too large " << size;
+
+  if(pid == response_node_) {
+    // only the inputs are sent to the node itself
+    assert(type == CalvinMemManager::INPUT_RING);
+    auto &writer = ctx_->input_writers[pid];
+    wait_credits(type,pid,writer,size,yield);
+    writer.local_put(ctx_->mem->get_local_ring(type,response_node_,worker_id_),payload,size);
+    return;
+  }
+
+  bool one_sided = (type == CalvinMemManager::INPUT_RING) ? CALVIN_ONE_SIDED_INPUT : CALVIN_ONE_SIDED_FORWARD;
+  if(one_sided) {
+    auto &writer = (type == CalvinMemManager::INPUT_RING) ? ctx_->input_writers[pid] : ctx_->forward_writers[pid];
+    wait_credits(type,pid,writer,size,yield);
+    uint64_t base = ctx_->mem->get_ring_offset(type,response_node_,worker_id_);
+    Qp *qp = get_qp(pid);
+    assert(qp != NULL);
+
+    int64_t wrap_off;
+    uint64_t off = writer.reserve(size,wrap_off);
+    if(wrap_off >= 0) {
+      *(uint64_t *)wrap_buf_ = CalvinMemManager::make_header(0,CalvinMemManager::WRAP_MAGIC);
+      scheduler_->post_send(qp,cor_id_,IBV_WR_RDMA_WRITE,wrap_buf_,sizeof(uint64_t),
+                            base + wrap_off,IBV_SEND_SIGNALED | IBV_SEND_INLINE);
+    }
+    int esz = CalvinRingWriter::format(buf,payload,size);
+    scheduler_->post_send(qp,cor_id_,IBV_WR_RDMA_WRITE,buf,esz,
+                          base + off,IBV_SEND_SIGNALED);
+    worker_->indirect_yield(yield);
+  } else {
+    // the receiver keeps the inputs which do not fit in its ring, see input_rpc_handler
+    char *msg = rpc_->get_fly_buf(cor_id_);
+    memcpy(msg,payload,size);
+    int rpc_id = (type == CalvinMemManager::INPUT_RING) ? RTX_CALVIN_INPUT_RPC_ID : RTX_CALVIN_FORWARD_RPC_ID;
+    rpc_->append_req(msg,rpc_id,size,cor_id_,RRpc::REQ,pid);
+  }
+}
+
+void CALVIN::wait_credits(int type,int pid,CalvinRingWriter &writer,int size,yield_func_t &yield) {
+  while(!writer.has_credits(size)) {
+    if(pid != response_node_) {
+      // refresh the cached head of the remote ring
+      scheduler_->post_send(get_qp(pid),cor_id_,IBV_WR_RDMA_READ,
+                            (char *)ctx_->mem->get_cached_head(type,pid,worker_id_),sizeof(uint64_t),
+                            ctx_->mem->get_head_offset(type,response_node_,worker_id_),IBV_SEND_SIGNALED);
+      worker_->indirect_yield(yield);
+      if(writer.has_credits(size))
+        break;
+    }
+    // the receiver may wait for the values of this mac to make progress, so keep forwarding them
+    poll_rings();
+    if(type == CalvinMemManager::INPUT_RING)
+      forward_ready(yield);
+    worker_->yield_next(yield);
+  }
+}
+
+bool CALVIN::forward_values(CalvinTxn *txn,yield_func_t &yield) {
+  det_request *req = txn->req;
+  int num = req->nReads + req->nWrites;
+
+  char *payload = fwd_buf_ + sizeof(uint64_t);
+  CalvinForwardHeader *header = (CalvinForwardHeader *)payload;
+
+  for(int pid = 0;pid < ctx_->mem->mac_num_;++pid) {
+    if(pid == response_node_ || !is_active(req,pid))
+      continue;
+    header->txn_id = req->txn_id;
+    header->from = response_node_;
+    header->num = 0;
+    char *ptr = payload + sizeof(CalvinForwardHeader);
+
+    for(int i = 0;i < num;++i) {
+      const CalvinAccess &a = req->access[i];
+      if(a.pid != response_node_)
+        continue;
+      int item_sz = sizeof(CalvinForwardItem) + CALVIN_ALIGN8(a.len);
+      if(ptr + item_sz - payload > CALVIN_CHUNK_SIZE) {
+        send_ring(CalvinMemManager::FORWARD_RING,pid,fwd_buf_,ptr - payload,yield);
+        header->num = 0;
+        ptr = payload + sizeof(CalvinForwardHeader);
+      }
+      CalvinForwardItem *item = (CalvinForwardItem *)ptr;
+      item->key = a.key;
+      item->len = a.len;
+      item->tableid = a.tableid;
+      uint64_t seq;
+      auto node = local_get_op(a.tableid,a.key,ptr + sizeof(CalvinForwardItem),a.len,seq,
+                               db_->_schemas[a.tableid].meta_len);
+      assert(node != NULL);
+      ptr += item_sz;
+      header->num += 1;
+    }
+    if(header->num > 0)
+      send_ring(CalvinMemManager::FORWARD_RING,pid,fwd_buf_,ptr - payload,yield);
+  }
+  return is_active(req,response_node_);
+}
+
+void CALVIN::prepare(CalvinTxn *txn) {
+  txn_ = txn;
+  det_request *req = txn->req;
+
+  gc_set(read_set_);
+  gc_set(write_set_);
+  for(int i = 0;i < req->nReads + req->nWrites;++i) {
+    const CalvinAccess &a = req->access[i];
+    auto &set = (i < req->nReads) ? read_set_ : write_set_;
+    set.emplace_back(a.tableid,a.key,(MemNode *)NULL,(char *)NULL,0,a.len,a.pid);
+  }
+}
+
+char *CALVIN::load(ReadSetItem &item,yield_func_t &yield) {
+  if(item.data_ptr != NULL)
+    return item.data_ptr;
+
+  char *val = (char *)malloc(item.len);
+  if(item.pid == response_node_) {
+    // the record is locked by the scheduler, so its value is stable
+    uint64_t seq;
+    auto node = local_get_op(item.tableid,item.key,val,item.len,seq,
+                             db_->_schemas[item.tableid].meta_len);
+    assert(node != NULL);
+  } else {
+    char *fwd;
+    while((fwd = ctx_->find_forward(txn_->req->txn_id,item.pid,item.tableid,item.key)) == NULL) {
+#if CALVIN_ONE_SIDED_FORWARD
+      ctx_->poll_forward();
+#endif
+      worker_->yield_next(yield);
+    }
+    memcpy(val,fwd,item.len);
+  }
+  item.data_ptr = val;
+  return val;
+}
+
+char *CALVIN::gen_load(const CalvinAccess &a,char *&val,yield_func_t &yield) {
+  if(val != NULL)
+    return val;
+  val = (char *)malloc(a.len);
+  if(a.pid == response_node_) {
+    uint64_t seq;
+    if(local_lookup_op(a.tableid,a.key) != NULL)
+      local_get_op(a.tableid,a.key,val,a.len,seq,db_->_schemas[a.tableid].meta_len);
+    else
+      memset(val,0,a.len);
+  } else {
+    char *msg = rpc_->get_fly_buf(cor_id_);
+    CalvinForwardItem *item = (CalvinForwardItem *)msg;
+    item->key = a.key;
+    item->len = a.len;
+    item->tableid = a.tableid;
+    rpc_->prepare_multi_req(val,1,cor_id_);
+    rpc_->append_req(msg,RTX_CALVIN_RECON_RPC_ID,sizeof(CalvinForwardItem),cor_id_,RRpc::REQ,a.pid);
+    worker_->indirect_yield(yield);
+  }
+  return val;
+}
+
+void CALVIN::write_back(yield_func_t &yield) {
+  for(auto &item : write_set_) {
+    if(item.pid != response_node_ || item.data_ptr == NULL)
+      continue;
+    inplace_write_op(item.tableid,item.key,item.data_ptr,item.len);
+  }
+}
+
+void CALVIN::finish(yield_func_t &yield) {
+  // values the execution did not load may still be on the fly,
+  // wait for them so that no stale entry is left in the forwarded map
+  det_request *req = txn_->req;
+  for(int i = 0;i < req->nReads + req->nWrites;++i) {
+    const CalvinAccess &a = req->access[i];
+    if(a.pid == response_node_)
+      continue;
+    while(ctx_->find_forward(req->txn_id,a.pid,a.tableid,a.key) == NULL) {
+#if CALVIN_ONE_SIDED_FORWARD
+      ctx_->poll_forward();
+#endif
+      worker_->yield_next(yield);
+    }
+  }
+  ctx_->forwarded.erase(req->txn_id);
+
+  gc_set(read_set_);
+  gc_set(write_set_);
+  ctx_->scheduler->finish(worker_id_,txn_);
+  txn_ = NULL;
+}
+
+void CALVIN::restart(yield_func_t &yield) {
+  det_request *req = txn_->req;
+  if(req->req_initiator == response_node_) {
+    ctx_->retries.emplace_back(req->req_idx,req->req_seed);
+    return;
+  }
+  char *msg = rpc_->get_fly_buf(cor_id_);
+  memcpy(msg,req,sizeof(det_request));
+  rpc_->append_req(msg,RTX_CALVIN_RETRY_RPC_ID,sizeof(det_request),cor_id_,RRpc::REQ,req->req_initiator);
+}
+
+bool CALVIN::is_reporter(const det_request *req,int nid) {
+  // the first active participant, or the first participant of a read-only TX
+  int reporter = -1;
+  for(int i = req->nReads;i < req->nReads + req->nWrites;++i) {
+    if(reporter < 0 || req->access[i].pid < reporter)
+      reporter = req->access[i].pid;
+  }
+  if(reporter < 0) {
+    for(int i = 0;i < req->nReads;++i) {
+      if(reporter < 0 || req->access[i].pid < reporter)
+        reporter = req->access[i].pid;
+    }
+  }
+  return reporter == nid;
+}
+
+void CALVIN::register_default_rpc_handlers() {
+  ROCC_BIND_STUB(rpc_,&CALVIN::input_rpc_handler,this,RTX_CALVIN_INPUT_RPC_ID);
+  ROCC_BIND_STUB(rpc_,&CALVIN::forward_rpc_handler,this,RTX_CALVIN_FORWARD_RPC_ID);
+  ROCC_BIND_STUB(rpc_,&CALVIN::recon_rpc_handler,this,RTX_CALVIN_RECON_RPC_ID);
+  ROCC_BIND_STUB(rpc_,&CALVIN::retry_rpc_handler,this,RTX_CALVIN_RETRY_RPC_ID);
+}
+
+void CALVIN::input_rpc_handler(int id,int cid,char *msg,void *arg) {
+  int size = (uint64_t)arg;
+  // the ring is full if the scheduler lags behind, then the input waits in the backlog,
+  // which is drained by the sequencer
+  auto &backlog = ctx_->input_backlog[id];
+  auto &writer = ctx_->rpc_input_writers[id];
+  if(backlog.empty() && writer.has_credits(size))
+    writer.local_put(ctx_->mem->get_local_ring(CalvinMemManager::INPUT_RING,id,worker_id_),msg,size);
+  else
+    backlog.emplace_back(msg,size);
+}
+
+void CALVIN::forward_rpc_handler(int id,int cid,char *msg,void *arg) {
+  int size = (uint64_t)arg;
+  ctx_->store_forward(msg,size);
+}
+
+void CALVIN::recon_rpc_handler(int id,int cid,char *msg,void *arg) {
+  CalvinForwardItem *item = (CalvinForwardItem *)msg;
+  char *reply = rpc_->get_reply_buf();
+  // no lock is needed, the execution checks the prediction
+  uint64_t seq;
+  if(local_lookup_op(item->tableid,item->key) != NULL)
+    local_get_op(item->tableid,item->key,reply,item->len,seq,db_->_schemas[item->tableid].meta_len);
+  else
+    memset(reply,0,item->len);
+  rpc_->send_reply(reply,item->len,id,cid);
+}
+
+void CALVIN::retry_rpc_handler(int id,int cid,char *msg,void *arg) {
+  det_request *req = (det_request *)msg;
+  ctx_->retries.emplace_back(req->req_idx,req->req_seed);
+}
+
+} // namespace rtx
+} // namespace nocc
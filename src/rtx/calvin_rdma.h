@@ -1,529 +1,390 @@
 #pragma once
 
 #include "tx_config.h"
-    
-#if ENABLE_TXN_API
-#include "txn_interface.h"
-#else
-#include "tx_operator.hpp"
-#include "core/utils/latency_profier.h"
-#include "core/utils/count_vector.hpp"
-#include "dslr.h"
-#endif
 
+#include "txn_interface.h"
 #include "logger.hpp"
+#include "two_phase_committer.hpp"
+#include "two_phase_commit_mem_manager.hpp"
 
 #include "core/logging.h"
 
-#include "rdma_req_helper.hpp"
+#include "calvin_structure.h"
+#include "calvin_mem_manager.hpp"
+#include "calvin_scheduler.h"
 
-#include "rwlock.hpp"
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
 
 namespace nocc {
 
 namespace rtx {
 
-typedef rwsets_t::ReadSetItem ReadSetItem;
+#define CALVIN_CHUNK_SIZE (MAX_MSG_SIZE - 256) // max payload of a ring entry, fits in an RPC
 
-#if ENABLE_TXN_API
-class CALVIN : public TxnAlg {
+#if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_TXN_BROADCAST_INPUT) != 0
+#define CALVIN_ONE_SIDED_INPUT 1
 #else
-class CALVIN : public TXOpBase {
+#define CALVIN_ONE_SIDED_INPUT 0
 #endif
 
-protected:
-  // return the last index in the read-set
-  int local_read(int tableid,uint64_t key,int len,yield_func_t &yield) {
-    MemNode *node = local_lookup_op(tableid, key);
-    assert(node != NULL);
-    assert(node->value != NULL);
-
-    // add to read-set
-    read_set_.emplace_back(tableid,key,(MemNode *)node,(char*)NULL,0,len,response_node_);
-    return read_set_.size() - 1;
-  }
-
-  // return the last index in the write-set
-  int local_write(int tableid,uint64_t key,int len,yield_func_t &yield) {
-    MemNode *node = local_lookup_op(tableid, key);
-    assert(node != NULL);
-    assert(node->value != NULL);
-
-    // add to write-set
-    write_set_.emplace_back(tableid,key,(MemNode *)node,(char*)NULL,0,len,response_node_);
-    return write_set_.size() - 1;
-  }
-
-  int local_insert(int tableid,uint64_t key,char *val,int len,yield_func_t &yield) {
-    // char *data_ptr = (char *)malloc(len);
-    // uint64_t seq;
-    // auto node = local_insert_op(tableid,key,seq);
-    // memcpy(data_ptr,val,len);
-    // write_set_.emplace_back(tableid,key,node,data_ptr,seq,len,node_id_);
-    // return write_set_.size() - 1;
-    return -1;
-  }
+#if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_VALUE_FORWARDING) != 0
+#define CALVIN_ONE_SIDED_FORWARD 1
+#else
+#define CALVIN_ONE_SIDED_FORWARD 0
+#endif
 
-  // return the last index in the read-set
-  int remote_read(int pid,int tableid,uint64_t key,int len,yield_func_t &yield) {
-    MemNode *node = NULL;
-    // fprintf(stderr, "response_node_ = %d, in remote read: pid = %d, tableid = %d, key = %d\n", response_node_, pid, tableid, key);
-    if (pid == response_node_) {
-      node = local_lookup_op(tableid, key);
-      assert(node != NULL);
-      assert(node->value != NULL);
+/**
+ * Per worker states of CALVIN, shared by the worker's coroutines.
+ */
+struct CalvinContext {
+  CalvinContext(CalvinScheduler *s,CalvinMemManager *m,int nid,int tid) :
+      scheduler(s),mem(m),tid(tid),input_backlog(m->mac_num_) {
+    for(int i = 0;i < m->mac_num_;++i) {
+      // the ring to the node itself is read locally, the remote heads are cached
+      input_writers.emplace_back(m->ring_size_,(i == nid) ? m->get_local_head(CalvinMemManager::INPUT_RING,nid,tid)
+                                                          : m->get_cached_head(CalvinMemManager::INPUT_RING,i,tid));
+      forward_writers.emplace_back(m->ring_size_,m->get_cached_head(CalvinMemManager::FORWARD_RING,i,tid));
+      rpc_input_writers.emplace_back(m->ring_size_,m->get_local_head(CalvinMemManager::INPUT_RING,i,tid));
+      forward_readers.emplace_back(m->get_local_ring(CalvinMemManager::FORWARD_RING,i,tid),m->ring_size_,
+                                   m->get_local_head(CalvinMemManager::FORWARD_RING,i,tid));
     }
-    read_set_.emplace_back(tableid,key,(MemNode *)node,(char*)NULL,
-                           0,
-                           len,pid);
-    return read_set_.size() - 1;
   }
 
-  // return the last index in the write-set
-  int remote_write(int pid,int tableid,uint64_t key,int len,yield_func_t &yield) {
-    MemNode *node = NULL;
-    // fprintf(stderr, "response_node_ = %d, in remote write: pid = %d, tableid = %d, key = %d\n", response_node_, pid, tableid, key);    
-    if (pid == response_node_) {
-      node = local_lookup_op(tableid, key);
-      assert(node != NULL);
-      assert(node->value != NULL);
+  void store_forward(const char *msg,int size) {
+    auto header = (const CalvinForwardHeader *)msg;
+    forwarded[header->txn_id].emplace_back(msg,size);
+  }
+
+  // returns the forwarded value of a remote record, or NULL if it has not arrived
+  char *find_forward(uint64_t txn_id,int pid,int tableid,uint64_t key) {
+    auto it = forwarded.find(txn_id);
+    if(it == forwarded.end())
+      return NULL;
+    for(auto &m : it->second) {
+      auto header = (CalvinForwardHeader *)m.data();
+      if(header->from != pid)
+        continue;
+      char *ptr = (char *)m.data() + sizeof(CalvinForwardHeader);
+      for(int i = 0;i < header->num;++i) {
+        auto item = (CalvinForwardItem *)ptr;
+        if(item->tableid == (uint32_t)tableid && item->key == key)
+          return ptr + sizeof(CalvinForwardItem);
+        ptr += sizeof(CalvinForwardItem) + CALVIN_ALIGN8(item->len);
+      }
     }
-    write_set_.emplace_back(tableid,key,(MemNode *)node,(char*)NULL,
-                           0,
-                           len,pid);
-    return write_set_.size() - 1;
+    return NULL;
   }
 
-  int remote_insert(int pid,int tableid,uint64_t key,int len,yield_func_t &yield) {
-    // remote insert for calvin is not needed: all insertions happen locally.
-    return -1;
-  }
-
-#if 0
-  void prepare_write_contents() {
-    // Notice that it should contain local records
-    // This function has to be called after lock + validation success
-    write_batch_helper_.clear_buf(); // only clean buf, not the mac_set
-
-    for(auto it = write_set_.begin();it != write_set_.end();++it) {
-      if ((*it).pid != node_id_) {
-        add_batch_entry_wo_mac<RtxWriteItem>(write_batch_helper_,
-                                             (*it).pid,
-                                             /* init write item */ (*it).pid,(*it).tableid,(*it).key,(*it).len);
-        memcpy(write_batch_helper_.req_buf_end_,(*it).data_ptr,(*it).len);
-        write_batch_helper_.req_buf_end_ += (*it).len;
+  // drains the forward rings written by one-sided WRITEs
+  void poll_forward() {
+    for(auto &r : forward_readers) {
+      uint32_t size;
+      char *payload;
+      while((payload = r.peek(size)) != NULL) {
+        store_forward(payload,size);
+        r.pop(size);
       }
     }
   }
 
-#endif
-  /**
-   * GC the read/write set is a little complex using RDMA.
-   * Since some pointers are allocated from the RDMA heap, not from local heap.
-   */
-  void gc_helper(std::vector<ReadSetItem> &set) {
-    for(auto it = set.begin();it != set.end();++it) {
-      // ASSERT(node_id_ == response_node_) << 
-              // "node_id_ = " << node_id_ << ", response_node_ =" << response_node_;
-      if(it->pid == response_node_) {
-        // fprintf(stderr, "Rfreed %p.\n", (*it).data_ptr);
-        Rfree((*it).data_ptr);
-      } else {
-        // fprintf(stderr, "Freed %p.\n", (*it).data_ptr);
-        free((*it).data_ptr);
+  // puts the inputs which were received by RPC when their rings were full
+  void drain_input_backlog() {
+    for(int i = 0;i < mem->mac_num_;++i) {
+      auto &q = input_backlog[i];
+      while(!q.empty() && rpc_input_writers[i].has_credits(q.front().size())) {
+        rpc_input_writers[i].local_put(mem->get_local_ring(CalvinMemManager::INPUT_RING,i,tid),
+                                       q.front().data(),q.front().size());
+        q.pop_front();
       }
     }
   }
 
-  // overwrite GC functions, to use Rfree
-  void gc_readset() {
-    gc_helper(read_set_);
-  }
+  CalvinScheduler  *scheduler;
+  CalvinMemManager *mem;
+  const int tid;
 
-  void gc_writeset() {
-    gc_helper(write_set_);
-  }
+  std::vector<CalvinRingWriter> input_writers;     // to each mac
+  std::vector<CalvinRingWriter> forward_writers;   // to each mac
+  std::vector<CalvinRingWriter> rpc_input_writers; // local input rings filled by the RPC handler
+  std::vector<CalvinRingReader> forward_readers;   // from each mac
 
-  bool dummy_commit() {
-    // clean remaining resources
-    gc_readset();
-    gc_writeset();
-    return true;
-  }
+  std::vector<std::deque<std::string> > input_backlog; // from each mac
 
-  void release_reads(yield_func_t &yield);
-  void release_writes(yield_func_t &yield);
-  void write_back(yield_func_t &yield);
+  std::unordered_map<uint64_t,std::vector<std::string> > forwarded; // txn id -> forwarded values
+  std::deque<CalvinTxn *> exec_queue; // granted TXs, whose local values have been forwarded
+  std::deque<CalvinTxn *> passive;    // granted TXs which this mac only provides values to, to be reported
+  std::deque<std::pair<uint16_t,uint64_t> > retries; // (req_idx, req_seed) of the diverged TXs initiated here
+};
+
+/**
+ * CALVIN, a deterministic protocol.
+ * The same CALVIN object works in two modes:
+ * 1. gen mode, used by the sequencer to run a TX once and record its read/write set as its input.
+ *    This is a reconnaissance: the values are read without locks, local records directly and remote
+ *    ones by RPC, so that accesses which depend on the values (e.g. graph links) are predicted;
+ * 2. exec mode, used by the executors to run a granted TX with the same input (the same seed),
+ *    where local records are read directly and remote records are forwarded by their owners.
+ * No lock, validation or 2PC is required during the execution. If the records a TX's accesses
+ * depend on changed after the reconnaissance, the execution diverges from the input at all the
+ * active participants alike; the TX then writes nothing, and is sequenced again by its initiator.
+ * Inserts are ignored, as the other protocols do.
+ */
+class CALVIN : public TxnAlg {
+#include "occ_internal_structure.h"
+ public:
 
-public:
   CALVIN(oltp::RWorker *worker,MemDB *db,RRpc *rpc_handler,int nid,int tid,int cid,int response_node,
-          RdmaCtrl *cm,RScheduler* sched,int ms) :
-#if ENABLE_TXN_API
+         RdmaCtrl *cm,RScheduler* sched,int ms) :
       TxnAlg(worker,db,rpc_handler,nid,tid,cid,response_node,cm,sched,ms),
-#else
-      TXOpBase(worker,db,rpc_handler,cm,sched,response_node,tid,ms),// response_node shall always equal *real node id*
-#endif
-      read_set_(),write_set_(),
-      read_batch_helper_(rpc_->get_static_buf(MAX_MSG_SIZE),reply_buf_),
-      write_batch_helper_(rpc_->get_static_buf(MAX_MSG_SIZE),reply_buf_),
-      rpc_op_send_buf_(rpc_->get_static_buf(MAX_MSG_SIZE)),
       cor_id_(cid),response_node_(nid)
   {
-#if !ENABLE_TXN_API
-        dslr_lock_manager = new DSLR(worker, db, rpc_handler, 
-                                 nid, tid, cid, response_node, 
-                                 cm, sched, ms);
-#endif
-    register_default_rpc_handlers();
-    memset(reply_buf_,0,MAX_MSG_SIZE);
-    lock_req_ = new RDMACASLockReq(cid);
-    read_req_ = new RDMAReadReq(cid);
-    read_set_.clear();
-    write_set_.clear();
+    send_buf_ = (char *)Rmalloc(MAX_MSG_SIZE + sizeof(uint64_t) * 2);
+    fwd_buf_  = (char *)Rmalloc(MAX_MSG_SIZE + sizeof(uint64_t) * 2);
+    wrap_buf_ = (char *)Rmalloc(sizeof(uint64_t));
+    scratch_  = (char *)calloc(1,MAX_MSG_SIZE);
+    assert(send_buf_ != NULL && fwd_buf_ != NULL && wrap_buf_ != NULL);
+    memset(abort_cnt,0,sizeof(abort_cnt));
   }
 
   void set_logger(Logger *log) { logger_ = log; }
 
-#if ENABLE_TXN_API
-  // get the read lock of the record and actually read
-  inline __attribute__((always_inline))
-  virtual int read(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    int index;
-    // step 1: find offset of the key in either local/remote memory
-    if(pid == response_node_)
-      index = local_read(tableid,key,len,yield);
-    else {
-      // remote case
-      index = remote_read(pid,tableid,key,len,yield);
-    }
-
-    return index;
-  }
-
-  // read2 is used only by the sequencer thread to generate the read set
-  static int read2(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    read_set.emplace_back(tableid,key,(MemNode *)NULL,(char*)NULL,
-                           0,
-                           len,pid);
-    return read_set.size() - 1;
+  void set_context(CalvinContext *ctx) {
+    ctx_ = ctx;
+    register_default_rpc_handlers();
   }
 
-  template <int tableid,typename V>
-  inline __attribute__((always_inline))
-  int read(int pid,uint64_t key,yield_func_t &yield) {
-    return read(pid, tableid, key, sizeof(V), yield);
-  }
+  void set_gen_mode() { gen_ = true; }
 
-#else
-  template <int tableid,typename V> // the value stored corresponding to tableid
-  inline __attribute__((always_inline))
-  int  read(int pid,uint64_t key,yield_func_t &yield) {
-    int index;
-    if(pid == response_node_)
-      index = local_read(tableid,key,sizeof(V),yield);
-    else {
-      // remote case
-      index = remote_read(pid,tableid,key,sizeof(V),yield);
+  virtual void begin(yield_func_t &yield) {
+    if(gen_) {
+      gen_reads_.clear();
+      gen_writes_.clear();
+      gc_vals(gen_read_vals_);
+      gc_vals(gen_write_vals_);
     }
-
-    return index;
+    read_cursor_ = write_cursor_ = 0;
+    diverged_ = false;
   }
-#endif
-
-#if ENABLE_TXN_API
-  // lock the record and add the record to the write-set
-  inline __attribute__((always_inline))
-  virtual int write(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    int index;
-
-    // step 1: find offset of the key in either local/remote memory
-    if(pid == response_node_)
-      index = local_write(tableid,key,len,yield);
-    else {
-      // remote case
-      index = remote_write(pid,tableid,key,len,yield);
-    }
 
-    return index;
+  virtual int read(int pid,int tableid,uint64_t key,size_t len,yield_func_t &yield) {
+    return access(read_set_,gen_reads_,gen_read_vals_,read_cursor_,pid,tableid,key,len);
   }
 
-  // write2 is used only by the sequencer thread to generate the write set
-  static int write2(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    write_set.emplace_back(tableid,key,(MemNode *)NULL,(char*)NULL,
-                           0,
-                           len,pid);
-    return write_set.size() - 1;
+  virtual int write(int pid,int tableid,uint64_t key,size_t len,yield_func_t &yield) {
+    return access(write_set_,gen_writes_,gen_write_vals_,write_cursor_,pid,tableid,key,len);
   }
 
   template <int tableid,typename V>
   inline __attribute__((always_inline))
-  int write(int pid,uint64_t key,yield_func_t &yield) {
-    return write(pid, tableid, key, sizeof(V), yield);
-  }
-
-  // Actually load the data, can be done only after all locks are acquired.
-  inline __attribute__((always_inline))
-  virtual char* load_read(int idx, size_t len, yield_func_t &yield) {
-    // fprintf(stderr, "in load read.\n");
-    std::vector<ReadSetItem> &set = read_set_;
-    // fprintf(stderr, "pid = %d\n", set[idx].pid);
-    
-    assert(idx < set.size());
-    ASSERT(len == set[idx].len) <<
-        "excepted size " << (int)(set[idx].len)  << " for table " << (int)(set[idx].tableid) << "; idx " << idx;
-
-    if(set[idx].pid == response_node_) {
-      if (set[idx].data_ptr == NULL) {
-        // local actual read
-        char *temp_val = (char *)Rmalloc(len);
-        // fprintf(stdout, "load read Rmalloc %p\n", temp_val);
-
-        uint64_t seq;
-        auto node = local_get_op(set[idx].tableid,set[idx].key, temp_val, set[idx].len,seq,
-                                 db_->_schemas[set[idx].tableid].meta_len);
-        if(unlikely(node == NULL)) {
-          Rfree(temp_val);
-          assert(false);
-          return NULL;
-        }
-
-        set[idx].data_ptr = temp_val;
-      }
-    }
-
-    return (set[idx].data_ptr);
-  }
-
-
-  // Actually load the data, can be done only after all locks are acquired.
-  inline __attribute__((always_inline))
-  virtual char* load_write(int idx, size_t len, yield_func_t &yield) {
-    // fprintf(stderr, "in load write.\n");
-    std::vector<ReadSetItem> &set = write_set_;
-    // fprintf(stderr, "pid = %d\n", set[idx].pid);
-
-    assert(idx < set.size());
-    ASSERT(len == set[idx].len) <<
-        "excepted size " << (int)(set[idx].len)  << " for table " << (int)(set[idx].tableid) << "; idx " << idx << " however len = " << len;
-
-    // note that we must use response_node_ here to indicate the actual
-    // node id.
-    // fprintf(stdout, "pid in load write %d = %d. my node id = %d\n", idx, set[idx].pid, response_node_);
-    if(set[idx].pid == response_node_) {
-      // assert(set[idx].data_ptr == NULL);
-      if (set[idx].data_ptr == NULL) {
-        // local actual write
-        char *temp_val = (char *)Rmalloc(len);
-        // fprintf(stdout, "load write Rmalloc %p\n", temp_val);
-
-        uint64_t seq;
-        auto node = local_get_op(set[idx].tableid,set[idx].key, temp_val, set[idx].len,seq, db_->_schemas[set[idx].tableid].meta_len);
-        if(unlikely(node == NULL)) {
-          Rfree(temp_val);
-          assert(false);
-          return NULL;
-        }
-        
-        set[idx].data_ptr = temp_val;
-      }
-      // fprintf(stdout, "in load write: %f@%p\n", *(float*)set[idx].data_ptr, set[idx].data_ptr);
-    }
-
-    return (set[idx].data_ptr);
+  int read(int pid,uint64_t key,yield_func_t &yield) {
+    return read(pid,tableid,key,sizeof(V),yield);
   }
 
-  template <typename V>
+  template <int tableid,typename V>
   inline __attribute__((always_inline))
-  V *get_readset(int idx,yield_func_t &yield) {
-    return (V*)load_read(idx, sizeof(V), yield);
+  int write(int pid,uint64_t key,yield_func_t &yield) {
+    return write(pid,tableid,key,sizeof(V),yield);
   }
 
-  template <typename V>
-  inline __attribute__((always_inline))
-  V *get_writeset(int idx,yield_func_t &yield) {
-    return (V*)load_write(idx, sizeof(V), yield);
+  virtual char *load_read(int idx,size_t len,yield_func_t &yield) {
+    if(idx < 0)
+      return dummy_val(len);
+    if(gen_)
+      return gen_load(gen_reads_[idx],gen_read_vals_[idx],yield);
+    return load(read_set_[idx],yield);
   }
 
-  void display_sets() {
-    fprintf(stdout, "in reads set: \n");
-    for (int i = 0; i < read_set_.size(); i++) {
-      fprintf(stdout, "pid = %d", read_set_[i].pid);
-      fprintf(stdout, " tableid = %d", read_set_[i].tableid);
-      fprintf(stdout, " len = %d", read_set_[i].len);
-      fprintf(stdout, " key = %lu\n", read_set_[i].key);      
-    }
-    fprintf(stdout, "in write set: \n");
-    for (int i = 0; i < write_set_.size(); i++) {
-      fprintf(stdout, "pid = %d", write_set_[i].pid);
-      fprintf(stdout, " tableid = %d", write_set_[i].tableid);
-      fprintf(stdout, " len = %d", write_set_[i].len);
-      fprintf(stdout, " key = %lu\n", write_set_[i].key);      
-    }
+  virtual char *load_write(int idx,size_t len,yield_func_t &yield) {
+    if(idx < 0)
+      return dummy_val(len);
+    if(gen_)
+      return gen_load(gen_writes_[idx],gen_write_vals_[idx],yield);
+    return load(write_set_[idx],yield);
   }
 
-  bool sync_reads(int req_idx, yield_func_t &yield);
-
-#else
-
   template <typename V>
   inline __attribute__((always_inline))
   V *get_readset(int idx,yield_func_t &yield) {
-    return get_set_helper<V>(read_set_, idx, yield);
+    return (V *)load_read(idx,sizeof(V),yield);
   }
 
   template <typename V>
   inline __attribute__((always_inline))
   V *get_writeset(int idx,yield_func_t &yield) {
-    return get_set_helper<V>(write_set_, idx, yield);
-  }
-
-  template <typename V>
-  inline __attribute__((always_inline))
-  V* get_set_helper(std::vector<ReadSetItem> &set, int idx,yield_func_t &yield) {
-    assert(idx < set.size());
-    ASSERT(sizeof(V) == set[idx].len) <<
-        "excepted size " << (int)(set[idx].len)  << " for table " << (int)(set[idx].tableid) << "; idx " << idx;
-
-    if(set[idx].pid != response_node_) {
-        ;
-    } else {
-      if (set[idx].data_ptr == NULL) {
-        // local actual read
-        char *temp_val = (char *)malloc(len);
-        uint64_t seq;
-        auto node = local_get_op(set[idx].tableid,set[idx].key, temp_val, set[idx].len,seq,
-                                 db_->_schemas[set[idx].tableid].meta_len);
-        if(unlikely(node == NULL)) {
-          free(temp_val);
-          assert(false);
-          return NULL;
-        }
-
-        set[idx].data_ptr = temp_val;
-      }
-    }
-
-    return (V*)(set[idx].data_ptr);
+    return (V *)load_write(idx,sizeof(V),yield);
   }
-#endif
 
   template <int tableid,typename V>
   V *get(int pid,uint64_t key,yield_func_t &yield) {
-#if ENABLE_TXN_API
     int idx = read(pid,tableid,key,sizeof(V),yield);
-#else
-    int idx = read<tableid,V>(pid,key,yield);
-#endif
     return get_readset<V>(idx,yield);
   }
-  
+
+  // inserts are ignored, as the other protocols do
   template <int tableid,typename V>
   inline __attribute__((always_inline))
   int insert(int pid,uint64_t key,V *val,yield_func_t &yield) {
-    if(pid == response_node_)
-      return local_insert(tableid,key,(char *)val,sizeof(V),yield);
-    else {
-      return remote_insert(pid,tableid,key,sizeof(V),yield);
-    }
     return -1;
   }
 
-  // start a TX
-  virtual void begin(yield_func_t &yield) {
-    assert(false);
-    read_set_.clear();
-    write_set_.clear();
-    #if USE_DSLR
-      dslr_lock_manager->init();
-    #endif
-    txn_start_time = rwlock::get_now();
-    // the txn_end_time is approximated using the LEASE_TIME
-    txn_end_time = txn_start_time + rwlock::LEASE_TIME;
+  virtual bool commit(yield_func_t &yield) {
+    if(gen_)
+      return true;
+    if(diverged_)
+      return false;
+#if TX_ONLY_EXE
+    return dummy_commit();
+#endif
+    write_back(yield);
+    return true;
   }
 
-  void begin(det_request* req, yield_func_t &yield) {
-#if DEBUG_LEVEL==1
-    fprintf(stderr, "executing txn with ts %lx of type %d. \n", req->timestamp, req->req_idx);
+  // whether the last execution diverged from its input
+  inline bool diverged() const { return diverged_; }
+
+  /******** sequencer side ********/
+  // fill the input of the TX which just ran in the gen mode
+  void fill_request(det_request *req);
+
+  // send the batch of an epoch to all macs, each mac only receives the TXs it participates
+  void send_batch(uint64_t epoch,char *reqs,int num,yield_func_t &yield);
+
+  // forward the local values of the granted TXs; the ones this mac shall execute go to
+  // ctx_->exec_queue, the others to ctx_->passive
+  void forward_ready(yield_func_t &yield);
+
+  // consume the entries which the rings, or the RPC handlers, have buffered
+  void poll_rings() {
+    ctx_->drain_input_backlog();
+#if CALVIN_ONE_SIDED_FORWARD
+    ctx_->poll_forward();
 #endif
-    req_ = req;
-    read_set_.clear();
-    write_set_.clear();
-    rwsets_t* sets = (rwsets_t*)req->req_info;
-    int reads = sets->nReads, writes = sets->nWrites;
-    for (int i = 0; i < reads; i++) {
-      read_set_.push_back(sets->access[i]);
+  }
+
+  /******** executor side ********/
+  // forward the local values of a granted TX to the other active participants;
+  // returns whether this mac shall execute the TX
+  bool forward_values(CalvinTxn *txn,yield_func_t &yield);
+
+  void prepare(CalvinTxn *txn);
+
+  // wait for the pending forwarded values, then release the locks and the resources of the TX
+  void finish(yield_func_t &yield);
+
+  // ask the initiator to sequence the diverged TX again; called by the reporter
+  void restart(yield_func_t &yield);
+
+  // whether this mac reports the commit of the TX
+  static bool is_reporter(const det_request *req,int nid);
+
+  static bool is_active(const det_request *req,int pid) {
+    for(int i = req->nReads;i < req->nReads + req->nWrites;++i)
+      if(req->access[i].pid == pid) return true;
+    return false;
+  }
+
+  void show_abort() {
+  }
+
+ protected:
+  int access(std::vector<ReadSetItem> &set,std::vector<CalvinAccess> &gen_set,std::vector<char *> &gen_vals,
+             int &cursor,int pid,int tableid,uint64_t key,size_t len) {
+    if(gen_) {
+      ASSERT(gen_reads_.size() + gen_writes_.size() < CALVIN_MAX_ACCESS) << "too many records for CALVIN";
+      CalvinAccess a;
+      a.key = key; a.len = len; a.pid = pid; a.tableid = tableid;
+      gen_set.push_back(a);
+      gen_vals.push_back(NULL);
+      return gen_set.size() - 1;
     }
-    for (int i = 0; i < writes; i++) {
-      write_set_.push_back(sets->access[reads+i]);
+    if(diverged_)
+      return -1;
+    // the execution shall issue the same accesses as the sequenced one; otherwise the records
+    // which the accesses depend on changed since the reconnaissance
+    int idx = cursor++;
+    if(idx >= (int)set.size() || set[idx].tableid != tableid || set[idx].key != key) {
+      diverged_ = true;
+      return -1;
     }
+    return idx;
   }
 
-  // commit a TX
-  virtual bool commit(yield_func_t &yield) {
+  char *load(ReadSetItem &item,yield_func_t &yield);
+  char *gen_load(const CalvinAccess &a,char *&val,yield_func_t &yield);
+  void write_back(yield_func_t &yield);
 
-#if TX_ONLY_EXE
-    return dummy_commit();
-#endif
+  // the value of an access which is not in the input, after the execution diverges
+  inline char *dummy_val(size_t len) {
+    assert(len <= MAX_MSG_SIZE);
+    memset(scratch_,0,len);
+    return scratch_;
+  }
 
-    asm volatile("" ::: "memory");
+  // put a ring entry (composed at buf + 8) to a mac
+  void send_ring(int type,int pid,char *buf,int size,yield_func_t &yield);
 
-    // prepare_write_contents();
-    // log_remote(yield); // log remote using *logger_*
+  // wait until the ring to pid has space for an entry of size
+  void wait_credits(int type,int pid,CalvinRingWriter &writer,int size,yield_func_t &yield);
 
-    // write the modifications of records back
-    write_back(yield);
-    release_reads(yield);
-    release_writes(yield);
-    gc_readset();
-    gc_writeset();
-#if DEBUG_LEVEL==1
-    fprintf(stderr, "txn with timestamp %lx committed.\n", req_->timestamp);
-#endif
+  void gc_set(std::vector<ReadSetItem> &set) {
+    for(auto &item : set)
+      free(item.data_ptr);
+    set.clear();
+  }
+
+  void gc_vals(std::vector<char *> &vals) {
+    for(auto v : vals)
+      free(v);
+    vals.clear();
+  }
+
+  virtual inline bool dummy_commit() {
     return true;
   }
 
-public:
+ public:
   std::vector<ReadSetItem>  read_set_;
   std::vector<ReadSetItem>  write_set_;
-  det_request* req_ = NULL;
-  // this two sets are used by the sequencer to generate for different benchmarks.
-  // they are not belonging to any CALVIN object and any execution threads' coroutines.
-  static std::vector<ReadSetItem> read_set;
-  static std::vector<ReadSetItem> write_set;
-protected:
-  // helper to send batch read/write operations
-  BatchOpCtrlBlock read_batch_helper_;
-  BatchOpCtrlBlock write_batch_helper_;
-  RDMACASLockReq* lock_req_;
-  RDMAReadReq* read_req_;
+ protected:
+  bool gen_ = false;
+  bool diverged_ = false;
+  std::vector<CalvinAccess> gen_reads_;
+  std::vector<CalvinAccess> gen_writes_;
+  std::vector<char *> gen_read_vals_;  // values fetched by the reconnaissance
+  std::vector<char *> gen_write_vals_;
+  int read_cursor_  = 0;
+  int write_cursor_ = 0;
+
+  CalvinContext *ctx_ = NULL;
+  CalvinTxn     *txn_ = NULL;
+
+  char *send_buf_;  // registered, | header | payload | header |, for the inputs
+  char *fwd_buf_;   // the same, for the forwarded values
+  char *wrap_buf_;
+  char *scratch_;   // dummy values after the execution diverges
 
   const int cor_id_;
   const int response_node_;
 
   Logger *logger_ = NULL;
 
-  char* rpc_op_send_buf_;
-  char reply_buf_[MAX_MSG_SIZE];
-
-#if !ENABLE_TXN_API
-  DSLR* dslr_lock_manager;
-#endif
-
-  uint64_t txn_start_time = 0;
-  uint64_t txn_end_time = 0;
-
   friend class BenchWorker;
   friend class BankWorker;
 
-public:
+ public:
 #include "occ_statistics.h"
 
-  // helper functions
   void register_default_rpc_handlers();
 
  private:
   // RPC handlers
+  void input_rpc_handler(int id,int cid,char *msg,void *arg);
   void forward_rpc_handler(int id,int cid,char *msg,void *arg);
+  void recon_rpc_handler(int id,int cid,char *msg,void *arg);
+  void retry_rpc_handler(int id,int cid,char *msg,void *arg);
 };
 
 } // namespace rtx
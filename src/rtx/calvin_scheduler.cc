@@ -0,0 +1,174 @@
+#include "calvin_scheduler.h"
+
+#include <stdlib.h>
+
+namespace nocc {
+
+namespace rtx {
+
+CalvinScheduler::CalvinScheduler(CalvinMemManager *mem,int nid,int ms,int ts) :
+    ndb_thread(true,"calvin-scheduler"),
+    mem_(mem),node_id_(nid),mac_num_(ms),thread_num_(ts) {
+  for(int m = 0;m < mac_num_;++m)
+    for(int t = 0;t < thread_num_;++t)
+      rings_.emplace_back(mem_->get_local_ring(CalvinMemManager::INPUT_RING,m,t),mem_->ring_size_,
+                          mem_->get_local_head(CalvinMemManager::INPUT_RING,m,t));
+  ready_ = new TxnQueue[thread_num_];
+  done_  = new TxnQueue[thread_num_];
+}
+
+void CalvinScheduler::run() {
+  while(true) {
+    for(int t = 0;t < thread_num_;++t) {
+      CalvinTxn *txn;
+      while((txn = pop(done_[t])) != NULL) {
+        release(txn);
+        free(txn->req);
+        delete txn;
+        inflight_ -= 1;
+      }
+    }
+    if(inflight_ < CALVIN_MAX_INFLIGHT)
+      consume_inputs();
+  }
+}
+
+CalvinTxn *CalvinScheduler::next_ready(int tid) {
+  return pop(ready_[tid]);
+}
+
+void CalvinScheduler::finish(int tid,CalvinTxn *txn) {
+  push(done_[tid],txn);
+}
+
+// consume the input batches in the global order, returns false if the next batch has not arrived
+bool CalvinScheduler::consume_inputs() {
+  while(inflight_ < CALVIN_MAX_INFLIGHT) {
+    uint32_t size;
+    char *payload = rings_[cur_ring_].peek(size);
+    if(payload == NULL)
+      return false;
+
+    CalvinBatchHeader *header = (CalvinBatchHeader *)payload;
+    ASSERT(header->epoch == epoch_) << "CALVIN batch of epoch " << header->epoch
+                                    << " received at epoch " << epoch_;
+    char *ptr = payload + sizeof(CalvinBatchHeader);
+    for(int i = 0;i < header->num;++i) {
+      det_request *req = (det_request *)ptr;
+      schedule(req);
+      ptr += req->size();
+    }
+    bool last = header->last;
+    rings_[cur_ring_].pop(size);
+
+    if(last) {
+      if(++cur_ring_ == (int)rings_.size()) {
+        cur_ring_ = 0;
+        epoch_ += 1;
+      }
+    }
+  }
+  return true;
+}
+
+int CalvinScheduler::local_locks(const det_request *req,LockKey *keys,bool *writes) {
+  int num = 0;
+  for(int i = 0;i < req->nReads + req->nWrites;++i) {
+    const CalvinAccess &a = req->access[i];
+    if(a.pid != node_id_)
+      continue;
+    bool write = (i >= req->nReads);
+    int j = 0;
+    for(;j < num;++j) {
+      if(keys[j].tableid == a.tableid && keys[j].key == a.key)
+        break;
+    }
+    if(j == num) {
+      keys[num].tableid = a.tableid;
+      keys[num].key = a.key;
+      writes[num++] = write;
+    } else
+      writes[j] = writes[j] || write;
+  }
+  return num;
+}
+
+void CalvinScheduler::schedule(const det_request *req) {
+  LockKey keys[CALVIN_MAX_ACCESS];
+  bool writes[CALVIN_MAX_ACCESS];
+  int num = local_locks(req,keys,writes);
+  if(num == 0)
+    return; // not a participant
+
+  CalvinTxn *txn = new CalvinTxn;
+  txn->req = (det_request *)malloc(req->size());
+  memcpy(txn->req,req,req->size());
+  txn->waits = num + 1; // in case the TX is granted before all its locks are queued
+  inflight_ += 1;
+
+  for(int i = 0;i < num;++i) {
+    auto &q = locks_[keys[i]];
+    q.push_back({txn,writes[i],false});
+    grant(q);
+  }
+  if(--txn->waits == 0)
+    push(ready_[CALVIN_TXN_TID(txn->req->txn_id)],txn);
+}
+
+void CalvinScheduler::grant(std::deque<LockRequest> &q) {
+  for(size_t i = 0;i < q.size();++i) {
+    auto &r = q[i];
+    if(r.write && i > 0)
+      break;
+    if(!r.granted) {
+      r.granted = true;
+      if(--r.txn->waits == 0)
+        push(ready_[CALVIN_TXN_TID(r.txn->req->txn_id)],r.txn);
+    }
+    if(r.write)
+      break;
+  }
+}
+
+void CalvinScheduler::release(CalvinTxn *txn) {
+  LockKey keys[CALVIN_MAX_ACCESS];
+  bool writes[CALVIN_MAX_ACCESS];
+  int num = local_locks(txn->req,keys,writes);
+
+  for(int i = 0;i < num;++i) {
+    auto it = locks_.find(keys[i]);
+    assert(it != locks_.end());
+    auto &q = it->second;
+    for(auto r = q.begin();r != q.end();++r) {
+      if(r->txn == txn) {
+        assert(r->granted);
+        q.erase(r);
+        break;
+      }
+    }
+    if(q.empty())
+      locks_.erase(it);
+    else
+      grant(q);
+  }
+}
+
+void CalvinScheduler::push(TxnQueue &q,CalvinTxn *txn) {
+  q.lock.Lock();
+  q.txns.push_back(txn);
+  q.lock.Unlock();
+}
+
+CalvinTxn *CalvinScheduler::pop(TxnQueue &q) {
+  CalvinTxn *res = NULL;
+  q.lock.Lock();
+  if(!q.txns.empty()) {
+    res = q.txns.front();
+    q.txns.pop_front();
+  }
+  q.lock.Unlock();
+  return res;
+}
+
+} // namespace rtx
+} // namespace nocc
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "tx_config.h"
+
+#include "calvin_structure.h"
+#include "calvin_mem_manager.hpp"
+
+#include "core/utils/thread.h"
+#include "util/spinlock.h"
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+namespace nocc {
+
+namespace rtx {
+
+// A sequenced TX at the scheduler
+struct CalvinTxn {
+  det_request *req;
+  int waits;  // local locks not granted yet
+};
+
+/**
+ * The deterministic lock scheduler of CALVIN, one thread per node.
+ * It merges the input batches of all sequencers epoch by epoch, in the order of
+ * (mac, thread, index), and grants the locks of local records in this global order.
+ * Since every lock is granted in the same order at every node, TXs never deadlock nor abort.
+ * Granted TXs are executed by the worker thread which has the same id as the TX's sequencer,
+ * so the values are always forwarded between the same pair of threads.
+ */
+class CalvinScheduler : public ndb_thread {
+ public:
+  CalvinScheduler(CalvinMemManager *mem,int nid,int ms,int ts);
+
+  void run();
+
+  // called by the workers
+  CalvinTxn *next_ready(int tid);
+  void finish(int tid,CalvinTxn *txn);
+
+  // the epoch being scheduled; sequencers shall not run too far ahead of it
+  inline uint64_t epoch() const { return epoch_; }
+
+ private:
+  struct LockKey {
+    int      tableid;
+    uint64_t key;
+    bool operator==(const LockKey &o) const { return tableid == o.tableid && key == o.key; }
+  };
+  struct LockKeyHash {
+    size_t operator()(const LockKey &k) const { return (k.key * 0x9E3779B97F4A7C15ULL) ^ k.tableid; }
+  };
+  struct LockRequest {
+    CalvinTxn *txn;
+    bool write;
+    bool granted;
+  };
+  struct TxnQueue {
+    SpinLock lock;
+    std::deque<CalvinTxn *> txns;
+  };
+
+  bool consume_inputs();
+  void schedule(const det_request *req);
+  void release(CalvinTxn *txn);
+  void grant(std::deque<LockRequest> &q);
+  int  local_locks(const det_request *req,LockKey *keys,bool *writes);
+
+  void push(TxnQueue &q,CalvinTxn *txn);
+  CalvinTxn *pop(TxnQueue &q);
+
+  CalvinMemManager *mem_;
+  const int node_id_;
+  const int mac_num_;
+  const int thread_num_;
+
+  std::vector<CalvinRingReader> rings_; // input rings, ordered by (mac, thread)
+  int cur_ring_ = 0;
+  volatile uint64_t epoch_ = 0;
+  int inflight_ = 0;
+
+  std::unordered_map<LockKey,std::deque<LockRequest>,LockKeyHash> locks_;
+
+  TxnQueue *ready_; // per worker
+  TxnQueue *done_;  // per worker
+};
+
+} // namespace rtx
+} // namespace nocc
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace nocc {
+
+namespace rtx {
+
+/**
+ * Wire formats of CALVIN.
+ * A TX's input is sequenced as a det_request, and all nodes execute the requests
+ * of an epoch in the order of (epoch, initiator mac, initiator thread, index).
+ */
+
+#define CALVIN_MAX_ACCESS   64          // max records accessed by a TX
+#define CALVIN_EPOCH_US     5000        // length of a sequencing epoch
+#define CALVIN_EPOCH_LAG    4           // max epochs a sequencer runs ahead of the local scheduler
+#define CALVIN_TXS_PER_COR  4           // inputs sequenced per executor coroutine per epoch
+#define CALVIN_MAX_INFLIGHT 8192        // max TXs scheduled but not finished at a node
+#define CALVIN_RING_SIZE    (256 * 1024)
+
+// txn id: 32 bit epoch | 8 bit mac | 8 bit thread | 16 bit index in the batch
+#define CALVIN_TXN_ID(epoch,mac,tid,idx) \
+  ( ((uint64_t)(epoch) << 32) | ((uint64_t)(mac) << 24) | ((uint64_t)(tid) << 16) | (uint64_t)(idx) )
+#define CALVIN_TXN_EPOCH(id) ((id) >> 32)
+#define CALVIN_TXN_MAC(id)   (((id) >> 24) & 0xff)
+#define CALVIN_TXN_TID(id)   (((id) >> 16) & 0xff)
+
+struct CalvinAccess {
+  uint64_t key;
+  uint32_t len;
+  uint8_t  pid;
+  uint8_t  tableid;
+  uint8_t  is_write;
+  uint8_t  padding;
+} __attribute__ ((aligned (8)));
+
+struct det_request {
+  uint64_t txn_id;
+  uint64_t timestamp; // rdtsc at the sequencer, only meaningful at the initiator
+  uint64_t req_seed;  // seed of the random generator which produces the TX's inputs
+  uint32_t input_time_s; // wall clock (s) when the inputs are produced, e.g. for a moving hotspot
+  uint16_t req_idx;   // which TX in the workload
+  uint8_t  req_initiator;
+  uint8_t  nReads;
+  uint8_t  nWrites;
+  uint8_t  padding[7];
+  CalvinAccess access[0]; // reads, then writes
+
+  inline int size() const {
+    return sizeof(det_request) + (nReads + nWrites) * sizeof(CalvinAccess);
+  }
+
+  inline bool touches(int pid) const {
+    for(int i = 0;i < nReads + nWrites;++i)
+      if(access[i].pid == pid) return true;
+    return false;
+  }
+} __attribute__ ((aligned (8)));
+
+// A batch of det_requests of one epoch, sent from one sequencer to one node.
+// A batch may be split into several chunks, the last one is marked.
+struct CalvinBatchHeader {
+  uint64_t epoch;
+  uint16_t num;
+  uint16_t last;
+  uint32_t padding;
+} __attribute__ ((aligned (8)));
+
+// Values of the local records of a TX, forwarded to the other participants
+struct CalvinForwardHeader {
+  uint64_t txn_id;
+  uint16_t from;
+  uint16_t num;
+  uint32_t padding;
+} __attribute__ ((aligned (8)));
+
+struct CalvinForwardItem {
+  uint64_t key;
+  uint32_t len;
+  uint32_t tableid;
+  // follows the payload, aligned to 8 bytes
+} __attribute__ ((aligned (8)));
+
+#define CALVIN_ALIGN8(x) (((x) + 7) & ~((uint64_t)7))
+
+} // namespace rtx
+} // namespace nocc
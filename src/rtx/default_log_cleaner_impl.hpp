@@ -8,8 +8,21 @@
 #include "core/logging.h"
 
 #include "log_cleaner.hpp"
+#include "log_mem_manager.hpp"
+#include "log_delta.hpp"
+#include "log_replayer.hpp"
 #include "msg_format.hpp"
 
+#if DURABLE_LOG
+#include "durable_log.hpp"
+#include <deque>
+#include <string>
+#endif
+
+#if LOG_ACK_BATCH
+#include <vector>
+#endif
+
 extern size_t current_partition;
 
 namespace nocc {
@@ -19,35 +32,130 @@ namespace rtx {
 // provide a default implementation of the log cleaner
 class DefaultLogCleaner : public LogCleaner {
  public:
-  DefaultLogCleaner(int num,RRpc *rpc) :
+  DefaultLogCleaner(int num,RRpc *rpc,LogMemManager *mem = NULL) :
       LogCleaner(num),
-      rpc_handler_(rpc)
+      rpc_handler_(rpc),
+      log_mem_(mem)
   {
 
   }
 
   void register_callback(int id,RRpc *rpc) {
+#if LOG_ACK_BATCH
+    rpc->register_callback(std::bind(&DefaultLogCleaner::clean_log_batch,this,
+                                     std::placeholders::_1,
+                                     std::placeholders::_2,
+                                     std::placeholders::_3,
+                                     std::placeholders::_4),id,true);
+#else
     rpc->register_callback(std::bind(&DefaultLogCleaner::clean_log,this,
                                      std::placeholders::_1,
                                      std::placeholders::_2,
                                      std::placeholders::_3,
                                      std::placeholders::_4),id,true);
+#endif
   }
 
-  void clean_log(int nid,int cid,char *msg, void *) {
+  void clean_log(int nid,int cid,char *msg, void *arg) {
+    if(unlikely(!global_view->is_alive(nid))) // fenced by a view change
+      return;
+#if DURABLE_LOG
+    uint64_t lsn = apply_log(nid,msg,(uint64_t)arg);
+#else
+    apply_log(nid,msg,(uint64_t)arg);
+#endif
+
+#if DURABLE_LOG_WAIT
+    // the ack is deferred until the log is on disk
+    pending_ack(nid,cid,lsn,0);
+#elif !PA
+    char *reply_msg = rpc_handler_->get_reply_buf();
+    rpc_handler_->send_reply(reply_msg,sizeof(uint64_t),nid,cid);
+#endif
+  }
+
+#if LOG_ACK_BATCH
+  /**
+   * Cleans a batch of logs (see Logger::log_ack).
+   * Instead of a reply, the batch's LSN becomes the applied watermark of its sender,
+   * which is sent back lazily, piggybacked on the acks to it if possible.
+   */
+  void clean_log_batch(int nid,int cid,char *msg,void *arg) {
+    if(unlikely(!global_view->is_alive(nid)))
+      return;
+    RtxLogBatchHeader *header = (RtxLogBatchHeader *)msg;
+    update_watermark(nid,header->watermark);
+
+    char *ptr = msg + sizeof(RtxLogBatchHeader);
+    uint64_t lsn = 0;
+    for(uint i = 0;i < header->num;++i) {
+      uint64_t size = *((uint64_t *)ptr);
+      lsn = apply_log(nid,ptr + sizeof(uint64_t),size);
+      ptr += sizeof(uint64_t) + RTX_ALIGN8(size);
+    }
+#if DURABLE_LOG_WAIT
+    pending_ack(nid,cid,lsn,header->lsn);
+#else
+    applied_[nid] = header->lsn;
+#endif
+  }
+
+  void watermark_handler(int nid,int cid,char *msg,void *arg) {
+    update_watermark(nid,*((uint64_t *)msg));
+  }
+
+  void register_watermark_callback(int id,RRpc *rpc) {
+    rpc->register_callback(std::bind(&DefaultLogCleaner::watermark_handler,this,
+                                     std::placeholders::_1,
+                                     std::placeholders::_2,
+                                     std::placeholders::_3,
+                                     std::placeholders::_4),id,true);
+  }
+
+  void init_watermarks(int ms) {
+    applied_.assign(ms,0);
+    watermarks_.assign(ms,0);
+  }
+
+  // LSN of the last log received from nid which is applied (and durable, if required)
+  inline uint64_t applied(int nid) const { return applied_[nid]; }
+
+  // LSN of the last log sent to backup nid which the backup has applied
+  inline uint64_t watermark(int nid) const { return watermarks_[nid]; }
+
+  inline void update_watermark(int nid,uint64_t lsn) {
+    if(lsn > watermarks_[nid])
+      watermarks_[nid] = lsn;
+  }
+#endif
+
+ private:
+  // applies a log to the backup stores, returns its LSN in the durable log (if any),
+  // or UNKNOWN_LSN if the log waits to be appended to the durable log
+  uint64_t apply_log(int nid,char *msg,uint64_t size) {
+    uint64_t lsn = 0;
+#if DURABLE_LOG
+    lsn = durable_append(nid,msg,size);
+#endif
 
     RTX_ITER_ITEM(msg,sizeof(RtxWriteItem)) {
       auto item = (RtxWriteItem *)ttptr;
       ttptr += item->len;
 
       // check whether to log
-      if(!global_view->is_backup(current_partition,item->pid))
+      if(!global_view->is_table_backup(current_partition,item->pid,item->tableid))
         continue;
 
       assert(item->pid != current_partition);
       auto store = get_backed_store(item->pid);
       assert(store != NULL);
 
+      if(log_replayer != NULL) {
+        // applied by the replay threads
+        log_replayer->enqueue(rpc_handler_->worker_id_,store,item);
+        continue;
+      }
+
       MemNode *node = store->stores_[item->tableid]->GetWithInsert((uint64_t)(item->key));
       char *new_val;
       if(item->len == 0) {
@@ -60,29 +168,109 @@ class DefaultLogCleaner : public LogCleaner {
       }
       node->lock = 0;
       uint64_t old_seq = node->seq;
+      if(unlikely(!write_item_applies(old_seq,item))) {
+        __sync_fetch_and_add(&rejected_deltas(),1);
+        continue;
+      }
       node->seq   = 1;
       asm volatile("" ::: "memory");
 #if EM_FASST || INLINE_OVERWRITE
-      memcpy(node->padding, (char *)item + sizeof(RtxWriteItem),item->len);
+      apply_write_item((char *)(node->padding),item);
 #else
       if(unlikely(node->value == NULL)) {
+        ASSERT(!item->delta) << "delta log of a missing record, table " << (int)item->tableid;
         node->value = (uint64_t *)malloc(item->len);
       }
-      memcpy((char *)(node->value),
-             (char *)item + sizeof(RtxWriteItem),item->len);
+      apply_write_item((char *)(node->value),item);
 #endif
       asm volatile("" ::: "memory");
-      node->seq = old_seq + 2;
+      node->seq = applied_seq(old_seq,item);
       asm volatile("" ::: "memory");
       node->lock = 0;
     } // end iterating
-#if !PA
-    char *reply_msg = rpc_handler_->get_reply_buf();
-    rpc_handler_->send_reply(reply_msg,sizeof(uint64_t),nid,cid);
+    // the log is applied (or queued for replay), so its space in the ring can be reused by the primary
+    if(log_mem_ != NULL)
+      log_mem_->consume(nid,rpc_handler_->worker_id_,size);
+    return lsn;
+  }
+
+ public:
+  // enqueue the items which did not fit in the replay queues, append the logs which did not fit
+  // in the durable log, and send the acks whose logs have been made durable
+  void poll_acks() {
+    if(log_replayer != NULL)
+      log_replayer->poll(rpc_handler_->worker_id_);
+#if DURABLE_LOG
+    while(!deferred_.empty()) {
+      auto &d = deferred_.front();
+      uint64_t lsn = durable_log->append(rpc_handler_->worker_id_,d.nid,d.log.data(),d.log.size());
+      if(lsn == 0)
+        break;
+      if(d.lsn_slot != NULL)
+        *d.lsn_slot = lsn;
+      deferred_.pop_front();
+    }
+#endif
+#if DURABLE_LOG_WAIT
+    if(pending_acks_.empty())
+      return;
+    uint64_t durable = durable_log->durable_lsn(rpc_handler_->worker_id_);
+    while(!pending_acks_.empty() && pending_acks_.front().lsn <= durable) {
+      auto &ack = pending_acks_.front();
+#if LOG_ACK_BATCH
+      applied_[ack.nid] = ack.batch_lsn;
+#else
+      char *reply_msg = rpc_handler_->get_reply_buf();
+      rpc_handler_->send_reply(reply_msg,sizeof(uint64_t),ack.nid,ack.cid);
+#endif
+      pending_acks_.pop_front();
+    }
 #endif
   }
  private:
   RRpc *rpc_handler_;
+  LogMemManager *log_mem_;
+#if DURABLE_LOG
+  static const uint64_t UNKNOWN_LSN = UINT64_MAX;
+
+  // a log which waits for space in the durable log's buffer
+  struct DeferredLog {
+    int nid;
+    std::string log;
+    uint64_t *lsn_slot; // the LSN of its pending ack, if any
+  };
+  std::deque<DeferredLog> deferred_;
+
+  // the logs go to the durable log in the order they are received
+  uint64_t durable_append(int nid,const char *msg,uint64_t size) {
+    if(deferred_.empty()) {
+      uint64_t lsn = durable_log->append(rpc_handler_->worker_id_,nid,msg,size);
+      if(lsn != 0)
+        return lsn;
+    }
+    deferred_.push_back({nid,std::string(msg,size),NULL});
+    return UNKNOWN_LSN;
+  }
+#endif
+#if DURABLE_LOG_WAIT
+  struct PendingAck {
+    int nid;
+    int cid;
+    uint64_t lsn;
+    uint64_t batch_lsn; // the sender's LSN of a batch of logs
+  };
+  std::deque<PendingAck> pending_acks_; // references to the elements are stable at push_back/pop_front
+
+  inline void pending_ack(int nid,int cid,uint64_t lsn,uint64_t batch_lsn) {
+    pending_acks_.push_back({nid,cid,lsn,batch_lsn});
+    if(lsn == UNKNOWN_LSN)
+      deferred_.back().lsn_slot = &pending_acks_.back().lsn;
+  }
+#endif
+#if LOG_ACK_BATCH
+  std::vector<uint64_t> applied_;    // per sender
+  std::vector<uint64_t> watermarks_; // per backup
+#endif
 };
 
 }; // namespace rtx
@@ -0,0 +1,165 @@
+#include "durable_log.hpp"
+#include "ts_clock.hpp"
+
+#include "core/logging.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <utility>
+
+namespace nocc {
+
+namespace rtx {
+
+#define DURABLE_ALIGN8(x)  (((x) + 7) & ~((uint64_t)7))
+#define DURABLE_ALIGN_BLOCK(x) (((x) + DURABLE_LOG_BLOCK - 1) & ~((uint64_t)DURABLE_LOG_BLOCK - 1))
+
+DurableLog::DurableLog(const DurableLogConfig &conf,int nid,int num_streams) :
+    conf_(conf),node_id_(nid),num_streams_(num_streams),
+    buffer_size_(conf.buffer_kb * 1024) {
+  ASSERT(conf_.writers > 0) << "durable log needs at least one writer";
+  if(mkdir(conf_.dir.c_str(),0755) != 0 && errno != EEXIST)
+    ASSERT(false) << "cannot create the log dir " << conf_.dir << ": " << strerror(errno);
+
+  streams_ = new Stream[num_streams_];
+  for(int i = 0;i < num_streams_;++i) {
+    streams_[i].active   = (char *)malloc(buffer_size_);
+    streams_[i].flushing = (char *)malloc(buffer_size_);
+    assert(streams_[i].active != NULL && streams_[i].flushing != NULL);
+  }
+  for(int i = 0;i < conf_.writers;++i)
+    writers_.push_back(new Writer(this,i));
+}
+
+void DurableLog::start() {
+  for(auto w : writers_)
+    w->start();
+  LOG(2) << "durable log started with " << writers_.size() << " writers at " << conf_.dir
+         << ", flush interval " << conf_.flush_us << "us.";
+}
+
+uint64_t DurableLog::append(int stream,int from_mac,const char *log,uint32_t size) {
+  Stream &s = streams_[stream];
+  uint64_t len = sizeof(DurableLogHeader) + DURABLE_ALIGN8(size);
+  ASSERT(len <= buffer_size_) << "log of " << size << " bytes exceeds the durable log buffer";
+
+  s.lock.Lock();
+  if(s.active_len + len > buffer_size_) {
+    // the buffer is full; never wait here, the worker is in its RPC handlers
+    s.lock.Unlock();
+    return 0;
+  }
+  DurableLogHeader *header = (DurableLogHeader *)(s.active + s.active_len);
+  header->lsn      = ++s.appended_lsn;
+  header->from_mac = from_mac;
+  header->stream   = stream;
+  header->size     = size;
+  memcpy((char *)header + sizeof(DurableLogHeader),log,size);
+  s.active_len += len;
+  uint64_t lsn = s.appended_lsn;
+  s.lock.Unlock();
+  return lsn;
+}
+
+void DurableLog::report() const {
+  uint64_t flushes = 0,bytes = 0,cycles = 0;
+  for(auto w : writers_) {
+    flushes += w->flushes_;
+    bytes   += w->bytes_;
+    cycles  += w->flush_cycles_;
+  }
+  double flush_us = flushes == 0 ? 0 :
+                    (double)cycles / flushes / TSClock::us_to_cycles(1);
+  LOG(4) << "durable log: " << flushes << " group commits, " << bytes / (1024 * 1024) << "MB written, "
+         << "avg flush latency " << flush_us << "us";
+}
+
+DurableLog::Writer::Writer(DurableLog *log,int id) :
+    ndb_thread(true,"durable-log-writer"),
+    log_(log),id_(id) {
+  int owned = (log_->num_streams_ + log_->conf_.writers - 1) / log_->conf_.writers;
+  io_buf_size_ = DURABLE_ALIGN_BLOCK(owned * log_->buffer_size_) + DURABLE_LOG_BLOCK;
+  if(posix_memalign((void **)&io_buf_,DURABLE_LOG_BLOCK,io_buf_size_) != 0)
+    ASSERT(false) << "failed to allocate the durable log's IO buffer";
+}
+
+void DurableLog::Writer::run() {
+  open_segment();
+  while(true) {
+    usleep(log_->conf_.flush_us);
+    flush();
+  }
+}
+
+void DurableLog::Writer::open_segment() {
+  if(fd_ >= 0)
+    close(fd_);
+  char path[512];
+  snprintf(path,sizeof(path),"%s/rtx-log-n%d-w%d-%d.seg",
+           log_->conf_.dir.c_str(),log_->node_id_,id_,segment_++);
+  fd_ = open(path,O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT,0644);
+  if(fd_ < 0 && errno == EINVAL) {
+    // some file systems (e.g. tmpfs) do not support O_DIRECT
+    LOG(2) << "O_DIRECT is not supported for " << path << ", use buffered IO";
+    fd_ = open(path,O_WRONLY | O_CREAT | O_TRUNC,0644);
+  }
+  ASSERT(fd_ >= 0) << "cannot open log segment " << path << ": " << strerror(errno);
+  file_off_ = 0;
+}
+
+void DurableLog::Writer::flush() {
+  std::vector<std::pair<int,uint64_t> > flushed; // (stream, last lsn)
+  uint64_t len = 0;
+
+  // group the logs of all the owned streams into one write
+  for(int i = id_;i < log_->num_streams_;i += log_->conf_.writers) {
+    Stream &s = log_->streams_[i];
+    s.lock.Lock();
+    if(s.active_len == 0) {
+      s.lock.Unlock();
+      continue;
+    }
+    std::swap(s.active,s.flushing);
+    uint64_t n   = s.active_len;
+    uint64_t lsn = s.appended_lsn;
+    s.active_len = 0;
+    s.lock.Unlock();
+
+    memcpy(io_buf_ + len,s.flushing,n);
+    len += n;
+    flushed.emplace_back(i,lsn);
+  }
+  if(len == 0)
+    return;
+
+  uint64_t padded = DURABLE_ALIGN_BLOCK(len);
+  memset(io_buf_ + len,0,padded - len);
+  if(file_off_ + padded > log_->conf_.segment_mb * 1024 * 1024)
+    open_segment();
+
+  uint64_t begin = ::rdtsc();
+  uint64_t written = 0;
+  while(written < padded) {
+    ssize_t res = pwrite(fd_,io_buf_ + written,padded - written,file_off_ + written);
+    ASSERT(res > 0 || errno == EINTR) << "durable log write error: " << strerror(errno);
+    if(res > 0)
+      written += res;
+  }
+  ASSERT(fdatasync(fd_) == 0) << "durable log sync error: " << strerror(errno);
+  flush_cycles_ += ::rdtsc() - begin;
+  flushes_ += 1;
+  bytes_   += padded;
+  file_off_ += padded;
+
+  asm volatile("" ::: "memory");
+  for(auto &f : flushed)
+    log_->streams_[f.first].durable_lsn = f.second;
+}
+
+} // namespace rtx
+} // namespace nocc
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "core/utils/thread.h"
+#include "util/spinlock.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace nocc {
+
+namespace rtx {
+
+#define DURABLE_LOG_BLOCK 4096 // alignment required by O_DIRECT
+
+struct DurableLogConfig {
+  std::string dir        = "./rtx_log";
+  int         writers    = 1;       // writer threads per node
+  uint64_t    flush_us   = 200;     // group commit interval
+  uint64_t    segment_mb = 256;     // size of a segment file
+  uint64_t    buffer_kb  = 4096;    // staging buffer per worker
+};
+
+/**
+ * A record in the segment files, followed by the log (8 bytes aligned).
+ * A zero header means the rest of the block is padding.
+ */
+struct DurableLogHeader {
+  uint64_t lsn;
+  uint16_t from_mac;
+  uint16_t stream;
+  uint32_t size;
+} __attribute__ ((aligned (8)));
+
+/**
+ * The durable tier of the logs received by a backup.
+ * Each worker appends the logs it receives to its own stream; writer threads
+ * group-commit the streams they own to append-only segment files with O_DIRECT,
+ * every flush interval, and publish the streams' durable LSNs after fdatasync.
+ */
+class DurableLog {
+ public:
+  DurableLog(const DurableLogConfig &conf,int nid,int num_streams);
+
+  void start();
+
+  // called by the worker which owns the stream; returns the LSN of the log (LSNs start from 1),
+  // or 0 if the stream's buffer is full, then the worker shall retry after the writer drains it
+  uint64_t append(int stream,int from_mac,const char *log,uint32_t size);
+
+  inline uint64_t durable_lsn(int stream) const {
+    return streams_[stream].durable_lsn;
+  }
+
+  void report() const;
+
+ private:
+  struct Stream {
+    SpinLock lock;
+    char    *active;      // appended by the worker
+    char    *flushing;    // drained by the writer
+    uint64_t active_len = 0;
+    uint64_t appended_lsn = 0;
+    volatile uint64_t durable_lsn = 0;
+  };
+
+  class Writer : public ndb_thread {
+   public:
+    Writer(DurableLog *log,int id);
+    void run();
+   private:
+    void flush();
+    void open_segment();
+
+    DurableLog *log_;
+    const int   id_;
+    int         fd_ = -1;
+    int         segment_ = 0;
+    uint64_t    file_off_ = 0;
+    char       *io_buf_;
+    uint64_t    io_buf_size_;
+   public:
+    uint64_t    flushes_ = 0;
+    uint64_t    bytes_   = 0;
+    uint64_t    flush_cycles_ = 0;
+  };
+
+  const DurableLogConfig conf_;
+  const int node_id_;
+  const int num_streams_;
+  const uint64_t buffer_size_;
+
+  Stream *streams_;
+  std::vector<Writer *> writers_;
+};
+
+} // namespace rtx
+} // namespace nocc
@@ -0,0 +1,219 @@
+#include "tx_config.h"
+
+#include "failover.hpp"
+#include "global_vars.h"
+#include "log_replayer.hpp"
+#include "ts_clock.hpp"
+
+#include "core/logging.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <set>
+
+namespace nocc {
+
+namespace rtx {
+
+FailoverConfig failover_config;
+
+FailoverManager::FailoverManager(RRpc *rpc,rdmaio::RdmaCtrl *cm,int nid,int total,int nthreads,
+                                 int heartbeat_rpc_id,int view_rpc_id,MemDB *store,char *rdma_base,
+                                 store_lookup_t backed_store) :
+    rpc_(rpc),cm_(cm),node_id_(nid),total_(total),nthreads_(nthreads),
+    heartbeat_rpc_id_(heartbeat_rpc_id),view_rpc_id_(view_rpc_id),
+    store_(store),rdma_base_(rdma_base),
+    backed_store_(backed_store),
+    start_time_(TSClock::local_now()),
+    last_seen_(total,start_time_) {
+  ROCC_BIND_STUB(rpc_,&FailoverManager::heartbeat_handler,this,heartbeat_rpc_id_);
+  ROCC_BIND_STUB(rpc_,&FailoverManager::view_change_handler,this,view_rpc_id_);
+}
+
+void FailoverManager::poll() {
+  uint64_t now = TSClock::local_now();
+  if(unlikely(failover_config.crash_node == node_id_ && failover_config.crash_after_s > 0 &&
+              now - start_time_ > failover_config.crash_after_s * 1000000)) {
+    LOG(4) << "emulate a crash of node " << node_id_;
+    _exit(1);
+  }
+  if(!changes_.empty()) {
+    if(!changing_)
+      start_view_change(changes_.front());
+    if(try_finish_view_change())
+      changes_.pop_front();
+  }
+  if(!promotions_.empty() && !changing_)
+    apply_promotions();
+  if(now < next_heartbeat_)
+    return;
+  next_heartbeat_ = now + failover_config.heartbeat_us;
+
+  std::set<int> others = alive_others();
+  if(others.empty())
+    return;
+  char *msg = rpc_->get_fly_buf(0);
+  *((uint64_t *)msg) = global_view->epoch();
+  rpc_->broadcast_to(msg,heartbeat_rpc_id_,sizeof(uint64_t),0,RRpc::REQ,others);
+
+  // only the coordinator starts a view change, one at a time
+  if(coordinator() != node_id_ || !changes_.empty())
+    return;
+  int failed = -1;
+  for(auto n : others) {
+    if(now - last_seen_[n] > failover_config.timeout_us) {
+      failed = n; // one failure per view change
+      break;
+    }
+  }
+  if(failed < 0)
+    return;
+  ViewChange *change = (ViewChange *)(rpc_->get_fly_buf(0));
+  change->epoch    = global_view->epoch() + 1;
+  change->failed   = failed;
+  change->promoted = -1;
+  others.erase(failed);
+  if(!others.empty())
+    rpc_->broadcast_to((char *)change,view_rpc_id_,sizeof(ViewChange),0,RRpc::REQ,others);
+  changes_.push_back(*change);
+}
+
+std::set<int> FailoverManager::alive_others() const {
+  std::set<int> others;
+  for(int i = 0;i < total_;++i)
+    if(i != node_id_ && global_view->is_alive(i))
+      others.insert(i);
+  return others;
+}
+
+// the lowest alive node which is not suspected
+int FailoverManager::coordinator() const {
+  uint64_t now = TSClock::local_now();
+  for(int i = 0;i < total_;++i) {
+    if(!global_view->is_alive(i))
+      continue;
+    if(i == node_id_ || now - last_seen_[i] <= failover_config.timeout_us)
+      return i;
+  }
+  return node_id_;
+}
+
+void FailoverManager::heartbeat_handler(int id,int cid,char *msg,void *arg) {
+  if(global_view->is_alive(id)) // a fenced node stays out of the view
+    last_seen_[id] = TSClock::local_now();
+}
+
+void FailoverManager::view_change_handler(int id,int cid,char *msg,void *arg) {
+  ViewChange *change = (ViewChange *)msg;
+  if(change->promoted >= 0) {
+    promotions_.push_back({change->epoch,change->promoted,id});
+    return;
+  }
+  uint64_t last = changes_.empty() ? global_view->epoch() : changes_.back().epoch;
+  if(change->epoch > last)
+    changes_.push_back(*change);
+}
+
+void FailoverManager::start_view_change(const ViewChange &change) {
+  change_begin_ = TSClock::local_now();
+  detect_us_ = change_begin_ - last_seen_[change.failed];
+  global_view->halt();
+  changing_ = true;
+}
+
+bool FailoverManager::try_finish_view_change() {
+  if(global_view->quiesced() < nthreads_) {
+    if(TSClock::local_now() - change_begin_ < failover_config.timeout_us)
+      return false;
+    LOG(4) << nthreads_ - global_view->quiesced() << " workers still have TXs in flight, "
+           << "change the view anyway.";
+  }
+  uint64_t epoch = changes_.front().epoch;
+  int failed     = changes_.front().failed;
+
+  // the workers see the node failed before their QPs to it are flushed
+  std::vector<std::pair<int,int> > promoted;
+  global_view->fail(failed,epoch,promoted);
+  fence(failed);
+
+  take_over(promoted,epoch);
+  global_view->resume();
+  changing_ = false;
+
+  change_us_ = TSClock::local_now() - change_begin_;
+  failovers_ += 1;
+  LOG(4) << "node " << failed << " is removed in view " << epoch << ": detected in "
+         << detect_us_ / 1000.0 << "ms, view changed in " << change_us_ / 1000.0 << "ms.";
+  return true;
+}
+
+void FailoverManager::take_over(const std::vector<std::pair<int,int> > &promoted,uint64_t epoch) {
+  std::set<int> absorbed; // the partitions taken over from one node are in one backup store
+  std::set<int> others = alive_others();
+  for(auto &p : promoted) {
+    if(p.second != node_id_)
+      continue;
+    int src = global_view->source_of(p.first);
+    if(absorbed.insert(src).second) {
+      // the backup becomes the primary after all the logs it received are applied
+      if(log_replayer != NULL)
+        log_replayer->drain(rpc_->worker_id_);
+      MemDB *backup = backed_store_(src);
+      ASSERT(backup != NULL) << "no backup store of node " << src;
+      uint64_t records = store_->Absorb(backup,rdma_base_);
+      LOG(4) << "merge " << records << " records backed for node " << src << " in view " << epoch;
+    }
+    global_view->promote(p.first,node_id_);
+    LOG(4) << "take over partition " << p.first << " in view " << epoch;
+
+    ViewChange *change = (ViewChange *)(rpc_->get_fly_buf(0));
+    change->epoch    = epoch;
+    change->failed   = -1;
+    change->promoted = p.first;
+    if(!others.empty())
+      rpc_->broadcast_to((char *)change,view_rpc_id_,sizeof(ViewChange),0,RRpc::REQ,others);
+  }
+}
+
+// a promotion is applied after the view change which removes the last primary
+void FailoverManager::apply_promotions() {
+  uint64_t epoch = global_view->epoch();
+  for(auto it = promotions_.begin();it != promotions_.end();) {
+    if(it->epoch > epoch) {
+      ++it;
+      continue;
+    }
+    // a stale one, e.g. of a node which has failed since, is ignored
+    if(global_view->is_alive(it->node) && global_view->promote(it->pid,it->node))
+      LOG(4) << "partition " << it->pid << " is served by node " << it->node;
+    it = promotions_.erase(it);
+  }
+}
+
+void FailoverManager::fence(int failed) {
+  if(cm_ == NULL)
+    return;
+  struct ibv_qp_attr attr;
+  memset(&attr,0,sizeof(attr));
+  attr.qp_state = IBV_QPS_ERR;
+  for(int tid = 0;tid < nthreads_;++tid) {
+    for(int idx = 0;idx < QP_NUMS;++idx) {
+      rdmaio::Qp *qp = cm_->get_rc_qp(tid,failed,idx);
+      if(qp == NULL || qp->qp == NULL)
+        continue;
+      if(ibv_modify_qp(qp->qp,&attr,IBV_QP_STATE) != 0)
+        LOG(4) << "failed to fence the QP of thread " << tid << " to node " << failed;
+    }
+  }
+}
+
+void FailoverManager::report() const {
+  if(failovers_ == 0)
+    return;
+  LOG(4) << failovers_ << " failovers, the last one took "
+         << (detect_us_ + change_us_) / 1000.0 << "ms ("
+         << detect_us_ / 1000.0 << "ms to detect).";
+}
+
+} // namespace rtx
+} // namespace nocc
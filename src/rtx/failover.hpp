@@ -0,0 +1,114 @@
+#pragma once
+
+#include "view.h"
+
+#include "core/rrpc.h"
+#include "rdmaio.h"
+#include "memstore/memdb.h"
+
+#include <vector>
+#include <deque>
+#include <set>
+#include <functional>
+
+namespace nocc {
+
+namespace rtx {
+
+using namespace oltp;
+
+struct FailoverConfig {
+  bool     enabled      = false;
+  uint64_t heartbeat_us = 10000;   // interval between two heartbeats
+  uint64_t timeout_us   = 200000;  // a node missing heartbeats for this long is failed
+  int      crash_node   = -1;      // emulates a crash of this node ...
+  uint64_t crash_after_s = 0;      // ... after the given seconds
+};
+
+// filled by the runner from config.xml
+extern FailoverConfig failover_config;
+
+/**
+ * Detects failed nodes with heartbeats, and removes them from the view.
+ *
+ * The lowest alive node coordinates a view change, by broadcasting the new epoch
+ * and the failed node. Upon a view change, each node:
+ *  - halts new TXs, and waits for all the workers to finish their TXs in flight
+ *    (at most timeout_us, since a TX may wait for the failed node forever);
+ *  - removes the failed node from the view, and fences it, by moving the RC QPs to it
+ *    to the error state, so that its in-flight one-sided writes are rejected;
+ *    the partitions the failed node served have no primary from now on;
+ *  - merges its backup stores of the partitions it takes over into its own store,
+ *    after the received logs are applied, and promotes itself as their primary;
+ *  - resumes the TXs, and reports the failover time.
+ * The new primary broadcasts each promotion, which the other nodes apply once they are in
+ * the view of it. Until then, the TXs on the partition are dropped (see TXOpBase::route);
+ * afterwards, they are routed to the new primary, locally, with RPCs, or with one-sided reads.
+ * It is driven by one worker's event loop, as the SkewEstimator, so the view changes
+ * are queued and done across the polls.
+ */
+class FailoverManager {
+  struct ViewChange {
+    uint64_t epoch;
+    int      failed;   // the node removed in epoch, or -1 if it is a promotion
+    int      promoted; // the partition the sender serves since epoch, or -1
+  };
+ public:
+  typedef std::function<MemDB *(int)> store_lookup_t;
+
+  // store is the one accessed by the TXs, which is allocated in the RDMA buffer starting at rdma_base
+  FailoverManager(RRpc *rpc,rdmaio::RdmaCtrl *cm,int nid,int total,int nthreads,
+                  int heartbeat_rpc_id,int view_rpc_id,MemDB *store,char *rdma_base,
+                  store_lookup_t backed_store);
+
+  // called in the worker's event loop
+  void poll();
+
+  void report() const;
+
+ private:
+  void heartbeat_handler(int id,int cid,char *msg,void *arg);
+  void view_change_handler(int id,int cid,char *msg,void *arg);
+
+  void start_view_change(const ViewChange &change);
+  bool try_finish_view_change();  // returns true if the queued change is done
+  void take_over(const std::vector<std::pair<int,int> > &promoted,uint64_t epoch);
+  void apply_promotions();
+  void fence(int failed);
+  int  coordinator() const;
+  std::set<int> alive_others() const;
+
+  RRpc *rpc_;
+  rdmaio::RdmaCtrl *cm_;
+  const int node_id_;
+  const int total_;
+  const int nthreads_;
+  const int heartbeat_rpc_id_;
+  const int view_rpc_id_;
+  MemDB *const store_;
+  char  *const rdma_base_;
+  store_lookup_t backed_store_;
+
+  uint64_t start_time_;
+  uint64_t next_heartbeat_ = 0;
+  std::vector<uint64_t> last_seen_;
+
+  std::deque<ViewChange> changes_;         // the front one is in progress if changing_
+  bool     changing_ = false;
+  uint64_t change_begin_ = 0;
+
+  struct Promotion {
+    uint64_t epoch;
+    int      pid;
+    int      node;
+  };
+  std::vector<Promotion> promotions_;      // received, yet not in the view of them
+
+  // statistics
+  int      failovers_ = 0;
+  uint64_t detect_us_ = 0;  // of the last failover
+  uint64_t change_us_ = 0;
+};
+
+} // namespace rtx
+} // namespace nocc
@@ -4,6 +4,7 @@
 #include <map>
 #include <list>
 #include <mutex>
+#include <new>
 #include "msg_format.hpp"
 #include "rwlock.hpp"
 #include "core/rrpc.h"
@@ -30,258 +31,106 @@ struct lock_waiter_t {
 	MemDB* db;
 };
 
+// a waiter in the FIFO queue of one lock
 struct wait_list_node {
-    volatile uint64_t* lock_ptr;
     lock_waiter_t waiter;
     wait_list_node* next = NULL;
-    wait_list_node* prev = NULL;
-    wait_list_node(volatile uint64_t* ptr, lock_waiter_t wait):lock_ptr(ptr),waiter(wait){}
 };
 
+// all the waiters of one lock
+struct lock_wait_queue {
+    volatile uint64_t* lock_ptr = NULL;
+    uint64_t last_seen = 0;      // lock value at the last check of the queue
+    bool dirty = false;          // new waiters since the last check
+    wait_list_node* head = NULL;
+    wait_list_node* tail = NULL;
+    lock_wait_queue* hash_next = NULL;   // next queue in the same bucket
+    lock_wait_queue* active_prev = NULL; // list of non-empty queues
+    lock_wait_queue* active_next = NULL;
+};
+
+// a free-list of objects, allocated in chunks and never returned to the heap
+template <typename T>
+class WaitObjPool {
+public:
+    T* get() {
+        if(free_ == NULL) {
+            T* chunk = new T[kChunk];
+            for(int i = 0;i < kChunk;++i)
+                put(&chunk[i]);
+        }
+        T* res = free_;
+        free_ = *(T**)res;
+        return new (res) T();
+    }
+    void put(T* obj) {
+        *(T**)obj = free_;
+        free_ = obj;
+    }
+private:
+    static const int kChunk = 256;
+    T* free_ = NULL;
+};
+
+/**
+ * Waiters of the locks delegated to one worker (WAITDIE/SUNDIAL with RPC locks).
+ * Waiters are hashed by the lock address into per-lock FIFO queues.
+ * check_to_notify only rescans a queue if its lock word changed or a waiter joined,
+ * so the polling cost is one load per waited lock instead of one pass per waiter.
+ */
 class GlobalLockManager {
 public:
 
 	GlobalLockManager() {
-		waiters = new std::map<volatile uint64_t*, std::vector<lock_waiter_t> >[20];
+		buckets_ = new lock_wait_queue*[LOCK_WAIT_BUCKETS]();
     }
-    int which_worker = -1;
-    wait_list_node* head = NULL;
-    int cnt = 0;
+    int cnt = 0; // number of waiters
+
     inline __attribute__((always_inline))
 	void add_to_waitlist(volatile uint64_t* lock_addr, lock_waiter_t waiter) {
-
-        //LOG(3) << "start at " << waiter.pid << ' ' << waiter.cid << ' ' << waiter.txn_start_time;
-        if(head == NULL) head = new wait_list_node(lock_addr, waiter);
-        else {
-            head->prev = new wait_list_node(lock_addr, waiter);
-            head->prev->next = head;
-            head = head->prev;
-        }
+        lock_wait_queue* q = find_queue(lock_addr);
+        wait_list_node* n = node_pool_.get();
+        n->waiter = waiter;
+        if(q->tail == NULL) q->head = n;
+        else q->tail->next = n;
+        q->tail = n;
+        q->dirty = true;
         cnt++;
     }
-	//inline __attribute__((always_inline))
-	//void add_to_waitlist(volatile uint64_t* lock_addr, lock_waiter_t waiter) {
-    //    if(which_worker == -1) which_worker = waiter.tid;
-    //    assert(waiter.tid == which_worker);
-	//	(waiters[waiter.cid])[lock_addr].push_back(waiter);
-    //    //auto it = waiters->find(lock_addr);
-    //    //if(it == waiters->end()) {
-    //    //   waiters->insert(std::pair<volatile uint64_t*, std::vector<lock_waiter_t> >(lock_addr, std::vector<lock_waiter_t>()));
-    //    //}
-	//	//(*waiters)[lock_addr].push_back(waiter);
-	//}
-    
+
 	inline __attribute__((always_inline))
 	void check_to_notify(int my_worker_id, oltp::RRpc *rpc_) {
-        using namespace rwlock_4_waitdie;
-        if(head == NULL) return;
-        auto iter = head;
-        while(iter != NULL) {
-        //if(waiters[i].size() == 0) continue;
-		uint8_t res = LOCK_SUCCESS_MAGIC;
-			volatile uint64_t* lockptr = iter->lock_ptr;
-            
-			lock_waiter_t& first_waiter = iter->waiter;
-			ASSERT(first_waiter.tid == my_worker_id) << first_waiter.tid << ' ' << my_worker_id;
-
-			char* reply_msg = rpc_->get_reply_buf();
-			size_t more = 0;
-		    switch(first_waiter.type) {
-		      case RTX_REQ_LOCK_READ:
-		      case RTX_REQ_LOCK_WRITE:
-		       	{
-			       	uint64_t my_ts = R_LEASE(first_waiter.txn_start_time);
-			       	if(first_waiter.type == RTX_REQ_LOCK_WRITE) {
-			       		my_ts += 1;
-			       	}
-			        while (true) {
-						volatile uint64_t l = *lockptr;
-						if(l == 0) {
-							if(unlikely(!__sync_bool_compare_and_swap(lockptr, l,
-								my_ts))) {
-								continue;
-							}
-							else {
-								res = LOCK_SUCCESS_MAGIC;
-								goto SUCCESS;	
-							}
-						}
-						else if(my_ts < l) {
-							// goon waiting
-							goto NEXT_ITEM;
-						}
-						else {
-							// LOG(3) << "dengbudao suo";
-							res = LOCK_FAIL_MAGIC;
-							goto SUCCESS;
-						}
-		          	}
-		      	}
-		        break;
-		    case SUNDIAL_REQ_LOCK_READ: { // sundial lock and read
-		    	auto node = local_lookup_op(first_waiter.item.tableid, first_waiter.item.key, first_waiter.db);
-		    	while(true) {
-		    		volatile uint64_t l = *lockptr;
-		    		if(l == 0) {
-		    			if(unlikely(!__sync_bool_compare_and_swap(lockptr, 0, first_waiter.txn_start_time))){
-							//LOG(3) << "fail change lock";
-		    				//continue;
-                            goto NEXT_ITEM;
-						}
-		    			else {
-		    				prepare_buf(reply_msg, &first_waiter.item, first_waiter.db);
-		    				more = first_waiter.item.len + sizeof(SundialResponse);
-		    				// LOG(3) << "dengdao suo";
-		    				res = LOCK_SUCCESS_MAGIC;
-		    				goto SUCCESS;
-		    			}
-		    			goto NEXT_ITEM;
-		    		}
-		    		else if(first_waiter.txn_start_time < l) {
-		    			goto NEXT_ITEM;
-		    		}
-		    		else {
-		    			res = LOCK_FAIL_MAGIC;
-		    			// LOG(3) << "dengbudao suo";
-		    			goto SUCCESS;
-		    		}
-		    	}
-		    }
-            break;
-		      default:
-		        assert(false);
-		    }
-
-SUCCESS:
-	  		*((uint8_t *)reply_msg) = res;
-	  		rpc_->send_reply(reply_msg,sizeof(uint8_t) + more, first_waiter.pid, first_waiter.cid);
-            //LOG(3) << "back to " << first_waiter.pid << ' ' << first_waiter.cid << ' ' << first_waiter.txn_start_time;
-            if(iter->prev != NULL) {
-                iter->prev->next = iter->next;
-                if(iter->next != NULL)
-                    iter->next->prev = iter->prev;
+        lock_wait_queue* q = active_;
+        while(q != NULL) {
+            lock_wait_queue* next = q->active_next;
+            uint64_t l = *(q->lock_ptr);
+            if(q->dirty || l != q->last_seen) {
+                q->dirty = false;
+                q->last_seen = l; // a grant changes the lock, so the queue is checked again
+                wait_list_node* prev = NULL;
+                wait_list_node* iter = q->head;
+                while(iter != NULL) {
+                    wait_list_node* n = iter->next;
+                    ASSERT(iter->waiter.tid == my_worker_id) << iter->waiter.tid << ' ' << my_worker_id;
+                    if(try_notify(q->lock_ptr, iter->waiter, rpc_)) {
+                        if(prev == NULL) q->head = n;
+                        else prev->next = n;
+                        if(q->tail == iter) q->tail = prev;
+                        node_pool_.put(iter);
+                        --cnt;
+                        assert(cnt >= 0);
+                    } else
+                        prev = iter;
+                    iter = n;
+                }
+                if(q->head == NULL)
+                    remove_queue(q);
             }
-            else {
-                assert(iter == head);
-                head = head->next;
-                if(head != NULL)
-                    head->prev = NULL;
-            }
-            --cnt;
-            assert(cnt >=0);
-NEXT_ITEM:
-            iter = iter->next;
-    }
+            q = next;
+        }
     }
 
-	//inline __attribute__((always_inline))
-	//void check_to_notify(int my_worker_id, oltp::RRpc *rpc_) {
-	//using namespace rwlock_4_waitdie;
-	//if(waiters == NULL) return;
-    //for(int i = 0; i < 20; ++i){
-    //    if(waiters[i].size() == 0) continue;
-	//	uint8_t res = LOCK_SUCCESS_MAGIC;
-	//	for (auto itr = waiters[i].begin(); itr != waiters[i].end(); ) {
-	//		volatile uint64_t* lockptr = itr->first;
-	//		//assert(itr->second.size() > 0);
-    //        //LOG(3)<<waiters->size();
-    //        if(itr->second.size() == 0) {
-    //            //itr++;
-    //            //waiters->erase(itr++);
-    //            itr = waiters[i].erase(itr);
-    //            //continue;
-    //            break;
-    //        }
-	//		lock_waiter_t& first_waiter = *(itr->second.begin());
-	//		ASSERT(first_waiter.tid == my_worker_id) << first_waiter.tid << ' ' << my_worker_id;
-
-	//		char* reply_msg = rpc_->get_reply_buf();
-	//		size_t more = 0;
-	//	    switch(first_waiter.type) {
-	//	      case RTX_REQ_LOCK_READ:
-	//	      case RTX_REQ_LOCK_WRITE:
-	//	       	{
-	//		       	uint64_t my_ts = R_LEASE(first_waiter.txn_start_time);
-	//		       	if(first_waiter.type == RTX_REQ_LOCK_WRITE) {
-	//		       		my_ts += 1;
-	//		       	}
-	//		        while (true) {
-	//					volatile uint64_t l = *lockptr;
-	//					if(l == 0) {
-	//						if(unlikely(!__sync_bool_compare_and_swap(lockptr, l,
-	//							my_ts))) {
-	//							continue;
-	//						}
-	//						else {
-	//							res = LOCK_SUCCESS_MAGIC;
-	//							goto SUCCESS;	
-	//						}
-	//					}
-	//					else if(my_ts < l) {
-	//						// goon waiting
-	//						goto NEXT_ITEM;
-	//					}
-	//					else {
-	//						// LOG(3) << "dengbudao suo";
-	//						res = LOCK_FAIL_MAGIC;
-	//						goto SUCCESS;
-	//					}
-	//	          	}
-	//	      	}
-	//	        break;
-	//	    case SUNDIAL_REQ_LOCK_READ: { // sundial lock and read
-	//	    	auto node = local_lookup_op(first_waiter.item.tableid, first_waiter.item.key, first_waiter.db);
-	//	    	while(true) {
-	//	    		volatile uint64_t l = *lockptr;
-	//	    		if(l == 0) {
-	//	    			if(unlikely(!__sync_bool_compare_and_swap(lockptr, 0, first_waiter.txn_start_time))){
-	//						LOG(3) << "fail change lock";
-	//	    				//continue;
-    //                        goto NEXT_ITEM;
-	//					}
-	//	    			else {
-	//	    				prepare_buf(reply_msg, &first_waiter.item, first_waiter.db);
-	//	    				more = first_waiter.item.len + sizeof(SundialResponse);
-	//	    				// LOG(3) << "dengdao suo";
-	//	    				res = LOCK_SUCCESS_MAGIC;
-	//	    				goto SUCCESS;
-	//	    			}
-	//	    			goto NEXT_ITEM;
-	//	    		}
-	//	    		else if(first_waiter.txn_start_time < l) {
-	//	    			goto NEXT_ITEM;
-	//	    		}
-	//	    		else {
-	//	    			res = LOCK_FAIL_MAGIC;
-	//	    			// LOG(3) << "dengbudao suo";
-	//	    			goto SUCCESS;
-	//	    		}
-	//	    	}
-	//	    }
-    //        break;
-	//	      default:
-	//	        assert(false);
-	//	    }
-
-//SUCCESS:
-	//  		*((uint8_t *)reply_msg) = res;
-	//  		rpc_->send_reply(reply_msg,sizeof(uint8_t) + more, first_waiter.pid, first_waiter.cid);
-    //        //LOG(3) << "back to " << first_waiter.pid << ' ' << first_waiter.cid << ' ' << first_waiter.
-    //        itr->second.begin()->pid = -1;
-	//		itr->second.erase(itr->second.begin());
-//NEXT_ITEM:
-	//		//if (itr->second.empty()) {
-	//		//	itr = waiters->erase(itr);
-	//		//} else {
-	//		//	++itr;
-	//		//}
-    //        itr++;
-	//	}
-	//}
-    //}
 	void thread_local_init() {
-		//waiters = new std::map<volatile uint64_t*, std::vector<lock_waiter_t> >();
-
 	}
 #include "occ_internal_structure.h"
 private:
@@ -321,14 +170,102 @@ private:
 
 
 
-public:
-	// a map from the lock addr to a vector of waiters.
-	std::map<volatile uint64_t*, std::vector<lock_waiter_t> >* waiters = NULL;
-	// static std::mutex* mtx;
+	static const int LOCK_WAIT_BUCKETS = 1024;
+
+	inline int bucket_of(volatile uint64_t* lock_addr) const {
+		return (int)((((uint64_t)lock_addr >> 3) * 0x9E3779B97F4A7C15ULL) >> 54); // 10 bits
+	}
+
+	lock_wait_queue* find_queue(volatile uint64_t* lock_addr) {
+		int b = bucket_of(lock_addr);
+		for(lock_wait_queue* q = buckets_[b];q != NULL;q = q->hash_next) {
+			if(q->lock_ptr == lock_addr)
+				return q;
+		}
+		lock_wait_queue* q = queue_pool_.get();
+		q->lock_ptr = lock_addr;
+		q->hash_next = buckets_[b];
+		buckets_[b] = q;
+		q->active_next = active_;
+		if(active_ != NULL) active_->active_prev = q;
+		active_ = q;
+		return q;
+	}
+
+	void remove_queue(lock_wait_queue* q) {
+		lock_wait_queue** pp = &buckets_[bucket_of(q->lock_ptr)];
+		while(*pp != q)
+			pp = &((*pp)->hash_next);
+		*pp = q->hash_next;
+		if(q->active_prev != NULL) q->active_prev->active_next = q->active_next;
+		else active_ = q->active_next;
+		if(q->active_next != NULL) q->active_next->active_prev = q->active_prev;
+		queue_pool_.put(q);
+	}
+
+	// try to acquire the lock for the waiter; returns true if the waiter is replied
+	bool try_notify(volatile uint64_t* lockptr, lock_waiter_t& waiter, oltp::RRpc *rpc_) {
+		using namespace rwlock_4_waitdie;
+		uint8_t res = LOCK_SUCCESS_MAGIC;
+		char* reply_msg = rpc_->get_reply_buf();
+		size_t more = 0;
+		switch(waiter.type) {
+		  case RTX_REQ_LOCK_READ:
+		  case RTX_REQ_LOCK_WRITE: {
+			uint64_t my_ts = R_LEASE(waiter.txn_start_time);
+			if(waiter.type == RTX_REQ_LOCK_WRITE) {
+				my_ts += 1;
+			}
+			while (true) {
+				volatile uint64_t l = *lockptr;
+				if(l == 0) {
+					if(unlikely(!__sync_bool_compare_and_swap(lockptr, l, my_ts)))
+						continue;
+					res = LOCK_SUCCESS_MAGIC;
+					break;
+				}
+				else if(my_ts < l) {
+					// goon waiting
+					return false;
+				}
+				else {
+					res = LOCK_FAIL_MAGIC;
+					break;
+				}
+			}
+		  }
+			break;
+		  case SUNDIAL_REQ_LOCK_READ: { // sundial lock and read
+			volatile uint64_t l = *lockptr;
+			if(l == 0) {
+				if(unlikely(!__sync_bool_compare_and_swap(lockptr, 0, waiter.txn_start_time)))
+					return false;
+				prepare_buf(reply_msg, &waiter.item, waiter.db);
+				more = waiter.item.len + sizeof(SundialResponse);
+				res = LOCK_SUCCESS_MAGIC;
+			}
+			else if(waiter.txn_start_time < l) {
+				return false;
+			}
+			else {
+				res = LOCK_FAIL_MAGIC;
+			}
+		  }
+			break;
+		  default:
+			assert(false);
+		}
+		*((uint8_t *)reply_msg) = res;
+		rpc_->send_reply(reply_msg,sizeof(uint8_t) + more, waiter.pid, waiter.cid);
+		return true;
+	}
 
-	// the set of lock addresses each thread needs to keep an eye on.
-	// thread_local static std::map<volatile uint64_t*, waiter_t*>* locks_to_check;
+	lock_wait_queue** buckets_ = NULL;
+	lock_wait_queue*  active_  = NULL;
+	WaitObjPool<wait_list_node>  node_pool_;
+	WaitObjPool<lock_wait_queue> queue_pool_;
 
+public:
 	bool prepare_buf(char* reply_msg, RTXSundialReadItem *item, MemDB* db) {
 		char* reply = reply_msg + 1;
 		uint64_t seq;
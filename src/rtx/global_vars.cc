@@ -5,5 +5,11 @@ namespace rtx {
 
 SymmetricView *global_view = NULL;
 GlobalLockManager *global_lock_manager = NULL;
+
+CalvinMemManager *calvin_mem = NULL;
+CalvinScheduler  *calvin_scheduler = NULL;
+
+DurableLog *durable_log = NULL;
+LogReplayer *log_replayer = NULL;
 }
 }
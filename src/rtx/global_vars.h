@@ -9,6 +9,11 @@ namespace nocc {
 
 namespace rtx {
 
+class CalvinMemManager;
+class CalvinScheduler;
+class DurableLog;
+class LogReplayer;
+
 /**
  * New meta data for each record
  */
@@ -23,6 +28,16 @@ struct MVCCHeader {
 extern SymmetricView *global_view;
 extern GlobalLockManager *global_lock_manager;
 
+// CALVIN's RDMA rings and the per-node lock scheduler, only used by CALVIN_TX
+extern CalvinMemManager *calvin_mem;
+extern CalvinScheduler  *calvin_scheduler;
+
+// the durable tier of the received logs, only used if DURABLE_LOG
+extern DurableLog *durable_log;
+
+// the replay threads of the backup stores; if NULL, the log cleaners apply the logs inline
+extern LogReplayer *log_replayer;
+
 //extern int ycsb_set_length;
 //extern int ycsb_write_num;
 
@@ -1,5 +1,6 @@
 #include "tx_config.h"
 #include "msg_format.hpp"
+#include "global_vars.h"
 
 #include <utility> // for forward
 
@@ -44,6 +45,29 @@ MemNode * TXOpBase::local_get_op(int tableid,uint64_t key,char *val,int len,uint
   return local_get_op(node,val,seq,len,meta);
 }
 
+inline __attribute__((always_inline))
+int TXOpBase::route(int pid) {
+  int nid = global_view->primary_of(pid);
+  if(unlikely(nid < 0))
+    unavailable_ = true;
+  return nid;
+}
+
+inline char *TXOpBase::unavailable_val(size_t len) {
+  ASSERT(len <= kUnavailableValSize) << "record of " << len << " bytes";
+  memset(unavailable_val_,0,len);
+  return unavailable_val_;
+}
+
+inline __attribute__((always_inline))
+char *TXOpBase::local_replicated_get(int tableid,uint64_t key,int len,char *val) {
+  if(val == NULL)
+    val = (char *)malloc(len);
+  uint64_t seq;
+  local_get_op(tableid,key,val,len,seq,db_->_schemas[tableid].meta_len);
+  return val;
+}
+
 inline __attribute__((always_inline))
 MemNode *TXOpBase::local_insert_op(int tableid,uint64_t key,uint64_t &seq) {
   assert(false);
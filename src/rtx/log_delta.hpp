@@ -0,0 +1,136 @@
+#pragma once
+
+#include "tx_config.h"
+#include "msg_format.hpp"
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+namespace nocc {
+
+namespace rtx {
+
+/**
+ * Delta encoding of the write items in the logs.
+ * The payload of a delta item is a sequence of runs, each is a RtxDeltaRun followed
+ * by the len new bytes at offset off of the record.
+ */
+struct RtxDeltaRun {
+  uint16_t off;
+  uint16_t len;
+} __attribute__ ((packed));
+
+/**
+ * Encodes val against the read image into out.
+ * Records are compared in words; a run ends at an unchanged word, since skipping a word
+ * saves more bytes than the header of the next run costs.
+ * Returns the encoded size, or -1 if it is not smaller than shipping the full record.
+ */
+inline int encode_delta(char *out,const char *val,const char *image,int len) {
+  const int word = sizeof(uint64_t);
+  int size = 0;
+  int i = 0;
+  while(i < len) {
+    int w = std::min(word,len - i);
+    if(memcmp(val + i,image + i,w) == 0) {
+      i += w;
+      continue;
+    }
+    int start = i;
+    for(;i < len;i += w) {
+      w = std::min(word,len - i);
+      if(memcmp(val + i,image + i,w) == 0)
+        break;
+    }
+    RtxDeltaRun run = {(uint16_t)start,(uint16_t)(i - start)};
+    if(size + (int)sizeof(RtxDeltaRun) + run.len >= len)
+      return -1;
+    memcpy(out + size,&run,sizeof(RtxDeltaRun));
+    memcpy(out + size + sizeof(RtxDeltaRun),val + start,run.len);
+    size += sizeof(RtxDeltaRun) + run.len;
+  }
+  return size;
+}
+
+inline void apply_delta(char *dst,const char *runs,int size) {
+  const char *end = runs + size;
+  while(runs < end) {
+    RtxDeltaRun run;
+    memcpy(&run,runs,sizeof(RtxDeltaRun));
+    runs += sizeof(RtxDeltaRun);
+    memcpy(dst + run.off,runs,run.len);
+    runs += run.len;
+  }
+}
+
+/**
+ * A delta is only correct for a backup record which equals the read image it is encoded against.
+ * So the items of a delta log are tagged with the seqs of their read images, and the backup
+ * applies a delta only if its record is at the same seq; the backups' seqs follow the
+ * primaries', since both start from the loaded records and add 2 per write.
+ * Otherwise the backup has missed a write of the record, and rejects the delta.
+ * A full record always applies, and re-bases the backup's seq on the primary's.
+ * The seqs are compared in their low 32 bits, which fit in the item's padding.
+ */
+inline bool write_item_applies(uint64_t seq,const RtxWriteItem *item) {
+  return !item->delta || (item->based && (uint32_t)seq == item->base_seq);
+}
+
+// the seq of a backup record at seq, after item is applied
+inline uint64_t applied_seq(uint64_t seq,const RtxWriteItem *item) {
+  if(item->based)
+    seq = (seq & ~(uint64_t)UINT32_MAX) | item->base_seq;
+  return seq + 2;
+}
+
+// the number of the deltas rejected by the backups of this node
+inline volatile uint64_t &rejected_deltas() {
+  static volatile uint64_t num = 0;
+  return num;
+}
+
+// applies a (full or delta) write item of the log to the record's value
+inline void apply_write_item(char *dst,RtxWriteItem *item) {
+  char *payload = (char *)item + sizeof(RtxWriteItem);
+  if(item->delta)
+    apply_delta(dst,payload,item->len);
+  else
+    memcpy(dst,payload,item->len);
+}
+
+/**
+ * The read images of a TX's write set, kept before the TX modifies the records.
+ * Images are copied into one buffer which is reused across TXs.
+ */
+class WriteImages {
+ public:
+  inline void clear() {
+    offs_.clear();
+    buf_.clear();
+  }
+
+  // keeps the image of write set item idx, if it is not kept yet
+  inline void keep(int idx,const char *val,int len) {
+    if(idx < (int)offs_.size() && offs_[idx] != 0)
+      return;
+    if(idx >= (int)offs_.size())
+      offs_.resize(idx + 1,0);
+    offs_[idx] = buf_.size() + 1;
+    buf_.insert(buf_.end(),val,val + len);
+  }
+
+  // returns NULL if the item has no read image, e.g. an insert
+  inline const char *get(int idx) const {
+    if(idx >= (int)offs_.size() || offs_[idx] == 0)
+      return NULL;
+    return buf_.data() + offs_[idx] - 1;
+  }
+
+ private:
+  std::vector<uint64_t> offs_; // offset + 1 of each image in buf_; 0 means not kept
+  std::vector<char>     buf_;
+};
+
+} // namespace rtx
+} // namespace nocc
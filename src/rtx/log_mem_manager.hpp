@@ -11,6 +11,19 @@ namespace rtx {
 // The default size of each log entry
 #define RTX_LOG_ENTRY_SIZE 2048
 
+// Each consumed head occupies a cache line, since they are updated by different threads
+#define RTX_LOG_HEAD_SIZE  64
+
+/**
+ * The log area is organized as one ring per (primary mac, thread) at each backup.
+ * After all the rings, there are two head areas:
+ *  - the consumed heads of the rings, updated by the backup after it has applied the logs,
+ *    and read by the primaries with one-sided READs;
+ *  - the primaries' cached copies of the heads of their remote rings, used as local READ buffers.
+ * A primary can append to a ring only if it has enough credits,
+ * i.e. it will not overwrite the logs which the backup has not consumed.
+ */
+
 class LogMemManager {
  public:
   LogMemManager(char *local_p,int ms,int ts,int size,int entry_size = RTX_LOG_ENTRY_SIZE,uint64_t base_off = 0) :
@@ -41,7 +54,48 @@ class LogMemManager {
   }
 
   inline uint64_t total_log_size() {
-    return total_mac_log_size_ * mac_num_;
+    return total_mac_log_size_ * mac_num_ + 2 * head_area_size();
+  }
+
+  inline uint64_t ring_size() const {
+    return thread_buf_size_ - log_entry_size_;
+  }
+
+  // the free space of the ring at to_mid, according to its last known head
+  inline int64_t credits(int from_tid,int to_mid) {
+    return (int64_t)ring_size() - (int64_t)(remote_tailers_[to_mid] - cached_head(from_tid,to_mid));
+  }
+
+  inline bool has_credits(int from_tid,int to_mid,int log_size) {
+    return credits(from_tid,to_mid) >= log_size;
+  }
+
+  // offset of the consumed head of ring (from_mac,from_tid) at the backup
+  inline uint64_t remote_head_offset(int from_mac,int from_tid) {
+    return base_offset_ + head_offset(from_mac,from_tid);
+  }
+
+  // local buffer to read the head of the ring at to_mid
+  inline char *cached_head_ptr(int from_tid,int to_mid) {
+    return (char *)local_buffer_ + head_area_size() + head_offset(to_mid,from_tid);
+  }
+
+  inline uint64_t cached_head(int from_tid,int to_mid) {
+    return *((volatile uint64_t *)cached_head_ptr(from_tid,to_mid));
+  }
+
+  // called by the backup after the logs of ring (from_mac,from_tid) are applied
+  inline void consume(int from_mac,int from_tid,int log_size) {
+    volatile uint64_t *head = (volatile uint64_t *)((char *)local_buffer_ + head_offset(from_mac,from_tid));
+    *head = *head + log_size;
+  }
+
+  // clear the heads owned by thread tid, before any log is sent
+  inline void reset_heads(int tid) {
+    for(uint i = 0;i < mac_num_;++i) {
+      *((uint64_t *)((char *)local_buffer_ + head_offset(i,tid))) = 0;
+      *((uint64_t *)cached_head_ptr(tid,i)) = 0;
+    }
   }
 
 
@@ -104,6 +158,15 @@ class LogMemManager {
   uint64_t *local_headers_  = NULL;
 
   uint64_t base_offset_;
+
+  inline uint64_t head_area_size() const {
+    return (uint64_t)mac_num_ * thread_num_ * RTX_LOG_HEAD_SIZE;
+  }
+
+  // heads are placed after the rings
+  inline uint64_t head_offset(int mac,int tid) const {
+    return (uint64_t)total_mac_log_size_ * mac_num_ + (mac * thread_num_ + tid) * RTX_LOG_HEAD_SIZE;
+  }
 };
 }; // namespace rtx
 
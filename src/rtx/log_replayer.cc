@@ -0,0 +1,160 @@
+#include "log_replayer.hpp"
+#include "log_delta.hpp"
+
+#include "core/logging.h"
+#include "port/atomic.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace nocc {
+
+namespace rtx {
+
+#define REPLAY_ALIGN8(x) (((x) + 7) & ~((uint64_t)7))
+
+ReplayQueue::ReplayQueue() {
+  // the tail room ensures a skip mark always fits at the end
+  buf_ = (char *)malloc(REPLAY_QUEUE_SIZE + sizeof(Entry));
+  assert(buf_ != NULL);
+}
+
+bool ReplayQueue::push(MemDB *store,RtxWriteItem *item,volatile uint64_t *tickets) {
+  uint64_t size = REPLAY_ALIGN8(sizeof(Entry) + sizeof(RtxWriteItem) + item->len);
+  ASSERT(size <= REPLAY_QUEUE_SIZE) << "write item of " << item->len << " bytes exceeds the replay queue";
+
+  uint64_t off  = tail_ % REPLAY_QUEUE_SIZE;
+  uint64_t skip = (off + size > REPLAY_QUEUE_SIZE) ? REPLAY_QUEUE_SIZE - off : 0;
+  if(tail_ + skip + size - head_ > REPLAY_QUEUE_SIZE)
+    return false; // wait for the replayer
+
+  if(skip > 0) {
+    ((Entry *)(buf_ + off))->size = 0;
+    off = 0;
+  }
+  Entry *e = (Entry *)(buf_ + off);
+  e->store  = store;
+  e->ticket = __sync_fetch_and_add(tickets,1);
+  e->size   = size;
+  memcpy((char *)e + sizeof(Entry),item,sizeof(RtxWriteItem) + item->len);
+  asm volatile("" ::: "memory");
+  tail_ = tail_ + skip + size;
+  return true;
+}
+
+LogReplayer::LogReplayer(int num_replayers,int num_producers) :
+    num_replayers_(num_replayers),
+    num_producers_(num_producers),
+    queues_(new ReplayQueue[num_replayers * num_producers]),
+    tickets_(new Ticket[num_replayers]),
+    deferred_(new Deferred[num_producers]) {
+  ASSERT(num_replayers_ > 0);
+  for(int i = 0;i < num_replayers_;++i)
+    replayers_.push_back(new Replayer(this,i));
+}
+
+void LogReplayer::start() {
+  for(auto r : replayers_)
+    r->start();
+  LOG(2) << "log replayer started with " << num_replayers_ << " threads.";
+}
+
+void LogReplayer::poll(int producer) {
+  auto &deferred = deferred_[producer].items;
+  int n = 0;
+  while(!deferred.empty()) {
+    auto &d = deferred.front();
+    if(!push(producer,d.store,(RtxWriteItem *)(d.item.data())))
+      break;
+    deferred.pop_front();
+    n += 1;
+  }
+  if(n > 0)
+    __sync_fetch_and_sub(&deferred_num_,n);
+}
+
+void LogReplayer::drain(int producer) {
+  while(deferred_num_ > 0) {
+    poll(producer);
+    cpu_relax();
+  }
+  for(int i = 0;i < num_replayers_ * num_producers_;++i) {
+    while(!queues_[i].empty())
+      cpu_relax();
+  }
+}
+
+void LogReplayer::report() const {
+  uint64_t applied = 0;
+  for(auto r : replayers_)
+    applied += r->applied_;
+  LOG(4) << "log replayer applied " << applied << " write items.";
+}
+
+LogReplayer::Replayer::Replayer(LogReplayer *r,int id) :
+    ndb_thread(true,"log-replayer"),
+    replayer_(r),id_(id) {
+  alloc_value(0); // preallocate the first chunk of value buffers
+}
+
+void LogReplayer::Replayer::run() {
+  ReplayQueue *queues = replayer_->queues_ + id_ * replayer_->num_producers_;
+  while(true) {
+    int n = 0;
+    for(int i = 0;i < replayer_->num_producers_;++i) {
+      // an item is applied after all the items enqueued before it; a missing ticket is being
+      // pushed by its producer, and shows up shortly
+      ReplayQueue::Entry *e;
+      while((e = queues[i].front()) != NULL && e->ticket == next_ticket_) {
+        apply(e->store,e->item());
+        queues[i].pop(e);
+        next_ticket_ += 1;
+        n += 1;
+      }
+    }
+    if(n == 0)
+      cpu_relax();
+    applied_ += n;
+  }
+}
+
+void LogReplayer::Replayer::apply(MemDB *store,RtxWriteItem *item) {
+  MemNode *node = store->stores_[item->tableid]->GetWithInsert((uint64_t)(item->key));
+
+  // the replayer is the only writer of the record, so only the seqlock is kept for readers
+  uint64_t old_seq = node->seq;
+  if(unlikely(!write_item_applies(old_seq,item))) {
+    __sync_fetch_and_add(&rejected_deltas(),1);
+    return;
+  }
+  node->seq = 1;
+  asm volatile("" ::: "memory");
+#if EM_FASST || INLINE_OVERWRITE
+  apply_write_item((char *)(node->padding),item);
+#else
+  if(unlikely(node->value == NULL)) {
+    ASSERT(!item->delta) << "delta log of a missing record, table " << (int)item->tableid;
+    node->value = (uint64_t *)alloc_value(item->len);
+  }
+  apply_write_item((char *)(node->value),item);
+#endif
+  asm volatile("" ::: "memory");
+  node->seq = applied_seq(old_seq,item);
+}
+
+char *LogReplayer::Replayer::alloc_value(int size) {
+  uint64_t sz = REPLAY_ALIGN8(size);
+  if(unlikely(arena_left_ < sz || arena_ == NULL)) {
+    arena_ = (char *)malloc(REPLAY_ARENA_CHUNK);
+    assert(arena_ != NULL);
+    memset(arena_,0,REPLAY_ARENA_CHUNK); // fault in the pages before replaying
+    arena_left_ = REPLAY_ARENA_CHUNK;
+  }
+  char *res = arena_;
+  arena_ += sz;
+  arena_left_ -= sz;
+  return res;
+}
+
+} // namespace rtx
+} // namespace nocc
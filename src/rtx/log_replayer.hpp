@@ -0,0 +1,164 @@
+#pragma once
+
+#include "all.h"
+#include "tx_config.h"
+
+#include "core/utils/thread.h"
+#include "memstore/memdb.h"
+
+#include "msg_format.hpp"
+
+#include <vector>
+#include <deque>
+#include <string>
+
+namespace nocc {
+
+namespace rtx {
+
+#define REPLAY_QUEUE_SIZE  (4 * 1024 * 1024)  // bytes of each (producer,replayer) queue
+#define REPLAY_ARENA_CHUNK (64 * 1024 * 1024) // value buffers are carved from chunks of this size
+
+/**
+ * A single-producer single-consumer byte ring, which passes write items
+ * from a log cleaner to a replay thread.
+ * Each entry carries a ticket of its replay thread, taken when it is pushed.
+ */
+class ReplayQueue {
+ public:
+  struct Entry {
+    MemDB   *store;
+    uint64_t ticket;
+    uint32_t size;   // total size of the entry; 0 means the rest of the ring is skipped
+    uint32_t padding;
+
+    inline RtxWriteItem *item() { return (RtxWriteItem *)((char *)this + sizeof(Entry)); }
+  };
+
+  ReplayQueue();
+
+  // called by the producer; returns false if the queue is full, otherwise takes the entry's
+  // ticket from tickets
+  bool push(MemDB *store,RtxWriteItem *item,volatile uint64_t *tickets);
+
+  inline bool empty() const {
+    return head_ == tail_;
+  }
+
+  // called by the consumer; returns the oldest entry, or NULL if the queue is empty
+  inline Entry *front() {
+    while(head_ != tail_) {
+      asm volatile("" ::: "memory");
+      Entry *e = (Entry *)(buf_ + head_ % REPLAY_QUEUE_SIZE);
+      if(e->size != 0)
+        return e;
+      head_ += REPLAY_QUEUE_SIZE - head_ % REPLAY_QUEUE_SIZE; // wrapped
+    }
+    return NULL;
+  }
+
+  inline void pop(Entry *e) {
+    asm volatile("" ::: "memory");
+    head_ += e->size;
+  }
+
+ private:
+  char *buf_;
+  // head_ and tail_ are on different cache lines; they are padded rather than aligned,
+  // since the queues are allocated with new[]
+  char pad0_[CACHE_LINE_SZ];
+  volatile uint64_t head_ = 0; // consumed by the replayer
+  char pad1_[CACHE_LINE_SZ];
+  volatile uint64_t tail_ = 0; // appended by the cleaner
+  char pad2_[CACHE_LINE_SZ];
+};
+
+/**
+ * Applies the logs received by a backup with dedicated replay threads.
+ * The log cleaners parse each log once, and partition its write items by (table,key)
+ * onto the replay threads. Since each key has a single replay thread, the items are applied
+ * without locking the records, and the value buffers are carved from per-thread arenas.
+ * The items of a key may be received by different cleaners, so a replay thread applies the
+ * items of all its queues in the order of their tickets, i.e. the order they are enqueued,
+ * which is the order the logs are applied without the replayer.
+ * A cleaner does not wait for a full queue in its RPC handler: the item is deferred, as well as
+ * the items it receives after it, and they are enqueued in order by its later polls.
+ */
+class LogReplayer {
+ public:
+  LogReplayer(int num_replayers,int num_producers);
+
+  void start();
+
+  // called by the log cleaner of worker producer
+  inline void enqueue(int producer,MemDB *store,RtxWriteItem *item) {
+    auto &deferred = deferred_[producer].items;
+    if(deferred.empty() && push(producer,store,item))
+      return;
+    deferred.push_back({store,std::string((char *)item,sizeof(RtxWriteItem) + item->len)});
+    __sync_fetch_and_add(&deferred_num_,1);
+  }
+
+  // called in the event loop of worker producer; enqueues its deferred items
+  void poll(int producer);
+
+  // wait until all the queued and deferred items are applied; called by worker producer,
+  // whose deferred items are enqueued meanwhile
+  void drain(int producer);
+
+  void report() const;
+
+ private:
+  inline int partition(int tableid,uint64_t key) const {
+    uint64_t h = (key ^ ((uint64_t)tableid << 56)) * 0x9E3779B97F4A7C15ULL;
+    return (h >> 32) % num_replayers_;
+  }
+
+  inline bool push(int producer,MemDB *store,RtxWriteItem *item) {
+    int r = partition(item->tableid,item->key);
+    return queues_[r * num_producers_ + producer].push(store,item,&tickets_[r].next);
+  }
+
+  class Replayer : public ndb_thread {
+   public:
+    Replayer(LogReplayer *r,int id);
+    void run();
+   private:
+    void apply(MemDB *store,RtxWriteItem *item);
+    char *alloc_value(int size);
+
+    LogReplayer *replayer_;
+    const int id_;
+    char    *arena_ = NULL;
+    uint64_t arena_left_ = 0;
+    uint64_t next_ticket_ = 0;
+   public:
+    volatile uint64_t applied_ = 0;
+  };
+
+  struct Ticket {
+    volatile uint64_t next = 0;
+    char padding[CACHE_LINE_SZ - sizeof(uint64_t)];
+  };
+
+  const int num_replayers_;
+  const int num_producers_;
+  // the items waiting for room in the queues, only accessed by their producer
+  struct Deferred {
+    struct Item {
+      MemDB      *store;
+      std::string item;
+    };
+    std::deque<Item> items;
+    char padding[CACHE_LINE_SZ];
+  };
+
+  ReplayQueue *queues_;  // replayer-major
+  Ticket      *tickets_; // per replayer
+  Deferred    *deferred_; // per producer
+  volatile uint64_t deferred_num_ = 0;
+  std::vector<Replayer *> replayers_;
+};
+
+} // namespace rtx
+} // namespace nocc
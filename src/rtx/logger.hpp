@@ -9,6 +9,20 @@
 #include "log_mem_manager.hpp"
 #include "default_log_cleaner_impl.hpp"
 
+#if LOG_ACK_BATCH || EPOCH_COMMIT
+#include "ts_clock.hpp"
+#include <vector>
+#endif
+
+#if LOG_ACK_BATCH
+#define RTX_ACK_BATCH_BUFS 4 // send buffers of the ack batch to each backup
+#endif
+
+#if EPOCH_COMMIT
+#include "core/rworker.h"
+#define RTX_EPOCH_MAX_ITEMS 127 // bounded by RTXRequestHeader::num
+#endif
+
 namespace nocc {
 
 namespace rtx {
@@ -31,13 +45,35 @@ class Logger {
   Logger(RRpc *rpc,int ack_rpc_id,uint64_t base_off,
          int expected_store_num,char *local_p,int ms,int ts,int size,int entry_size = RTX_LOG_ENTRY_SIZE):
       mem_(local_p,ms,ts,size,entry_size,base_off),
-      cleaner_(expected_store_num,rpc),
+      cleaner_(expected_store_num,rpc,&mem_),
       rpc_handler_(rpc),
       ack_rpc_id_(ack_rpc_id),
       reply_buf_((char *)malloc(ms * sizeof(uint64_t)))
 
   {
+    mem_.reset_heads(rpc->worker_id_);
     cleaner_.register_callback(ack_rpc_id_,rpc_handler_);
+#if LOG_ACK_BATCH
+    cleaner_.init_watermarks(ms);
+    cleaner_.register_watermark_callback(RTX_LOG_WATERMARK_RPC_ID,rpc_handler_);
+    ack_batches_.resize(ms);
+    for(auto &b : ack_batches_) {
+      for(int i = 0;i < RTX_ACK_BATCH_BUFS;++i)
+        b.bufs[i] = rpc_handler_->get_static_buf(MAX_MSG_SIZE);
+      b.reset();
+    }
+    wm_sent_.assign(ms,0);
+    wm_time_.assign(ms,0);
+#endif
+#if EPOCH_COMMIT
+    for(int i = 0;i < 2;++i) {
+      for(int m = 0;m < ms;++m)
+        epochs_[i].bufs.push_back(rpc_handler_->get_static_buf(RTX_LOG_ENTRY_SIZE));
+      epochs_[i].ends.resize(ms);
+      epochs_[i].nums.resize(ms);
+      epochs_[i].reset();
+    }
+#endif
   }
 
   ~Logger() {
@@ -50,11 +86,96 @@ class Logger {
   virtual void check_remote(BatchOpCtrlBlock &ctrl,int cor_id,yield_func_t &yield) {
   }
 
+  // whether the log can be posted without overwriting unconsumed logs at the backups.
+  // if not, the caller shall yield and check again.
+  virtual bool check_credits(BatchOpCtrlBlock &ctrl,int cor_id) {
+    return true;
+  }
+
   // ack log at remote servers
   // a helper function to broadcast this message to others
   virtual void log_ack(BatchOpCtrlBlock &ctrl,int cor_id) {
+#if LOG_ACK_BATCH
+    // the log is appended to the pending batch of each backup, and the TX waits for
+    // the backups' watermarks to cover it (see log_acked)
+    ((RTXRequestHeader *)ctrl.req_buf_)->num = ctrl.batch_size_;
+    uint64_t size = ctrl.batch_msg_size();
+    for(auto it = ctrl.mac_set_.begin();it != ctrl.mac_set_.end();++it) {
+      int mac = *it;
+      AckBatch &b = ack_batches_[mac];
+      if(b.end + sizeof(uint64_t) + size > b.buf() + MAX_MSG_SIZE)
+        flush_acks(mac);
+      ASSERT(b.end + sizeof(uint64_t) + size <= b.buf() + MAX_MSG_SIZE) << "log of " << size << " bytes exceeds an ack batch";
+      if(b.num == 0)
+        b.start = TSClock::local_now();
+      *((uint64_t *)b.end) = size;
+      memcpy(b.end + sizeof(uint64_t),ctrl.req_buf_,size);
+      b.end += sizeof(uint64_t) + RTX_ALIGN8(size);
+      b.num += 1;
+      b.lsn += 1;
+      ticket(cor_id,mac) = b.lsn;
+    }
+#else
     ctrl.send_batch_op(rpc_handler_,cor_id,ack_rpc_id_,PA);
     // a yield call is necessary after this
+#endif
+  }
+
+#if LOG_ACK_BATCH
+  // whether the last log acked by cor_id has been applied by all its (alive) backups
+  bool log_acked(BatchOpCtrlBlock &ctrl,int cor_id) {
+    for(auto it = ctrl.mac_set_.begin();it != ctrl.mac_set_.end();++it) {
+      if(cleaner_.watermark(*it) < ticket(cor_id,*it) && global_view->is_alive(*it))
+        return false;
+    }
+    return true;
+  }
+#endif
+
+#if EPOCH_COMMIT
+  /**
+   * Group commit of the TX's log (in ctrl) with the other TXs of the thread.
+   * The log joins the open epoch, which is replicated with one log write (and one ack)
+   * per backup once it has been open for EPOCH_US, or is full.
+   * The first coroutine which finds the epoch due becomes its leader and flushes it;
+   * the others wait. The call returns after the TX's epoch is committed.
+   */
+  void epoch_commit(BatchOpCtrlBlock &ctrl,int cor_id,yield_func_t &yield) {
+    while(!epochs_[open_].fits(ctrl)) {
+      if(!flushing_)
+        flush_epoch(cor_id,yield);
+      else
+        RWorker::thread_worker->yield_next(yield);
+    }
+    uint64_t epoch = epoch_id_;
+    epochs_[open_].append(ctrl);
+    epoch_txs_ += 1;
+
+    while(committed_epoch_ < epoch) {
+      if(!flushing_ && epoch_id_ == epoch
+         && TSClock::local_now() - epochs_[open_].start >= EPOCH_US)
+        flush_epoch(cor_id,yield);
+      else
+        RWorker::thread_worker->yield_next(yield);
+    }
+  }
+
+  void epoch_report() const {
+    fprintf(stdout,"epochs committed %lu, %f TXs per epoch\n",committed_epoch_,
+            epoch_txs_ / (double)(committed_epoch_ + (committed_epoch_ == 0)));
+  }
+#endif
+
+  // called in the worker's event loop
+  inline void poll() {
+    cleaner_.poll_acks();
+#if LOG_ACK_BATCH
+    poll_ack_batches();
+#endif
+  }
+
+  inline MemDB *backed_store(int pid) {
+    return cleaner_.get_backed_store(pid);
   }
 
   inline void add_backup_store(int id,MemDB *backup_store) {
@@ -70,6 +191,167 @@ class Logger {
  private:
   const int ack_rpc_id_;
 
+#if LOG_ACK_BATCH
+  struct AckBatch {
+    char    *bufs[RTX_ACK_BATCH_BUFS]; // rotated, since a sent batch may still be in flight
+    int      cur = 0;
+    char    *end;
+    uint32_t num;
+    uint64_t start;   // time of the first log in the batch
+    uint64_t lsn = 0; // LSN of the last log appended
+
+    inline char *buf() { return bufs[cur]; }
+    inline void reset() {
+      end = buf() + sizeof(RtxLogBatchHeader);
+      num = 0;
+    }
+  };
+
+  inline uint64_t &ticket(int cor_id,int mac) {
+    uint64_t idx = (uint64_t)cor_id * ack_batches_.size() + mac;
+    if(idx >= tickets_.size())
+      tickets_.resize(idx + 1,0);
+    return tickets_[idx];
+  }
+
+  // sends the pending batch to mac, with the watermark of mac's logs piggybacked
+  void flush_acks(int mac) {
+    AckBatch &b = ack_batches_[mac];
+    if(b.num == 0)
+      return;
+    RtxLogBatchHeader *header = (RtxLogBatchHeader *)b.buf();
+    header->num = b.num;
+    header->lsn = b.lsn;
+    header->watermark = cleaner_.applied(mac);
+    rpc_handler_->append_req(b.buf(),ack_rpc_id_,b.end - b.buf(),0,RRpc::REQ,mac);
+    wm_sent_[mac] = header->watermark;
+    wm_time_[mac] = TSClock::local_now();
+    b.cur = (b.cur + 1) % RTX_ACK_BATCH_BUFS;
+    b.reset();
+  }
+
+  // flushes the batches which are held for a window, and sends the watermarks which have not been
+  // piggybacked on any batch within a window
+  void poll_ack_batches() {
+    uint64_t now = TSClock::local_now();
+    for(int mac = 0;mac < ack_batches_.size();++mac) {
+      AckBatch &b = ack_batches_[mac];
+      if(b.num > 0 && now - b.start >= LOG_ACK_WINDOW_US) {
+        flush_acks(mac);
+        continue;
+      }
+      uint64_t applied = cleaner_.applied(mac);
+      if(applied > wm_sent_[mac] && now - wm_time_[mac] >= LOG_ACK_WINDOW_US) {
+        char *msg = rpc_handler_->get_fly_buf(0);
+        *((uint64_t *)msg) = applied;
+        rpc_handler_->append_req(msg,RTX_LOG_WATERMARK_RPC_ID,sizeof(uint64_t),0,RRpc::REQ,mac);
+        wm_sent_[mac] = applied;
+        wm_time_[mac] = now;
+      }
+    }
+  }
+
+  std::vector<AckBatch> ack_batches_; // per backup
+  std::vector<uint64_t> tickets_;     // LSN of the last log acked by each coroutine, to each backup
+  std::vector<uint64_t> wm_sent_;     // the last watermark sent to each primary
+  std::vector<uint64_t> wm_time_;
+#endif
+
+#if EPOCH_COMMIT
+  // the logs of an epoch, one per backup
+  struct Epoch {
+    std::vector<char *> bufs;
+    std::vector<char *> ends;
+    std::vector<int>    nums;
+    std::set<int>       macs;
+    uint64_t start;     // time the first log joins
+
+    inline bool fits(BatchOpCtrlBlock &ctrl) {
+      int size = ctrl.batch_msg_size() - sizeof(RTXRequestHeader);
+      for(auto it = ctrl.mac_set_.begin();it != ctrl.mac_set_.end();++it) {
+        if(ends[*it] + size > bufs[*it] + RTX_LOG_ENTRY_SIZE
+           || nums[*it] + ctrl.batch_size_ > RTX_EPOCH_MAX_ITEMS) {
+          ASSERT(nums[*it] > 0) << "log of " << size << " bytes exceeds an epoch";
+          return false;
+        }
+      }
+      return true;
+    }
+
+    inline void append(BatchOpCtrlBlock &ctrl) {
+      if(macs.empty())
+        start = TSClock::local_now();
+      int size = ctrl.batch_msg_size() - sizeof(RTXRequestHeader);
+      for(auto it = ctrl.mac_set_.begin();it != ctrl.mac_set_.end();++it) {
+        memcpy(ends[*it],ctrl.req_buf_ + sizeof(RTXRequestHeader),size);
+        ends[*it] += size;
+        nums[*it] += ctrl.batch_size_;
+        macs.insert(*it);
+      }
+    }
+
+    inline void reset() {
+      for(uint i = 0;i < bufs.size();++i) {
+        ends[i] = bufs[i] + sizeof(RTXRequestHeader);
+        nums[i] = 0;
+      }
+      macs.clear();
+    }
+  };
+
+  // replicates the open epoch, as a log of the items of all its TXs to each backup
+  void flush_epoch(int cor_id,yield_func_t &yield) {
+    flushing_ = true;
+    Epoch &e = epochs_[open_];
+    uint64_t epoch = epoch_id_;
+    // the following TXs join the next epoch
+    open_ ^= 1;
+    epoch_id_ += 1;
+
+    std::vector<BatchOpCtrlBlock> logs;
+    for(auto mac : e.macs) {
+      logs.emplace_back(e.bufs[mac],reply_buf_);
+      auto &log = logs.back();
+      log.add_mac(mac);
+      log.req_buf_end_ = e.ends[mac];
+      log.batch_size_  = e.nums[mac];
+    }
+    for(auto &log : logs) {
+      while(!check_credits(log,cor_id))
+        RWorker::thread_worker->indirect_yield(yield);
+    }
+    for(auto &log : logs)
+      log_remote(log,cor_id);
+    RWorker::thread_worker->indirect_yield(yield);
+
+    for(auto &log : logs) {
+      // the epoch's buffers are re-used, so the acks are sent from the fly buffers
+      char *buf = rpc_handler_->get_fly_buf(cor_id);
+      memcpy(buf,log.req_buf_,log.batch_msg_size());
+      log.req_buf_end_ = buf + log.batch_msg_size();
+      log.req_buf_ = buf;
+      log_ack(log,cor_id);
+    }
+    RWorker::thread_worker->indirect_yield(yield);
+#if LOG_ACK_BATCH && !PA
+    for(auto &log : logs) {
+      while(!log_acked(log,cor_id))
+        RWorker::thread_worker->yield_next(yield);
+    }
+#endif
+    e.reset();
+    committed_epoch_ = epoch;
+    flushing_ = false;
+  }
+
+  Epoch    epochs_[2];          // the open one, and the one being flushed
+  int      open_ = 0;
+  uint64_t epoch_id_ = 1;       // of the open epoch
+  uint64_t committed_epoch_ = 0;
+  bool     flushing_ = false;
+  uint64_t epoch_txs_ = 0;
+#endif
+
   friend RdmaChecker;
   friend OCC;
 
@@ -95,14 +95,27 @@ struct RTXRemoteWriteItem {
 struct RtxWriteItem {
   uint8_t  pid;
   uint8_t  tableid;
+  uint8_t  delta;    // whether the payload is delta runs (see log_delta.hpp), rather than the full record
+  uint8_t  based;    // whether base_seq is set, i.e. the item is based on a read image
+  uint32_t base_seq; // low bits of the seq of the read image at the primary
   uint64_t key;
   uint16_t len;
-  RtxWriteItem(int pid,int tableid,uint64_t key,int len) :
-      pid(pid),tableid(tableid),key(key),len(len) {
+  RtxWriteItem(int pid,int tableid,uint64_t key,int len,bool delta = false) :
+      pid(pid),tableid(tableid),delta(delta),based(0),base_seq(0),key(key),len(len) {
 
   }
 } __attribute__ ((aligned (8)));
 
+#define RTX_ALIGN8(x) (((x) + 7) & ~((uint64_t)7))
+
+// header of a batch of log acks (LOG_ACK_BATCH).
+// each log in the batch is preceded by its size in a uint64_t, and padded to 8 bytes.
+struct RtxLogBatchHeader {
+  uint32_t num;
+  uint64_t lsn;        // LSN of the last log in the batch, per (sender,receiver) pair
+  uint64_t watermark;  // the sender's applied LSN of the logs from the receiver
+} __attribute__ ((aligned (8)));
+
 struct RTXUpdateItem {
   uint8_t  pid;
   uint8_t  tableid;
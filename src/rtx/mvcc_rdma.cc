@@ -40,6 +40,7 @@ void MVCC::release_writes(yield_func_t &yield, bool all) {
   int release_num = write_set_.size();
   abort_cnt[19]+=release_num;
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   if(!all) {
     release_num -= 1;
   }
@@ -100,6 +101,7 @@ void MVCC::release_writes(yield_func_t &yield, bool all) {
   }
 #endif
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 bool MVCC::try_read_rpc(int index, yield_func_t &yield) {
@@ -267,6 +269,7 @@ bool MVCC::try_update_rpc(yield_func_t &yield) {
   start_batch_rpc_op(write_batch_helper_);
   bool need_send = false;
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   for(auto& item : write_set_) {
     if(item.pid != node_id_) {
       need_send = true;
@@ -311,6 +314,7 @@ bool MVCC::try_update_rpc(yield_func_t &yield) {
 #endif
   }
   END(commit);
+  STAGE_END(STAGE_COMMIT);
   return true;
 }
 
@@ -343,23 +347,28 @@ void MVCC::log_remote(yield_func_t &yield) {
         << "FaSST should uses rep-factor's log entries, current num "
         << cblock.mac_set_.size() << "; rep-factor " << global_view->rep_factor_;
 #else
-    for(auto it = write_batch_helper_.mac_set_.begin();
-        it != write_batch_helper_.mac_set_.end();++it) {
-      global_view->add_backup(*it,cblock.mac_set_);
-    }
-    // add local server
-    global_view->add_backup(current_partition,cblock.mac_set_);
+    // the backups of the written partitions, which keep the written tables
+    for(auto it = write_set_.begin();it != write_set_.end();++it)
+      global_view->add_backup_of_table(it->pid,it->tableid,cblock.mac_set_);
+    if(cblock.mac_set_.empty())
+      return; // only the tables without backups are written
 #endif
 
 #if CHECKS
     LOG(3) << "log to " << cblock.mac_set_.size() << " macs";
 #endif
 
+    // wait for the backups to free enough space in the log rings
+    while(!logger_->check_credits(cblock,cor_id_))
+      worker_->indirect_yield(yield);
+
     START(log);
+    STAGE_START(STAGE_LOG);
     logger_->log_remote(cblock,cor_id_);
     abort_cnt[18]++;
     worker_->indirect_yield(yield);
     END(log);
+    STAGE_END(STAGE_LOG);
 #if 1
     cblock.req_buf_ = rpc_->get_fly_buf(cor_id_);
     memcpy(cblock.req_buf_,write_batch_helper_.req_buf_,write_batch_helper_.batch_msg_size());
@@ -368,6 +377,11 @@ void MVCC::log_remote(yield_func_t &yield) {
     logger_->log_ack(cblock,cor_id_); // need to yield
     abort_cnt[18]++;    
     worker_->indirect_yield(yield);
+#if LOG_ACK_BATCH && !PA
+    // the acks are batched, so wait for the backups' watermarks
+    while(!logger_->log_acked(cblock,cor_id_))
+      worker_->yield_next(yield);
+#endif
 #endif
   }
 }
@@ -907,6 +921,7 @@ bool MVCC::try_read_rdma(int index, yield_func_t &yield) {
 
 bool MVCC::try_update_rdma(yield_func_t &yield) {
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   bool need_yield = false;
   for(auto& item : write_set_) {
     if(item.pid != -1) {
@@ -967,6 +982,7 @@ bool MVCC::try_update_rdma(yield_func_t &yield) {
     worker_->indirect_yield(yield);
   }
   END(commit);
+  STAGE_END(STAGE_COMMIT);
   return true;
 }
 
@@ -48,6 +48,11 @@ protected:
   void broadcast_decision(bool commit_or_abort, yield_func_t &yield);
   
   int remote_read(int pid,int tableid,uint64_t key,int len,yield_func_t &yield) {
+    // a replicated (read-only) table is read locally without concurrency control
+    if(global_view->is_replicated(tableid)) {
+      read_set_.emplace_back(tableid,key,(MemNode*)NULL,local_replicated_get(tableid,key,len),0,len,node_id_);
+      return read_set_.size() - 1;
+    }
     char* data_ptr = (char*)malloc(len);
     for(auto&item : write_set_) {
       if(item.key == key && item.tableid == tableid) {
@@ -66,31 +71,31 @@ protected:
     read_set_.emplace_back(tableid, key, (MemNode*)NULL, data_ptr, 0, len, pid);
     int index = read_set_.size() - 1;
 
-// HARD CODED!!!
-    if(tableid == 7) {
-      read_set_[index].data_ptr = (char*)malloc(len);
-      return index;
-    }
-
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_READ) != 0
     START(read_lat);
+    STAGE_START(STAGE_READ);
     if(!try_read_rdma(index, yield)) {
       release_reads(yield);
       release_writes(yield);
+      record_conflict(tableid,key);
       return -1;
     }
     END(read_lat);
+    STAGE_END(STAGE_READ);
 #else
     START(read_lat);
+    STAGE_START(STAGE_READ);
     if(!try_read_rpc(index, yield)) {
       release_reads(yield);
       release_writes(yield);
+      record_conflict(tableid,key);
       return -1;
     }
     if(pid != node_id_){
       process_received_data(reply_buf_, read_set_.back());
     }
     END(read_lat);
+    STAGE_END(STAGE_READ);
 #endif
     return index;
   }
@@ -109,27 +114,33 @@ protected:
     index = write_set_.size() - 1;
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_LOCK) != 0
     START(lock);
+    STAGE_START(STAGE_LOCK);
     int ret = try_lock_read_rdma(index, yield);
     if(ret == -1) {
       release_reads(yield);
       release_writes(yield, false);
+      record_conflict(tableid,key);
       return -1;
     }
     else if(ret == -2) {
       release_reads(yield);
       release_writes(yield);
+      record_conflict(tableid,key);
       return -1; 
     }
     else if(ret != 0) {
       assert(false);
     }
     END(lock);
+    STAGE_END(STAGE_LOCK);
 #elif ONE_SIDED_READ == 2 && ((HYBRID_CODE & RCC_USE_ONE_SIDED_RELEASE) != 0 || (HYBRID_CODE & RCC_USE_ONE_SIDED_COMMIT) != 0)
     START(lock);
+    STAGE_START(STAGE_LOCK);
     if(!try_lock_read_rpc(index, yield)) {
       // abort
       release_reads(yield);
       release_writes(yield, false);
+      record_conflict(tableid,key);
       return -1;
     }
     
@@ -143,12 +154,15 @@ protected:
       process_received_data_hybrid(reply_buf_, write_set_.back());
     }
     END(lock);
+    STAGE_END(STAGE_LOCK);
 #else // ONE_SIDED_READ == 0 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_RELEASE) == 0 && (HYBRID_CODE & RCC_USE_ONE_SIDED_COMMIT) == 0
     START(lock);
+    STAGE_START(STAGE_LOCK);
     if(!try_lock_read_rpc(index, yield)) {
       // abort
       release_reads(yield);
       release_writes(yield, false);
+      record_conflict(tableid,key);
       return -1;
     }
 
@@ -167,6 +181,7 @@ protected:
       process_received_data(reply_buf_, write_set_.back(), true);
     }
     END(lock);
+    STAGE_END(STAGE_LOCK);
 #endif
     ASSERT(write_set_[index].data_ptr != NULL) << index;
     return index;
@@ -239,6 +254,8 @@ public:
 
   inline __attribute__((always_inline))
   virtual int write(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
+    if(unlikely((pid = route(pid)) < 0))
+      return -1;
     return remote_write(pid, tableid, key, len, yield);
   }
 
@@ -250,6 +267,9 @@ public:
 
   inline __attribute__((always_inline))
   virtual int read(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
+    // a replicated table is read locally, see remote_read
+    if(!global_view->is_replicated(tableid) && unlikely((pid = route(pid)) < 0))
+      return -1;
     return remote_read(pid, tableid, key, len, yield);
   }
 
@@ -261,12 +281,16 @@ public:
 
   inline __attribute__((always_inline))
   virtual char* load_write(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     assert(write_set_[idx].data_ptr != NULL);
     return write_set_[idx].data_ptr;
   }
 
   inline __attribute__((always_inline))
   virtual char* load_read(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     auto& item = read_set_[idx];
     assert(item.data_ptr != NULL);
     return item.data_ptr;
@@ -279,6 +303,7 @@ public:
   }
 
 	virtual void begin(yield_func_t &yield) {
+    unavailable_ = false;
     memptr = 0;
     read_set_.clear();
     write_set_.clear();
@@ -287,8 +312,7 @@ public:
     // + response_node_ * 80 + worker_id_ * 10 + cor_id_ + 1
     // - init_time; // TODO: may be too large
 
-    txn_start_time = ((++cnt_timer) << 10) 
-    + response_node_ * 80 + worker_id_ * 10 + cor_id_ + 1;
+    txn_start_time = new_timestamp();
 
     // LOG(3) << worker_id_ << ' ' << cor_id_ << ' ' << txn_start_time;
 
@@ -297,12 +321,31 @@ public:
     // txn_end_time = txn_start_time + rwlock::LEASE_TIME;
   }
 
+  // the logical clock of the coroutine, also used by its read-only snapshots
+  inline uint64_t new_timestamp() {
+    return ((++cnt_timer) << 10) + response_node_ * 80 + worker_id_ * 10 + cor_id_ + 1;
+  }
+
+  inline void catch_up_clock(uint64_t ts) {
+    cnt_timer = std::max(cnt_timer,ts >> 10);
+  }
+
   virtual bool commit(yield_func_t &yield) {
+    if(unlikely(unavailable_)) {
+      release_reads(yield);
+      release_writes(yield);
+      return false;
+    }
 #if TX_TWO_PHASE_COMMIT_STYLE > 0
     START(twopc)
+    STAGE_START(STAGE_2PC);
     bool vote_commit = prepare_commit(yield); // broadcasting prepare messages and collecting votes
-    // broadcast_decision(vote_commit, yield);
+#if TX_TWO_PHASE_COMMIT_STYLE == 2
+    if (vote_commit)
+      broadcast_decision(true, yield); // an abort is decided in prepare_commit
+#endif
     END(twopc);
+    STAGE_END(STAGE_2PC);
     if (!vote_commit) {
       release_reads(yield);
       release_writes(yield);
@@ -150,6 +150,7 @@ bool NOWAIT::try_lock_write_w_rdma(int index, yield_func_t &yield) {
 void NOWAIT::release_reads_w_rdma(yield_func_t &yield, bool release_all) {
   // can only work with lock_w_rdma
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   int num = read_set_.size();
   if(!release_all) {
@@ -159,6 +160,7 @@ void NOWAIT::release_reads_w_rdma(yield_func_t &yield, bool release_all) {
   uint64_t lock_content = R_LEASE(txn_start_time);
   for(int i = 0; i < num; ++i) {
     auto it = read_set_.begin() + i;
+    if(global_view->is_replicated((*it).tableid)) continue; // not locked
     if((*it).pid != node_id_) {
       RdmaValHeader *header = (RdmaValHeader *)((*it).data_ptr - sizeof(RdmaValHeader));
       if(header->lock == 333) { // successfull locked
@@ -183,11 +185,13 @@ void NOWAIT::release_reads_w_rdma(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
   return;
 }
 
 void NOWAIT::release_writes_w_rdma(yield_func_t &yield, bool release_all) {
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   int num = write_set_.size();
   if(!release_all) {
@@ -221,6 +225,7 @@ void NOWAIT::release_writes_w_rdma(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
   return;
 }
 
@@ -233,6 +238,7 @@ void NOWAIT::write_back_w_rdma(yield_func_t &yield) {
    */
   RDMAWriteReq req(cor_id_,PA /* whether to use passive ack*/);
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   CYCLE_START(commit);
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
 
@@ -271,6 +277,7 @@ void NOWAIT::write_back_w_rdma(yield_func_t &yield) {
   CYCLE_RESUME(commit);
   CYCLE_END(commit);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 bool NOWAIT::try_lock_read_w_rwlock_rpc(int index, yield_func_t &yield) {
@@ -429,6 +436,7 @@ bool NOWAIT::try_lock_write_w_rwlock_rpc(int index, yield_func_t &yield) {
 void NOWAIT::release_reads(yield_func_t &yield, bool release_all) {
   using namespace rwlock_4_waitdie;
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   int num = read_set_.size();
   if(!release_all) {
@@ -437,6 +445,7 @@ void NOWAIT::release_reads(yield_func_t &yield, bool release_all) {
   abort_cnt[19]+=num;
   start_batch_rpc_op(write_batch_helper_);
   for(int i = 0; i < num; ++i) {
+    if(global_view->is_replicated(read_set_[i].tableid)) continue; // not locked
     if(read_set_[i].pid != node_id_) { // remote case
       add_batch_entry<RTXLockRequestItem>(write_batch_helper_, read_set_[i].pid,
                                    /*init RTXLockRequestItem */ 
@@ -454,11 +463,13 @@ void NOWAIT::release_reads(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 void NOWAIT::release_writes(yield_func_t &yield, bool release_all) {
   using namespace rwlock_4_waitdie;
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   int num = write_set_.size();
   if(!release_all) {
@@ -484,6 +495,7 @@ void NOWAIT::release_writes(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 void NOWAIT::prepare_write_contents() {
@@ -515,19 +527,23 @@ void NOWAIT::log_remote(yield_func_t &yield) {
         << "FaSST should uses rep-factor's log entries, current num "
         << cblock.mac_set_.size() << "; rep-factor " << global_view->rep_factor_;
 #else
-    for(auto it = write_batch_helper_.mac_set_.begin();
-        it != write_batch_helper_.mac_set_.end();++it) {
-      global_view->add_backup(*it,cblock.mac_set_);
-    }
-    // add local server
-    global_view->add_backup(current_partition,cblock.mac_set_);
+    // the backups of the written partitions, which keep the written tables
+    for(auto it = write_set_.begin();it != write_set_.end();++it)
+      global_view->add_backup_of_table(it->pid,it->tableid,cblock.mac_set_);
+    if(cblock.mac_set_.empty())
+      return; // only the tables without backups are written
 #endif
 
 #if CHECKS
     LOG(3) << "log to " << cblock.mac_set_.size() << " macs";
 #endif
 
+    // wait for the backups to free enough space in the log rings
+    while(!logger_->check_credits(cblock,cor_id_))
+      worker_->indirect_yield(yield);
+
     START(log);
+    STAGE_START(STAGE_LOG);
     CYCLE_START(log);
     logger_->log_remote(cblock,cor_id_);
     abort_cnt[18]++;
@@ -536,6 +552,7 @@ void NOWAIT::log_remote(yield_func_t &yield) {
     CYCLE_RESUME(log);
     CYCLE_END(log);
     END(log);
+    STAGE_END(STAGE_LOG);
 #if 1
     cblock.req_buf_ = rpc_->get_fly_buf(cor_id_);
     memcpy(cblock.req_buf_,write_batch_helper_.req_buf_,write_batch_helper_.batch_msg_size());
@@ -544,6 +561,11 @@ void NOWAIT::log_remote(yield_func_t &yield) {
     logger_->log_ack(cblock,cor_id_); // need to yield
     abort_cnt[18]++;
     worker_->indirect_yield(yield);
+#if LOG_ACK_BATCH && !PA
+    // the acks are batched, so wait for the backups' watermarks
+    while(!logger_->log_acked(cblock,cor_id_))
+      worker_->yield_next(yield);
+#endif
 #endif
   } // end check whether it is necessary to log
 }
@@ -581,6 +603,7 @@ void NOWAIT::broadcast_decision(bool commit_or_abort, yield_func_t &yield) {
 
 void NOWAIT::write_back(yield_func_t &yield) {
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   CYCLE_START(commit);
   start_batch_rpc_op(write_batch_helper_);
   
@@ -608,6 +631,7 @@ void NOWAIT::write_back(yield_func_t &yield) {
 #endif
   CYCLE_END(commit);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 
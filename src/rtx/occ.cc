@@ -36,8 +36,12 @@ OCC::OCC(oltp::RWorker *worker,MemDB *db,RRpc *rpc_handler,int nid,int cid,int r
 void OCC::begin(yield_func_t &yield) {
 
   abort_ = false;
+  unavailable_ = false;
   read_set_.clear();
   write_set_.clear();
+#if LOG_DELTA
+  write_images_.clear();
+#endif
 
   start_batch_read();
 }
@@ -51,7 +55,7 @@ bool OCC::commit(yield_func_t &yield) {
 #endif
 
   bool ret = true;
-  if(abort_) {
+  if(abort_ || unavailable_) {
     abort_cnt[22]++;
     // goto ABORT;
     release_writes(yield);
@@ -82,9 +86,14 @@ bool OCC::commit(yield_func_t &yield) {
 
 #if TX_TWO_PHASE_COMMIT_STYLE > 0
     START(twopc)
+    STAGE_START(STAGE_2PC);
     bool vote_commit = prepare_commit(yield); // broadcasting prepare messages and collecting votes
-    // broadcast_decision(vote_commit, yield);
+#if TX_TWO_PHASE_COMMIT_STYLE == 2
+    if (vote_commit)
+      broadcast_decision(true, yield); // an abort is decided in prepare_commit
+#endif
     END(twopc);
+    STAGE_END(STAGE_2PC);
     if (!vote_commit) {
       // goto ABORT;
       release_writes(yield);
@@ -338,6 +347,7 @@ void OCC::write_back_oneshot(yield_func_t &yield) {
   // make use of the content that is already prepared in write_batch_helper's buffer.
   char *cur_ptr = write_batch_helper_.req_buf_ + sizeof(RTXRequestHeader);
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   CYCLE_START(commit);
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
     if((*it).pid != node_id_) {
@@ -360,10 +370,12 @@ void OCC::write_back_oneshot(yield_func_t &yield) {
   CYCLE_RESUME(commit);
   CYCLE_END(commit);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 bool OCC::release_writes(yield_func_t &yield) {
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   start_batch_rpc_op(write_batch_helper_);
   abort_cnt[19]+=write_set_.size();
@@ -383,16 +395,22 @@ bool OCC::release_writes(yield_func_t &yield) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 void OCC::log_remote(yield_func_t &yield) {
 
   if(write_set_.size() > 0 && global_view->rep_factor_ > 0) {
 
+#if LOG_DELTA
+    BatchOpCtrlBlock cblock(rpc_->get_fly_buf(cor_id_),write_batch_helper_.reply_buf_);
+    prepare_log_contents(cblock);
+#else
     // re-use write_batch_helper_'s data structure
     BatchOpCtrlBlock cblock(write_batch_helper_.req_buf_,write_batch_helper_.reply_buf_);
     cblock.batch_size_  = write_batch_helper_.batch_size_;
     cblock.req_buf_end_ = write_batch_helper_.req_buf_end_;
+#endif
 
 #if EM_FASST
     global_view->add_backup(response_node_,cblock.mac_set_);
@@ -400,19 +418,29 @@ void OCC::log_remote(yield_func_t &yield) {
         << "FaSST should uses rep-factor's log entries, current num "
         << cblock.mac_set_.size() << "; rep-factor " << global_view->rep_factor_;
 #else
-    for(auto it = write_batch_helper_.mac_set_.begin();
-        it != write_batch_helper_.mac_set_.end();++it) {
-      global_view->add_backup(*it,cblock.mac_set_);
-    }
-    // add local server
-    global_view->add_backup(current_partition,cblock.mac_set_);
+    // the backups of the written partitions, which keep the written tables
+    for(auto it = write_set_.begin();it != write_set_.end();++it)
+      global_view->add_backup_of_table(it->pid,it->tableid,cblock.mac_set_);
+    if(cblock.mac_set_.empty())
+      return; // only the tables without backups are written
 #endif
 
 #if CHECKS
     LOG(3) << "log to " << cblock.mac_set_.size() << " macs";
 #endif
 
+#if EPOCH_COMMIT
+    // the log is replicated with the other TXs of the epoch
+    logger_->epoch_commit(cblock,cor_id_,yield);
+    return;
+#endif
+
+    // wait for the backups to free enough space in the log rings
+    while(!logger_->check_credits(cblock,cor_id_))
+      worker_->indirect_yield(yield);
+
     START(log);
+    STAGE_START(STAGE_LOG);
     CYCLE_START(log);
     logger_->log_remote(cblock,cor_id_);
     abort_cnt[18]++;
@@ -421,30 +449,76 @@ void OCC::log_remote(yield_func_t &yield) {
     CYCLE_RESUME(log);
     CYCLE_END(log);
     END(log);
+    STAGE_END(STAGE_LOG);
 #if 1
+#if !LOG_DELTA // the delta log is already in a fly buffer
     cblock.req_buf_ = rpc_->get_fly_buf(cor_id_);
     memcpy(cblock.req_buf_,write_batch_helper_.req_buf_,write_batch_helper_.batch_msg_size());
     cblock.req_buf_end_ = cblock.req_buf_ + write_batch_helper_.batch_msg_size();
+#endif
     //log ack
     logger_->log_ack(cblock,cor_id_); // need to yield
     abort_cnt[18]++;
     worker_->indirect_yield(yield);
+#if LOG_ACK_BATCH && !PA
+    // the acks are batched, so wait for the backups' watermarks
+    while(!logger_->log_acked(cblock,cor_id_))
+      worker_->yield_next(yield);
+#endif
 #endif
   } // end check whether it is necessary to log
 }
 
+#if LOG_DELTA
+/**
+ * Encodes the log from the write contents, where a record is shipped as the byte ranges
+ * it changes in the read image, if that is smaller than the full record.
+ * The items of the write contents follow the order of the write set.
+ */
+void OCC::prepare_log_contents(BatchOpCtrlBlock &clk) {
+  char *ptr = write_batch_helper_.req_buf_ + sizeof(RTXRequestHeader);
+  int idx = 0;
+  for(int i = 0;i < write_batch_helper_.batch_size_;++i) {
+    RtxWriteItem *item = (RtxWriteItem *)ptr;
+    char *val = ptr + sizeof(RtxWriteItem);
+    ptr = val + item->len;
+    while(write_set_[idx].pid != item->pid || write_set_[idx].tableid != item->tableid
+          || write_set_[idx].key != item->key)
+      idx += 1;
+    const char *image = write_images_.get(idx++);
+
+    RtxWriteItem *log_item = (RtxWriteItem *)clk.req_buf_end_;
+    char *log_val = clk.req_buf_end_ + sizeof(RtxWriteItem);
+    int size = (image == NULL || item->len == 0) ? -1 : encode_delta(log_val,val,image,item->len);
+    bool delta = size >= 0;
+    if(!delta) { // fall back to the full record
+      size = item->len;
+      memcpy(log_val,val,size);
+    }
+    *log_item = RtxWriteItem(item->pid,item->tableid,item->key,size,delta);
+    log_item->based    = image != NULL;
+    log_item->base_seq = (uint32_t)write_set_[idx - 1].seq;
+    clk.req_buf_end_ = log_val + size;
+    clk.batch_size_ += 1;
+  }
+}
+#endif
+
 bool OCC::validate_reads(yield_func_t &yield) {
   START(validate);
+  STAGE_START(STAGE_VALIDATE);
   CYCLE_START(validate);
   start_batch_rpc_op(read_batch_helper_);
 
   for(auto it = read_set_.begin();it != read_set_.end();++it) {
+    if(global_view->is_replicated((*it).tableid)) continue;
     if((*it).pid != node_id_) { // remote case
       add_batch_entry<RtxLockItem>(read_batch_helper_, (*it).pid,
                                    /*init RTXLockItem */ (*it).pid,(*it).tableid,(*it).key,(*it).seq);
     } else {
       if(!local_validate_op(it->node,it->seq)) {
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[15]++;
         return false;
 #endif
@@ -468,12 +542,14 @@ bool OCC::validate_reads(yield_func_t &yield) {
 
   CYCLE_END(validate);
   END(validate);
+  STAGE_END(STAGE_VALIDATE);
   return true;
 }
 
 bool OCC::lock_writes(yield_func_t &yield) {
 
   START(lock);
+  STAGE_START(STAGE_LOCK);
   CYCLE_START(lock);
   start_batch_rpc_op(write_batch_helper_);
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
@@ -490,12 +566,14 @@ bool OCC::lock_writes(yield_func_t &yield) {
       if(unlikely(!local_try_lock_op(it->node,
                                      ENCODE_LOCK_CONTENT(response_node_,worker_id_,cor_id_ + 1)))){
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[17]++;
         return false;
 #endif
       }
       if(unlikely(!local_validate_op(it->node,it->seq))) {
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[23]++;
         return false;
 #endif
@@ -546,6 +624,7 @@ bool OCC::lock_writes(yield_func_t &yield) {
   abort_cnt[24]+=write_set_.size();
   CYCLE_END(lock);
   END(lock);
+  STAGE_END(STAGE_LOCK);
   return true;
 }
 
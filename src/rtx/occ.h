@@ -10,6 +10,7 @@
 #endif
 
 #include "logger.hpp"
+#include "log_delta.hpp"
 #include "two_phase_committer.hpp"
 #include "two_phase_commit_mem_manager.hpp"
 
@@ -71,11 +72,15 @@ class OCC : public TXOpBase {
 
   inline __attribute__((always_inline))
   virtual int read(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    if(tableid == 7) {
+    if(global_view->is_replicated(tableid)) {
+      // read-only and loaded at every node, so it is read locally without concurrency control;
+      // the item is a local one, so its copy is freed as a local read's
       int idx = read_set_.size();
-      read_set_.emplace_back(tableid,key,(MemNode*)NULL,(char*)NULL,0,len,0);
+      read_set_.emplace_back(tableid,key,(MemNode*)NULL,local_replicated_get(tableid,key,len),0,len,node_id_);
       return idx;
     }
+    if(unlikely((pid = route(pid)) < 0))
+      return -1;
     if(pid == node_id_)
       return local_read(tableid,key,len,yield);
     else {
@@ -106,6 +111,8 @@ class OCC : public TXOpBase {
    */
   template <int tableid,typename V> // the value stored corresponding to tableid
   int  pending_read(int pid,uint64_t key,yield_func_t &yield) {
+    if(unlikely((pid = route(pid)) < 0))
+      return -1;
     if(pid == node_id_)
       return local_read(tableid,key,sizeof(V),yield);
     else
@@ -117,6 +124,8 @@ class OCC : public TXOpBase {
   virtual int write(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
       int index;
 
+      if(unlikely((pid = route(pid)) < 0))
+        return -1;
       if(pid == node_id_)
         index = local_write(tableid,key,len,yield);
       else {
@@ -134,8 +143,10 @@ class OCC : public TXOpBase {
 
   inline __attribute__((always_inline))
   virtual char* load_read(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     std::vector<ReadSetItem> &set = read_set_;  
-    if(set[idx].tableid == 7) return (char*)malloc(set[idx].len);
+    if(global_view->is_replicated(set[idx].tableid)) return set[idx].data_ptr;
     assert(idx < set.size());
     ASSERT(len == set[idx].len) <<
         "excepted size " << (int)(set[idx].len)  << " for table " << (int)(set[idx].tableid) << "; idx " << idx;
@@ -143,6 +154,7 @@ class OCC : public TXOpBase {
     if(set[idx].data_ptr == NULL
        && set[idx].pid != node_id_) {
       START(read_lat);
+      STAGE_START(STAGE_READ);
       CYCLE_START(read);
       // do actual reads here
       auto replies = send_batch_read();
@@ -156,6 +168,7 @@ class OCC : public TXOpBase {
       }
       CYCLE_END(read);
       END(read_lat);
+      STAGE_END(STAGE_READ);
       assert(set[idx].data_ptr != NULL);
       start_batch_rpc_op(read_batch_helper_);
     }
@@ -165,6 +178,8 @@ class OCC : public TXOpBase {
 
   inline __attribute__((always_inline))
   virtual char* load_write(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     std::vector<ReadSetItem> &set = write_set_;  
     assert(idx < set.size());
     ASSERT(len == set[idx].len) <<
@@ -173,6 +188,7 @@ class OCC : public TXOpBase {
     if(set[idx].data_ptr == NULL
        && set[idx].pid != node_id_) {
       START(read_lat);
+      STAGE_START(STAGE_READ);
       CYCLE_START(read);
       // do actual reads here
       auto replies = send_batch_read();
@@ -186,9 +202,14 @@ class OCC : public TXOpBase {
       }
       CYCLE_END(read);
       END(read_lat);
+      STAGE_END(STAGE_READ);
       assert(set[idx].data_ptr != NULL);
       start_batch_rpc_op(read_batch_helper_);
     }
+#if LOG_DELTA
+    // the user may modify the record after this
+    write_images_.keep(idx,set[idx].data_ptr,set[idx].len);
+#endif
 
     return (set[idx].data_ptr);
   }
@@ -270,6 +291,9 @@ class OCC : public TXOpBase {
   virtual void broadcast_decision(bool commit_or_abort, yield_func_t &yield);
   virtual void write_back(yield_func_t &yield);
   void write_back_oneshot(yield_func_t &yield);
+#if LOG_DELTA
+  void prepare_log_contents(BatchOpCtrlBlock &clk);
+#endif
 
  protected:
   std::vector<ReadSetItem>  read_set_;
@@ -278,6 +302,9 @@ class OCC : public TXOpBase {
   // helper to send batch read/write operations
   BatchOpCtrlBlock read_batch_helper_;
   BatchOpCtrlBlock write_batch_helper_;
+#if LOG_DELTA
+  WriteImages      write_images_; // read images of the write set, which the logs are encoded against
+#endif
 
   const int cor_id_;
   const int response_node_;
@@ -11,6 +11,7 @@ bool OCCR::lock_writes_w_rdma(yield_func_t &yield) {
   RDMALockReq req(cor_id_);
 
   START(lock); 
+  STAGE_START(STAGE_LOCK);
   CYCLE_START(lock);
   // send requests
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
@@ -48,12 +49,14 @@ bool OCCR::lock_writes_w_rdma(yield_func_t &yield) {
       if(unlikely(!local_try_lock_op(it->node,
                                      ENCODE_LOCK_CONTENT(response_node_,worker_id_,cor_id_ + 1)))){
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[4]++;
         return false;
 #endif
       } // check local lock
       if(unlikely(!local_validate_op(it->node,it->seq))) {
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[5]++;
         return false;
 #endif
@@ -76,6 +79,7 @@ bool OCCR::lock_writes_w_rdma(yield_func_t &yield) {
       if(node->lock != 0){ // check locks
 #if !NO_ABORT
         //LOG(3) << "abort!";
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[6]++;
         return false;
 #endif
@@ -83,6 +87,7 @@ bool OCCR::lock_writes_w_rdma(yield_func_t &yield) {
       if(node->seq != (*it).seq) {     // check seqs
 #if !NO_ABORT
        // LOG(3) << node->seq << ' ' << (*it).seq;
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[7]++;
         return false;
 #endif
@@ -97,6 +102,7 @@ bool OCCR::lock_writes_w_rdma(yield_func_t &yield) {
   abort_cnt[24]+=write_set_.size();
   CYCLE_END(lock);
   END(lock);
+  STAGE_END(STAGE_LOCK);
   return true;
 }
 
@@ -111,6 +117,7 @@ bool OCCR::lock_writes_w_FA_rdma(yield_func_t &yield) {
   dslr_lock_manager->init();
   
   START(lock);
+  STAGE_START(STAGE_LOCK);
   // send requests
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
     if((*it).pid != node_id_) { // remote case
@@ -169,6 +176,7 @@ bool OCCR::lock_writes_w_FA_rdma(yield_func_t &yield) {
   worker_->indirect_yield(yield);
   // gather replies
   END(lock);
+  STAGE_END(STAGE_LOCK);
 
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
     if((*it).pid != node_id_) {
@@ -197,6 +205,7 @@ bool OCCR::lock_writes_w_FA_rdma(yield_func_t &yield) {
 void OCCR::release_writes_w_rdma(yield_func_t &yield) {
   // can only work with lock_w_rdma
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   uint64_t lock_content =  ENCODE_LOCK_CONTENT(response_node_,worker_id_,cor_id_ + 1);
   abort_cnt[19]+=write_set_.size();
@@ -226,6 +235,7 @@ void OCCR::release_writes_w_rdma(yield_func_t &yield) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
   return;
 }
 
@@ -267,6 +277,7 @@ void OCCR::write_back_w_rdma(yield_func_t &yield) {
    */
   RDMAWriteReq req(cor_id_,PA /* whether to use passive ack*/);
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   CYCLE_START(commit);
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
 
@@ -308,6 +319,7 @@ void OCCR::write_back_w_rdma(yield_func_t &yield) {
   CYCLE_RESUME(commit);
   CYCLE_END(commit);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 void OCCR::write_back_w_CAS_rdma(yield_func_t &yield) {
@@ -323,6 +335,7 @@ void OCCR::write_back_w_FA_rdma(yield_func_t &yield) {
    */
   RDMAWriteOnlyReq req(cor_id_,PA /* whether to use passive ack*/);
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
 
     if((*it).pid != node_id_) {
@@ -358,13 +371,15 @@ void OCCR::write_back_w_FA_rdma(yield_func_t &yield) {
   abort_cnt[18]++;
   worker_->indirect_yield(yield);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 bool OCCR::validate_reads_w_rdma(yield_func_t &yield) {
   START(validate);
+  STAGE_START(STAGE_VALIDATE);
   CYCLE_START(validate);
   for(auto it = read_set_.begin();it != read_set_.end();++it) {
-    if((*it).tableid == 7) continue;
+    if(global_view->is_replicated((*it).tableid)) continue;
     if((*it).pid != node_id_) {
 
 #if INLINE_OVERWRITE
@@ -386,6 +401,7 @@ bool OCCR::validate_reads_w_rdma(yield_func_t &yield) {
     } else { // local case
       if(!local_validate_op(it->node,it->seq)) {
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         abort_cnt[12]++;
         return false;
 #endif
@@ -405,6 +421,7 @@ bool OCCR::validate_reads_w_rdma(yield_func_t &yield) {
 #endif
       if(node->seq != (*it).seq || node->lock != 0) { // check lock and versions
 #if !NO_ABORT
+        record_conflict((*it).tableid,(*it).key);
         if (node->seq != (*it).seq)
           abort_cnt[0]++;
         else
@@ -417,6 +434,7 @@ bool OCCR::validate_reads_w_rdma(yield_func_t &yield) {
   
   CYCLE_END(validate);
   END(validate);
+  STAGE_END(STAGE_VALIDATE);
   return true;
 }
 
@@ -427,6 +445,7 @@ bool OCCR::validate_reads_w_CAS_rdma(yield_func_t &yield) {
 bool OCCR::validate_reads_w_FA_rdma(yield_func_t &yield) {
 
   for(auto it = read_set_.begin();it != read_set_.end();++it) {
+    if(global_view->is_replicated((*it).tableid)) continue;
     if((*it).pid != node_id_) {
 
 #if INLINE_OVERWRITE
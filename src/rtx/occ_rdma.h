@@ -126,6 +126,7 @@ class OCCR : public OCC {
   int remote_read(int pid,int tableid,uint64_t key,int len,yield_func_t &yield) {
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_READ) != 0
     START(read_lat);
+    STAGE_START(STAGE_READ);
     CYCLE_START(read);
     char *data_ptr = (char *)Rmalloc(sizeof(MemNode) + len);
     ASSERT(data_ptr != NULL);
@@ -154,6 +155,7 @@ class OCCR : public OCC {
                            len,pid);
     CYCLE_END(read);
     END(read_lat);
+    STAGE_END(STAGE_READ);
     return read_set_.size() - 1;
 
 #elif ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_VALIDATE) != 0
@@ -190,6 +192,7 @@ class OCCR : public OCC {
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_READ) != 0
 
     START(read_lat);
+    STAGE_START(STAGE_READ);
     CYCLE_START(read);
     char *data_ptr = (char *)Rmalloc(sizeof(MemNode) + len);
     ASSERT(data_ptr != NULL);
@@ -218,6 +221,7 @@ class OCCR : public OCC {
                            len,pid);
     CYCLE_END(read);
     END(read_lat);
+    STAGE_END(STAGE_READ);
     return write_set_.size() - 1;
 
 #elif ONE_SIDED_READ == 2 && ((HYBRID_CODE & RCC_USE_ONE_SIDED_LOCK) != 0 || (HYBRID_CODE & RCC_USE_ONE_SIDED_RELEASE) != 0 || (HYBRID_CODE & RCC_USE_ONE_SIDED_COMMIT) != 0)
@@ -241,6 +245,14 @@ class OCCR : public OCC {
     return dummy_commit();
 #endif
 
+    if(unlikely(unavailable_)) {
+      // nothing is locked before the commit
+      gc_readset();
+      gc_writeset();
+      write_batch_helper_.clear();
+      return false;
+    }
+
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_LOCK) != 0
 #if USE_DSLR
     if(!lock_writes_w_FA_rdma(yield)) {
@@ -367,9 +379,14 @@ ABORT:
 
   inline bool do_2pc(yield_func_t &yield) {
     START(twopc)
+    STAGE_START(STAGE_2PC);
     bool vote_commit = prepare_commit(yield); // broadcasting prepare messages and collecting votes
-    // broadcast_decision(vote_commit, yield);
+#if TX_TWO_PHASE_COMMIT_STYLE == 2
+    if (vote_commit)
+      broadcast_decision(true, yield); // an abort is decided in prepare_commit
+#endif
     END(twopc);
+    STAGE_END(STAGE_2PC);
     if (!vote_commit) {
       // goto ABORT;
       release_writes(yield);
@@ -58,7 +58,7 @@ class OCCFast : public OCC {
   bool commit(yield_func_t &yield) {
 
     bool ret = true;
-    if(abort_) {
+    if(abort_ || unavailable_) {
       goto ABORT;
     }
 
@@ -152,7 +152,7 @@ class OCCFastR : public OCCR {
   bool commit(yield_func_t &yield) {
 
     bool ret = true;
-    if(abort_) {
+    if(abort_ || unavailable_) {
       goto ABORT;
     }
 
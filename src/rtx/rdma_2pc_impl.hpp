@@ -3,6 +3,7 @@
 #include "core/rdma_sched.h"
 #include "rdmaio.h"
 #include "two_phase_commit_mem_manager.hpp"
+#include "ts_clock.hpp"
 
 namespace nocc {
 namespace rtx {
@@ -14,6 +15,13 @@ namespace rtx {
 using namespace rdmaio;
 using namespace oltp;
 
+/**
+ * One-sided two-phase-commit.
+ * The coordinator writes the prepare record to the participants' request slots, and the
+ * participants write their votes back to the coordinator's vote slots (see RWorker::serve_two_phase_commit).
+ * So the coordinator collects votes by polling its local memory, instead of reading each participant.
+ * A participant which does not vote in TWO_PC_TIMEOUT_US is counted as an abort vote.
+ */
 class RDMATwoPhaseCommitter : public TwoPhaseCommitter {
  public:
   RDMATwoPhaseCommitter(RdmaCtrl *cm, RWorker* worker, RScheduler* rdma_sched,int nid,int tid,uint64_t base_off,
@@ -21,103 +29,77 @@ class RDMATwoPhaseCommitter : public TwoPhaseCommitter {
       :TwoPhaseCommitter(cm, worker),
        twopc_mem_(local_p,ms,ts,cs,base_off),
        scheduler_(rdma_sched),
-       node_id_(nid),worker_id_(tid),local_base_ptr(local_p)
+       node_id_(nid),worker_id_(tid),local_base_ptr(local_p),
+       seqs_(cs + 1,0)
   {
     // init local QP vector
     fill_qp_vec(cm,worker_id_);
   }
 
   inline bool prepare(TXOpBase* tx, BatchOpCtrlBlock &clk, int cor_id, yield_func_t &yield) {
-    memset(clk.req_buf_, TwoPhaseCommitMemManager::TWO_PHASE_PREPARE, sizeof(uint8_t));
-    clk.req_buf_end_ = clk.req_buf_ + sizeof(uint8_t);
-
-    int size = sizeof(uint8_t);
     assert(clk.mac_set_.size() > 0);
-    // post the prepare message to remote participants
+    uint64_t seq = ++seqs_[cor_id];
+    uint64_t rec = TwoPhaseCommitMemManager::encode(seq,TwoPhaseCommitMemManager::TWO_PHASE_PREPARE);
+
+    // post the prepare message to remote participants;
+    // the writes are not waited, since the votes are only written after they arrive
+    auto off = twopc_mem_.request_offset(node_id_,worker_id_,cor_id);
     for(auto it = clk.mac_set_.begin();it != clk.mac_set_.end();++it) {
-      int  mac_id = *it;
-        //auto qp = qp_vec_[mac_id];
-        auto qp = get_qp(mac_id);
-        auto off = twopc_mem_.get_remote_offset(node_id_,worker_id_,cor_id);
-        // auto off = 4096 * (worker_id_ + 1);
-        // LOG(3) << "off " << off << " prepare written.";
-        assert(off != 0);
-        scheduler_->post_send(qp,cor_id,
-                              IBV_WR_RDMA_WRITE,clk.req_buf_,size,off,
-                              IBV_SEND_SIGNALED | ((size < 64)?IBV_SEND_INLINE:0));
+      scheduler_->post_send_pending(get_qp(*it),0,
+                                    IBV_WR_RDMA_WRITE,(char *)&rec,sizeof(uint64_t),off,IBV_SEND_INLINE);
     }
-    tx->abort_cnt[18]++;
-    worker_->indirect_yield(yield);
 
-    // LOG(3) << "COLLECTING VOTES";
-    //fetch the vote message from remote participants
+    // collect the votes written to the local vote slots
+    uint64_t start = TSClock::local_now();
     int n_vote_commit = 0, n_vote_abort = 0;
-
     while (true) {
       n_vote_commit = 0;
       n_vote_abort = 0;
       for (auto it = clk.mac_set_.begin(); it != clk.mac_set_.end(); ++it) {
-        int mac_id = *it;
-          auto qp = get_qp(mac_id);
-          auto off = twopc_mem_.get_remote_offset(node_id_,worker_id_,cor_id);
-
-          // auto off = 4096 * (worker_id_ + 1);
-          assert(off != 0);
-          // char *local_buf = local_base_ptr + worker_id_ * 4096 + cor_id * CACHE_LINE_SZ;
-          scheduler_->post_send(qp,cor_id,
-                                IBV_WR_RDMA_READ, 
-                                // local_buf, 
-                                clk.req_buf_, 
-                                size,
-                                off,
-                                // IBV_SEND_SIGNALED | ((size < 64)?IBV_SEND_INLINE:0)
-                                IBV_SEND_SIGNALED
-                                );
-          tx->abort_cnt[18]++;
-          worker_->indirect_yield(yield);
-
-
-          uint8_t vote = *(uint8_t*)clk.req_buf_;
-          ASSERT(vote == TwoPhaseCommitMemManager::TWO_PHASE_PREPARE ||
-                 vote == TwoPhaseCommitMemManager::VOTE_COMMIT ||
-                 vote == TwoPhaseCommitMemManager::VOTE_ABORT);
-          if (vote == TwoPhaseCommitMemManager::VOTE_COMMIT) {
-            // LOG(3) << "collected vote commit from " << mac_id;
-            n_vote_commit += 1;
-          }
-          if (vote == TwoPhaseCommitMemManager::VOTE_ABORT) {
-            // LOG(3) << "collected vote abort from " << mac_id;
-            n_vote_abort += 1;
-          }
+        uint64_t vote = *(twopc_mem_.get_local_ptr(twopc_mem_.vote_offset(*it,worker_id_,cor_id)));
+        if(TwoPhaseCommitMemManager::seq(vote) != seq)
+          continue; // not voted yet
+        if (TwoPhaseCommitMemManager::type(vote) == TwoPhaseCommitMemManager::VOTE_COMMIT)
+          n_vote_commit += 1;
+        else
+          n_vote_abort += 1;
       }
 
       if (n_vote_commit + n_vote_abort == clk.mac_set_.size())
         break;
+      if (n_vote_abort > 0 || TSClock::local_now() - start > TWO_PC_TIMEOUT_US) {
+        timeouts_ += (n_vote_abort == 0);
+        break;
+      }
       worker_->yield_next(yield);
     }
 
-    return n_vote_commit == clk.mac_set_.size();
+    bool commit = (n_vote_commit == clk.mac_set_.size());
+    if(!commit) {
+      // the participants which have voted commit shall not be left in doubt
+      broadcast_global_decision(tx,clk,TwoPhaseCommitMemManager::TWO_PHASE_DECISION_ABORT,cor_id,yield);
+    }
+    return commit;
   }
 
 
   inline void broadcast_global_decision(TXOpBase* tx, BatchOpCtrlBlock& clk, uint8_t commit_or_abort, int cor_id, yield_func_t& yield) {
-    memset(clk.req_buf_, commit_or_abort, sizeof(uint8_t));
-    clk.req_buf_end_ = clk.req_buf_ + sizeof(uint8_t);
-
-    int size = clk.batch_msg_size(); // log size
     assert(clk.mac_set_.size() > 0);
-    // post the prepare message to remote participants
+    uint64_t rec = TwoPhaseCommitMemManager::encode(seqs_[cor_id],commit_or_abort);
+
+    // published locally, for the in-doubt participants which missed the decision
+    *(twopc_mem_.get_local_ptr(twopc_mem_.decision_offset(worker_id_,cor_id))) = rec;
+
+    auto off = twopc_mem_.request_offset(node_id_,worker_id_,cor_id);
     for(auto it = clk.mac_set_.begin();it != clk.mac_set_.end();++it) {
-      int  mac_id = *it;
-      auto qp = get_qp(mac_id);
-      auto off = twopc_mem_.get_remote_offset(node_id_,worker_id_,cor_id);
-      assert(off != 0);
-      scheduler_->post_send(qp,cor_id,
-                            IBV_WR_RDMA_WRITE,clk.req_buf_,size,off,
-                            IBV_SEND_SIGNALED | ((size < 64)?IBV_SEND_INLINE:0));
+      scheduler_->post_send_pending(get_qp(*it),0,
+                                    IBV_WR_RDMA_WRITE,(char *)&rec,sizeof(uint64_t),off,IBV_SEND_INLINE);
     }
-    tx->abort_cnt[18]++;
-    worker_->indirect_yield(yield);
+  }
+
+  void report() const {
+    fprintf(stdout,"2pc votes timed out %lu, in-doubt rounds resolved %lu\n",
+            timeouts_,twophase_mem->in_doubt(worker_id_));
   }
 
  private:
@@ -127,6 +109,8 @@ class RDMATwoPhaseCommitter : public TwoPhaseCommitter {
   int worker_id_;
   char* local_base_ptr;
   TwoPhaseCommitMemManager twopc_mem_;
+  std::vector<uint64_t> seqs_;  // the 2PC round of each coroutine
+  uint64_t timeouts_ = 0;
 
 #include "qp_selection_helper.h"
 };
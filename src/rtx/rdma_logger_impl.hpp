@@ -3,6 +3,8 @@
 #include "core/rdma_sched.h"
 #include "rdmaio.h"
 
+#include "rdma_req_helper.hpp"
+
 namespace nocc {
 namespace rtx {
 
@@ -22,6 +24,26 @@ class RDMALogger : public Logger {
     fill_qp_vec(cm,worker_id_);
   }
 
+  /**
+   * If some ring is out of credits, re-read its head with a signaled READ.
+   * The log shall wait until the READs complete, and check again.
+   */
+  bool check_credits(BatchOpCtrlBlock &clk,int cor_id) {
+    int size = clk.batch_msg_size();
+    bool res = true;
+    for(auto it = clk.mac_set_.begin();it != clk.mac_set_.end();++it) {
+      int mac_id = *it;
+      if(mem_.has_credits(worker_id_,mac_id,size))
+        continue;
+      scheduler_->post_send(get_qp(mac_id),cor_id,IBV_WR_RDMA_READ,
+                            mem_.cached_head_ptr(worker_id_,mac_id),sizeof(uint64_t),
+                            mem_.remote_head_offset(node_id_,worker_id_),IBV_SEND_SIGNALED);
+      credit_stalls_ += 1;
+      res = false;
+    }
+    return res;
+  }
+
   inline void log_remote(BatchOpCtrlBlock &clk, int cor_id) {
 
     int size = clk.batch_msg_size(); // log size
@@ -31,15 +53,27 @@ class RDMALogger : public Logger {
       int  mac_id = *it;
       //auto qp = qp_vec_[mac_id];
       auto qp = get_qp(mac_id);
+      ASSERT(mem_.has_credits(worker_id_,mac_id,size)) << "log ring to " << mac_id << " overflows";
       auto off = mem_.get_remote_log_offset(node_id_,worker_id_,mac_id,size);
       assert(off != 0);
-      scheduler_->post_send(qp,cor_id,
-                            IBV_WR_RDMA_WRITE,clk.req_buf_,size,off,
-                            IBV_SEND_SIGNALED | ((size < 64)?IBV_SEND_INLINE:0));
+      if(mem_.credits(worker_id_,mac_id) < (int64_t)mem_.ring_size() / 2) {
+        // refresh the head lazily, piggybacked on the log's WRITE
+        RDMALogReq req(cor_id);
+        req.set_head_meta(mem_.remote_head_offset(node_id_,worker_id_),
+                          mem_.cached_head_ptr(worker_id_,mac_id));
+        req.set_write_meta(off,clk.req_buf_,size);
+        req.post_reqs(scheduler_,qp);
+      } else {
+        scheduler_->post_send(qp,cor_id,
+                              IBV_WR_RDMA_WRITE,clk.req_buf_,size,off,
+                              IBV_SEND_SIGNALED | ((size < 64)?IBV_SEND_INLINE:0));
+      }
     }
     // requires yield call after this!
   }
 
+  uint64_t credit_stalls_ = 0; // times which a log waits for the backups
+
  private:
   RScheduler *scheduler_;
   int node_id_;
@@ -351,6 +351,51 @@ class RDMAFAUnlockReq : RDMAReqBase<1> {
 };
 
 
+/**
+ * Raw RDMA req to help append a log to a remote ring.
+ * Here, we assume that:
+ *  - *READ* operation, which refreshes the cached head of the ring; and
+ *  - *WRITE* operation, which writes the log.
+ * are batched using doorbell batching to the same node, so the head is read for free.
+ */
+class RDMALogReq : RDMAReqBase<2> {
+ public:
+  explicit RDMALogReq(int cid) : RDMAReqBase(cid)
+  {
+    sr[0].opcode = IBV_WR_RDMA_READ;
+    sr[1].opcode = IBV_WR_RDMA_WRITE;
+  }
+
+  inline void set_head_meta(uint64_t remote_off,char *local_addr) {
+    sr[0].wr.rdma.remote_addr =  remote_off;
+    sge[0].addr = (uint64_t)local_addr;
+    sge[0].length = sizeof(uint64_t);
+  }
+
+  inline void set_write_meta(uint64_t remote_off,char *local_addr,int size) {
+    sr[1].wr.rdma.remote_addr =  remote_off;
+    sge[1].addr = (uint64_t)local_addr;
+    sge[1].length = size;
+    if(size < 64) {
+      sr[1].send_flags |= IBV_SEND_INLINE;
+    }
+  }
+
+  inline void post_reqs(oltp::RScheduler *s,Qp *qp) {
+
+    sr[0].wr.rdma.remote_addr += qp->remote_attr_.memory_attr_.buf;
+    sr[0].wr.rdma.rkey = qp->remote_attr_.memory_attr_.rkey;
+    sge[0].lkey = qp->dev_->conn_buf_mr->lkey;
+
+    sr[1].wr.rdma.remote_addr += qp->remote_attr_.memory_attr_.buf;
+    sr[1].wr.rdma.rkey = qp->remote_attr_.memory_attr_.rkey;
+    sge[1].lkey = qp->dev_->conn_buf_mr->lkey;
+
+    s->post_batch(qp,cor_id,&(sr[0]),&bad_sr,1);
+  }
+};
+
+
 } // namespace rtx
 
 } // namespace nocc
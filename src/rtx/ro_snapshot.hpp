@@ -0,0 +1,268 @@
+#pragma once
+
+#include "tx_config.h"
+
+#include "tx_operator.hpp"
+#include "global_vars.h"
+#include "rwlock.hpp"
+#include "rdma_req_helper.hpp"
+
+#if MVCC_TX
+#include "mvcc_rdma.h"
+#endif
+
+#include "core/logging.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace nocc {
+
+namespace rtx {
+
+/**
+ * Read-only transactions with a snapshot.
+ * Records are fetched using one-sided READs (or local reads), without any lock, log or 2PC.
+ * Multi-versioned records (MVCC) are read at the newest version before the snapshot timestamp,
+ * which is taken from the coroutine's MVCC clock; the read advances the record's rts, as MVCC's
+ * reads do, so no older writer can commit under the snapshot.
+ * Other records keep the (lock,seq) header and are re-checked once at commit.
+ */
+class ROSnapshot : public TXOpBase {
+  struct ROItem {
+    int      pid;
+    int      tableid;
+    uint64_t key;
+    int      len;
+    int      vnum;     // number of versions stored in the record
+    uint64_t off;      // remote offset of the record's header
+    uint64_t seq;      // seq (or the wts of the version read under MVCC)
+    MemNode *node;     // local node, if any
+    char    *buf;      // header + payload
+    char    *data_ptr; // payload
+
+    ROItem(int p,int t,uint64_t k,int l) :
+        pid(p),tableid(t),key(k),len(l),vnum(1),off(0),seq(0),node(NULL),buf(NULL),data_ptr(NULL) {
+    }
+  };
+
+ public:
+  ROSnapshot(oltp::RWorker *worker,MemDB *db,RRpc *rpc_handler,int nid,int tid,int cid,int response_node,
+             RdmaCtrl *cm,RScheduler* sched,int ms) :
+      TXOpBase(worker,db,rpc_handler,cm,sched,response_node,tid,ms),
+      cor_id_(cid),response_node_(nid) {
+    memset(abort_cnt,0,sizeof(int) * 40);
+    arena_ = (char *)Rmalloc(RO_ARENA_SIZE + sizeof(uint64_t));
+    assert(arena_ != NULL);
+    cas_buf_ = arena_ + RO_ARENA_SIZE;
+    read_set_.reserve(RO_MAX_ITEMS);
+#if MVCC_TX
+    cas_req_ = new RDMACASLockReq(cid);
+#endif
+  }
+
+#if MVCC_TX
+  // the MVCC engine of the same coroutine, whose clock gives the snapshot timestamps
+  void set_clock(MVCC *engine) { clock_ = engine; }
+#endif
+
+  void begin(yield_func_t &yield) {
+    read_set_.clear();
+    arena_used_ = 0;
+#if MVCC_TX
+    assert(clock_ != NULL);
+    snapshot_ts_ = clock_->new_timestamp();
+#endif
+  }
+
+  template <int tableid,typename V>
+  inline __attribute__((always_inline))
+  int read(int pid,uint64_t key,yield_func_t &yield) {
+    return read(pid,tableid,key,sizeof(V),yield);
+  }
+
+  // return -1 if the record is being written before the snapshot
+  int read(int pid,int tableid,uint64_t key,size_t len,yield_func_t &yield) {
+    ASSERT(read_set_.size() < RO_MAX_ITEMS) << "too many records for a read-only TX";
+    read_set_.emplace_back(pid,tableid,key,(int)len);
+    auto &item = read_set_.back();
+    int meta_len = db_->_schemas[tableid].meta_len;
+#if MVCC_TX
+    // only the hash tables are multi-versioned
+    if(meta_len == sizeof(MVCCHeader))
+      item.vnum = MVCC_VERSION_NUM;
+#endif
+    // the buffer also holds the remote MemNode during lookup
+    int buf_len = std::max(meta_len + (int)len * item.vnum,(int)sizeof(MemNode));
+    ASSERT(arena_used_ + buf_len <= RO_ARENA_SIZE) << "read-only TX reads too much: " << read_set_.size();
+    item.buf = arena_ + arena_used_;
+    arena_used_ += (buf_len + 7) & ~7;
+
+    if(pid == node_id_) {
+      item.node = local_lookup_op(tableid,key);
+      assert(item.node != NULL);
+      memcpy(item.buf,item.node->value,meta_len + len * item.vnum);
+    } else {
+      item.off = rdma_read_val(pid,tableid,key,len * item.vnum,item.buf,yield,meta_len);
+    }
+
+    if(!pick_version(item)) {
+      abort_cnt[1]++;
+      return -1;
+    }
+#if MVCC_TX
+    if(item.vnum > 1)
+      advance_rts(item,yield);
+#endif
+    return read_set_.size() - 1;
+  }
+
+  inline char *load_read(int idx,size_t len,yield_func_t &yield) {
+    return read_set_[idx].data_ptr;
+  }
+
+  // validate the read-set once, no lock or log is involved
+  bool commit(yield_func_t &yield) {
+    bool need_yield = false;
+    for(auto &item : read_set_) {
+      if(item.pid == node_id_)
+        continue;
+      Qp *qp = get_qp(item.pid);
+      scheduler_->post_send(qp,cor_id_,IBV_WR_RDMA_READ,item.buf,
+                            db_->_schemas[item.tableid].meta_len,item.off,IBV_SEND_SIGNALED);
+      need_yield = true;
+    }
+    if(need_yield) {
+      abort_cnt[18]++;
+      worker_->indirect_yield(yield);
+    }
+    for(auto &item : read_set_) {
+      char *header = (item.pid == node_id_) ? (char *)(item.node->value) : item.buf;
+      if(!still_valid(header,item)) {
+        abort_cnt[2]++;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void show_abort() {
+    LOG(3) << "read-only TX aborts: read " << abort_cnt[1] << ", validate " << abort_cnt[2];
+  }
+
+ private:
+  static const int RO_MAX_ITEMS  = 256;
+  static const int RO_ARENA_SIZE = 64 * 1024;
+
+  inline bool write_locked(uint64_t lock) const {
+#if defined(NOWAIT_TX) || defined(WAITDIE_TX)
+    return (lock & rwlock::W_LOCKED) != 0; // readers also hold the lock word
+#else
+    return lock != 0;
+#endif
+  }
+
+  inline uint64_t version_of(uint64_t seq) const {
+#if defined(SUNDIAL_TX)
+    return WTS(seq); // lease renewal only bumps the rts
+#else
+    return seq;
+#endif
+  }
+
+  bool pick_version(ROItem &item) {
+    if(item.vnum > 1) {
+      MVCCHeader *header = (MVCCHeader *)item.buf;
+      // an earlier writer may install a version visible to the snapshot
+      if(header->lock != 0 && header->lock < snapshot_ts_)
+        return false;
+      uint64_t max_wts = 0;
+      int pos = -1;
+      for(int i = 0;i < item.vnum;++i) {
+        if(header->wts[i] < snapshot_ts_ && header->wts[i] > max_wts) {
+          max_wts = header->wts[i];
+          pos = i;
+        }
+      }
+      if(pos < 0) {
+        // all versions are newer than the snapshot, catch up the clock for the retry
+#if MVCC_TX
+        for(int i = 0;i < item.vnum;++i)
+          clock_->catch_up_clock(header->wts[i]);
+#endif
+        return false;
+      }
+      item.seq = max_wts;
+      item.data_ptr = item.buf + sizeof(MVCCHeader) + pos * item.len;
+      return true;
+    }
+    RdmaValHeader *header = (RdmaValHeader *)item.buf;
+    if(write_locked(header->lock) || header->seq == CONFLICT_WRITE_FLAG)
+      return false;
+    item.seq = version_of(header->seq);
+    item.data_ptr = item.buf + db_->_schemas[item.tableid].meta_len;
+    return true;
+  }
+
+  bool still_valid(char *h,ROItem &item) const {
+    if(item.vnum > 1) {
+      // the version read must not be recycled, and no newer version before the snapshot appears;
+      // a writer which locked before the rts was advanced may still install one
+      MVCCHeader *header = (MVCCHeader *)h;
+      if(header->lock != 0 && header->lock < snapshot_ts_)
+        return false;
+      bool found = false;
+      for(int i = 0;i < item.vnum;++i) {
+        if(header->wts[i] == item.seq)
+          found = true;
+        else if(header->wts[i] > item.seq && header->wts[i] < snapshot_ts_)
+          return false;
+      }
+      return found;
+    }
+    RdmaValHeader *header = (RdmaValHeader *)h;
+    return !write_locked(header->lock) && version_of(header->seq) == item.seq;
+  }
+
+#if MVCC_TX
+  // advance the rts of the record to the snapshot, so later writers before it abort
+  void advance_rts(ROItem &item,yield_func_t &yield) {
+    if(item.pid == node_id_) {
+      volatile uint64_t *rts_ptr = &(((MVCCHeader *)(item.node->value))->rts);
+      while(true) {
+        uint64_t rts = *rts_ptr;
+        if(rts >= snapshot_ts_ || __sync_bool_compare_and_swap(rts_ptr,rts,snapshot_ts_))
+          break;
+      }
+      return;
+    }
+    Qp *qp = get_qp(item.pid);
+    uint64_t compare = ((MVCCHeader *)item.buf)->rts;
+    while(compare < snapshot_ts_) {
+      cas_req_->set_lock_meta(item.off + sizeof(uint64_t),compare,snapshot_ts_,cas_buf_);
+      cas_req_->post_reqs(scheduler_,qp);
+      worker_->indirect_yield(yield);
+      uint64_t back = *(uint64_t *)cas_buf_;
+      if(back == compare)
+        break;
+      compare = back;
+    }
+  }
+
+  MVCC *clock_ = NULL;
+  RDMACASLockReq *cas_req_ = NULL;
+#endif
+
+  std::vector<ROItem> read_set_;
+  char    *arena_ = NULL;  // registered memory for the one-sided READs
+  int      arena_used_ = 0;
+  char    *cas_buf_ = NULL;
+
+  uint64_t snapshot_ts_ = 0;
+
+  const int cor_id_;
+  const int response_node_;
+};
+
+} // namespace rtx
+} // namespace nocc
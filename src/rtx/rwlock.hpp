@@ -3,17 +3,19 @@
 
 #define USE_RWLOCK 1
 #include <chrono>
-#include <sys/timex.h>
+
+#include "ts_clock.hpp"
 
 // #include "core/rworker.h"
 // #include "db/txs/ts_manager.hpp"
 
 
 // the following macros are used by namespace rwlock
+// the TSClock starts at the process's start, so the 55 bits of time never overflow
 #define R_LEASE(end_time) ((end_time) << (1+8))
-#define END_TIME(state) ((state) >> (1+8) | (get_now_ntp() & (~0x7fffffffffffff)) )
+#define END_TIME(state) ((state) >> (1+8))
 // the following macros are used by namespace rwlock_4_waitdie
-#define START_TIME(state) ((state) >> (1+8) | (get_now_ntp() & (~0x7fffffffffffff)) )
+#define START_TIME(state) ((state) >> (1+8))
 #define LEASE_DURATION(state) (((state) & 0x1ff) >> 1)
 
 // used by sundial 
@@ -45,40 +47,14 @@ const uint64_t DELTA = 50; // 50 micro-seconds
 const uint64_t LEASE_TIME = 3000; // 0.4 milli-seconds
 const uint64_t LEASE_TIME_RPC = 1500;
 
-// get current wall-time to the precision of microseconds
+// get current time of the TSClock to the precision of microseconds
 inline __attribute__((always_inline))
 uint64_t get_now() {
-    using namespace std::chrono;
-    // Get current time with precision of microseconds
-    auto now = time_point_cast<microseconds>(system_clock::now());
-    // sys_microseconds is type time_point<system_clock, microseconds>
-    using sys_microseconds = decltype(now);
-    // Convert time_point to signed integral type
-    auto integral_duration = now.time_since_epoch().count();
-
-    return (uint64_t)integral_duration;
+  return TSClock::now();
 }
 
 inline __attribute__((always_inline))
 uint64_t get_now_ntp() {
-  // ntptimeval tv;
-  // int ret;
-  // if ((ret = ntp_gettime(&tv)) == 0) {
-  //   return (tv.time.tv_sec * 1000000 + tv.time.tv_usec);
-  // } 
-  // else {
-  //   switch(ret) {
-  //   case EFAULT:
-  //     fprintf(stderr,"efault\n");
-  //     break;
-  //   case EOVERFLOW:
-  //     fprintf(stderr,"eoverflow\n");
-  //     break;
-  //   default:
-  //     fprintf(stderr,"gettime ret: %d\n",ret);
-  //   }
-  //   assert(false);
-  // }
   return get_now();
 }
 
@@ -100,14 +76,15 @@ uint64_t LOCKED(uint64_t owner_id) {
   return (((owner_id & 0xff) << 1) | W_LOCKED);
 }
 
+// the margin also covers the skew to the other nodes' clocks
 inline __attribute__((always_inline))
 bool EXPIRED(uint64_t end_time) {
-  return get_now_ntp() > (end_time) + DELTA;
+  return get_now_ntp() > (end_time) + DELTA + TSClock::uncertainty();
 }
 
 inline __attribute__((always_inline))
 bool VALID(uint64_t end_time) {
-  return get_now_ntp() < (end_time) - DELTA;
+  return get_now_ntp() < (end_time) - DELTA - TSClock::uncertainty();
 }
 
 } // namespace rw-lock
@@ -125,40 +102,15 @@ const uint64_t W_LOCKED = 0x1;
 const uint64_t DELTA = 50; // 50 micro-seconds
 const uint64_t LEASE_TIME = 400; // 0.4 milli-seconds
 
-// get current wall-time to the precision of microseconds
+// get current time of the TSClock to the precision of microseconds
 inline __attribute__((always_inline))
 uint64_t get_now() {
-    using namespace std::chrono;
-    // Get current time with precision of microseconds
-    auto now = time_point_cast<microseconds>(system_clock::now());
-    // sys_microseconds is type time_point<system_clock, microseconds>
-    using sys_microseconds = decltype(now);
-    // Convert time_point to signed integral type
-    auto integral_duration = now.time_since_epoch().count();
-
-    return (uint64_t)integral_duration;
+  return TSClock::now();
 }
 
 inline __attribute__((always_inline))
 uint64_t get_now_ntp() {
-  ntptimeval tv;
-  int ret;
-  if ((ret = ntp_gettime(&tv)) == 0) {
-    return (tv.time.tv_sec * 1000000 + tv.time.tv_usec);
-  } 
-  else {
-    switch(ret) {
-    case EFAULT:
-      fprintf(stderr,"efault\n");
-      break;
-    case EOVERFLOW:
-      fprintf(stderr,"eoverflow\n");
-      break;
-    default:
-      fprintf(stderr,"gettime ret: %d\n",ret);
-    }
-    assert(false);
-  }
+  return get_now();
 }
 
 inline __attribute__((always_inline))
@@ -173,12 +125,12 @@ uint64_t W_LOCKED_WORD(uint64_t txn_start_time, uint64_t owner_id) {
 
 inline __attribute__((always_inline))
 bool EXPIRED(uint64_t txn_start_time, uint64_t duration) {
-  return get_now_ntp() > (txn_start_time + duration) + DELTA;
+  return get_now_ntp() > (txn_start_time + duration) + DELTA + TSClock::uncertainty();
 }
 
 inline __attribute__((always_inline))
 bool VALID(uint64_t txn_start_time, uint64_t duration) {
-  return get_now_ntp() < (txn_start_time + duration) - DELTA;
+  return get_now_ntp() < (txn_start_time + duration) - DELTA - TSClock::uncertainty();
 }
 
 } // namespace rwlock_4_waitdie
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ts_clock.hpp"
+
+#include "core/rrpc.h"
+#include "core/logging.h"
+
+namespace nocc {
+
+namespace rtx {
+
+using namespace oltp;
+
+/**
+ * Estimates the offset between the local TSClock and the reference node's,
+ * using Cristian's algorithm over one-shot RPCs.
+ * Among a window of probes, the one with the smallest round trip is used,
+ * and half of its round trip is the uncertainty of the offset.
+ */
+class SkewEstimator {
+  struct TSProbe {
+    uint64_t t0;    // local clock when the probe is sent
+    uint64_t t_ref; // reference clock when the probe is received
+  };
+ public:
+  SkewEstimator(RRpc *rpc,int nid,int probe_rpc_id,int reply_rpc_id,int ref = 0) :
+      rpc_(rpc),node_id_(nid),ref_(ref),
+      probe_rpc_id_(probe_rpc_id),reply_rpc_id_(reply_rpc_id) {
+    ROCC_BIND_STUB(rpc_,&SkewEstimator::probe_handler,this,probe_rpc_id_);
+    ROCC_BIND_STUB(rpc_,&SkewEstimator::reply_handler,this,reply_rpc_id_);
+  }
+
+  // called in the worker's event loop
+  inline void poll() {
+    if(node_id_ == ref_)
+      return;
+    uint64_t now = ::rdtsc();
+    if(now < next_probe_)
+      return;
+    next_probe_ = now + TSClock::us_to_cycles(SKEW_PROBE_INTERVAL_US);
+
+    char *msg = rpc_->get_fly_buf(0);
+    ((TSProbe *)msg)->t0 = TSClock::local_now();
+    rpc_->append_req(msg,probe_rpc_id_,sizeof(TSProbe),0,RRpc::REQ,ref_);
+  }
+
+ private:
+  // at the reference node
+  void probe_handler(int id,int cid,char *msg,void *arg) {
+    char *reply = rpc_->get_reply_buf();
+    ((TSProbe *)reply)->t0 = ((TSProbe *)msg)->t0;
+    ((TSProbe *)reply)->t_ref = TSClock::now();
+    rpc_->append_req(reply,reply_rpc_id_,sizeof(TSProbe),0,RRpc::REQ,id);
+  }
+
+  void reply_handler(int id,int cid,char *msg,void *arg) {
+    TSProbe *probe = (TSProbe *)msg;
+    uint64_t t1 = TSClock::local_now();
+    uint64_t rtt = t1 - probe->t0;
+    if(rtt < best_rtt_) {
+      best_rtt_ = rtt;
+      best_offset_ = (int64_t)probe->t_ref - (int64_t)(probe->t0 + rtt / 2);
+    }
+    if(++samples_ < SKEW_WINDOW)
+      return;
+
+    if(TSClock::uncertainty() == 0)
+      LOG(2) << "clock offset to node " << ref_ << ": " << best_offset_ << "us, +-" << best_rtt_ / 2 << "us";
+    TSClock::adjust(best_offset_,best_rtt_ / 2 + 1);
+    samples_ = 0;
+    best_rtt_ = UINT64_MAX;
+  }
+
+  RRpc *rpc_;
+  const int node_id_;
+  const int ref_;
+  const int probe_rpc_id_;
+  const int reply_rpc_id_;
+
+  uint64_t next_probe_ = 0;
+  int      samples_ = 0;
+  uint64_t best_rtt_ = UINT64_MAX;
+  int64_t  best_offset_ = 0;
+};
+
+} // namespace rtx
+} // namespace nocc
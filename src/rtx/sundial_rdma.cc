@@ -37,6 +37,7 @@ bool SUNDIAL::try_update_rdma(yield_func_t &yield) {
   RDMAWriteReq req(cor_id_,PA /* whether to use passive ack*/);
   bool need_yield = false;
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   for(auto& item : write_set_){
     if(item.pid != node_id_) {
       RdmaValHeader *header = (RdmaValHeader*)(item.data_ptr - sizeof(RdmaValHeader));
@@ -78,6 +79,7 @@ bool SUNDIAL::try_update_rdma(yield_func_t &yield) {
     worker_->indirect_yield(yield);
   }
   END(commit);
+  STAGE_END(STAGE_COMMIT);
   return true;
 }
 
@@ -85,6 +87,7 @@ bool SUNDIAL::try_update_rpc(yield_func_t &yield) {
   start_batch_rpc_op(write_batch_helper_);
   bool need_send = false;
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   for(auto& item : write_set_){
     if(item.pid != node_id_) {//
     // if(item.pid != response_node_) {//
@@ -111,6 +114,7 @@ bool SUNDIAL::try_update_rpc(yield_func_t &yield) {
 #endif
   }
   END(commit);
+  STAGE_END(STAGE_COMMIT);
   return true;
 }
 
@@ -143,23 +147,28 @@ void SUNDIAL::log_remote(yield_func_t &yield) {
         << "FaSST should uses rep-factor's log entries, current num "
         << cblock.mac_set_.size() << "; rep-factor " << global_view->rep_factor_;
 #else
-    for(auto it = write_batch_helper_.mac_set_.begin();
-        it != write_batch_helper_.mac_set_.end();++it) {
-      global_view->add_backup(*it,cblock.mac_set_);
-    }
-    // add local server
-    global_view->add_backup(current_partition,cblock.mac_set_);
+    // the backups of the written partitions, which keep the written tables
+    for(auto it = write_set_.begin();it != write_set_.end();++it)
+      global_view->add_backup_of_table(it->pid,it->tableid,cblock.mac_set_);
+    if(cblock.mac_set_.empty())
+      return; // only the tables without backups are written
 #endif
 
 #if CHECKS
     LOG(3) << "log to " << cblock.mac_set_.size() << " macs";
 #endif
 
+    // wait for the backups to free enough space in the log rings
+    while(!logger_->check_credits(cblock,cor_id_))
+      worker_->indirect_yield(yield);
+
     START(log);
+    STAGE_START(STAGE_LOG);
     logger_->log_remote(cblock,cor_id_);
     abort_cnt[18]++;
     worker_->indirect_yield(yield);
     END(log);
+    STAGE_END(STAGE_LOG);
 #if 1
     cblock.req_buf_ = rpc_->get_fly_buf(cor_id_);
     memcpy(cblock.req_buf_,write_batch_helper_.req_buf_,write_batch_helper_.batch_msg_size());
@@ -168,6 +177,11 @@ void SUNDIAL::log_remote(yield_func_t &yield) {
     logger_->log_ack(cblock,cor_id_); // need to yield
     abort_cnt[18]++;
     worker_->indirect_yield(yield);
+#if LOG_ACK_BATCH && !PA
+    // the acks are batched, so wait for the backups' watermarks
+    while(!logger_->log_acked(cblock,cor_id_))
+      worker_->yield_next(yield);
+#endif
 #endif
   }
 }
@@ -210,7 +224,9 @@ void SUNDIAL::update_rpc_handler(int id,int cid,char *msg,void *arg) {
 bool SUNDIAL::try_renew_all_lease_rdma(uint32_t commit_id, yield_func_t &yield) {
   bool need_yield = false;
   START(renew_lease);
+  STAGE_START(STAGE_VALIDATE);
   for(auto& item : read_set_) {
+    if(global_view->is_replicated(item.tableid)) continue; // has no lease
     if(item.pid != node_id_) {
       Qp *qp = get_qp(item.pid);
       assert(qp != NULL);
@@ -234,6 +250,7 @@ bool SUNDIAL::try_renew_all_lease_rdma(uint32_t commit_id, yield_func_t &yield)
   }
   need_yield = false;
   for(auto& item : read_set_) {
+    if(global_view->is_replicated(item.tableid)) continue;
     RdmaValHeader* header = (RdmaValHeader*)((char*)item.data_ptr - sizeof(RdmaValHeader));
     uint32_t node_rts = RTS(header->seq);
     uint32_t node_wts = WTS(header->seq);
@@ -266,6 +283,7 @@ bool SUNDIAL::try_renew_all_lease_rdma(uint32_t commit_id, yield_func_t &yield)
     }
   }
   END(renew_lease);
+  STAGE_END(STAGE_VALIDATE);
   return true;
 }
 
@@ -276,7 +294,7 @@ bool SUNDIAL::try_renew_all_lease_rpc(uint32_t commit_id, yield_func_t &yield) {
   start_batch_rpc_op(write_batch_helper_);
   bool need_send = false;
   for(auto& item : read_set_) {
-    if (item.rts >= commit_id)
+    if (item.rts >= commit_id || global_view->is_replicated(item.tableid))
               continue;
 
     if(item.pid != node_id_) {
@@ -316,6 +334,7 @@ bool SUNDIAL::try_renew_all_lease_rpc(uint32_t commit_id, yield_func_t &yield) {
 bool SUNDIAL::try_renew_lease_rdma(int index, uint32_t commit_id, yield_func_t &yield) {
   auto& item = read_set_[index];
   START(renew_lease);
+  STAGE_START(STAGE_VALIDATE);
   Qp *qp = get_qp(item.pid);
   assert(qp != NULL);
   abort_cnt[36]++;
@@ -350,6 +369,7 @@ bool SUNDIAL::try_renew_lease_rdma(int index, uint32_t commit_id, yield_func_t &
       // }
     }
     END(renew_lease);
+    STAGE_END(STAGE_VALIDATE);
     abort_cnt[35]++;
     Rfree(local_buf);
     return true;
@@ -398,6 +418,7 @@ bool SUNDIAL::try_renew_lease_rpc(uint8_t pid, uint8_t tableid, uint64_t key, ui
   // if(pid != response_node_) {
   if(pid != node_id_) {
     START(renew_lease);
+    STAGE_START(STAGE_VALIDATE);
     rpc_op<RTXRenewLeaseItem>(cor_id_, RTX_RENEW_LEASE_RPC_ID, pid,
                                  rpc_op_send_buf_,reply_buf_,
                                  /*init RTXRenewLeaseItem*/
@@ -405,6 +426,7 @@ bool SUNDIAL::try_renew_lease_rpc(uint8_t pid, uint8_t tableid, uint64_t key, ui
     abort_cnt[18]++;
     worker_->indirect_yield(yield);
     END(renew_lease);
+    STAGE_END(STAGE_VALIDATE);
 
     uint8_t resp_status = *(uint8_t*)reply_buf_;
     if(resp_status == LOCK_SUCCESS_MAGIC)
@@ -843,6 +865,7 @@ void SUNDIAL::release_reads(yield_func_t &yield) {
 
 void SUNDIAL::release_writes(yield_func_t &yield, bool all) {
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   int release_num = write_set_.size();
   if(!all)
     release_num -= 1;
@@ -906,6 +929,7 @@ void SUNDIAL::release_writes(yield_func_t &yield, bool all) {
   }
 #endif
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 void SUNDIAL::release_rpc_handler(int id,int cid,char *msg,void *arg) {
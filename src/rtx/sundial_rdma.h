@@ -80,6 +80,7 @@ protected:
 
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_READ) != 0
     START(read_lat);
+    STAGE_START(STAGE_READ);
     if(!try_read_rdma(index, yield)) {
       // abort
       abort_cnt[33]++;
@@ -87,11 +88,14 @@ protected:
       release_writes(yield);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
     END(read_lat);
+    STAGE_END(STAGE_READ);
 #elif ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_RENEW) != 0
     START(read_lat);
+    STAGE_START(STAGE_READ);
     if(!try_read_rpc(index, yield)) {
       // abort
       abort_cnt[11]++;
@@ -99,6 +103,7 @@ protected:
       release_writes(yield);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
 
@@ -110,8 +115,10 @@ protected:
     
     process_received_data(reply_buf_, read_set_.back(), false);
     END(read_lat);
+    STAGE_END(STAGE_READ);
 #else
     START(read_lat);
+    STAGE_START(STAGE_READ);
     if(!try_read_rpc(index, yield)) {
       // abort
       abort_cnt[14]++;
@@ -119,10 +126,12 @@ protected:
       release_writes(yield);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
     process_received_data(reply_buf_, read_set_.back(), false);
     END(read_lat);
+    STAGE_END(STAGE_READ);
 #endif
     return index;
   }
@@ -143,6 +152,7 @@ protected:
     // sundial exec: lock the remote record and get the info
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_LOCK) != 0
     START(lock);
+    STAGE_START(STAGE_LOCK);
     if(!try_lock_read_rdma(index, yield)) {
       // abort
       abort_cnt[9]++;
@@ -150,11 +160,14 @@ protected:
       release_writes(yield, false);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
     END(lock);
+    STAGE_END(STAGE_LOCK);
 #elif ONE_SIDED_READ == 2 && ((HYBRID_CODE & RCC_USE_ONE_SIDED_RELEASE) != 0 || (HYBRID_CODE & RCC_USE_ONE_SIDED_COMMIT) != 0)
     START(lock);
+    STAGE_START(STAGE_LOCK);
     if(!try_lock_read_rpc(index, yield)) {
       // abort
       abort_cnt[10]++;
@@ -162,6 +175,7 @@ protected:
       release_writes(yield, false);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
 
@@ -173,8 +187,10 @@ protected:
 
     process_received_data(reply_buf_, write_set_.back(), true);
     END(lock);
+    STAGE_END(STAGE_LOCK);
 #else
     START(lock);
+    STAGE_START(STAGE_LOCK);
     if(!try_lock_read_rpc(index, yield)) {
       // abort
       abort_cnt[10]++;
@@ -182,10 +198,12 @@ protected:
       release_writes(yield, false);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
     process_received_data(reply_buf_, write_set_.back(), true);
     END(lock);
+    STAGE_END(STAGE_LOCK);
 #endif // ONE_SIDED_READ
     return index;
   }
@@ -280,14 +298,16 @@ public:
         lock_req_ = new RDMACASLockReq(cid);
         unlock_req_ = new RDMAFAUnlockReq(cid, 0);
         memset(abort_cnt, 0, sizeof(int) * 40);
-        for(int i = 0; i < 100; ++i) {
-          Rmempool[i] = (char*)Rmalloc(2048);
+        for(int i = 0; i < kMempoolBufs; ++i) {
+          Rmempool[i] = (char*)Rmalloc(kMempoolBufSize);
           memptr = 0;
         }
       }
 
   inline __attribute__((always_inline))
   virtual int write(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
+    if(unlikely((pid = route(pid)) < 0))
+      return -1;
     return remote_write(pid, tableid, key, len, yield);
   }
 
@@ -299,11 +319,17 @@ public:
 
   inline __attribute__((always_inline))
   virtual int read(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    if(tableid == 7) {
+    if(global_view->is_replicated(tableid)) {
+      // read-only and loaded at every node, so it is read locally without concurrency control;
+      // the copy is in the TX's memory pool, which is reused by the next TX
+      assert(len <= kMempoolBufSize && memptr < kMempoolBufs);
       int idx = read_set_.size();
-      read_set_.emplace_back(tableid,key,(MemNode*)NULL,(char*)NULL,0,len,0);
+      read_set_.emplace_back(tableid,key,(MemNode*)NULL,
+                             local_replicated_get(tableid,key,len,Rmempool[memptr++]),0,len,node_id_);
       return idx;
     }
+    if(unlikely((pid = route(pid)) < 0))
+      return -1;
     return remote_read(pid, tableid, key, len, yield);
   }
 
@@ -315,12 +341,16 @@ public:
 
   inline __attribute__((always_inline))
   virtual char* load_write(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     assert(write_set_[idx].data_ptr != NULL);
     return write_set_[idx].data_ptr;
   }
 
   inline __attribute__((always_inline))
   virtual char* load_read(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     auto& item = read_set_[idx];
     assert(item.data_ptr != NULL);
     return item.data_ptr;
@@ -371,14 +401,16 @@ public:
 
   // start a TX
   virtual void begin(yield_func_t &yield) {
+    unavailable_ = false;
     memptr = 0;
     read_set_.clear();
     write_set_.clear();
-    txn_start_time = (rwlock::get_now()<<11) + response_node_ * 200 + worker_id_*20 + cor_id_ + 1;;
+    txn_start_time = TSClock::tx_timestamp(last_start_time_,11,response_node_ * 200 + worker_id_*20 + cor_id_ + 1);
   }
 
   bool prepare(yield_func_t &yield) {
     START(renew_lease);
+    STAGE_START(STAGE_VALIDATE);
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_RENEW) != 0
     if(!try_renew_all_lease_rdma(commit_id_, yield)) {
 #else
@@ -393,10 +425,18 @@ public:
       return false;
     }
     END(renew_lease);
+    STAGE_END(STAGE_VALIDATE);
     return true;
   }
 
   virtual bool commit(yield_func_t &yield) {
+    if(unlikely(unavailable_)) {
+      release_reads(yield);
+      release_writes(yield);
+      gc_readset();
+      gc_writeset();
+      return false;
+    }
     if(!prepare(yield)) {
       abort_cnt[17]++;
       release_reads(yield);
@@ -408,9 +448,14 @@ public:
 
 #if TX_TWO_PHASE_COMMIT_STYLE > 0
     START(twopc)
+    STAGE_START(STAGE_2PC);
     bool vote_commit = prepare_commit(yield); // broadcasting prepare messages and collecting votes
-    // broadcast_decision(vote_commit, yield);
+#if TX_TWO_PHASE_COMMIT_STYLE == 2
+    if (vote_commit)
+      broadcast_decision(true, yield); // an abort is decided in prepare_commit
+#endif
     END(twopc);
+    STAGE_END(STAGE_2PC);
     if (!vote_commit) {
       abort_cnt[17]++;
       release_reads(yield);
@@ -494,7 +539,9 @@ protected:
   Logger *logger_       = NULL;
   TwoPhaseCommitter *two_phase_committer_ = NULL;
 
-  char* Rmempool[100];
+  static const int kMempoolBufs    = 100;
+  static const int kMempoolBufSize = 2048;
+  char* Rmempool[kMempoolBufs];
   int memptr = 0;
 
   char* rpc_op_send_buf_;
@@ -502,6 +549,7 @@ protected:
 
   uint64_t txn_start_time = 0;
   uint64_t txn_end_time = 0;
+  uint64_t last_start_time_ = 0;
 
 public:
 #include "occ_statistics.h"
@@ -0,0 +1,31 @@
+#include "ts_clock.hpp"
+
+#include "core/logging.h"
+
+#include <chrono>
+
+namespace nocc {
+
+namespace rtx {
+
+uint64_t TSClock::base_tsc_ = 0;
+double   TSClock::us_per_cycle_ = 0;
+volatile int64_t  TSClock::offset_ = 0;
+volatile uint64_t TSClock::uncertainty_ = 0;
+
+void TSClock::calibrate() {
+  using namespace std::chrono;
+  auto     w0 = steady_clock::now();
+  uint64_t c0 = ::rdtsc();
+  usleep(TS_CALIBRATE_US);
+  auto     w1 = steady_clock::now();
+  uint64_t c1 = ::rdtsc();
+
+  double elapsed_us = duration_cast<nanoseconds>(w1 - w0).count() / 1000.0;
+  us_per_cycle_ = elapsed_us / (double)(c1 - c0);
+  base_tsc_ = c1;
+  LOG(2) << "TSC calibrated, " << 1.0 / us_per_cycle_ << " cycles per us.";
+}
+
+} // namespace rtx
+} // namespace nocc
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "util/util.h" // rdtsc
+
+#include <stdint.h>
+
+namespace nocc {
+
+namespace rtx {
+
+#define TS_CALIBRATE_US        100000 // time used to calibrate the TSC
+#define SKEW_PROBE_INTERVAL_US 10000  // interval between two skew probes
+#define SKEW_WINDOW            8      // probes per skew estimation
+
+/**
+ * A loosely synchronized clock in micro-seconds, built on the calibrated TSC.
+ * Reading it costs a rdtsc and a multiplication, instead of a call to the system clock.
+ *
+ * Each node's local clock starts at its calibration. The SkewEstimator aligns it to the
+ * reference node by an offset, and records the uncertainty of the alignment,
+ * which shall be added to the lease's safety margin.
+ */
+class TSClock {
+ public:
+  // shall be called once per process, before any TX begins
+  static void calibrate();
+
+  // the aligned clock, in micro-seconds
+  static inline __attribute__((always_inline))
+  uint64_t now() {
+    int64_t res = (int64_t)local_now() + offset_;
+    return res > 0 ? res : 0;
+  }
+
+  static inline __attribute__((always_inline))
+  uint64_t local_now() {
+    return (uint64_t)((::rdtsc() - base_tsc_) * us_per_cycle_);
+  }
+
+  static inline uint64_t us_to_cycles(uint64_t us) {
+    return (uint64_t)(us / us_per_cycle_);
+  }
+
+  /**
+   * A TX timestamp: | now() | id (shift bits) |.
+   * It is monotonic per coroutine (last is the coroutine's previous timestamp),
+   * even if the offset is moved backward by the estimator.
+   */
+  static inline __attribute__((always_inline))
+  uint64_t tx_timestamp(uint64_t &last,int shift,uint64_t id) {
+    uint64_t res = (now() << shift) + id;
+    if(unlikely(res <= last))
+      res = last + (1ULL << shift);
+    last = res;
+    return res;
+  }
+
+  // called by the SkewEstimator
+  static void adjust(int64_t offset,uint64_t uncertainty) {
+    offset_ = offset;
+    uncertainty_ = uncertainty;
+  }
+
+  static inline int64_t  offset()      { return offset_; }
+  static inline uint64_t uncertainty() { return uncertainty_; }
+
+ private:
+  static uint64_t base_tsc_;
+  static double   us_per_cycle_;
+  static volatile int64_t  offset_;
+  static volatile uint64_t uncertainty_;
+};
+
+} // namespace rtx
+} // namespace nocc
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <vector>
 
 #include "core/logging.h"
 
@@ -8,6 +9,19 @@ namespace nocc {
 
 namespace rtx {
 
+/**
+ * The RDMA status area of the one-sided two-phase-commit.
+ * Each slot is a 8-byte record: | seq (56 bits) | type (8 bits) |, where seq numbers
+ * the 2PC rounds of a coordinator coroutine, so that stale records are ignored.
+ *
+ * The area has four parts:
+ *  - request:  at the participant, [coord mac][coord tid][coord cid], written by the coordinator
+ *              with the prepare message and the decision;
+ *  - vote:     at the coordinator, [participant mac][tid][cid], written by the participants;
+ *  - inquiry:  at the participant, the same index as request, where an in-doubt participant
+ *              reads the coordinator's decision into;
+ *  - decision: at the coordinator, [tid][cid], the decision of the last round.
+ */
 class TwoPhaseCommitMemManager {
  public:
   TwoPhaseCommitMemManager(char *local_p,int ms,int ts,int cs, uint64_t base_off = 0) :
@@ -15,48 +29,74 @@ class TwoPhaseCommitMemManager {
       thread_num_(ts),
       coroutine_num_(cs),
       local_buffer_(local_p),
-      base_offset_(base_off)
+      base_offset_(base_off),
+      voted_at_(ms * ts * (cs + 1),0),
+      in_doubt_(ts,0)
   {
-    thread_buf_size_ = coroutine_num_ * sizeof(uint8_t);
+    thread_buf_size_ = (coroutine_num_ + 1) * sizeof(uint64_t); // coroutine ids start from 1
     mac_buf_size_ = thread_num_ * thread_buf_size_;
+    area_size_ = mac_buf_size_ * mac_num_;
   }
 
   ~TwoPhaseCommitMemManager() {}
 
   inline uint64_t total_size() {
-    return mac_buf_size_ * mac_num_;
+    return area_size_ * 3 + mac_buf_size_;
   }
 
+  static inline uint64_t encode(uint64_t seq,uint8_t type) { return (seq << 8) | type; }
+  static inline uint64_t seq(uint64_t rec)  { return rec >> 8; }
+  static inline uint8_t  type(uint64_t rec) { return rec & 0xff; }
 
-  inline uint64_t get_remote_offset(int from_mac,int from_tid,int from_cid) {
-    return from_mac * mac_buf_size_ +
-           from_tid * thread_buf_size_ +
-           from_cid * sizeof(uint8_t);
-           + base_offset_; // the start pointer of 2pc status area
+  inline uint64_t request_offset(int from_mac,int from_tid,int from_cid) {
+    return base_offset_ + slot_offset(from_mac,from_tid,from_cid);
   }
 
-  inline char *get_local_ptr(int from_mac,int from_tid,int from_cid) {
-    return (char *)local_buffer_ + get_remote_offset(from_mac, from_tid, from_cid);
+  inline uint64_t vote_offset(int from_mac,int tid,int cid) {
+    return base_offset_ + area_size_ + slot_offset(from_mac,tid,cid);
   }
 
+  inline uint64_t inquiry_offset(int from_mac,int from_tid,int from_cid) {
+    return base_offset_ + area_size_ * 2 + slot_offset(from_mac,from_tid,from_cid);
+  }
+
+  inline uint64_t decision_offset(int tid,int cid) {
+    return base_offset_ + area_size_ * 3 + slot_offset(0,tid,cid);
+  }
+
+  inline volatile uint64_t *get_local_ptr(uint64_t off) {
+    return (volatile uint64_t *)(local_buffer_ + off);
+  }
+
+  // the local time a participant voted in the slot, to detect in-doubt rounds
+  inline uint64_t &voted_at(int from_mac,int from_tid,int from_cid) {
+    return voted_at_[slot_offset(from_mac,from_tid,from_cid) / sizeof(uint64_t)];
+  }
+
+  // number of in-doubt rounds resolved by the participant thread
+  inline uint64_t &in_doubt(int tid) { return in_doubt_[tid]; }
+
   // total number of machines
   const int mac_num_;
 
   // total number of thread
   const int thread_num_;
 
-  // total number of coroutines 
+  // total number of coroutines
   const int coroutine_num_;
 
-  // the start pointer of 2pc status area
-  const char *local_buffer_;
+  // the start pointer of the RDMA buffer
+  char *local_buffer_;
 
   // total buffer used at each thread
   int thread_buf_size_;
-  
-  // total log size used by one mac
+
+  // total buffer used by one mac
   int mac_buf_size_;
 
+  // size of each part of the area
+  uint64_t area_size_;
+
   enum {
     TWO_PHASE_PREPARE=129,
     TWO_PHASE_DECISION_COMMIT=131,
@@ -64,9 +104,16 @@ class TwoPhaseCommitMemManager {
     VOTE_COMMIT=151,
     VOTE_ABORT=153
   } TwoPhaseCommitterMsgType;
-  
+
  private:
-  uint64_t base_offset_;
+  inline uint64_t slot_offset(int mac,int tid,int cid) {
+    return mac * mac_buf_size_ + tid * thread_buf_size_ + cid * sizeof(uint64_t);
+  }
+
+  uint64_t base_offset_; // the start offset of 2pc status area
+
+  std::vector<uint64_t> voted_at_;
+  std::vector<uint64_t> in_doubt_;
 };
 }; // namespace rtx
 
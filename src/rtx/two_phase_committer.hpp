@@ -25,6 +25,8 @@ class TwoPhaseCommitter {
 
   virtual void broadcast_global_decision(TXOpBase* tx, BatchOpCtrlBlock& clk, uint8_t commit_or_abort, int cor_id, yield_func_t& yield) = 0;
 
+  virtual void report() const {}
+
  protected:
   RdmaCtrl *cm_;
   RWorker *worker_;
@@ -23,6 +23,15 @@
 #define RTX_LOCK_READ_RPC_ID 14
 #define RTX_2PC_PREPARE_RPC_ID 15
 #define RTX_2PC_DECIDE_RPC_ID 16
+#define RTX_CALVIN_INPUT_RPC_ID   17
+#define RTX_CALVIN_FORWARD_RPC_ID 18
+#define RTX_TS_PROBE_RPC_ID 19
+#define RTX_TS_REPLY_RPC_ID 20
+#define RTX_HEARTBEAT_RPC_ID 21
+#define RTX_VIEW_CHANGE_RPC_ID 22
+#define RTX_LOG_WATERMARK_RPC_ID 23
+#define RTX_CALVIN_RECON_RPC_ID   24
+#define RTX_CALVIN_RETRY_RPC_ID   25
 #endif
 
 namespace nocc {
@@ -86,6 +95,10 @@ class TXOpBase {
 
   MemNode *local_insert_op(int tableid,uint64_t key,uint64_t &seq);
 
+  // a copy of the record of a replicated (read-only) table, read at the local store;
+  // into val, or into a malloced buffer if val is NULL
+  char *local_replicated_get(int tableid,uint64_t key,int len,char *val = NULL);
+
   // NULL: lock failed
   MemNode *local_try_lock_op(int tableid,uint64_t key,uint64_t lock_content);
   bool     local_try_lock_op(MemNode *node,uint64_t lock_content);
@@ -144,6 +157,27 @@ class TXOpBase {
   MemDB *db_       = NULL;
   int abort_cnt[40];
 
+  // the record which caused the last abort, consumed by the contention manager
+  int      conflict_tableid_ = -1;
+  uint64_t conflict_key_     = 0;
+
+  inline void record_conflict(int tableid,uint64_t key) {
+    conflict_tableid_ = tableid;
+    conflict_key_     = key;
+  }
+
+  /**
+   * The node which serves partition pid in the current view, which the TX accesses instead of pid.
+   * If the partition is being taken over, returns -1, and the TX is unavailable: its accesses
+   * to the partition return -1, its commit aborts, and the worker drops it rather than retrying.
+   */
+  int route(int pid);
+
+  inline bool unavailable() const { return unavailable_; }
+
+  // the value of an access which returned -1 for an unavailable partition, zeroed
+  char *unavailable_val(size_t len);
+
  protected:
   RWorker *worker_ = NULL;
   RRpc  *rpc_      = NULL;
@@ -156,6 +190,10 @@ class TXOpBase {
   int node_id_;
   int worker_id_;
 
+  bool unavailable_ = false; // reset by begin
+  static const int kUnavailableValSize = 4096;
+  char unavailable_val_[kUnavailableValSize];
+
   DISABLE_COPY_AND_ASSIGN(TXOpBase);
 }; // TX ops
 
@@ -25,6 +25,15 @@
 #define RTX_LOCK_READ_RPC_ID 14
 #define RTX_2PC_PREPARE_RPC_ID 15
 #define RTX_2PC_DECIDE_RPC_ID 16
+#define RTX_CALVIN_INPUT_RPC_ID   17
+#define RTX_CALVIN_FORWARD_RPC_ID 18
+#define RTX_TS_PROBE_RPC_ID 19
+#define RTX_TS_REPLY_RPC_ID 20
+#define RTX_HEARTBEAT_RPC_ID 21
+#define RTX_VIEW_CHANGE_RPC_ID 22
+#define RTX_LOG_WATERMARK_RPC_ID 23
+#define RTX_CALVIN_RECON_RPC_ID   24
+#define RTX_CALVIN_RETRY_RPC_ID   25
 #endif
 
 namespace nocc {
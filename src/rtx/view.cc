@@ -5,26 +5,101 @@ namespace nocc {
 
 namespace rtx {
 
-void SymmetricView::assign_backups(int total) {
+PlacementConfig placement_config;
+
+int SymmetricView::max_rep_factor(int default_rep,const PlacementConfig &placement) {
+  int res = default_rep;
+  for(auto &p : placement.backups)
+    res = std::max(res,(int)p.second.size());
+  return res;
+}
+
+void SymmetricView::assign_backups(int total,const PlacementConfig &placement) {
   ASSERT(rep_factor_ <= RTX_MAX_BACKUP) << "Too many backups supported.";
   LOG(2) << "total " << total <<" backups to assign";
   for(uint i = 0;i < total;++i) {
-    mapping_.emplace_back(rep_factor_);
-    assign_one(i,total);
+    auto it = placement.backups.find(i);
+    if(it == placement.backups.end()) {
+      mapping_.emplace_back(default_rep_);
+      assign_one(i,total);
+      continue;
+    }
+    // explicit placement
+    mapping_.emplace_back(it->second.size());
+    for(uint j = 0;j < it->second.size();++j) {
+      int b = it->second[j];
+      ASSERT(b >= 0 && b < total && b != (int)i && !is_backup(b,i,j))
+          << "invalid backup " << b << " of partition " << i;
+      mapping_[i][j] = b;
+    }
   }
 }
 
 void SymmetricView::assign_one(int idx,int total) {
 
-  ASSERT(total > rep_factor_) << "Cannot assign backups properly. Total mac " << total
-                              << "; rep factor " << rep_factor_;
-  for(uint i = 0;i < rep_factor_;++i) {
+  ASSERT(total > default_rep_) << "Cannot assign backups properly. Total mac " << total
+                               << "; rep factor " << default_rep_;
+  for(uint i = 0;i < default_rep_;++i) {
     // uses static mapping.
     // maybe we can use a random strategy
     mapping_[idx][i] = (idx + i + 1) % (total);
   }
 }
 
+void SymmetricView::assign_tables(const PlacementConfig &placement) {
+  for(auto &t : placement.table_rep) {
+    if(t.first >= (int)table_rep_.size())
+      table_rep_.resize(t.first + 1,-1);
+    table_rep_[t.first] = t.second;
+    LOG(2) << "table " << t.first << " is logged to " << t.second << " backups.";
+  }
+  for(auto t : placement.replicated) {
+    // a replicated table is not written, so it is not logged
+    if(t >= (int)table_rep_.size())
+      table_rep_.resize(t + 1,-1);
+    table_rep_[t] = 0;
+    if(t >= (int)replicated_.size())
+      replicated_.resize(t + 1,false);
+    replicated_[t] = true;
+    LOG(2) << "table " << t << " is replicated at every node.";
+  }
+}
+
+void SymmetricView::fail(int nid,uint64_t epoch,std::vector<std::pair<int,int> > &promoted) {
+  alive_[nid] = false;
+  epoch_ = epoch;
+  for(int pid = 0;pid < total_mac_;++pid) {
+    if(primary_[pid] != nid && taking_over_[pid] != nid)
+      continue;
+    // the records are at the backups of the source, rather than at the ones of pid,
+    // if pid has been taken over before
+    int src  = source_[pid];
+    int next = -1;
+    for(uint i = 0;i < mapping_[src].rep_factor;++i) {
+      if(alive_[mapping_[src][i]]) {
+        next = mapping_[src][i];
+        break;
+      }
+    }
+    primary_[pid]     = -1;
+    taking_over_[pid] = next;
+    if(next < 0) {
+      LOG(4) << "partition " << pid << " has no alive backup to take over.";
+      continue;
+    }
+    promoted.push_back(std::make_pair(pid,next));
+  }
+}
+
+bool SymmetricView::promote(int pid,int nid) {
+  if(taking_over_[pid] != nid)
+    return false;
+  taking_over_[pid] = -1;
+  source_[pid]      = nid;
+  primary_[pid]     = nid;
+  return true;
+}
+
 void SymmetricView::print() {
   for(uint i = 0;i < mapping_.size();++i) {
     LOG(2) << "Mac [" << i << "] backed by " << mapping_[i];
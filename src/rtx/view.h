@@ -5,6 +5,9 @@
 #include <vector>
 #include <algorithm>
 #include <set>
+#include <map>
+#include <atomic>
+#include <memory>
 
 #include "core/logging.h"
 
@@ -35,26 +38,62 @@ struct BackupInfo {
   }
 };
 
+/**
+ * Replica placement, filled by the runner from config.xml:
+ *  <placement>
+ *    <partition><id>0</id><backups>2 3</backups></partition>  explicit backups of a partition
+ *    <table><id>2</id><rep_factor>1</rep_factor></table>     logs of a table go to its partitions' first backups only
+ *    <table><id>7</id><replicated>1</replicated></table>     a read-only table loaded at every node, read locally
+ *  </placement>
+ * The partitions without explicit backups use the symmetric mapping of bench.rep_factor.
+ * A table may be given a <bench>, e.g. tpcc, and then it is ignored by the other benchmarks.
+ */
+struct PlacementConfig {
+  std::map<int,std::vector<int> > backups;  // partition -> its backups
+  std::map<int,int> table_rep;              // table -> replication factor
+  std::set<int>     replicated;             // fully replicated, read-only tables
+};
+
+extern PlacementConfig placement_config;
+
 class SymmetricView {
  public:
-  SymmetricView(int rep_factor,int total_mac) :
-      rep_factor_(rep_factor >= total_mac?0:rep_factor)
+  SymmetricView(int rep_factor,int total_mac,const PlacementConfig &placement = PlacementConfig()) :
+      default_rep_(rep_factor >= total_mac?0:rep_factor),
+      rep_factor_(max_rep_factor(default_rep_,placement)),
+      total_mac_(total_mac),
+      alive_(new std::atomic<bool>[total_mac]),
+      primary_(new std::atomic<int>[total_mac]),
+      source_(total_mac),
+      taking_over_(total_mac,-1)
   {
-    if(rep_factor_ >= total_mac) {
+    for(int i = 0;i < total_mac;++i) {
+      alive_[i]   = true;
+      primary_[i] = i;
+      source_[i]  = i;
+    }
+    if(rep_factor >= total_mac) {
       LOG(3) << "Disable backups!"
-             << "Rep factor requires at least " << rep_factor_ + 1 <<" macs,"
+             << "Rep factor requires at least " << rep_factor + 1 <<" macs,"
              << "yet total " << total_mac << "in the setting.";
     }
-    LOG(3) << "Start with " << rep_factor_ << " backups.";
-    assign_backups(total_mac);
+    LOG(3) << "Start with " << default_rep_ << " backups.";
+    assign_backups(total_mac,placement);
+    assign_tables(placement);
   }
 
   /**
    * add pid's backup list to the mac_set.
    */
   inline void add_backup(int pid,std::set<int> &mac_set) {
-    for(uint i = 0;i < rep_factor_;++i)
-      mac_set.insert(mapping_[pid][i]);
+    add_backup(pid,mapping_[pid].rep_factor,mac_set);
+  }
+
+  /**
+   * add the backups of pid which keep table tableid to the mac_set.
+   */
+  inline void add_backup_of_table(int pid,int tableid,std::set<int> &mac_set) {
+    add_backup(pid,table_rep(pid,tableid),mac_set);
   }
 
   /**
@@ -62,7 +101,25 @@ class SymmetricView {
    * Otherwise, return false.
    */
   inline bool is_backup(int bid,int pid) {
-    return is_backup(bid,pid,rep_factor_);
+    return is_backup(bid,pid,mapping_[pid].rep_factor);
+  }
+
+  // whether bid keeps pid's records of table tableid
+  inline bool is_table_backup(int bid,int pid,int tableid) {
+    return is_backup(bid,pid,table_rep(pid,tableid));
+  }
+
+  // number of pid's backups which keep table tableid
+  inline int table_rep(int pid,int tableid) const {
+    int rep = mapping_[pid].rep_factor;
+    if(tableid < (int)table_rep_.size() && table_rep_[tableid] >= 0)
+      rep = std::min(rep,table_rep_[tableid]);
+    return rep;
+  }
+
+  // whether the table is read-only and loaded at every node
+  inline bool is_replicated(int tableid) const {
+    return tableid < (int)replicated_.size() && replicated_[tableid];
   }
 
   inline size_t response_for(int bid,std::set<int> &set) {
@@ -85,13 +142,106 @@ class SymmetricView {
 
   void print();
 
+  /**
+   * Failover related.
+   * A failed node is removed from the view, and each partition it served
+   * is taken over by its first alive backup.
+   * A partition has no primary (-1) until the backup has merged its backup store
+   * into its primary store, and is promoted; then the TXs route the partition to it.
+   * The view is changed by one thread, and read by all the workers.
+   */
+  inline bool is_alive(int nid) const {
+    return alive_[nid];
+  }
+
+  // the node which serves partition pid in the current view, or -1 if it is being taken over
+  inline int primary_of(int pid) const {
+    return primary_[pid];
+  }
+
+  // the node whose backups keep the records of partition pid, i.e. its last primary,
+  // since the records are logged as the primary's own ones
+  inline int source_of(int pid) const {
+    return source_[pid];
+  }
+
+  inline uint64_t epoch() const {
+    return epoch_;
+  }
+
+  // new TXs are not started when the view is changing
+  inline bool halted() const {
+    return halted_;
+  }
+
+  /**
+   * Starts a halt round, and returns its number.
+   * Each worker acks a round with quiesce() once it has no TX in flight; the round
+   * is done after all the workers have acked.
+   */
+  inline uint64_t halt() {
+    quiesced_ = 0;
+    uint64_t round = ++halt_round_;
+    halted_ = true;
+    return round;
+  }
+
+  inline void resume() {
+    halted_ = false;
+  }
+
+  inline uint64_t halt_round() const {
+    return halt_round_;
+  }
+
+  inline void quiesce() {
+    quiesced_.fetch_add(1);
+  }
+
+  // the number of the workers which have acked the current halt round
+  inline int quiesced() const {
+    return quiesced_;
+  }
+
+  // move to view epoch without nid; fills the partitions to take over, and their new primaries,
+  // in promoted. These partitions have no primary until they are promoted.
+  void fail(int nid,uint64_t epoch,std::vector<std::pair<int,int> > &promoted);
+
+  // nid serves partition pid from now on; returns false if nid does not take over pid,
+  // e.g. nid has failed before, and pid is taken over by another node
+  bool promote(int pid,int nid);
+
+  // the replication factor of the symmetric mapping
+  const int default_rep_;
+
+  // the max replication factor of the partitions; 0 means no backups at all
   const int rep_factor_;
 
  private:
   std::vector<BackupInfo> mapping_;
+  const int total_mac_;
+  std::unique_ptr<std::atomic<bool>[]> alive_;
+  std::unique_ptr<std::atomic<int>[]>  primary_;
+  std::vector<int>  source_;
+  std::vector<int>  taking_over_; // the node to promote of a partition without primary
+  std::vector<int>  table_rep_;  // -1 uses the partition's replication factor
+  std::vector<bool> replicated_;
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<bool>     halted_{false};
+  std::atomic<uint64_t> halt_round_{0};
+  std::atomic<int>      quiesced_{0};
+
+  inline void add_backup(int pid,int rep,std::set<int> &mac_set) {
+    for(uint i = 0;i < rep;++i)
+      if(alive_[mapping_[pid][i]])
+        mac_set.insert(mapping_[pid][i]);
+  }
+
+  static int max_rep_factor(int default_rep,const PlacementConfig &placement);
 
-  void assign_backups(int total);
+  void assign_backups(int total,const PlacementConfig &placement);
   void assign_one(int idx,int total);
+  void assign_tables(const PlacementConfig &placement);
 
 
   DISABLE_COPY_AND_ASSIGN(SymmetricView);
@@ -147,6 +147,7 @@ bool WAITDIE::try_lock_write_w_rdma(int index, yield_func_t &yield) {
 void WAITDIE::release_reads_w_rdma(yield_func_t &yield, bool release_all) {
   // can only work with lock_w_rdma
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
   int num = read_set_.size();
   if(!release_all) {
@@ -156,6 +157,7 @@ void WAITDIE::release_reads_w_rdma(yield_func_t &yield, bool release_all) {
   uint64_t lock_content = R_LEASE(txn_start_time);
   for(int i = 0; i < num; ++i) {
     auto it = read_set_.begin() + i;
+    if(global_view->is_replicated((*it).tableid)) continue; // not locked
     if((*it).pid != node_id_) {
       RdmaValHeader *header = (RdmaValHeader *)((*it).data_ptr - sizeof(RdmaValHeader));
       if(header->lock == 333) { // successfull locked
@@ -180,11 +182,13 @@ void WAITDIE::release_reads_w_rdma(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
   return;
 }
 
 void WAITDIE::release_writes_w_rdma(yield_func_t &yield, bool release_all) {
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
 
   int num = write_set_.size();
@@ -219,6 +223,7 @@ void WAITDIE::release_writes_w_rdma(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
   return;
 }
 
@@ -231,6 +236,7 @@ void WAITDIE::write_back_w_rdma(yield_func_t &yield) {
    */
   RDMAWriteReq req(cor_id_,PA /* whether to use passive ack*/);
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   CYCLE_START(commit);
 
   for(auto it = write_set_.begin();it != write_set_.end();++it) {
@@ -270,6 +276,7 @@ void WAITDIE::write_back_w_rdma(yield_func_t &yield) {
   CYCLE_RESUME(commit);
   CYCLE_END(commit);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 bool WAITDIE::try_lock_read_w_rwlock_rpc(int index, yield_func_t &yield) {
@@ -426,6 +433,7 @@ bool WAITDIE::try_lock_write_w_rwlock_rpc(int index, yield_func_t &yield) {
 void WAITDIE::release_reads(yield_func_t &yield, bool release_all) {
   using namespace rwlock_4_waitdie;
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
 
   int num = read_set_.size();
@@ -435,6 +443,7 @@ void WAITDIE::release_reads(yield_func_t &yield, bool release_all) {
   abort_cnt[19]+=num;
   start_batch_rpc_op(write_batch_helper_);
   for(int i = 0; i < num; ++i) {
+    if(global_view->is_replicated(read_set_[i].tableid)) continue; // not locked
     if(read_set_[i].pid != node_id_) { // remote case
       add_batch_entry<RTXLockRequestItem>(write_batch_helper_, read_set_[i].pid,
                                    /*init RTXLockRequestItem */ 
@@ -452,11 +461,13 @@ void WAITDIE::release_reads(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 void WAITDIE::release_writes(yield_func_t &yield, bool release_all) {
   using namespace rwlock_4_waitdie;
   START(release_write);
+  STAGE_START(STAGE_RELEASE);
   CYCLE_START(release_write);
 
   int num = write_set_.size();
@@ -483,6 +494,7 @@ void WAITDIE::release_writes(yield_func_t &yield, bool release_all) {
   CYCLE_RESUME(release_write);
   CYCLE_END(release_write);
   END(release_write);
+  STAGE_END(STAGE_RELEASE);
 }
 
 void WAITDIE::prepare_write_contents() {
@@ -514,19 +526,23 @@ void WAITDIE::log_remote(yield_func_t &yield) {
         << "FaSST should uses rep-factor's log entries, current num "
         << cblock.mac_set_.size() << "; rep-factor " << global_view->rep_factor_;
 #else
-    for(auto it = write_batch_helper_.mac_set_.begin();
-        it != write_batch_helper_.mac_set_.end();++it) {
-      global_view->add_backup(*it,cblock.mac_set_);
-    }
-    // add local server
-    global_view->add_backup(current_partition,cblock.mac_set_);
+    // the backups of the written partitions, which keep the written tables
+    for(auto it = write_set_.begin();it != write_set_.end();++it)
+      global_view->add_backup_of_table(it->pid,it->tableid,cblock.mac_set_);
+    if(cblock.mac_set_.empty())
+      return; // only the tables without backups are written
 #endif
 
 #if CHECKS
     LOG(3) << "log to " << cblock.mac_set_.size() << " macs";
 #endif
 
+    // wait for the backups to free enough space in the log rings
+    while(!logger_->check_credits(cblock,cor_id_))
+      worker_->indirect_yield(yield);
+
     START(log);
+    STAGE_START(STAGE_LOG);
     CYCLE_START(log);
     logger_->log_remote(cblock,cor_id_);
     abort_cnt[18]++;
@@ -535,6 +551,7 @@ void WAITDIE::log_remote(yield_func_t &yield) {
     CYCLE_RESUME(log);
     CYCLE_END(log);
     END(log);
+    STAGE_END(STAGE_LOG);
 #if 1
     cblock.req_buf_ = rpc_->get_fly_buf(cor_id_);
     memcpy(cblock.req_buf_,write_batch_helper_.req_buf_,write_batch_helper_.batch_msg_size());
@@ -543,6 +560,11 @@ void WAITDIE::log_remote(yield_func_t &yield) {
     logger_->log_ack(cblock,cor_id_); // need to yield
     abort_cnt[18]++;    
     worker_->indirect_yield(yield);
+#if LOG_ACK_BATCH && !PA
+    // the acks are batched, so wait for the backups' watermarks
+    while(!logger_->log_acked(cblock,cor_id_))
+      worker_->yield_next(yield);
+#endif
 #endif
   } // end check whether it is necessary to log
 }
@@ -577,6 +599,7 @@ void WAITDIE::broadcast_decision(bool commit_or_abort, yield_func_t &yield) {
 
 void WAITDIE::write_back(yield_func_t &yield) {
   START(commit);
+  STAGE_START(STAGE_COMMIT);
   CYCLE_START(commit);
 
   start_batch_rpc_op(write_batch_helper_);
@@ -606,6 +629,7 @@ void WAITDIE::write_back(yield_func_t &yield) {
 #endif
   CYCLE_END(commit);
   END(commit);
+  STAGE_END(STAGE_COMMIT);
 }
 
 
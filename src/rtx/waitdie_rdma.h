@@ -446,14 +446,21 @@ public:
   // get the read lock of the record and actually read
   inline __attribute__((always_inline))
   virtual int read(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
-    if(tableid == 7) {
+    if(global_view->is_replicated(tableid)) {
+      // read-only and loaded at every node, so it is read locally without concurrency control;
+      // the item is a local one, so its copy is freed as a local read's
       int idx = read_set_.size();
-      read_set_.emplace_back(tableid,key,(MemNode*)NULL,(char*)NULL,0,len,0);
+      read_set_.emplace_back(tableid,key,(MemNode*)NULL,local_replicated_get(tableid,key,len),0,len,node_id_);
       return idx;
     }
+    if(unlikely((pid = route(pid)) < 0)) {
+      abort_unavailable(yield);
+      return -1;
+    }
     int index;
 
     START(lock);
+    STAGE_START(STAGE_LOCK);
     // step 1: find offset of the key in either local/remote memory
     if(pid == node_id_)
       index = local_read(tableid,key,len,yield);
@@ -469,6 +476,7 @@ public:
       do_release_writes(yield);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
 #else
@@ -477,11 +485,13 @@ public:
       do_release_writes(yield);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
 #endif
 
     END(lock);
+    STAGE_END(STAGE_LOCK);
     return index;
   }
 
@@ -509,8 +519,13 @@ public:
   inline __attribute__((always_inline))
   virtual int write(int pid, int tableid, uint64_t key, size_t len, yield_func_t &yield) {
     int index;
+    if(unlikely((pid = route(pid)) < 0)) {
+      abort_unavailable(yield);
+      return -1;
+    }
 
     START(lock);
+    STAGE_START(STAGE_LOCK);
     // step 1: find offset of the key in either local/remote memory
     if(pid == node_id_)
       index = local_write(tableid,key,len,yield);
@@ -531,6 +546,7 @@ public:
       do_release_writes(yield,false);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
 #else
@@ -539,11 +555,13 @@ public:
       do_release_writes(yield,false);
       gc_readset();
       gc_writeset();
+      record_conflict(tableid,key);
       return -1;
     }
 #endif
 
     END(lock);
+    STAGE_END(STAGE_LOCK);
     return index;
   }
 
@@ -556,6 +574,8 @@ public:
   // Actually load the data, can be done only after all locks are acquired.
   inline __attribute__((always_inline))
   virtual char* load_read(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     std::vector<ReadSetItem> &set = read_set_;
 
     assert(idx < set.size());
@@ -571,6 +591,7 @@ public:
       // do actual reads here
       assert(false);
       START(read_lat);
+      STAGE_START(STAGE_READ);
       auto replies = send_batch_read();
       assert(replies > 0);
       abort_cnt[18]++;
@@ -579,6 +600,7 @@ public:
       parse_batch_result(replies);
       assert(set[idx].data_ptr != NULL);
       END(read_lat);
+      STAGE_END(STAGE_READ);
       start_batch_rpc_op(read_batch_helper_);
     }
 #endif
@@ -590,6 +612,8 @@ public:
   // Actually load the data, can be done only after all locks are acquired.
   inline __attribute__((always_inline))
   virtual char* load_write(int idx, size_t len, yield_func_t &yield) {
+    if(unlikely(idx < 0 && unavailable_))
+      return unavailable_val(len);
     std::vector<ReadSetItem> &set = write_set_;
 
     assert(idx < set.size());
@@ -604,6 +628,7 @@ public:
       // do actual reads here
       assert(false);
       START(read_lat);
+      STAGE_START(STAGE_READ);
       auto replies = send_batch_read();
       assert(replies > 0);
       abort_cnt[18]++;
@@ -612,6 +637,7 @@ public:
       parse_batch_result(replies);
       assert(set[idx].data_ptr != NULL);
       END(read_lat);
+      STAGE_END(STAGE_READ);
       start_batch_rpc_op(read_batch_helper_);
     }
 #endif
@@ -658,6 +684,7 @@ public:
       assert(false);
       // do actual reads here
       START(read_lat);
+      STAGE_START(STAGE_READ);
       auto replies = send_batch_read();
       assert(replies > 0);
       abort_cnt[18]++;
@@ -666,6 +693,7 @@ public:
       parse_batch_result(replies);
       assert(set[idx].data_ptr != NULL);
       END(read_lat);
+      STAGE_END(STAGE_READ);
       start_batch_rpc_op(read_batch_helper_);
     }
 
@@ -712,6 +740,7 @@ public:
 
   // start a TX
   virtual void begin(yield_func_t &yield) {
+    unavailable_ = false;
     read_set_.clear();
     write_set_.clear();
     #if ONE_SIDED_READ == 0 || ONE_SIDED_READ == 2
@@ -721,9 +750,9 @@ public:
     #if USE_DSLR
       dslr_lock_manager->init();
     #endif
-    txn_start_time = (rwlock::get_now()<<10) + response_node_ * 80 + worker_id_*10 + cor_id_ + 1;
-    // the txn_end_time is approximated using the LEASE_TIME
-    txn_end_time = txn_start_time + rwlock::LEASE_TIME;
+    txn_start_time = TSClock::tx_timestamp(last_start_time_,10,response_node_ * 80 + worker_id_*10 + cor_id_ + 1);
+    // the txn_end_time is approximated using the LEASE_TIME, in the TSClock's micro-seconds
+    txn_end_time = (txn_start_time >> 10) + rwlock::LEASE_TIME;
   }
 
   // commit a TX
@@ -735,11 +764,21 @@ public:
     return dummy_commit();
 #endif
 
+    if(unlikely(unavailable_)) {
+      abort_unavailable(yield);
+      return false;
+    }
+
 #if TX_TWO_PHASE_COMMIT_STYLE > 0
     START(twopc)
+    STAGE_START(STAGE_2PC);
     bool vote_commit = prepare_commit(yield); // broadcasting prepare messages and collecting votes
-    // broadcast_decision(vote_commit, yield);
+#if TX_TWO_PHASE_COMMIT_STYLE == 2
+    if (vote_commit)
+      broadcast_decision(true, yield); // an abort is decided in prepare_commit
+#endif
     END(twopc);
+    STAGE_END(STAGE_2PC);
     if (!vote_commit) {
       do_release_reads(yield);
       do_release_writes(yield);
@@ -777,6 +816,17 @@ public:
     return true;
   }
 
+  // an unavailable TX releases its locks at once, as a conflicting one; its items are forgotten,
+  // so that the later accesses of the TX, and its commit, do not release them again
+  inline void abort_unavailable(yield_func_t &yield) {
+    do_release_reads(yield);
+    do_release_writes(yield);
+    gc_readset();
+    gc_writeset();
+    read_set_.clear();
+    write_set_.clear();
+  }
+
   inline void do_release_reads(yield_func_t &yield, bool release_all = true) {
 #if ONE_SIDED_READ == 1 || ONE_SIDED_READ == 2 && (HYBRID_CODE & RCC_USE_ONE_SIDED_RELEASE) != 0
       release_reads_w_rdma(yield, release_all);
@@ -826,6 +876,7 @@ protected:
 
   uint64_t txn_start_time = 0;
   uint64_t txn_end_time = 0;
+  uint64_t last_start_time_ = 0;
 
 public:
 #include "occ_statistics.h"
@@ -0,0 +1,86 @@
+#ifndef NOCC_UTIL_HDR_HISTOGRAM
+#define NOCC_UTIL_HDR_HISTOGRAM
+
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+
+namespace nocc {
+namespace util {
+
+/**
+ * A log-linear (HDR) histogram of uint64_t values.
+ * Each power of two is split into 2^(kSubBits - 1) buckets, so a recorded value is kept
+ * with a relative error of at most 2^-(kSubBits - 1), over the whole uint64_t range.
+ * A histogram has a single writer; readers may read the counts concurrently, and see
+ * a slightly stale snapshot.
+ * The bucket index of a value can also be computed at a lower precision (bits < kSubBits),
+ * which is used to ship a coarser copy of a histogram.
+ */
+class HdrHistogram {
+ public:
+  static const int kSubBits = 5;
+  static const int kBuckets = (66 - kSubBits) << (kSubBits - 1);
+
+  HdrHistogram() { clear(); }
+
+  inline void record(uint64_t v) { counts_[index(v)] += 1; }
+  inline void add(int idx,uint64_t c) { counts_[idx] += c; }
+  inline uint64_t count(int idx) const { return counts_[idx]; }
+
+  void clear() { memset(counts_,0,sizeof(counts_)); }
+
+  uint64_t total() const {
+    uint64_t sum = 0;
+    for(int i = 0;i < kBuckets;++i)
+      sum += counts_[i];
+    return sum;
+  }
+
+  // the highest value equivalent to the p-th percentile, 0 if empty
+  uint64_t percentile(double p) const {
+    uint64_t sum = total();
+    if(sum == 0) return 0;
+    uint64_t target = (uint64_t)std::ceil(sum * p / 100.0);
+    if(target == 0) target = 1;
+    uint64_t acc = 0;
+    for(int i = 0;i < kBuckets;++i) {
+      acc += counts_[i];
+      if(acc >= target)
+        return highest(i);
+    }
+    return max();
+  }
+
+  uint64_t max() const {
+    for(int i = kBuckets - 1;i >= 0;--i)
+      if(counts_[i] != 0)
+        return highest(i);
+    return 0;
+  }
+
+  static inline int index(uint64_t v,int bits = kSubBits) {
+    if(v < (1ULL << bits))
+      return (int)v;
+    int half  = 1 << (bits - 1);
+    int shift = (63 - __builtin_clzll(v)) - (bits - 1);
+    return (shift + 1) * half + (int)(v >> shift) - half;
+  }
+
+  // the highest value which falls into the bucket
+  static inline uint64_t highest(int idx,int bits = kSubBits) {
+    if(idx < (1 << bits))
+      return idx;
+    int half  = 1 << (bits - 1);
+    int shift = idx / half - 1;
+    uint64_t sub = idx % half + half;
+    return ((sub + 1) << shift) - 1;
+  }
+
+ private:
+  uint64_t counts_[kBuckets];
+};
+
+} // namespace util
+}   // namespace nocc
+#endif